@@ -38,6 +38,25 @@ SOURCES += \
     project/clip.cpp \
     playback/playback.cpp \
     playback/audio.cpp \
+    playback/decoderpool.cpp \
+    playback/framecache.cpp \
+    playback/reversedecoder.cpp \
+    playback/videofilter.cpp \
+    playback/audiofilter.cpp \
+    playback/decodescheduler.cpp \
+    playback/framepool.cpp \
+    playback/textureuploader.cpp \
+    playback/planartexture.cpp \
+    playback/planarconverter.cpp \
+    playback/prefetcher.cpp \
+    playback/audioringbuffer.cpp \
+    playback/audiomixer.cpp \
+    playback/mixkernels.cpp \
+    playback/offlineaudiorender.cpp \
+    playback/loudnessmeter.cpp \
+    playback/audiometer.cpp \
+    playback/audioscrubber.cpp \
+    playback/recordingwriter.cpp \
     io/config.cpp \
     dialogs/newsequencedialog.cpp \
     ui/viewerwidget.cpp \
@@ -45,6 +64,9 @@ SOURCES += \
     dialogs/exportdialog.cpp \
     ui/collapsiblewidget.cpp \
     io/exportthread.cpp \
+    io/exportpresets.cpp \
+    io/audiodecoder.cpp \
+    io/headlessrender.cpp \
     ui/timelineheader.cpp \
     ui/labelslider.cpp \
     dialogs/preferencesdialog.cpp \
@@ -122,7 +144,13 @@ SOURCES += \
     ui/Forms/markersviewer.cpp \
     ui/Forms/markerwidget.cpp \
     ui/markerdockwidget.cpp \
-    project/footagestream.cpp
+    project/footagestream.cpp \
+    project/keyframeindex.cpp \
+    project/waveformpyramid.cpp \
+    project/proxytranscoder.cpp \
+    project/proxygeneratorthread.cpp \
+    project/conformedaudio.cpp \
+    project/audioconformthread.cpp
 
 HEADERS += \
     chestnut.h \
@@ -154,13 +182,36 @@ HEADERS += \
     project/clip.h \
     playback/playback.h \
     playback/audio.h \
+    playback/decoderpool.h \
+    playback/framecache.h \
+    playback/reversedecoder.h \
+    playback/videofilter.h \
+    playback/audiofilter.h \
+    playback/decodescheduler.h \
+    playback/framepool.h \
+    playback/textureuploader.h \
+    playback/planartexture.h \
+    playback/planarconverter.h \
+    playback/prefetcher.h \
+    playback/audioringbuffer.h \
+    playback/audiomixer.h \
+    playback/mixkernels.h \
+    playback/offlineaudiorender.h \
+    playback/loudnessmeter.h \
+    playback/audiometer.h \
+    playback/audioscrubber.h \
+    playback/recordingwriter.h \
     io/config.h \
     dialogs/newsequencedialog.h \
     ui/viewerwidget.h \
     ui/viewercontainer.h \
     dialogs/exportdialog.h \
     ui/collapsiblewidget.h \
+    io/exportpipeline.h \
     io/exportthread.h \
+    io/exportpresets.h \
+    io/audiodecoder.h \
+    io/headlessrender.h \
     ui/timelineheader.h \
     ui/labelslider.h \
     dialogs/preferencesdialog.h \
@@ -241,7 +292,13 @@ HEADERS += \
     ui/Forms/markerwidget.h \
     project/ixmlstreamer.h \
     ui/markerdockwidget.h \
-    project/footagestream.h
+    project/footagestream.h \
+    project/keyframeindex.h \
+    project/waveformpyramid.h \
+    project/proxytranscoder.h \
+    project/proxygeneratorthread.h \
+    project/conformedaudio.h \
+    project/audioconformthread.h
 
 DISTFILES +=
 
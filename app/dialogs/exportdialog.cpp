@@ -31,6 +31,8 @@
 #include <QPushButton>
 #include <QProgressBar>
 #include <QStandardPaths>
+#include <algorithm>
+#include <array>
 #include <limits>
 
 #include "debug.h"
@@ -38,6 +40,7 @@
 #include "ui/viewerwidget.h"
 #include "project/sequence.h"
 #include "io/exportthread.h"
+#include "playback/audioscrubber.h"
 #include "playback/playback.h"
 #include "ui/mainwindow.h"
 #include "coderconstants.h"
@@ -214,11 +217,13 @@ void ExportDialog::render_thread_finished()
     QMessageBox::critical(
           this,
           tr("Export Failed"),
-          tr("Export failed - %1").arg(export_error),
+          tr("Export failed - %1").arg(et->error()),
           QMessageBox::Ok
           );
   }
   prep_ui_for_render(false);
+  // clips opened on the originals for export go back to their proxies
+  e_rendering = false;
   PanelManager::sequenceViewer().viewer_widget->makeCurrent();
   PanelManager::sequenceViewer().viewer_widget->initializeGL();
   PanelManager::refreshPanels(false);
@@ -320,8 +325,11 @@ void ExportDialog::export_action()
 
     connect(et, SIGNAL(finished()), et, SLOT(deleteLater()));
     connect(et, SIGNAL(finished()), this, SLOT(render_thread_finished()));
-    connect(et, SIGNAL(progress_changed(int, qint64)), this, SLOT(update_progress_bar(int, qint64)));
+    qRegisterMetaType<chestnut::io::ExportStageTimes>();
+    connect(et, &ExportThread::progress_changed, this, &ExportDialog::update_progress_bar);
 
+    // the clips' effects are run by the export alone
+    chestnut::playback::AudioScrubber::instance().stop();
     sequence_->closeActiveClips();
 
     MainWindow::instance().set_rendering_state(true);
@@ -367,21 +375,30 @@ void ExportDialog::export_action()
       et->end_frame = qMin(sequence_->workarea_.out_, et->end_frame);
     }
 
-    et->ed = this;
     cancelled = false;
 
     et->start();
   }
 }
 
-void ExportDialog::update_progress_bar(int value, qint64 remaining_ms)
+void ExportDialog::update_progress_bar(int value, qint64 remaining_ms,
+                                       const chestnut::io::ExportStageTimes& stage_times)
 {
   // convert ms to H:MM:SS
   const int seconds = qFloor(remaining_ms * 0.001) % 60;
   const int minutes = qFloor(remaining_ms / 60000) % 60;
   const int hours = qFloor(remaining_ms / 3600000);
+  // the stages overlap, so the export goes at the pace of the slowest
+  const std::array<std::pair<QString, double>, 5> stages {{{tr("render"), stage_times.render_},
+                                                           {tr("audio"), stage_times.audio_},
+                                                           {tr("convert"), stage_times.convert_},
+                                                           {tr("encode"), stage_times.encode_},
+                                                           {tr("mux"), stage_times.mux_}}};
+  const auto slowest = std::max_element(stages.begin(), stages.end(),
+                                        [] (const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; });
   progressBar->setFormat("%p% (ETA: " + QString::number(hours) + ":" + QString::number(minutes).rightJustified(2, '0')
-                         + ":" + QString::number(seconds).rightJustified(2, '0') + ")");
+                         + ":" + QString::number(seconds).rightJustified(2, '0') + ", " + slowest->first + ": "
+                         + QString::number(slowest->second, 'f', 1) + "ms)");
 
   progressBar->setValue(value);
 }
@@ -51,12 +51,10 @@ class ExportDialog : public QDialog
     ExportDialog(const ExportDialog&& ) = delete;
     ExportDialog& operator=(const ExportDialog&&) = delete;
 
-    QString export_error;
-
   private slots:
     void format_changed(int index);
     void export_action();
-    void update_progress_bar(int value, qint64 remaining_ms);
+    void update_progress_bar(int value, qint64 remaining_ms, const chestnut::io::ExportStageTimes& stage_times);
     void cancel_render();
     void render_thread_finished();
     void vcodec_changed(int index);
@@ -37,10 +37,12 @@
 
 extern "C" {
 #include <libavcodec/avcodec.h>
+#include <libavutil/channel_layout.h>
 }
 
 constexpr auto SAMPLE_RATES = {22050, 24000, 32000, 44100, 48000, 88200, 96000};
 constexpr auto FRAME_RATES = {6.0, 8.0, 10.0, 12.5, 15.0, 23.976, 24.0, 25.0, 29.97, 30.0, 50.0, 59.94, 60.0};
+constexpr auto CHANNEL_LAYOUTS = {AV_CH_LAYOUT_MONO, AV_CH_LAYOUT_STEREO, AV_CH_LAYOUT_5POINT1, AV_CH_LAYOUT_7POINT1};
 
 NewSequenceDialog::NewSequenceDialog(QWidget *parent, MediaPtr existing) :
   QDialog(parent),
@@ -68,6 +70,12 @@ NewSequenceDialog::NewSequenceDialog(QWidget *parent, MediaPtr existing) :
         break;
       }
     }
+    for (int i=0;i<audio_layout_combobox->count();i++) {
+      if (audio_layout_combobox->itemData(i).toULongLong() == static_cast<quint64>(existing_sequence->audioLayout())) {
+        audio_layout_combobox->setCurrentIndex(i);
+        break;
+      }
+    }
   } else {
     existing_sequence = nullptr;
     setWindowTitle(tr("New Sequence"));
@@ -90,7 +98,7 @@ void NewSequenceDialog::create() {
     s->setHeight(height_numeric->value());
     s->setFrameRate(frame_rate_combobox->currentData().toDouble());
     s->setAudioFrequency(audio_frequency_combobox->currentData().toInt());
-    s->setAudioLayout(AV_CH_LAYOUT_STEREO);
+    s->setAudioLayout(static_cast<int32_t>(audio_layout_combobox->currentData().toULongLong()));
 
     ComboAction* ca = new ComboAction();
     panels::PanelManager::projectViewer().newSequence(ca, s, true, nullptr);
@@ -106,7 +114,7 @@ void NewSequenceDialog::create() {
     esc->height = height_numeric->value();
     esc->frame_rate = frame_rate_combobox->currentData().toDouble();
     esc->audio_frequency = audio_frequency_combobox->currentData().toInt();
-    esc->audio_layout = AV_CH_LAYOUT_STEREO;
+    esc->audio_layout = static_cast<int>(audio_layout_combobox->currentData().toULongLong());
     ca->append(esc);
 
     for (const auto& ex_clip : existing_sequence->clips()) {
@@ -253,6 +261,18 @@ void NewSequenceDialog::setup_ui() {
 
   audioLayout->addWidget(audio_frequency_combobox, 0, 1, 1, 1);
 
+  audioLayout->addWidget(new QLabel(tr("Channels: ")), 1, 0, 1, 1);
+
+  audio_layout_combobox = new QComboBox(audioGroupBox);
+  for (const auto& layout : CHANNEL_LAYOUTS) {
+    char name[64];
+    av_get_channel_layout_string(name, sizeof(name), 0, layout);
+    audio_layout_combobox->addItem(name, static_cast<quint64>(layout));
+  }
+  audio_layout_combobox->setCurrentIndex(1);
+
+  audioLayout->addWidget(audio_layout_combobox, 1, 1, 1, 1);
+
   verticalLayout->addWidget(audioGroupBox);
 
   QWidget* nameWidget = new QWidget(this);
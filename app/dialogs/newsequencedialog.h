@@ -58,6 +58,7 @@ class NewSequenceDialog : public QDialog
     QComboBox* interlacing_combobox;
     QComboBox* frame_rate_combobox;
     QComboBox* audio_frequency_combobox;
+    QComboBox* audio_layout_combobox;
     QLineEdit* sequence_name_edit;
 };
 
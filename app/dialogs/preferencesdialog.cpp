@@ -39,6 +39,7 @@
 
 #include "io/config.h"
 #include "ui/mainwindow.h"
+#include "panels/panelmanager.h"
 
 
 #include "debug.h"
@@ -140,12 +141,22 @@ void PreferencesDialog::save() {
   global::config.css_path = custom_css_fn->text();
   MainWindow::instance().load_css_from_file(global::config.css_path);
   global::config.recording_mode = recordingComboBox->currentIndex() + 1;
+  global::config.split_recording_channels = split_recording_checkbox->isChecked();
   global::config.fast_seeking = fastSeekButton->isChecked();
   global::config.disable_multithreading_for_images = disable_img_multithread->isChecked();
+  global::config.use_pbo_upload = pbo_upload_checkbox->isChecked();
+  global::config.gpu_yuv_conversion = gpu_yuv_checkbox->isChecked();
+  const bool queue_proxies = use_proxies_checkbox->isChecked() && !global::config.use_proxies;
+  global::config.use_proxies = use_proxies_checkbox->isChecked();
+  global::config.proxy_height = proxy_height_spinbox->value();
+  const bool queue_conforms = conform_audio_checkbox->isChecked() && !global::config.conform_audio;
+  global::config.conform_audio = conform_audio_checkbox->isChecked();
   global::config.upcoming_queue_size = upcoming_queue_spinbox->value();
   global::config.upcoming_queue_type = upcoming_queue_type->currentIndex();
   global::config.previous_queue_size = previous_queue_spinbox->value();
   global::config.previous_queue_type = previous_queue_type->currentIndex();
+  global::config.frame_cache_size = frame_cache_spinbox->value();
+  global::config.prefetch_length = prefetch_spinbox->value();
   global::config.effect_textbox_lines = effect_textbox_lines_field->value();
 
   // save keyboard shortcuts
@@ -153,6 +164,13 @@ void PreferencesDialog::save() {
     key_shortcut_fields.at(i)->set_action_shortcut();
   }
 
+  if (queue_proxies) {
+    panels::PanelManager::projectViewer().queueProxies();
+  }
+  if (queue_conforms) {
+    panels::PanelManager::projectViewer().queueConforms();
+  }
+
   accept();
 }
 
@@ -305,13 +323,17 @@ void PreferencesDialog::setup_ui() {
   recordingComboBox->addItem(tr("Stereo"));
   general_layout->addWidget(recordingComboBox, 2, 1, 1, 2);
 
+  split_recording_checkbox = new QCheckBox(tr("Record Each Channel to a Track of its Own"), general_tab);
+  split_recording_checkbox->setChecked(global::config.split_recording_channels);
+  general_layout->addWidget(split_recording_checkbox, 3, 1, 1, 2);
+
   // General -> Effect Textbox Lines
-  general_layout->addWidget(new QLabel(tr("Effect Textbox Lines:")), 3, 0, 1, 1);
+  general_layout->addWidget(new QLabel(tr("Effect Textbox Lines:")), 4, 0, 1, 1);
 
   effect_textbox_lines_field = new QSpinBox(general_tab);
   effect_textbox_lines_field->setMinimum(1);
   effect_textbox_lines_field->setValue(global::config.effect_textbox_lines);
-  general_layout->addWidget(effect_textbox_lines_field, 3, 1, 1, 2);
+  general_layout->addWidget(effect_textbox_lines_field, 4, 1, 1, 2);
 
   tabWidget->addTab(general_tab, tr("General"));
 
@@ -328,6 +350,37 @@ void PreferencesDialog::setup_ui() {
   disable_img_multithread->setChecked(global::config.disable_multithreading_for_images);
   playback_tab_layout->addWidget(disable_img_multithread);
 
+  // Playback -> Buffered Texture Uploads
+  pbo_upload_checkbox = new QCheckBox(tr("Upload Frames Through Pixel Buffers"));
+  pbo_upload_checkbox->setChecked(global::config.use_pbo_upload);
+  playback_tab_layout->addWidget(pbo_upload_checkbox);
+
+  // Playback -> GPU Colour Conversion
+  gpu_yuv_checkbox = new QCheckBox(tr("Convert YUV Frames to RGB on the GPU"));
+  gpu_yuv_checkbox->setChecked(global::config.gpu_yuv_conversion);
+  playback_tab_layout->addWidget(gpu_yuv_checkbox);
+
+  // Playback -> Proxies
+  QGroupBox* proxy_group = new QGroupBox(playback_tab);
+  proxy_group->setTitle(tr("Proxies"));
+  QGridLayout* proxy_layout = new QGridLayout(proxy_group);
+  use_proxies_checkbox = new QCheckBox(tr("Generate Proxies and Use Them for Playback"));
+  use_proxies_checkbox->setChecked(global::config.use_proxies);
+  proxy_layout->addWidget(use_proxies_checkbox, 0, 0, 1, 2);
+  proxy_layout->addWidget(new QLabel(tr("Proxy Height:")), 1, 0);
+  proxy_height_spinbox = new QSpinBox();
+  proxy_height_spinbox->setRange(144, 2160);
+  proxy_height_spinbox->setSingleStep(2);
+  proxy_height_spinbox->setSuffix(tr(" px"));
+  proxy_height_spinbox->setValue(global::config.proxy_height);
+  proxy_layout->addWidget(proxy_height_spinbox, 1, 1);
+  playback_tab_layout->addWidget(proxy_group);
+
+  // Playback -> Conformed Audio
+  conform_audio_checkbox = new QCheckBox(tr("Conform Audio to the Sample Rate in the Background"));
+  conform_audio_checkbox->setChecked(global::config.conform_audio);
+  playback_tab_layout->addWidget(conform_audio_checkbox);
+
   // Playback -> Seeking
   QGroupBox* seeking_group = new QGroupBox(playback_tab);
   seeking_group->setTitle(tr("Seeking"));
@@ -362,6 +415,18 @@ void PreferencesDialog::setup_ui() {
   previous_queue_type->addItem(tr("seconds"));
   previous_queue_type->setCurrentIndex(global::config.previous_queue_type);
   memory_usage_layout->addWidget(previous_queue_type, 1, 2);
+  memory_usage_layout->addWidget(new QLabel(tr("Decoded Frame Cache:")), 2, 0);
+  frame_cache_spinbox = new QSpinBox();
+  frame_cache_spinbox->setRange(64, 65536);
+  frame_cache_spinbox->setSuffix(tr(" MiB"));
+  frame_cache_spinbox->setValue(global::config.frame_cache_size);
+  memory_usage_layout->addWidget(frame_cache_spinbox, 2, 1);
+  memory_usage_layout->addWidget(new QLabel(tr("Open Clips Ahead of Playhead:")), 3, 0);
+  prefetch_spinbox = new QDoubleSpinBox();
+  prefetch_spinbox->setRange(0.0, 30.0);
+  prefetch_spinbox->setSuffix(tr(" s"));
+  prefetch_spinbox->setValue(global::config.prefetch_length);
+  memory_usage_layout->addWidget(prefetch_spinbox, 3, 1);
   playback_tab_layout->addWidget(memory_usage_group);
 
   tabWidget->addTab(playback_tab, tr("Playback"));
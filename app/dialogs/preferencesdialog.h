@@ -75,14 +75,22 @@ class PreferencesDialog : public QDialog
 
     QLineEdit* custom_css_fn {nullptr};
     QComboBox* recordingComboBox {nullptr};
+    QCheckBox* split_recording_checkbox {nullptr};
     QRadioButton* accurateSeekButton {nullptr};
     QRadioButton* fastSeekButton {nullptr};
     QTreeWidget* keyboard_tree {nullptr};
     QCheckBox* disable_img_multithread {nullptr};
+    QCheckBox* pbo_upload_checkbox {nullptr};
+    QCheckBox* gpu_yuv_checkbox {nullptr};
+    QCheckBox* use_proxies_checkbox {nullptr};
+    QSpinBox* proxy_height_spinbox {nullptr};
+    QCheckBox* conform_audio_checkbox {nullptr};
     QDoubleSpinBox* upcoming_queue_spinbox {nullptr};
     QComboBox* upcoming_queue_type {nullptr};
     QDoubleSpinBox* previous_queue_spinbox {nullptr};
     QComboBox* previous_queue_type {nullptr};
+    QSpinBox* frame_cache_spinbox {nullptr};
+    QDoubleSpinBox* prefetch_spinbox {nullptr};
     QSpinBox* effect_textbox_lines_field {nullptr};
 
     QVector<QAction*> key_shortcut_actions;
@@ -21,6 +21,15 @@
 #include <QtMath>
 #include <random>
 
+#include "playback/mixkernels.h"
+
+namespace
+{
+  // interleaved 16-bit, of any number of channels
+  constexpr size_t SAMPLE_BYTES = sizeof(int16_t);
+  constexpr double S16_SCALE = 32768.0;
+}
+
 AudioNoiseEffect::AudioNoiseEffect(ClipPtr c, const EffectMeta& em) : Effect(c, em) {
 
 
@@ -30,33 +39,34 @@ void AudioNoiseEffect::process_audio(const double timecode_start,
                                      const double timecode_end,
                                      quint8 *samples,
                                      const int nb_bytes,
-                                     const int)
+                                     const int channel_count)
 {
-  double interval = (timecode_end - timecode_start)/nb_bytes;
-  for (int i=0;i<nb_bytes;i+=4) {
-    double timecode = timecode_start+(interval*i);
-
-    qint16 left_noise_sample = this->randomNumber<qint16>();
-    qint16 right_noise_sample = this->randomNumber<qint16>();
-
-    // set noise volume
-    double vol = log_volume( amount_val->get_double_value(timecode, true)*0.01 );
-    left_noise_sample *= vol;
-    right_noise_sample *= vol;
+  if ( (nb_bytes <= 0) || (channel_count <= 0) ) {
+    return;
+  }
+  const auto channels = static_cast<size_t>(channel_count);
+  const auto frames = static_cast<size_t>(nb_bytes) / (SAMPLE_BYTES * channels);
+  amounts_.resize(frames);
+  amount_val->get_double_values(timecode_start, timecode_end, amounts_, [] (const double amount) {
+    return log_volume(amount * 0.01) / S16_SCALE;
+  });
 
-    // mix with source audio
-    if (mix_val->get_bool_value(timecode, true)) {
-      qint16 left_sample = static_cast<qint16> (((samples[i+1] & 0xFF) << 8) | (samples[i] & 0xFF));
-      qint16 right_sample = static_cast<qint16> (((samples[i+3] & 0xFF) << 8) | (samples[i+2] & 0xFF));
-      left_noise_sample = mix_audio_sample(left_noise_sample, left_sample);
-      right_noise_sample = mix_audio_sample(right_noise_sample, right_sample);
+  // independent in each channel
+  noise_.resize(frames * channels);
+  for (size_t i = 0; i < frames; ++i) {
+    for (size_t c = 0; c < channels; ++c) {
+      noise_[(i * channels) + c] = this->randomNumber<qint16>() * amounts_[i];
     }
+  }
 
-    samples[i+3] = static_cast<quint8> (right_noise_sample >> 8);
-    samples[i+2] = static_cast<quint8> (right_noise_sample);
-    samples[i+1] = static_cast<quint8> (left_noise_sample >> 8);
-    samples[i] = static_cast<quint8> (left_noise_sample);
+  // mix with source audio
+  auto s16 = reinterpret_cast<int16_t*>(samples);
+  if (mix_val->get_bool_value(timecode_start, true)) {
+    block_.resize(noise_.size());
+    chestnut::playback::kernel::fromS16(s16, block_.data(), block_.size());
+    chestnut::playback::kernel::accumulate(block_.data(), noise_.data(), noise_.size());
   }
+  chestnut::playback::kernel::toS16(noise_.data(), s16, noise_.size());
 }
 
 
@@ -20,6 +20,7 @@
 
 #include "project/effect.h"
 #include <random>
+#include <vector>
 
 class AudioNoiseEffect : public Effect {
 public:
@@ -38,6 +39,11 @@ public:
 
     EffectField* amount_val {nullptr};
     EffectField* mix_val {nullptr};
+  private:
+    // per-frame amount, the noise and the source as float, for the block being processed
+    std::vector<float> amounts_;
+    std::vector<float> noise_;
+    std::vector<float> block_;
 
 };
 
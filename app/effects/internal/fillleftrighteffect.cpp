@@ -18,10 +18,15 @@ void FillLeftRightEffect::process_audio(const double timecode_start,
                                         const double timecode_end,
                                         quint8* samples,
                                         const int nb_bytes,
-                                        const int)
+                                        const int channel_count)
 {
+  if ( (nb_bytes <= 0) || (channel_count < 2) ) {
+    return;
+  }
+  // the front pair of each interleaved 16-bit frame
+  const int frame_bytes = channel_count * 2;
   double interval = (timecode_end-timecode_start)/nb_bytes;
-  for (int i=0;i<nb_bytes;i+=4) {
+  for (int i=0;i+frame_bytes<=nb_bytes;i+=frame_bytes) {
     if (fill_type->get_combo_data(timecode_start+(interval*i)) == FILL_TYPE_LEFT) {
       samples[i+1] = samples[i+3];
       samples[i] = samples[i+2];
@@ -20,10 +20,16 @@
 #include <QGridLayout>
 #include <QLabel>
 #include <QtMath>
-#include <cmath>
 
 #include "ui/labelslider.h"
 #include "ui/collapsiblewidget.h"
+#include "playback/mixkernels.h"
+
+namespace
+{
+  // interleaved 16-bit, of any number of channels
+  constexpr size_t SAMPLE_BYTES = sizeof(int16_t);
+}
 
 PanEffect::PanEffect(ClipPtr c, const EffectMeta& em)
   : Effect(c, em)
@@ -35,27 +41,31 @@ void PanEffect::process_audio(const double timecode_start,
                               const double timecode_end,
                               quint8* samples,
                               const int nb_bytes,
-                              const int)
+                              const int channel_count)
 {
-  double interval = (timecode_end - timecode_start)/nb_bytes;
-  for (int i=0;i<nb_bytes;i+=4) {
-    double pval = log_volume(pan_val->get_double_value(timecode_start+(interval*i), true)*0.01);
-    qint16 left_sample = (qint16) (((samples[i+1] & 0xFF) << 8) | (samples[i] & 0xFF));
-    qint16 right_sample = (qint16) (((samples[i+3] & 0xFF) << 8) | (samples[i+2] & 0xFF));
-
-    if (pval < 0) {
-      // affect right channel
-      right_sample *= (1-std::abs(pval));
-    } else {
-      // affect left channel
-      left_sample *= (1-pval);
-    }
-
-    samples[i+3] = (quint8) (right_sample >> 8);
-    samples[i+2] = (quint8) right_sample;
-    samples[i+1] = (quint8) (left_sample >> 8);
-    samples[i] = (quint8) left_sample;
+  // panned between the front pair, so mono is left as it is
+  if ( (nb_bytes <= 0) || (channel_count < 2) ) {
+    return;
   }
+  const auto channels = static_cast<size_t>(channel_count);
+  const auto frames = static_cast<size_t>(nb_bytes) / (SAMPLE_BYTES * channels);
+  pans_.resize(frames);
+  pan_val->get_double_values(timecode_start, timecode_end, pans_, [] (const double pan) {
+    return log_volume(pan * 0.01);
+  });
+  // panning left attenuates the right channel, and vice versa
+  left_.resize(frames);
+  right_.resize(frames);
+  for (size_t i = 0; i < frames; ++i) {
+    left_[i] = 1.0f - qMax(pans_[i], 0.0f);
+    right_[i] = 1.0f + qMin(pans_[i], 0.0f);
+  }
+
+  auto s16 = reinterpret_cast<int16_t*>(samples);
+  block_.resize(frames * channels);
+  chestnut::playback::kernel::fromS16(s16, block_.data(), block_.size());
+  chestnut::playback::kernel::applyFrontGains(block_.data(), left_.data(), right_.data(), channel_count, frames);
+  chestnut::playback::kernel::toS16(block_.data(), s16, block_.size());
 }
 
 void PanEffect::setupUi()
@@ -18,6 +18,8 @@
 #ifndef PANEFFECT_H
 #define PANEFFECT_H
 
+#include <vector>
+
 #include "project/effect.h"
 
 class PanEffect : public Effect {
@@ -37,6 +39,12 @@ class PanEffect : public Effect {
     virtual void setupUi() override;
 
     EffectField* pan_val {nullptr};
+  private:
+    // per-frame pan and channel gains, and the samples as float, for the block being processed
+    std::vector<float> pans_;
+    std::vector<float> left_;
+    std::vector<float> right_;
+    std::vector<float> block_;
 };
 
 #endif // PANEFFECT_H
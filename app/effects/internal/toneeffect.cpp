@@ -18,13 +18,22 @@
 #include "toneeffect.h"
 
 #include <QtMath>
+#include <algorithm>
 
 constexpr int TONE_TYPE_SINE = 0;
 
 #include "project/clip.h"
 #include "project/sequence.h"
+#include "playback/mixkernels.h"
 #include "debug.h"
 
+namespace
+{
+  // interleaved 16-bit, of any number of channels
+  constexpr size_t SAMPLE_BYTES = sizeof(int16_t);
+  constexpr double S16_SCALE = 32768.0;
+}
+
 ToneEffect::ToneEffect(ClipPtr c, const EffectMeta& em)
   : Effect(c, em),
     sinX(INT_MIN)
@@ -36,33 +45,37 @@ void ToneEffect::process_audio(const double timecode_start,
                                const double timecode_end,
                                quint8 *samples,
                                const int nb_bytes,
-                               const int)
+                               const int channel_count)
 {
-  double interval = (timecode_end - timecode_start)/nb_bytes;
-  for (int i=0;i<nb_bytes;i+=4) {
-    double timecode = timecode_start+(interval*i);
-
-    // TODO: make left_tone_sample calc readable
-    qint16 left_tone_sample = qint16(qRound(qSin((2*M_PI*sinX*freq_val->get_double_value(timecode, true))/parent_clip->sequence->audioFrequency())
-                                            *log_volume(amount_val->get_double_value(timecode, true)*0.01)
-                                            *INT16_MAX));
-    qint16 right_tone_sample = left_tone_sample;
-
-    // mix with source audio
-    if (mix_val->get_bool_value(timecode, true)) {
-      qint16 left_sample = qint16(((samples[i+1] & 0xFF) << 8) | (samples[i] & 0xFF));
-      qint16 right_sample = qint16(((samples[i+3] & 0xFF) << 8) | (samples[i+2] & 0xFF));
-      left_tone_sample = mix_audio_sample(left_tone_sample, left_sample);
-      right_tone_sample = mix_audio_sample(right_tone_sample, right_sample);
-    }
-
-    samples[i+3] = quint8(right_tone_sample >> 8);
-    samples[i+2] = quint8(right_tone_sample);
-    samples[i+1] = quint8(left_tone_sample >> 8);
-    samples[i] = quint8(left_tone_sample);
+  if ( (nb_bytes <= 0) || (channel_count <= 0) ) {
+    return;
+  }
+  const auto channels = static_cast<size_t>(channel_count);
+  const auto frames = static_cast<size_t>(nb_bytes) / (SAMPLE_BYTES * channels);
+  freqs_.resize(frames);
+  freq_val->get_double_values(timecode_start, timecode_end, freqs_);
+  amounts_.resize(frames);
+  amount_val->get_double_values(timecode_start, timecode_end, amounts_, [] (const double amount) {
+    return log_volume(amount * 0.01) * INT16_MAX / S16_SCALE;
+  });
 
+  // the same tone in every channel
+  const double rate = parent_clip->sequence->audioFrequency();
+  tone_.resize(frames * channels);
+  for (size_t i = 0; i < frames; ++i) {
+    const auto sample = static_cast<float>(qSin((2 * M_PI * sinX * freqs_[i]) / rate) * amounts_[i]);
+    std::fill_n(tone_.begin() + static_cast<std::ptrdiff_t>(i * channels), channels, sample);
     sinX++;
   }
+
+  // mix with source audio
+  auto s16 = reinterpret_cast<int16_t*>(samples);
+  if (mix_val->get_bool_value(timecode_start, true)) {
+    block_.resize(tone_.size());
+    chestnut::playback::kernel::fromS16(s16, block_.data(), block_.size());
+    chestnut::playback::kernel::accumulate(block_.data(), tone_.data(), tone_.size());
+  }
+  chestnut::playback::kernel::toS16(tone_.data(), s16, tone_.size());
 }
 
 void ToneEffect::setupUi()
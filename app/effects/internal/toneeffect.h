@@ -18,6 +18,8 @@
 #ifndef TONEEFFECT_H
 #define TONEEFFECT_H
 
+#include <vector>
+
 #include "project/effect.h"
 
 class ToneEffect : public Effect {
@@ -41,6 +43,11 @@ class ToneEffect : public Effect {
     EffectField* mix_val {nullptr};
   private:
     int sinX;
+    // per-frame automation, the tone and the source as float, for the block being processed
+    std::vector<float> freqs_;
+    std::vector<float> amounts_;
+    std::vector<float> tone_;
+    std::vector<float> block_;
 };
 
 #endif // TONEEFFECT_H
@@ -21,16 +21,18 @@
 #include <QLabel>
 #include <QtMath>
 #include <stdint.h>
-#include <mediahandling/gsl-lite.hpp>
 
 #include "ui/labelslider.h"
 #include "ui/collapsiblewidget.h"
+#include "playback/mixkernels.h"
 
 constexpr auto VOLUME_MIN = -120.0;
 constexpr auto VOLUME_MAX = 10;
 constexpr auto VOLUME_DEFAULT = 0;
 constexpr auto VOLUME_SUFFIX = " dB";
 constexpr auto VOLUME_STEP = 0.1;
+// interleaved 16-bit, of any number of channels
+constexpr size_t SAMPLE_BYTES = sizeof(int16_t);
 
 VolumeEffect::VolumeEffect(ClipPtr c, const EffectMeta& em) : Effect(c, em)
 {
@@ -51,43 +53,23 @@ void VolumeEffect::process_audio(const double timecode_start,
                                  const double timecode_end,
                                  quint8* samples,
                                  const int nb_bytes,
-                                 const int /*channel_count*/)
+                                 const int channel_count)
 {
-  if (nb_bytes <= 0) {
+  if ( (nb_bytes <= 0) || (channel_count <= 0) ) {
     return;
   }
   Q_ASSERT(volume_val);
 
-  const double interval = (timecode_end - timecode_start) / nb_bytes;
-  for (size_t i = 0; i < nb_bytes; i += 4) {
-    const auto vol_val = decibelToPowerRatio(volume_val->get_double_value(timecode_start + (interval * i), true));
+  const auto channels = static_cast<size_t>(channel_count);
+  const auto frames = static_cast<size_t>(nb_bytes) / (SAMPLE_BYTES * channels);
+  gains_.resize(frames);
+  volume_val->get_double_values(timecode_start, timecode_end, gains_, decibelToPowerRatio);
 
-    gsl::span<quint8> samps(samples, static_cast<size_t>(nb_bytes));
-    qint32 right_samp = static_cast<qint16> (((samps.at(i + 3) & 0xFF) << 8) | (samps.at(i + 2) & 0xFF));
-    qint32 left_samp = static_cast<qint16> (((samps.at(i + 1) & 0xFF) << 8) | (samps.at(i) & 0xFF));
-
-    // Adjust amplitude
-    left_samp = lround(left_samp * vol_val);
-    right_samp = lround (right_samp * vol_val);
-
-    // Clamping
-    if (left_samp > INT16_MAX) {
-      left_samp = INT16_MAX;
-    } else if (left_samp < INT16_MIN) {
-      left_samp = INT16_MIN;
-    }
-
-    if (right_samp > INT16_MAX) {
-      right_samp = INT16_MAX;
-    } else if (right_samp < INT16_MIN) {
-      right_samp = INT16_MIN;
-    }
-
-    samps[i+3] = static_cast<quint8> (right_samp >> 8);
-    samps[i+2] = static_cast<quint8> (right_samp);
-    samps[i+1] = static_cast<quint8> (left_samp >> 8);
-    samps[i] = static_cast<quint8> (left_samp);
-  }
+  auto s16 = reinterpret_cast<int16_t*>(samples);
+  block_.resize(frames * channels);
+  chestnut::playback::kernel::fromS16(s16, block_.data(), block_.size());
+  chestnut::playback::kernel::applyFrameGains(block_.data(), gains_.data(), channel_count, frames);
+  chestnut::playback::kernel::toS16(block_.data(), s16, block_.size());
 }
 
 void VolumeEffect::setupUi()
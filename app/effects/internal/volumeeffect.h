@@ -18,6 +18,8 @@
 #ifndef VOLUMEEFFECT_H
 #define VOLUMEEFFECT_H
 
+#include <vector>
+
 #include "project/effect.h"
 
 class VolumeEffect : public Effect {
@@ -40,6 +42,9 @@ class VolumeEffect : public Effect {
 
   private:
     EffectField* volume_val {nullptr};
+    // per-frame gain and the samples as float, for the block being processed
+    std::vector<float> gains_;
+    std::vector<float> block_;
 };
 
 #endif // VOLUMEEFFECT_H
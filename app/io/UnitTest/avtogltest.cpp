@@ -0,0 +1,158 @@
+#include "avtogltest.h"
+#include <QtTest>
+
+#include "io/avtogl.h"
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+
+namespace
+{
+  constexpr float TOLERANCE = 0.01f;
+
+  // apply the conversion as the shader does, to sample codes of a texture of max value container_max
+  std::array<float, 3> toRgb(const YuvCoefficients& coeffs, const int y, const int u, const int v,
+                             const float container_max)
+  {
+    const std::array<float, 3> yuv {(y / container_max * coeffs.scale_) - coeffs.offset_.at(0),
+                                    (u / container_max * coeffs.scale_) - coeffs.offset_.at(1),
+                                    (v / container_max * coeffs.scale_) - coeffs.offset_.at(2)};
+    std::array<float, 3> rgb {};
+    for (size_t row = 0; row < rgb.size(); ++row) {
+      for (size_t col = 0; col < yuv.size(); ++col) {
+        rgb.at(row) += coeffs.matrix_.at(row * 3 + col) * yuv.at(col);
+      }
+    }
+    return rgb;
+  }
+
+  // apply the conversion as the export shader does, giving sample codes of a texture of max value container_max
+  std::array<float, 3> toYuv(const RgbCoefficients& coeffs, const float r, const float g, const float b,
+                             const float container_max)
+  {
+    const std::array<float, 3> rgb {r, g, b};
+    std::array<float, 3> yuv {};
+    for (size_t row = 0; row < yuv.size(); ++row) {
+      yuv.at(row) = coeffs.offset_.at(row);
+      for (size_t col = 0; col < rgb.size(); ++col) {
+        yuv.at(row) += coeffs.matrix_.at(row * 3 + col) * rgb.at(col);
+      }
+      yuv.at(row) *= container_max;
+    }
+    return yuv;
+  }
+
+  bool near(const std::array<float, 3>& rgb, const float r, const float g, const float b)
+  {
+    return (qAbs(rgb.at(0) - r) < TOLERANCE) && (qAbs(rgb.at(1) - g) < TOLERANCE) && (qAbs(rgb.at(2) - b) < TOLERANCE);
+  }
+}
+
+AvToGlTest::AvToGlTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void AvToGlTest::testCaseYuvFormats()
+{
+  QVERIFY(is_gl_yuv_format(AV_PIX_FMT_YUV420P));
+  QVERIFY(is_gl_yuv_format(AV_PIX_FMT_YUV422P10));
+  QVERIFY(is_gl_yuv_format(AV_PIX_FMT_YUVJ444P));
+  QVERIFY(!is_gl_yuv_format(AV_PIX_FMT_RGB24));
+  QVERIFY(!is_gl_yuv_format(AV_PIX_FMT_NV12));
+  QVERIFY(!is_gl_yuv_format(AV_PIX_FMT_NONE));
+}
+
+
+void AvToGlTest::testCasePlaneFormats()
+{
+  QCOMPARE(get_gl_plane_tex_fmt_from_av(AV_PIX_FMT_YUV420P), QOpenGLTexture::R8_UNorm);
+  QCOMPARE(get_gl_plane_pix_type_from_av(AV_PIX_FMT_YUV420P), QOpenGLTexture::UInt8);
+  QCOMPARE(get_gl_plane_tex_fmt_from_av(AV_PIX_FMT_YUV420P10), QOpenGLTexture::R16_UNorm);
+  QCOMPARE(get_gl_plane_pix_type_from_av(AV_PIX_FMT_YUV420P10), QOpenGLTexture::UInt16);
+}
+
+
+void AvToGlTest::testCaseLimitedRange()
+{
+  const auto coeffs = get_yuv_coefficients(AV_PIX_FMT_YUV420P, AVCOL_SPC_BT709, AVCOL_RANGE_MPEG, 1080);
+  QVERIFY(near(toRgb(coeffs, 16, 128, 128, 255), 0, 0, 0));
+  QVERIFY(near(toRgb(coeffs, 235, 128, 128, 255), 1, 1, 1));
+  // BT.709 100% red
+  QVERIFY(near(toRgb(coeffs, 63, 102, 240, 255), 1, 0, 0));
+}
+
+
+void AvToGlTest::testCaseFullRange()
+{
+  const auto coeffs = get_yuv_coefficients(AV_PIX_FMT_YUVJ420P, AVCOL_SPC_BT470BG, AVCOL_RANGE_UNSPECIFIED, 480);
+  QVERIFY(near(toRgb(coeffs, 0, 128, 128, 255), 0, 0, 0));
+  QVERIFY(near(toRgb(coeffs, 255, 128, 128, 255), 1, 1, 1));
+  // BT.601 full-range blue
+  QVERIFY(near(toRgb(coeffs, 29, 255, 107, 255), 0, 0, 1));
+}
+
+
+void AvToGlTest::testCaseTenBit()
+{
+  const auto coeffs = get_yuv_coefficients(AV_PIX_FMT_YUV422P10, AVCOL_SPC_BT709, AVCOL_RANGE_MPEG, 2160);
+  QVERIFY(coeffs.scale_ > 64.0f);
+  // samples sit in the low bits of 16-bit textures
+  QVERIFY(near(toRgb(coeffs, 64, 512, 512, 65535), 0, 0, 0));
+  QVERIFY(near(toRgb(coeffs, 940, 512, 512, 65535), 1, 1, 1));
+}
+
+
+void AvToGlTest::testCaseUnspecifiedMatrix()
+{
+  const auto sd = get_yuv_coefficients(AV_PIX_FMT_YUV420P, AVCOL_SPC_UNSPECIFIED, AVCOL_RANGE_MPEG, 576);
+  const auto bt601 = get_yuv_coefficients(AV_PIX_FMT_YUV420P, AVCOL_SPC_SMPTE170M, AVCOL_RANGE_MPEG, 576);
+  const auto hd = get_yuv_coefficients(AV_PIX_FMT_YUV420P, AVCOL_SPC_UNSPECIFIED, AVCOL_RANGE_MPEG, 1080);
+  const auto bt709 = get_yuv_coefficients(AV_PIX_FMT_YUV420P, AVCOL_SPC_BT709, AVCOL_RANGE_MPEG, 576);
+  QVERIFY(sd.matrix_ == bt601.matrix_);
+  QVERIFY(hd.matrix_ == bt709.matrix_);
+}
+
+
+void AvToGlTest::testCaseRgbToYuv()
+{
+  const auto coeffs = get_rgb_coefficients(AV_PIX_FMT_YUV420P, AVCOL_SPC_BT709, AVCOL_RANGE_MPEG, 1080);
+  constexpr float CODE_TOLERANCE = 0.5f;
+  const auto codes = [&] (const std::array<float, 3>& yuv, const float y, const float u, const float v) {
+    return (qAbs(yuv.at(0) - y) < CODE_TOLERANCE) && (qAbs(yuv.at(1) - u) < CODE_TOLERANCE)
+        && (qAbs(yuv.at(2) - v) < CODE_TOLERANCE);
+  };
+  QVERIFY(codes(toYuv(coeffs, 0, 0, 0, 255), 16, 128, 128));
+  QVERIFY(codes(toYuv(coeffs, 1, 1, 1, 255), 235, 128, 128));
+  // BT.709 100% red
+  QVERIFY(codes(toYuv(coeffs, 1, 0, 0, 255), 63, 102, 240));
+
+  // in the low bits of 16-bit textures
+  const auto ten_bit = get_rgb_coefficients(AV_PIX_FMT_YUV422P10, AVCOL_SPC_BT709, AVCOL_RANGE_MPEG, 1080);
+  QVERIFY(codes(toYuv(ten_bit, 0, 0, 0, 65535), 64, 512, 512));
+  QVERIFY(codes(toYuv(ten_bit, 1, 1, 1, 65535), 940, 512, 512));
+}
+
+
+void AvToGlTest::testCaseRgbRoundTrip()
+{
+  // encoded on export as footage of the format is decoded
+  const std::array<int, 3> formats {AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P10, AV_PIX_FMT_NV12};
+  for (const auto format : formats) {
+    for (const auto height : {480, 1080}) {
+      const auto to_yuv = get_rgb_coefficients(format, AVCOL_SPC_UNSPECIFIED, AVCOL_RANGE_UNSPECIFIED, height);
+      const auto to_rgb = get_yuv_coefficients(format, AVCOL_SPC_UNSPECIFIED, AVCOL_RANGE_UNSPECIFIED, height);
+      // as sampled, normalised to the texture's type
+      const auto yuv = toYuv(to_yuv, 0.2f, 0.5f, 0.9f, 1.0f);
+      std::array<float, 3> back {};
+      for (size_t row = 0; row < back.size(); ++row) {
+        for (size_t col = 0; col < yuv.size(); ++col) {
+          back.at(row) += to_rgb.matrix_.at(row * 3 + col) * ((yuv.at(col) * to_rgb.scale_) - to_rgb.offset_.at(col));
+        }
+      }
+      QVERIFY(near(back, 0.2f, 0.5f, 0.9f));
+    }
+  }
+}
@@ -0,0 +1,26 @@
+#ifndef AVTOGLTEST_H
+#define AVTOGLTEST_H
+
+#include <QObject>
+
+class AvToGlTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit AvToGlTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseYuvFormats();
+    void testCasePlaneFormats();
+    void testCaseLimitedRange();
+    void testCaseFullRange();
+    void testCaseTenBit();
+    void testCaseUnspecifiedMatrix();
+    void testCaseRgbToYuv();
+    void testCaseRgbRoundTrip();
+
+};
+
+#endif // AVTOGLTEST_H
@@ -0,0 +1,176 @@
+#include "exportpipelinetest.h"
+#include <QtTest>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "io/exportpipeline.h"
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+using chestnut::io::StageClock;
+using chestnut::io::StageQueue;
+using chestnut::io::segmentIndex;
+using chestnut::io::segmentLength;
+using chestnut::io::segmentWorkers;
+
+ExportPipelineTest::ExportPipelineTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void ExportPipelineTest::testCaseOrder()
+{
+  StageQueue<std::unique_ptr<int>> queue(4);
+  constexpr int count = 1000;
+  // through a queue far smaller than what passes through it, so both ends wait on the other
+  std::thread producer([&] {
+    for (int i = 0; i < count; ++i) {
+      queue.push(std::make_unique<int>(i));
+    }
+    queue.close();
+  });
+  std::unique_ptr<int> item;
+  int expected = 0;
+  while (queue.pop(item)) {
+    QCOMPARE(*item, expected++);
+  }
+  producer.join();
+  QCOMPARE(expected, count);
+}
+
+
+void ExportPipelineTest::testCaseBounded()
+{
+  StageQueue<int> queue(2);
+  QVERIFY(queue.push(1));
+  QVERIFY(queue.push(2));
+  std::atomic_bool pushed {false};
+  std::thread producer([&] {
+    queue.push(3);
+    pushed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  // held until there is space
+  QVERIFY(!pushed);
+  QCOMPARE(queue.size(), static_cast<size_t>(2));
+  int item = 0;
+  QVERIFY(queue.pop(item));
+  QCOMPARE(item, 1);
+  producer.join();
+  QVERIFY(pushed);
+  QCOMPARE(queue.size(), static_cast<size_t>(2));
+}
+
+
+void ExportPipelineTest::testCaseClose()
+{
+  StageQueue<int> queue(4);
+  QVERIFY(queue.push(1));
+  queue.close();
+  QVERIFY(!queue.push(2));
+  // what was queued before closing is still taken
+  int item = 0;
+  QVERIFY(queue.pop(item));
+  QCOMPARE(item, 1);
+  QVERIFY(!queue.pop(item));
+}
+
+
+void ExportPipelineTest::testCaseAbort()
+{
+  StageQueue<int> queue(1);
+  QVERIFY(queue.push(1));
+  std::atomic_bool result {true};
+  std::thread producer([&] {
+    result = queue.push(2);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  queue.abort();
+  producer.join();
+  // the waiting stage is released, and nothing is left to take
+  QVERIFY(!result);
+  int item = 0;
+  QVERIFY(!queue.pop(item));
+  QCOMPARE(queue.size(), static_cast<size_t>(0));
+}
+
+
+void ExportPipelineTest::testCaseClock()
+{
+  StageClock clock;
+  QCOMPARE(clock.perFrame(0), 0.0);
+  clock.add(std::chrono::milliseconds(30));
+  clock.add(std::chrono::milliseconds(10));
+  QCOMPARE(clock.perFrame(4), 10.0);
+  {
+    StageClock::Lap lap(clock);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  QVERIFY(clock.perFrame(1) >= 45.0);
+}
+
+
+void ExportPipelineTest::testCaseSegments()
+{
+  // whole GOPs, enough of them to reach the fewest frames
+  QCOMPARE(segmentLength(12, 50), static_cast<int64_t>(60));
+  QCOMPARE(segmentLength(25, 50), static_cast<int64_t>(50));
+  QCOMPARE(segmentLength(250, 50), static_cast<int64_t>(250));
+  QCOMPARE(segmentLength(0, 50), static_cast<int64_t>(50));
+  QCOMPARE(segmentLength(1, 0), static_cast<int64_t>(1));
+
+  constexpr int64_t frame_bytes = 1920 * 1080 * 3 / 2;
+  // the cores, unless the frames held would be too many
+  QCOMPARE(segmentWorkers(8, 50, frame_bytes, frame_bytes * 1000), 8);
+  QCOMPARE(segmentWorkers(8, 250, frame_bytes, frame_bytes * 1000), 4);
+  QCOMPARE(segmentWorkers(8, 2000, frame_bytes, frame_bytes * 1000), 1);
+  QCOMPARE(segmentWorkers(0, 50, frame_bytes, frame_bytes * 1000), 1);
+}
+
+
+void ExportPipelineTest::testCaseSegmentSplitStitch()
+{
+  // 29.97fps, as encoded, into the time-bases mp4, mkv and mpegts streams are given by their muxers
+  const AVRational encoder_base {1001, 30000};
+  constexpr int64_t frames = 300;
+  constexpr int64_t reorder_delay = 2;
+  const auto segment_frames = segmentLength(15, 50);
+  for (const AVRational stream_base : {AVRational{1, 30000}, AVRational{1, 1000}, AVRational{1, 90000}}) {
+    std::vector<std::vector<int64_t>> segments;
+    for (int64_t pts = 0; pts < frames; ++pts) {
+      const auto index = segmentIndex(pts, segment_frames);
+      if (segments.empty() || (index != static_cast<int64_t>(segments.size()) - 1)) {
+        QCOMPARE(index, static_cast<int64_t>(segments.size()));
+        segments.emplace_back();
+      }
+      segments.back().push_back(pts);
+    }
+    QCOMPARE(static_cast<int64_t>(segments.size()), frames / segment_frames);
+    for (const auto& segment : segments) {
+      QCOMPARE(static_cast<int64_t>(segment.size()), segment_frames);
+      // each begins on a GOP of the stream
+      QCOMPARE(segment.front() % 15, static_cast<int64_t>(0));
+    }
+
+    // stitched in order, each packet decoded ahead of its pts by the delay of a fresh encoder for every segment
+    int64_t last_pts = -1;
+    auto last_dts = std::numeric_limits<int64_t>::min();
+    for (const auto& segment : segments) {
+      for (const auto pts : segment) {
+        const auto stream_pts = av_rescale_q(pts, encoder_base, stream_base);
+        const auto stream_dts = av_rescale_q(pts - reorder_delay, encoder_base, stream_base);
+        QVERIFY(stream_pts > last_pts);
+        QVERIFY(stream_dts > last_dts);
+        QVERIFY(stream_dts <= stream_pts);
+        last_pts = stream_pts;
+        last_dts = stream_dts;
+      }
+    }
+    QCOMPARE(last_pts, av_rescale_q(frames - 1, encoder_base, stream_base));
+  }
+}
@@ -0,0 +1,25 @@
+#ifndef EXPORTPIPELINETEST_H
+#define EXPORTPIPELINETEST_H
+
+#include <QObject>
+
+class ExportPipelineTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit ExportPipelineTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseOrder();
+    void testCaseBounded();
+    void testCaseClose();
+    void testCaseAbort();
+    void testCaseClock();
+    void testCaseSegments();
+    void testCaseSegmentSplitStitch();
+
+};
+
+#endif // EXPORTPIPELINETEST_H
@@ -0,0 +1,56 @@
+#include "exportpresetstest.h"
+#include <QtTest>
+#include <set>
+
+#include "io/exportpresets.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+using chestnut::io::exportPresets;
+using chestnut::io::findExportPreset;
+
+ExportPresetsTest::ExportPresetsTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void ExportPresetsTest::testCaseNames()
+{
+  const auto& presets = exportPresets();
+  QVERIFY(!presets.empty());
+  std::set<QString> names;
+  for (const auto& preset : presets) {
+    QVERIFY(!preset.name_.isEmpty());
+    // found by name, so no two alike
+    QVERIFY(names.insert(preset.name_.toLower()).second);
+  }
+}
+
+
+void ExportPresetsTest::testCaseFind()
+{
+  const auto preset = findExportPreset("H264");
+  QVERIFY(preset.has_value());
+  QCOMPARE(preset->name_, QString("h264"));
+  QCOMPARE(preset->video_codec_, static_cast<int>(AV_CODEC_ID_H264));
+  QVERIFY(preset->gop_seconds_ > 0.0);
+}
+
+
+void ExportPresetsTest::testCaseFindUnknown()
+{
+  QVERIFY(!findExportPreset("").has_value());
+  QVERIFY(!findExportPreset("prores").has_value());
+}
+
+
+void ExportPresetsTest::testCaseAudioOnly()
+{
+  const auto preset = findExportPreset("wav");
+  QVERIFY(preset.has_value());
+  QCOMPARE(preset->video_codec_, -1);
+  QCOMPARE(preset->audio_codec_, static_cast<int>(AV_CODEC_ID_PCM_S16LE));
+}
@@ -0,0 +1,22 @@
+#ifndef EXPORTPRESETSTEST_H
+#define EXPORTPRESETSTEST_H
+
+#include <QObject>
+
+class ExportPresetsTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit ExportPresetsTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseNames();
+    void testCaseFind();
+    void testCaseFindUnknown();
+    void testCaseAudioOnly();
+
+};
+
+#endif // EXPORTPRESETSTEST_H
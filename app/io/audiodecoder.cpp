@@ -0,0 +1,185 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "audiodecoder.h"
+
+#include <algorithm>
+#include <array>
+
+#include "debug.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswresample/swresample.h>
+}
+
+using chestnut::io::AudioDecoder;
+
+namespace
+{
+  constexpr auto ERR_LEN = 256;
+}
+
+
+AudioDecoder::~AudioDecoder()
+{
+  av_frame_free(&frame_);
+  av_packet_free(&pkt_);
+  swr_free(&swr_);
+  avcodec_free_context(&dec_);
+  avformat_close_input(&fmt_);
+}
+
+
+bool AudioDecoder::open(const QString& location, const int stream_index, const int64_t channel_layout,
+                        const int sample_rate)
+{
+  Q_ASSERT(fmt_ == nullptr);
+  location_ = location;
+  stream_index_ = stream_index;
+  const auto filename = location.toUtf8();
+  if (failed(avformat_open_input(&fmt_, filename.data(), nullptr, nullptr), "Could not open audio file,", location)
+      || failed(avformat_find_stream_info(fmt_, nullptr), "Could not read audio file,", location)) {
+    return false;
+  }
+  if ( (stream_index < 0) || (static_cast<unsigned int>(stream_index) >= fmt_->nb_streams) ) {
+    qWarning() << "Could not find audio stream, path:" << location << "index:" << stream_index;
+    return false;
+  }
+  // only the packets of the one stream need to be read
+  for (unsigned int i = 0; i < fmt_->nb_streams; ++i) {
+    if (static_cast<int>(i) != stream_index) {
+      fmt_->streams[i]->discard = AVDISCARD_ALL;
+    }
+  }
+  const AVStream* strm = fmt_->streams[stream_index];
+
+  const AVCodec* decoder = avcodec_find_decoder(strm->codecpar->codec_id);
+  dec_ = avcodec_alloc_context3(decoder);
+  if ( (decoder == nullptr) || (dec_ == nullptr) ) {
+    qWarning() << "No audio decoder, path:" << location;
+    return false;
+  }
+  if (failed(avcodec_parameters_to_context(dec_, strm->codecpar), "Could not set up audio decoder,", location)
+      || failed(avcodec_open2(dec_, decoder, nullptr), "Could not open audio decoder,", location)) {
+    return false;
+  }
+  if (dec_->channels <= 0) {
+    qWarning() << "No audio channels, path:" << location;
+    return false;
+  }
+
+  const auto in_layout = (dec_->channel_layout != 0) ? static_cast<int64_t>(dec_->channel_layout)
+                                                      : av_get_default_channel_layout(dec_->channels);
+  const auto out_layout = (channel_layout != 0) ? channel_layout : in_layout;
+  const auto out_rate = (sample_rate > 0) ? sample_rate : dec_->sample_rate;
+  swr_ = swr_alloc_set_opts(nullptr,
+                            out_layout, AV_SAMPLE_FMT_FLT, out_rate,
+                            in_layout, dec_->sample_fmt, dec_->sample_rate,
+                            0, nullptr);
+  if ( (swr_ == nullptr) || failed(swr_init(swr_), "Could not set up audio conversion,", location) ) {
+    return false;
+  }
+  channels_ = av_get_channel_layout_nb_channels(static_cast<uint64_t>(out_layout));
+  pkt_ = av_packet_alloc();
+  frame_ = av_frame_alloc();
+  return (pkt_ != nullptr) && (frame_ != nullptr);
+}
+
+
+bool AudioDecoder::decode(const Sink& sink, const std::atomic_bool& running)
+{
+  Q_ASSERT(swr_ != nullptr);
+  int ret = 0;
+  while (running && ((ret = av_read_frame(fmt_, pkt_)) >= 0)) {
+    if (pkt_->stream_index == stream_index_) {
+      if (avcodec_send_packet(dec_, pkt_) >= 0) {
+        drain(sink);
+      }
+    }
+    av_packet_unref(pkt_);
+  }
+  if (!running) {
+    return false;
+  }
+  if (ret != AVERROR_EOF) {
+    failed(ret, "Audio decode incomplete,", location_);
+    return false;
+  }
+  avcodec_send_packet(dec_, nullptr);
+  drain(sink);
+  // the samples held back by the resampler
+  convert(sink, nullptr, 0, AV_NOPTS_VALUE);
+  return true;
+}
+
+
+bool AudioDecoder::decode(const Sink& sink)
+{
+  const std::atomic_bool running {true};
+  return decode(sink, running);
+}
+
+
+const AVStream* AudioDecoder::stream() const
+{
+  Q_ASSERT(fmt_ != nullptr);
+  return fmt_->streams[stream_index_];
+}
+
+
+int AudioDecoder::channels() const
+{
+  return channels_;
+}
+
+
+bool AudioDecoder::failed(const int ret, const char* msg, const QString& path)
+{
+  if (ret >= 0) {
+    return false;
+  }
+  std::array<char, ERR_LEN> err{};
+  av_strerror(ret, err.data(), ERR_LEN);
+  qWarning() << msg << "path:" << path << "msg =" << err.data();
+  return true;
+}
+
+
+void AudioDecoder::drain(const Sink& sink)
+{
+  while (avcodec_receive_frame(dec_, frame_) >= 0) {
+    convert(sink, const_cast<const uint8_t**>(frame_->extended_data), frame_->nb_samples,
+            frame_->best_effort_timestamp);
+    av_frame_unref(frame_);
+  }
+}
+
+
+void AudioDecoder::convert(const Sink& sink, const uint8_t** input, const int count, const int64_t pts)
+{
+  const int capacity = swr_get_out_samples(swr_, count);
+  if (capacity <= 0) {
+    return;
+  }
+  converted_.resize(static_cast<size_t>(capacity * channels_));
+  auto out = reinterpret_cast<uint8_t*>(converted_.data());
+  if (const int converted = swr_convert(swr_, &out, capacity, input, count); converted > 0) {
+    sink(converted_.data(), converted, pts);
+  }
+}
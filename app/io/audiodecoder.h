@@ -0,0 +1,116 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIODECODER_H
+#define AUDIODECODER_H
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct SwrContext;
+struct AVPacket;
+struct AVFrame;
+struct AVStream;
+
+namespace chestnut::io
+{
+  /**
+   * @brief Decodes the whole of one audio stream of a file into interleaved float samples, for what reads a file
+   *        through once rather than seeking about it as a clip does
+   */
+  class AudioDecoder
+  {
+    public:
+      /**
+       * @brief The samples of a frame once converted
+       * @param samples Interleaved, of the channels converted to
+       * @param frames  Sample frames in samples
+       * @param pts     Of the frame decoded, in the stream's time base, or AV_NOPTS_VALUE for those the resampler held
+       *                back until the end
+       */
+      using Sink = std::function<void(const float* samples, int frames, int64_t pts)>;
+
+      AudioDecoder() = default;
+      ~AudioDecoder();
+
+      AudioDecoder(const AudioDecoder&) = delete;
+      AudioDecoder(const AudioDecoder&&) = delete;
+      AudioDecoder& operator=(const AudioDecoder&) = delete;
+      AudioDecoder& operator=(const AudioDecoder&&) = delete;
+
+      /**
+       * @brief                 Open a stream of a file and the conversion of its samples
+       * @param location        Of the file
+       * @param stream_index    Of the audio stream in the file
+       * @param channel_layout  To convert to, or 0 for the stream's own
+       * @param sample_rate     To convert to, or 0 for the stream's own
+       * @return                true==opened
+       */
+      bool open(const QString& location, const int stream_index, const int64_t channel_layout = 0,
+                const int sample_rate = 0);
+      /**
+       * @brief         Decode the stream from its start to its end. A bad packet costs a gap in the samples rather
+       *                than all of them
+       * @param sink    Given the samples of each frame in turn
+       * @param running Stops the decode once false
+       * @return        true==the end of the stream was reached
+       */
+      bool decode(const Sink& sink, const std::atomic_bool& running);
+      bool decode(const Sink& sink);
+
+      /**
+       * @return The stream opened
+       */
+      const AVStream* stream() const;
+      /**
+       * @return Of the samples given to the sink
+       */
+      int channels() const;
+
+      /**
+       * @brief       Warn of a libav error
+       * @param ret   Returned by a libav function
+       * @param msg   Of what failed
+       * @param path  Of the file it failed on
+       * @return      true==ret is an error
+       */
+      static bool failed(const int ret, const char* msg, const QString& path);
+    private:
+      QString location_;
+      int stream_index_ {-1};
+      int channels_ {0};
+      AVFormatContext* fmt_ {nullptr};
+      AVCodecContext* dec_ {nullptr};
+      SwrContext* swr_ {nullptr};
+      AVPacket* pkt_ {nullptr};
+      AVFrame* frame_ {nullptr};
+      std::vector<float> converted_;
+
+      /**
+       * @brief Convert and hand on the frames the decoder has ready
+       */
+      void drain(const Sink& sink);
+      void convert(const Sink& sink, const uint8_t** input, const int count, const int64_t pts);
+  };
+}
+
+#endif // AUDIODECODER_H
@@ -19,6 +19,34 @@
 
 extern "C" {
 #include <libavutil/avutil.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace
+{
+  constexpr int HD_HEIGHT = 720;
+
+  struct LumaWeights
+  {
+    float kr_;
+    float kb_;
+  };
+
+  LumaWeights luma_weights(const int colorspace, const int height)
+  {
+    switch (colorspace) {
+      case AVCOL_SPC_BT709: return {0.2126f, 0.0722f};
+      case AVCOL_SPC_BT470BG:
+      case AVCOL_SPC_SMPTE170M: return {0.299f, 0.114f};
+      case AVCOL_SPC_BT2020_NCL:
+      case AVCOL_SPC_BT2020_CL: return {0.2627f, 0.0593f};
+      case AVCOL_SPC_SMPTE240M: return {0.212f, 0.087f};
+      case AVCOL_SPC_FCC: return {0.30f, 0.11f};
+      default:
+        // as players do for untagged footage
+        return (height >= HD_HEIGHT) ? LumaWeights{0.2126f, 0.0722f} : LumaWeights{0.299f, 0.114f};
+    }
+  }
 }
 
 enum QOpenGLTexture::PixelFormat get_gl_pix_fmt_from_av(const int format) {
@@ -34,3 +62,91 @@ enum QOpenGLTexture::TextureFormat get_gl_tex_fmt_from_av(const int format) {
     default: return QOpenGLTexture::RGBA8_UNorm;
   }
 }
+
+bool is_gl_yuv_format(const int format) {
+  switch (format) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUV422P:
+    case AV_PIX_FMT_YUV444P:
+    case AV_PIX_FMT_YUVJ420P:
+    case AV_PIX_FMT_YUVJ422P:
+    case AV_PIX_FMT_YUVJ444P:
+    case AV_PIX_FMT_YUV420P10:
+    case AV_PIX_FMT_YUV422P10:
+    case AV_PIX_FMT_YUV444P10:
+    case AV_PIX_FMT_YUV420P12:
+    case AV_PIX_FMT_YUV422P12:
+    case AV_PIX_FMT_YUV444P12:
+      return true;
+    default:
+      return false;
+  }
+}
+
+enum QOpenGLTexture::TextureFormat get_gl_plane_tex_fmt_from_av(const int format) {
+  const auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(format));
+  return ( (desc != nullptr) && (desc->comp[0].depth > 8) ) ? QOpenGLTexture::R16_UNorm : QOpenGLTexture::R8_UNorm;
+}
+
+enum QOpenGLTexture::PixelType get_gl_plane_pix_type_from_av(const int format) {
+  const auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(format));
+  return ( (desc != nullptr) && (desc->comp[0].depth > 8) ) ? QOpenGLTexture::UInt16 : QOpenGLTexture::UInt8;
+}
+
+YuvCoefficients get_yuv_coefficients(const int format, const int colorspace, const int color_range, const int height) {
+  const auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(format));
+  const int depth = (desc != nullptr) ? desc->comp[0].depth : 8;
+  const auto max = static_cast<float>((1 << depth) - 1);
+  const bool full_range = (color_range == AVCOL_RANGE_JPEG) || (format == AV_PIX_FMT_YUVJ420P)
+                          || (format == AV_PIX_FMT_YUVJ422P) || (format == AV_PIX_FMT_YUVJ444P);
+
+  // sampling normalises to the maximum of the texture's type, not of the bit depth
+  const float scale = ((depth > 8) ? 65535.0f : 255.0f) / max;
+  const auto shifted = [depth, max] (const int value) { return static_cast<float>(value << (depth - 8)) / max; };
+  const float black = full_range ? 0.0f : shifted(16);
+  const float luma_range = full_range ? 1.0f : shifted(219);
+  const float chroma_mid = static_cast<float>(1 << (depth - 1)) / max;
+  const float chroma_range = full_range ? 1.0f : shifted(224);
+
+  const auto [kr, kb] = luma_weights(colorspace, height);
+  const float kg = 1.0f - kr - kb;
+  const float y = 1.0f / luma_range;
+  const float c = 1.0f / chroma_range;
+
+  YuvCoefficients coeffs;
+  coeffs.matrix_ = {y, 0.0f,                                 2.0f * (1.0f - kr) * c,
+                    y, -2.0f * kb * (1.0f - kb) / kg * c,    -2.0f * kr * (1.0f - kr) / kg * c,
+                    y, 2.0f * (1.0f - kb) * c,               0.0f};
+  coeffs.offset_ = {black, chroma_mid, chroma_mid};
+  coeffs.scale_ = scale;
+  return coeffs;
+}
+
+RgbCoefficients get_rgb_coefficients(const int format, const int colorspace, const int color_range, const int height) {
+  const auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(format));
+  const int depth = (desc != nullptr) ? desc->comp[0].depth : 8;
+  const auto max = static_cast<float>((1 << depth) - 1);
+  const bool full_range = (color_range == AVCOL_RANGE_JPEG) || (format == AV_PIX_FMT_YUVJ420P)
+                          || (format == AV_PIX_FMT_YUVJ422P) || (format == AV_PIX_FMT_YUVJ444P);
+
+  // written normalised to the maximum of the texture's type, not of the bit depth
+  const float scale = max / ((depth > 8) ? 65535.0f : 255.0f);
+  const auto shifted = [depth, max] (const int value) { return static_cast<float>(value << (depth - 8)) / max; };
+  const float black = full_range ? 0.0f : shifted(16);
+  const float luma_range = full_range ? 1.0f : shifted(219);
+  const float chroma_mid = static_cast<float>(1 << (depth - 1)) / max;
+  const float chroma_range = full_range ? 1.0f : shifted(224);
+
+  const auto [kr, kb] = luma_weights(colorspace, height);
+  const float kg = 1.0f - kr - kb;
+  const float y = luma_range * scale;
+  const float cb = chroma_range / (2.0f * (1.0f - kb)) * scale;
+  const float cr = chroma_range / (2.0f * (1.0f - kr)) * scale;
+
+  RgbCoefficients coeffs;
+  coeffs.matrix_ = {y * kr,           y * kg,   y * kb,
+                    -cb * kr,         -cb * kg, cb * (1.0f - kb),
+                    cr * (1.0f - kr), -cr * kg, -cr * kb};
+  coeffs.offset_ = {black * scale, chroma_mid * scale, chroma_mid * scale};
+  return coeffs;
+}
@@ -19,8 +19,62 @@
 #define AVTOGL_H
 
 #include <QOpenGLTexture>
+#include <array>
 
 enum QOpenGLTexture::PixelFormat get_gl_pix_fmt_from_av(const int format);
 enum QOpenGLTexture::TextureFormat get_gl_tex_fmt_from_av(const int format);
 
+/**
+ * @brief         Identify if frames of a format are uploaded as they are, a texture per plane, and converted to RGB
+ *                in a shader
+ * @param format  AVPixelFormat
+ * @return        true==planar YUV handled by the shader
+ */
+bool is_gl_yuv_format(const int format);
+enum QOpenGLTexture::TextureFormat get_gl_plane_tex_fmt_from_av(const int format);
+enum QOpenGLTexture::PixelType get_gl_plane_pix_type_from_av(const int format);
+
+/**
+ * @brief The conversion of sampled planes to RGB: rgb = matrix * ((yuv * scale) - offset)
+ */
+struct YuvCoefficients
+{
+  // row-major
+  std::array<float, 9> matrix_;
+  std::array<float, 3> offset_;
+  // brings samples of fewer bits than their texture's to 0..1
+  float scale_;
+};
+
+/**
+ * @brief             Obtain the conversion of a frame's planes to RGB
+ * @param format      AVPixelFormat
+ * @param colorspace  AVColorSpace of the frame
+ * @param color_range AVColorRange of the frame
+ * @param height      Of the frame, to guess the matrix when the colorspace is unspecified
+ * @return            coefficients
+ */
+YuvCoefficients get_yuv_coefficients(const int format, const int colorspace, const int color_range, const int height);
+
+/**
+ * @brief The conversion of RGB to the samples of planes: yuv = (matrix * rgb) + offset, each normalised to the maximum
+ *        of its texture's type, as a shader writes them
+ */
+struct RgbCoefficients
+{
+  // row-major
+  std::array<float, 9> matrix_;
+  std::array<float, 3> offset_;
+};
+
+/**
+ * @brief             Obtain the conversion of RGB to a format's planes, the inverse of get_yuv_coefficients()
+ * @param format      AVPixelFormat
+ * @param colorspace  AVColorSpace to encode with
+ * @param color_range AVColorRange to encode with
+ * @param height      Of the frames, to pick the matrix when the colorspace is unspecified
+ * @return            coefficients
+ */
+RgbCoefficients get_rgb_coefficients(const int format, const int colorspace, const int color_range, const int height);
+
 #endif // AVTOGL_H
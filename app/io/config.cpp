@@ -93,6 +93,9 @@ void Config::load(QString path)
     } else if (stream.name() == "RecordingMode") {
       stream.readNext();
       recording_mode = stream.text().toInt();
+    } else if (stream.name() == "SplitRecordingChannels") {
+      stream.readNext();
+      split_recording_channels = (stream.text() == "1");
     } else if (stream.name() == "EnableSeekToImport") {
       stream.readNext();
       enable_seek_to_import = (stream.text() == "1");
@@ -138,6 +141,36 @@ void Config::load(QString path)
     } else if (stream.name() == "UpcomingFrameQueueType") {
       stream.readNext();
       upcoming_queue_type = stream.text().toInt();
+    } else if (stream.name() == "DecoderPoolSize") {
+      stream.readNext();
+      decoder_pool_size = stream.text().toInt();
+    } else if (stream.name() == "FrameCacheSize") {
+      stream.readNext();
+      frame_cache_size = stream.text().toInt();
+    } else if (stream.name() == "ReverseBufferSize") {
+      stream.readNext();
+      reverse_buffer_size = stream.text().toInt();
+    } else if (stream.name() == "DecodeThreads") {
+      stream.readNext();
+      decode_threads = stream.text().toInt();
+    } else if (stream.name() == "UsePboUpload") {
+      stream.readNext();
+      use_pbo_upload = (stream.text() == "1");
+    } else if (stream.name() == "GpuYuvConversion") {
+      stream.readNext();
+      gpu_yuv_conversion = (stream.text() == "1");
+    } else if (stream.name() == "UseProxies") {
+      stream.readNext();
+      use_proxies = (stream.text() == "1");
+    } else if (stream.name() == "ProxyHeight") {
+      stream.readNext();
+      proxy_height = stream.text().toInt();
+    } else if (stream.name() == "ConformAudio") {
+      stream.readNext();
+      conform_audio = (stream.text() == "1");
+    } else if (stream.name() == "PrefetchLength") {
+      stream.readNext();
+      prefetch_length = stream.text().toDouble();
     } else if (stream.name() == "Loop") {
       stream.readNext();
       loop = (stream.text() == "1");
@@ -193,6 +226,7 @@ void Config::save(QString path)
   stream.writeTextElement("EnableDragFilesToTimeline", QString::number(enable_drag_files_to_timeline));
   stream.writeTextElement("AutoscaleByDefault", QString::number(autoscale_by_default));
   stream.writeTextElement("RecordingMode", QString::number(recording_mode));
+  stream.writeTextElement("SplitRecordingChannels", QString::number(split_recording_channels));
   stream.writeTextElement("EnableSeekToImport", QString::number(enable_seek_to_import));
   stream.writeTextElement("AudioScrubbing", QString::number(enable_audio_scrubbing));
   stream.writeTextElement("DropFileOnMediaToReplace", QString::number(drop_on_media_to_replace));
@@ -207,6 +241,16 @@ void Config::save(QString path)
   stream.writeTextElement("PreviousFrameQueueType", QString::number(previous_queue_type));
   stream.writeTextElement("UpcomingFrameQueueSize", QString::number(upcoming_queue_size));
   stream.writeTextElement("UpcomingFrameQueueType", QString::number(upcoming_queue_type));
+  stream.writeTextElement("DecoderPoolSize", QString::number(decoder_pool_size));
+  stream.writeTextElement("FrameCacheSize", QString::number(frame_cache_size));
+  stream.writeTextElement("ReverseBufferSize", QString::number(reverse_buffer_size));
+  stream.writeTextElement("DecodeThreads", QString::number(decode_threads));
+  stream.writeTextElement("UsePboUpload", QString::number(use_pbo_upload));
+  stream.writeTextElement("GpuYuvConversion", QString::number(gpu_yuv_conversion));
+  stream.writeTextElement("UseProxies", QString::number(use_proxies));
+  stream.writeTextElement("ProxyHeight", QString::number(proxy_height));
+  stream.writeTextElement("ConformAudio", QString::number(conform_audio));
+  stream.writeTextElement("PrefetchLength", QString::number(prefetch_length));
   stream.writeTextElement("Loop", QString::number(loop));
   stream.writeTextElement("PauseAtOutPoint", QString::number(pause_at_out_point));
   stream.writeTextElement("SeekAlsoSelects", QString::number(seek_also_selects));
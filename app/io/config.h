@@ -62,6 +62,7 @@ struct Config {
     bool enable_drag_files_to_timeline {true};
     bool autoscale_by_default {false};
     int recording_mode {2};
+    bool split_recording_channels {false};
     bool enable_seek_to_import {false};
     bool enable_audio_scrubbing {true};
     bool drop_on_media_to_replace {true};
@@ -77,6 +78,16 @@ struct Config {
     int previous_queue_type {FRAME_QUEUE_TYPE_FRAMES};
     double upcoming_queue_size {0.5};
     int upcoming_queue_type {FRAME_QUEUE_TYPE_SECONDS};
+    int decoder_pool_size {8};
+    int frame_cache_size {512}; // MiB
+    int reverse_buffer_size {256}; // MiB
+    int decode_threads {0}; // 0 == one per core
+    bool use_pbo_upload {true};
+    bool gpu_yuv_conversion {true};
+    bool use_proxies {false};
+    int proxy_height {540};
+    bool conform_audio {false};
+    double prefetch_length {2.0}; // seconds
     bool loop {false};
     bool pause_at_out_point {true};
     bool seek_also_selects {false};
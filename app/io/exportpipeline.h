@@ -0,0 +1,239 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EXPORTPIPELINE_H
+#define EXPORTPIPELINE_H
+
+#include <QMetaType>
+#include <QMutex>
+#include <QWaitCondition>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+
+namespace chestnut::io
+{
+  /**
+   * @brief Milliseconds per frame spent in each stage of an export, on average. The stages run concurrently, so the
+   *        slowest of them rather than their sum sets the rate of the export
+   */
+  struct ExportStageTimes
+  {
+    // drawing the frame and starting it being read back
+    double render_ {0.0};
+    double audio_ {0.0};
+    double convert_ {0.0};
+    double encode_ {0.0};
+    double mux_ {0.0};
+  };
+
+  /**
+   * @brief A bounded queue between two stages, each on a thread of its own. Pushing waits while it is full and popping
+   *        while it is empty, so the faster stage is held to the pace of the slower
+   */
+  template <typename T>
+  class StageQueue
+  {
+    public:
+      explicit StageQueue(const size_t capacity) : capacity_(std::max(capacity, static_cast<size_t>(1)))
+      {
+
+      }
+
+      StageQueue(const StageQueue&) = delete;
+      StageQueue& operator=(const StageQueue&) = delete;
+
+      /**
+       * @brief       Add an item, waiting for space for it
+       * @param item
+       * @return      false==the queue was closed, and the item dropped
+       */
+      bool push(T item)
+      {
+        QMutexLocker locker(&mutex_);
+        while (!closed_ && (items_.size() >= capacity_)) {
+          not_full_.wait(&mutex_);
+        }
+        if (closed_) {
+          return false;
+        }
+        items_.push_back(std::move(item));
+        not_empty_.wakeOne();
+        return true;
+      }
+
+      /**
+       * @brief       Take the oldest item, waiting for one
+       * @param item  Set to the oldest
+       * @return      false==the queue was closed and is empty
+       */
+      bool pop(T& item)
+      {
+        QMutexLocker locker(&mutex_);
+        while (!closed_ && items_.empty()) {
+          not_empty_.wait(&mutex_);
+        }
+        if (items_.empty()) {
+          return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.wakeOne();
+        return true;
+      }
+
+      /**
+       * @brief Stop taking items. Those already queued can still be popped
+       */
+      void close()
+      {
+        QMutexLocker locker(&mutex_);
+        closed_ = true;
+        not_empty_.wakeAll();
+        not_full_.wakeAll();
+      }
+
+      /**
+       * @brief Stop taking items and drop those queued, to end both stages
+       */
+      void abort()
+      {
+        QMutexLocker locker(&mutex_);
+        closed_ = true;
+        items_.clear();
+        not_empty_.wakeAll();
+        not_full_.wakeAll();
+      }
+
+      size_t size() const
+      {
+        QMutexLocker locker(&mutex_);
+        return items_.size();
+      }
+
+      size_t capacity() const
+      {
+        return capacity_;
+      }
+
+    private:
+      const size_t capacity_;
+      mutable QMutex mutex_;
+      QWaitCondition not_empty_;
+      QWaitCondition not_full_;
+      std::deque<T> items_;
+      bool closed_ {false};
+  };
+
+  /**
+   * @brief Time spent in a stage, added to from whichever thread runs it
+   */
+  class StageClock
+  {
+    public:
+      /**
+       * @brief Adds the time it lives for to a clock
+       */
+      class Lap
+      {
+        public:
+          explicit Lap(StageClock& clock) : clock_(clock), start_(std::chrono::steady_clock::now())
+          {
+
+          }
+
+          ~Lap()
+          {
+            clock_.add(std::chrono::steady_clock::now() - start_);
+          }
+
+          Lap(const Lap&) = delete;
+          Lap& operator=(const Lap&) = delete;
+
+        private:
+          StageClock& clock_;
+          const std::chrono::steady_clock::time_point start_;
+      };
+
+      void add(const std::chrono::nanoseconds elapsed)
+      {
+        nanos_ += elapsed.count();
+      }
+
+      /**
+       * @param frames  Exported so far
+       * @return        Milliseconds per frame
+       */
+      double perFrame(const int64_t frames) const
+      {
+        if (frames <= 0) {
+          return 0.0;
+        }
+        return (static_cast<double>(nanos_) / 1E6) / static_cast<double>(frames);
+      }
+
+    private:
+      std::atomic<int64_t> nanos_ {0};
+  };
+
+  /**
+   * @brief             The frames of each segment of an export encoded apart from the others, as whole GOPs so that
+   *                    each segment begins with a keyframe as the stream would have anyway
+   * @param gop_length  Frames
+   * @param min_frames  Fewest to a segment, so that opening an encoder for each is a small part of encoding it
+   * @return            A multiple of the GOP length
+   */
+  inline int64_t segmentLength(const int64_t gop_length, const int64_t min_frames)
+  {
+    const auto gop = std::max(gop_length, static_cast<int64_t>(1));
+    const auto gops = std::max((min_frames + gop - 1) / gop, static_cast<int64_t>(1));
+    return gops * gop;
+  }
+
+  /**
+   * @brief                 The segment a frame is encoded in
+   * @param pts             Of the frame in the encoders' time-base of 1/frame-rate, so counting frames from the first
+   * @param segment_frames  As segmentLength() gives
+   * @return                Counting from 0
+   */
+  inline int64_t segmentIndex(const int64_t pts, const int64_t segment_frames)
+  {
+    return std::max(pts, static_cast<int64_t>(0)) / std::max(segment_frames, static_cast<int64_t>(1));
+  }
+
+  /**
+   * @brief                 Segments to encode at once. Rendering is in order, so a segment's frames are held while
+   *                        its encoder is behind and as many segments' frames can be held as are encoding at once
+   * @param cores
+   * @param segment_frames
+   * @param frame_bytes     Of a frame as encoded
+   * @param budget_bytes    Of frames held, at most
+   * @return                At least 1
+   */
+  inline int segmentWorkers(const int cores, const int64_t segment_frames, const int64_t frame_bytes,
+                            const int64_t budget_bytes)
+  {
+    const auto segment_bytes = std::max(segment_frames * frame_bytes, static_cast<int64_t>(1));
+    const auto affordable = budget_bytes / segment_bytes;
+    return static_cast<int>(std::max(std::min(static_cast<int64_t>(cores), affordable), static_cast<int64_t>(1)));
+  }
+}
+
+Q_DECLARE_METATYPE(chestnut::io::ExportStageTimes)
+
+#endif // EXPORTPIPELINE_H
@@ -0,0 +1,90 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "exportpresets.h"
+
+#include "coderconstants.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+using chestnut::io::ExportPreset;
+
+namespace
+{
+  ExportPreset h264Preset()
+  {
+    ExportPreset preset;
+    preset.name_ = "h264";
+    preset.description_ = "H.264 at a constant rate factor of 23, with AAC audio";
+    preset.video_codec_ = AV_CODEC_ID_H264;
+    preset.constant_quality_ = true;
+    preset.quality_ = 23;
+    preset.gop_seconds_ = 2.0;
+    preset.b_frames_ = 2;
+    preset.profile_ = H264_HIGH_PROFILE;
+    // high enough for any frame size the sequences can have
+    preset.level_ = "5.1";
+    preset.audio_codec_ = AV_CODEC_ID_AAC;
+    preset.audio_bitrate_ = 256;
+    return preset;
+  }
+
+  ExportPreset mpeg2Preset()
+  {
+    ExportPreset preset;
+    preset.name_ = "mpeg2";
+    preset.description_ = "MPEG-2 video at a constant 25Mbps, with MP2 audio";
+    preset.video_codec_ = AV_CODEC_ID_MPEG2VIDEO;
+    preset.quality_ = 25.0;
+    preset.gop_seconds_ = 0.5;
+    preset.b_frames_ = 2;
+    preset.profile_ = MPEG2_MAIN_PROFILE;
+    preset.level_ = MPEG2_HIGH_LEVEL;
+    preset.audio_codec_ = AV_CODEC_ID_MP2;
+    preset.audio_bitrate_ = 256;
+    return preset;
+  }
+
+  ExportPreset wavPreset()
+  {
+    ExportPreset preset;
+    preset.name_ = "wav";
+    preset.description_ = "16-bit PCM audio only";
+    preset.audio_codec_ = AV_CODEC_ID_PCM_S16LE;
+    return preset;
+  }
+}
+
+
+const std::vector<ExportPreset>& chestnut::io::exportPresets()
+{
+  static const std::vector<ExportPreset> presets {h264Preset(), mpeg2Preset(), wavPreset()};
+  return presets;
+}
+
+
+std::optional<ExportPreset> chestnut::io::findExportPreset(const QString& name)
+{
+  for (const auto& preset : exportPresets()) {
+    if (preset.name_.compare(name, Qt::CaseInsensitive) == 0) {
+      return preset;
+    }
+  }
+  return {};
+}
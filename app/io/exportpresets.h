@@ -0,0 +1,63 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EXPORTPRESETS_H
+#define EXPORTPRESETS_H
+
+#include <QString>
+#include <optional>
+#include <vector>
+
+namespace chestnut::io
+{
+  /**
+   * @brief Encoding settings exported with by name, rather than chosen in the export dialog. The frame size, rate and
+   *        sampling rate are those of the sequence and the container is that of the output file's extension
+   */
+  struct ExportPreset
+  {
+    QString name_;
+    QString description_;
+    // AVCodecID, or -1 for no video
+    int video_codec_ {-1};
+    // a rate factor when true, otherwise a constant bitrate
+    bool constant_quality_ {false};
+    // the rate factor, or megabits per second
+    double quality_ {0.0};
+    // of each closed GOP
+    double gop_seconds_ {0.0};
+    int b_frames_ {0};
+    QString profile_;
+    QString level_;
+    // AVCodecID, or -1 for no audio
+    int audio_codec_ {-1};
+    // kilobits per second
+    int audio_bitrate_ {0};
+  };
+
+  /**
+   * @return The presets, the default first
+   */
+  const std::vector<ExportPreset>& exportPresets();
+  /**
+   * @param name  Of the preset, case-insensitive
+   * @return      Empty if there is none of the name
+   */
+  std::optional<ExportPreset> findExportPreset(const QString& name);
+}
+
+#endif // EXPORTPRESETS_H
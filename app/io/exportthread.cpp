@@ -22,6 +22,9 @@
 #include <QOpenGLFramebufferObject>
 #include <QOpenGLPaintDevice>
 #include <QPainter>
+#include <algorithm>
+#include <functional>
+#include <memory>
 #include <utility>
 #include <thread>
 
@@ -31,14 +34,18 @@
 #include "ui/renderfunctions.h"
 #include "playback/playback.h"
 #include "playback/audio.h"
-#include "dialogs/exportdialog.h"
+#include "playback/audiomixer.h"
+#include "playback/offlineaudiorender.h"
+#include "playback/framepool.h"
 #include "ui/mainwindow.h"
 #include "debug.h"
 #include "coderconstants.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
 #include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
 #include <libswresample/swresample.h>
 #include <libswscale/swscale.h>
 #include <libavcodec/avcodec.h>
@@ -55,12 +62,65 @@ using panels::PanelManager;
 constexpr int WAIT_TIMEOUT_MILLIS = 10000;
 constexpr auto ERR_LEN = 256;
 constexpr auto INTERNAL_PIXEL_FORMAT = AV_PIX_FMT_RGBA;
+// queued between stages. Enough to smooth over a frame that is slow in one of them, bounding the frames in memory
+constexpr size_t FRAMES_IN_FLIGHT = 3;
+constexpr size_t PACKETS_IN_FLIGHT = 64;
+// of a segment encoded apart from the others, at least, so opening its encoder is little of the time spent on it
+constexpr double MIN_SEGMENT_SECONDS = 2.0;
+// of frames held for the segments being encoded, at most
+constexpr int64_t SEGMENT_BUFFER_BYTES = 1536LL * 1024 * 1024;
+
+using chestnut::io::StageClock;
+using chestnut::io::StageQueue;
+using chestnut::playback::FramePool;
 
 namespace  {
-  std::array<char, ERR_LEN> err;
+  // of whichever stage's thread failed
+  thread_local std::array<char, ERR_LEN> err;
   std::pair<double, AVRational> NTSC_24P {23.976, {24000, 1001}};
   std::pair<double, AVRational> NTSC_30P {29.97, {30000, 1001}};
   std::pair<double, AVRational> NTSC_60P {59.94, {60000, 1001}};
+
+  /**
+   * @param format
+   * @return        true==the format's samples span the full range, as those of the JPEG formats do
+   */
+  bool fullRange(const AVPixelFormat format)
+  {
+    switch (format) {
+      case AV_PIX_FMT_YUVJ420P:
+      case AV_PIX_FMT_YUVJ422P:
+      case AV_PIX_FMT_YUVJ444P:
+      case AV_PIX_FMT_YUVJ440P:
+      case AV_PIX_FMT_YUVJ411P:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  /**
+   * @param codec
+   * @param wanted  AV_CH_LAYOUT_*
+   * @return        The wanted layout if the encoder takes it, otherwise stereo or the encoder's first
+   */
+  uint64_t encoderLayout(const AVCodec& codec, const uint64_t wanted)
+  {
+    if (codec.channel_layouts == nullptr) {
+      return wanted;
+    }
+    bool stereo = false;
+    for (auto layout = codec.channel_layouts; *layout != 0; ++layout) {
+      if (*layout == wanted) {
+        return wanted;
+      }
+      stereo = stereo || (*layout == AV_CH_LAYOUT_STEREO);
+    }
+    if (stereo || (codec.channel_layouts[0] == 0)) {
+      return AV_CH_LAYOUT_STEREO;
+    }
+    return codec.channel_layouts[0];
+  }
 }
 
 ExportThread::ExportThread()
@@ -69,41 +129,53 @@ ExportThread::ExportThread()
   surface.create();
 }
 
-bool ExportThread::encode(AVFormatContext* ofmt_ctx,
-                          AVCodecContext* codec_ctx,
-                          AVFrame* frame,
-                          AVPacket* packet,
-                          AVStream* stream,
-                          bool rescale)
+void ExportThread::FrameDeleter::operator()(AVFrame* frame) const
+{
+  av_frame_free(&frame);
+}
+
+void ExportThread::PacketDeleter::operator()(AVPacket* packet) const
+{
+  av_packet_free(&packet);
+}
+
+bool ExportThread::encode(AVCodecContext* codec_ctx, AVFrame* frame, AVStream* stream, bool rescale,
+                          std::vector<PacketPtr>* held)
 {
   auto ret = avcodec_send_frame(codec_ctx, frame);
   if (ret < 0) {
     av_strerror(ret, err.data(), ERR_LEN);
     qCritical() << "Failed to send frame to encoder." << err.data();
-    ed->export_error = tr("failed to send frame to encoder (%1)").arg(err.data());
+    fail(tr("failed to send frame to encoder (%1)").arg(err.data()));
     return false;
   }
 
   while (ret >= 0) {
-    ret = avcodec_receive_packet(codec_ctx, packet);
+    PacketPtr packet(av_packet_alloc());
+    ret = avcodec_receive_packet(codec_ctx, packet.get());
     if (ret == AVERROR(EAGAIN)) {
       return true;
+    } else if (ret == AVERROR_EOF) {
+      // flushed
+      return true;
     } else if (ret < 0) {
-      if (ret != AVERROR_EOF) {
-        av_strerror(ret, err.data(), ERR_LEN);
-        qCritical() << "Failed to receive packet from encoder, code=" << err.data();
-        ed->export_error = tr("failed to receive packet from encoder (%1)").arg(QString::number(ret));
-      }
+      av_strerror(ret, err.data(), ERR_LEN);
+      qCritical() << "Failed to receive packet from encoder, code=" << err.data();
+      fail(tr("failed to receive packet from encoder (%1)").arg(QString::number(ret)));
       return false;
     }
 
     packet->stream_index = stream->index;
     if (rescale) {
-      av_packet_rescale_ts(packet, codec_ctx->time_base, stream->time_base);
+      av_packet_rescale_ts(packet.get(), codec_ctx->time_base, stream->time_base);
     }
 
-    av_interleaved_write_frame(ofmt_ctx, packet);
-    av_packet_unref(packet);
+    if (held != nullptr) {
+      held->push_back(std::move(packet));
+    } else if (!packets_->push(std::move(packet))) {
+      // the export was stopped
+      return false;
+    }
   }
   return true;
 }
@@ -133,13 +205,33 @@ void ExportThread::setupScaler()
               );
 
   Q_ASSERT(sws_ctx);
-  sws_frame = av_frame_alloc();
-  Q_ASSERT(sws_frame);
-  sws_frame->format = vcodec_ctx->pix_fmt;
-  sws_frame->width = video_params_.width_;
-  sws_frame->height = video_params_.height_;
-  av_frame_get_buffer(sws_frame, 0);
 
+  if (vcodec_ctx->colorspace != AVCOL_SPC_UNSPECIFIED) {
+    // the matrix and range the stream is tagged with, as converting as drawn does, for whichever YUV format
+    const auto table = sws_getCoefficients((vcodec_ctx->colorspace == AVCOL_SPC_BT709) ? SWS_CS_ITU709 : SWS_CS_ITU601);
+    const int dst_range = (vcodec_ctx->color_range == AVCOL_RANGE_JPEG) ? 1 : 0;
+    if (sws_setColorspaceDetails(sws_ctx, sws_getCoefficients(SWS_CS_DEFAULT), 1, table, dst_range, 0, 1 << 16,
+                                 1 << 16) < 0) {
+      qWarning() << "Could not set the colorspace to convert to, format =" << av_get_pix_fmt_name(vcodec_ctx->pix_fmt);
+    }
+  }
+}
+
+void ExportThread::setupReadback(RenderThread& renderer)
+{
+  // drawn straight into the encoder's format where the renderer can and nothing is scaled, so only the planes are
+  // read back and nothing is left to convert
+  const bool scaled = (global::sequence->width() != video_params_.width_)
+                      || (global::sequence->height() != video_params_.height_);
+  if (!scaled && renderer.setReadbackFormat(vcodec_ctx->pix_fmt, vcodec_ctx->colorspace, vcodec_ctx->color_range,
+                                            video_params_.width_, video_params_.height_)) {
+    readback_format_ = vcodec_ctx->pix_fmt;
+    qInfo() << "Converting frames as drawn, format =" << av_get_pix_fmt_name(readback_format_);
+    return;
+  }
+  renderer.setReadbackFormat(AV_PIX_FMT_NONE, AVCOL_SPC_UNSPECIFIED, AVCOL_RANGE_UNSPECIFIED);
+  readback_format_ = INTERNAL_PIXEL_FORMAT;
+  setupScaler();
 }
 
 //FIXME: setup is too naive/basic
@@ -157,7 +249,7 @@ bool ExportThread::setupVideo()
   vcodec = avcodec_find_encoder(static_cast<AVCodecID>(video_params_.codec_));
   if (!vcodec) {
     qCritical() << "Could not find video encoder";
-    ed->export_error = tr("could not video encoder for %1").arg(QString::number(video_params_.codec_));
+    error_ = tr("could not video encoder for %1").arg(QString::number(video_params_.codec_));
     return false;
   }
 
@@ -167,36 +259,67 @@ bool ExportThread::setupVideo()
   video_stream->id = 0;
   if (!video_stream) {
     qCritical() << "Could not allocate video stream";
-    ed->export_error = tr("could not allocate video stream");
+    error_ = tr("could not allocate video stream");
+    return false;
+  }
+
+  QString error;
+  vcodec_ctx = openVideoEncoder(static_cast<int>(std::thread::hardware_concurrency()), video_stream, error);
+  if (vcodec_ctx == nullptr) {
+    error_ = error;
+    return false;
+  }
+  video_stream->time_base = vcodec_ctx->time_base;
+
+  // copy video encoder parameters to output stream
+  const auto ret = avcodec_parameters_from_context(video_stream->codecpar, vcodec_ctx);
+  if (ret < 0) {
+    av_strerror(ret, err.data(), ERR_LEN);
+    qCritical() << "Could not copy video encoder parameters to output stream, code=" << err.data();
+    error_ = tr("could not copy video encoder parameters to output stream (%1)").arg(QString::number(ret));
     return false;
   }
 
+  return true;
+}
+
+AVCodecContext* ExportThread::openVideoEncoder(const int threads, AVStream* stream, QString& error)
+{
+  Q_ASSERT(vcodec);
   // allocate context
-  vcodec_ctx = avcodec_alloc_context3(vcodec);
-  if (!vcodec_ctx) {
+  auto ctx = avcodec_alloc_context3(vcodec);
+  if (!ctx) {
     qCritical() << "Could not allocate video encoding context";
-    ed->export_error = tr("could not allocate video encoding context");
-    return false;
+    error = tr("could not allocate video encoding context");
+    return nullptr;
   }
 
   // setup context
-  vcodec_ctx->codec_id = static_cast<AVCodecID>(video_params_.codec_);
-  vcodec_ctx->codec_type = AVMEDIA_TYPE_VIDEO;
-  vcodec_ctx->width = video_params_.width_;
-  vcodec_ctx->height = video_params_.height_;
-  vcodec_ctx->pix_fmt = vcodec->pix_fmts[0]; // maybe be breakable code
-  setupFrameRate(*vcodec_ctx, video_params_.frame_rate_);
+  ctx->codec_id = static_cast<AVCodecID>(video_params_.codec_);
+  ctx->codec_type = AVMEDIA_TYPE_VIDEO;
+  ctx->width = video_params_.width_;
+  ctx->height = video_params_.height_;
+  ctx->pix_fmt = vcodec->pix_fmts[0]; // maybe be breakable code
+  const auto pix_desc = av_pix_fmt_desc_get(ctx->pix_fmt);
+  if ( (pix_desc != nullptr) && ((pix_desc->flags & AV_PIX_FMT_FLAG_RGB) == 0) ) {
+    // as untagged footage is taken to be on import. the frames are converted to match
+    const bool hd = video_params_.height_ >= 720;
+    ctx->colorspace = hd ? AVCOL_SPC_BT709 : AVCOL_SPC_SMPTE170M;
+    ctx->color_primaries = hd ? AVCOL_PRI_BT709 : AVCOL_PRI_SMPTE170M;
+    ctx->color_trc = hd ? AVCOL_TRC_BT709 : AVCOL_TRC_SMPTE170M;
+    ctx->color_range = fullRange(ctx->pix_fmt) ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+  }
+  setupFrameRate(*ctx, video_params_.frame_rate_);
   if (video_params_.compression_type_ == CompressionType::CBR) {
     const int64_t brate = llround(video_params_.bitrate_ * 1E6);
-    vcodec_ctx->bit_rate = brate;
-    vcodec_ctx->rc_min_rate = brate;
-    vcodec_ctx->rc_max_rate = brate;
+    ctx->bit_rate = brate;
+    ctx->rc_min_rate = brate;
+    ctx->rc_max_rate = brate;
   }
-  vcodec_ctx->time_base = av_inv_q(vcodec_ctx->framerate);
-  video_stream->time_base = vcodec_ctx->time_base;
-  vcodec_ctx->gop_size = video_params_.gop_length_;
-  vcodec_ctx->thread_count = static_cast<int>(std::thread::hardware_concurrency());
-  vcodec_ctx->thread_type = FF_THREAD_SLICE;
+  ctx->time_base = av_inv_q(ctx->framerate);
+  ctx->gop_size = video_params_.gop_length_;
+  ctx->thread_count = threads;
+  ctx->thread_type = FF_THREAD_SLICE;
 
   AVDictionary* opts = nullptr;
   if (video_params_.closed_gop_) {
@@ -207,8 +330,9 @@ bool ExportThread::setupVideo()
     if (ret < 0) {
       av_strerror(ret, err.data(), ERR_LEN);
       qCritical() << "Failed to set closed-gop, code=" << err.data();
-      ed->export_error = tr("Failed to set closed-gop (%1)").arg(err.data());
-      return false;
+      error = tr("Failed to set closed-gop (%1)").arg(err.data());
+      avcodec_free_context(&ctx);
+      return nullptr;
     }
   }
 
@@ -219,69 +343,80 @@ bool ExportThread::setupVideo()
     if (ret < 0) {
       av_strerror(ret, err.data(), ERR_LEN);
       qCritical() << "Failed to set moov atom at start, code=" << err.data();
-      ed->export_error = tr("Failed to set moov atom at start (%1)").arg(err.data());
-      return false;
+      error = tr("Failed to set moov atom at start (%1)").arg(err.data());
+      av_dict_free(&opts);
+      avcodec_free_context(&ctx);
+      return nullptr;
     }
   }
 
   // Do bare minimum before avcodec_open2
-  switch (vcodec_ctx->codec_id) {
+  switch (ctx->codec_id) {
     case AV_CODEC_ID_H264:
-      setupH264Encoder(*vcodec_ctx, video_params_);
+      setupH264Encoder(*ctx, video_params_);
       break;
     case AV_CODEC_ID_MPEG2VIDEO:
-      setupMPEG2Encoder(*vcodec_ctx, *video_stream, video_params_);
+      setupMPEG2Encoder(*ctx, stream, video_params_);
       break;
     case AV_CODEC_ID_DNXHD:
-      setupDNXHDEncoder(*vcodec_ctx, video_params_);
+      setupDNXHDEncoder(*ctx, video_params_);
       break;
     case AV_CODEC_ID_MPEG4:
-      setupMPEG4Encoder(*vcodec_ctx, video_params_);
+      setupMPEG4Encoder(*ctx, video_params_);
     default:
       // Nothing defined for these codecs yet
       break;
   }
 
-  auto ret = avcodec_open2(vcodec_ctx, vcodec, &opts);
+  auto ret = avcodec_open2(ctx, vcodec, &opts);
+  av_dict_free(&opts);
   if (ret < 0) {
     av_strerror(ret, err.data(), ERR_LEN);
     qCritical() << "Could not open output video encoder." << err.data();
-    ed->export_error = tr("could not open output video encoder (%1)").arg(err.data());
-    return false;
+    error = tr("could not open output video encoder (%1)").arg(err.data());
+    avcodec_free_context(&ctx);
+    return nullptr;
   }
 
   if (fmt_ctx->oformat->flags & AVFMT_GLOBALHEADER) {
-    vcodec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
   }
 
-  vcodec_ctx->sample_aspect_ratio = {1, 1};
-  vcodec_ctx->max_b_frames = video_params_.b_frames_;
+  ctx->sample_aspect_ratio = {1, 1};
+  ctx->max_b_frames = video_params_.b_frames_;
+  return ctx;
+}
 
-  // copy video encoder parameters to output stream
-  ret = avcodec_parameters_from_context(video_stream->codecpar, vcodec_ctx);
-  if (ret < 0) {
-    av_strerror(ret, err.data(), ERR_LEN);
-    qCritical() << "Could not copy video encoder parameters to output stream, code=" << err.data();
-    ed->export_error = tr("could not copy video encoder parameters to output stream (%1)").arg(QString::number(ret));
-    return false;
+void ExportThread::setupSegments()
+{
+  segment_frames_ = 0;
+  segment_workers_ = 0;
+  segment_threads_ = 0;
+  // a segment's encoder must start on a keyframe the stream would have had anyway, and hardware encoders gain
+  // nothing from more of them
+  if (!video_params_.closed_gop_ || ((vcodec->capabilities & AV_CODEC_CAP_HARDWARE) != 0)) {
+    return;
   }
-
-  // create AVFrame
-  video_frame = av_frame_alloc();
-  av_frame_make_writable(video_frame);
-  video_frame->format = AV_PIX_FMT_RGBA;
-  video_frame->width = global::sequence->width();
-  video_frame->height = global::sequence->height();
-  av_frame_get_buffer(video_frame, 0);
-
-  av_init_packet(&video_pkt);
-
-  setupScaler();
-
-  return true;
+  const auto cores = static_cast<int>(std::thread::hardware_concurrency());
+  const auto frames = chestnut::io::segmentLength(video_params_.gop_length_,
+                                                  qRound64(video_params_.frame_rate_ * MIN_SEGMENT_SECONDS));
+  const auto frame_bytes = av_image_get_buffer_size(vcodec_ctx->pix_fmt, vcodec_ctx->width, vcodec_ctx->height, 1);
+  const auto workers = chestnut::io::segmentWorkers(cores, frames, frame_bytes, SEGMENT_BUFFER_BYTES);
+  if ( (workers < 2) || ((end_frame - start_frame + 1) < (frames * 2)) ) {
+    qInfo() << "Encoding as one segment, frames per segment =" << frames << "workers =" << workers;
+    return;
+  }
+  segment_frames_ = frames;
+  segment_workers_ = workers;
+  segment_threads_ = std::max(cores / workers, 1);
+  // the video arrives a segment at a time, behind the audio by as many as are encoding at once, so the muxer is
+  // left to wait for it rather than writing the audio ahead
+  fmt_ctx->max_interleave_delta = 0;
+  qInfo() << "Encoding in segments, frames per segment =" << segment_frames_ << "at once =" << segment_workers_
+          << "threads each =" << segment_threads_;
 }
 
-bool ExportThread::setupAudio()
+bool ExportThread::setupAudio(const uint64_t layout)
 {
   // if audio is disabled, no setup necessary
   if (!audio_params_.enabled) {
@@ -292,7 +427,7 @@ bool ExportThread::setupAudio()
   acodec = avcodec_find_encoder(static_cast<AVCodecID>(audio_params_.codec));
   if (!acodec) {
     qCritical() << "Could not find audio encoder";
-    ed->export_error = tr("could not audio encoder for %1").arg(QString::number(audio_params_.codec));
+    error_ = tr("could not audio encoder for %1").arg(QString::number(audio_params_.codec));
     return false;
   }
 
@@ -301,7 +436,7 @@ bool ExportThread::setupAudio()
   audio_stream->id = 1;
   if (!audio_stream) {
     qCritical() << "Could not allocate audio stream";
-    ed->export_error = tr("could not allocate audio stream");
+    error_ = tr("could not allocate audio stream");
     return false;
   }
 
@@ -309,7 +444,7 @@ bool ExportThread::setupAudio()
   acodec_ctx = avcodec_alloc_context3(acodec);
   if (!acodec_ctx) {
     qCritical() << "Could not find allocate audio encoding context";
-    ed->export_error = tr("could not allocate audio encoding context");
+    error_ = tr("could not allocate audio encoding context");
     return false;
   }
 
@@ -317,7 +452,8 @@ bool ExportThread::setupAudio()
   acodec_ctx->codec_id = static_cast<AVCodecID>(audio_params_.codec);
   acodec_ctx->codec_type = AVMEDIA_TYPE_AUDIO;
   acodec_ctx->sample_rate = audio_params_.sampling_rate;
-  acodec_ctx->channel_layout = AV_CH_LAYOUT_STEREO;  // change this to support surround/mono sound in the future (this is what the user sets the output audio to)
+  // downmixed by the resampler where the encoder doesn't take the layout mixed
+  acodec_ctx->channel_layout = encoderLayout(*acodec, layout);
   acodec_ctx->channels = av_get_channel_layout_nb_channels(acodec_ctx->channel_layout);
   acodec_ctx->sample_fmt = acodec->sample_fmts[0];
   acodec_ctx->bit_rate = audio_params_.bitrate * 1000;
@@ -336,7 +472,7 @@ bool ExportThread::setupAudio()
   if (ret < 0) {
     av_strerror(ret, err.data(), ERR_LEN);
     qCritical() << "Could not open output audio encoder, code=" << err.data();
-    ed->export_error = tr("could not open output audio encoder (%1)").arg(QString::number(ret));
+    error_ = tr("could not open output audio encoder (%1)").arg(QString::number(ret));
     return false;
   }
 
@@ -345,7 +481,7 @@ bool ExportThread::setupAudio()
   if (ret < 0) {
     av_strerror(ret, err.data(), ERR_LEN);
     qCritical() << "Could not copy audio encoder parameters to output stream, code=" << err.data();
-    ed->export_error = tr("could not copy audio encoder parameters to output stream (%1)").arg(QString::number(ret));
+    error_ = tr("could not copy audio encoder parameters to output stream (%1)").arg(QString::number(ret));
     return false;
   }
 
@@ -355,8 +491,8 @@ bool ExportThread::setupAudio()
               static_cast<int64_t>(acodec_ctx->channel_layout),
               acodec_ctx->sample_fmt,
               acodec_ctx->sample_rate,
-              global::sequence->audioLayout(),
-              AV_SAMPLE_FMT_S16,
+              static_cast<int64_t>(layout),
+              AV_SAMPLE_FMT_FLT,
               global::sequence->audioFrequency(),
               0,
               nullptr
@@ -366,7 +502,7 @@ bool ExportThread::setupAudio()
   if (ret < 0) {
     av_strerror(ret, err.data(), ERR_LEN);
     qCritical() << "Could not init resample context, code=" << err.data();
-    ed->export_error = tr("cCould not init resample context (%1)").arg(QString::number(ret));
+    error_ = tr("cCould not init resample context (%1)").arg(QString::number(ret));
     return false;
   }
 
@@ -375,15 +511,16 @@ bool ExportThread::setupAudio()
   audio_frame->sample_rate = global::sequence->audioFrequency();
   audio_frame->nb_samples = acodec_ctx->frame_size;
   if (audio_frame->nb_samples == 0) audio_frame->nb_samples = 256; // should possibly be smaller?
-  audio_frame->format = AV_SAMPLE_FMT_S16;
-  audio_frame->channel_layout = AV_CH_LAYOUT_STEREO; // change this to support surround/mono sound in the future (this is whatever format they're held in the internal buffer)
+  // as mixed, converted only for the encoder
+  audio_frame->format = AV_SAMPLE_FMT_FLT;
+  audio_frame->channel_layout = layout;
   audio_frame->channels = av_get_channel_layout_nb_channels(audio_frame->channel_layout);
   av_frame_make_writable(audio_frame);
   ret = av_frame_get_buffer(audio_frame, 0);
   if (ret < 0) {
     av_strerror(ret, err.data(), ERR_LEN);
     qCritical() << "Could not allocate audio buffer, code=" << err.data();
-    ed->export_error = tr("could not allocate audio buffer (%1)").arg(QString::number(ret));
+    error_ = tr("could not allocate audio buffer (%1)").arg(QString::number(ret));
     return false;
   }
   aframe_bytes = av_samples_get_buffer_size(nullptr, audio_frame->channels, audio_frame->nb_samples, static_cast<AVSampleFormat>(audio_frame->format), 0);
@@ -396,8 +533,6 @@ bool ExportThread::setupAudio()
   swr_frame->format = acodec_ctx->sample_fmt;
   av_frame_make_writable(swr_frame);
 
-  av_init_packet(&audio_pkt);
-
   return true;
 }
 
@@ -407,7 +542,7 @@ bool ExportThread::setupContainer()
   if (!fmt_ctx || ret < 0) {
     av_strerror(ret, err.data(), ERR_LEN);
     qCritical() << "Could not create output context, code=" << err.data();
-    ed->export_error = tr("could not create output format context");
+    error_ = tr("could not create output format context");
     return false;
   }
 
@@ -415,7 +550,7 @@ bool ExportThread::setupContainer()
   if (ret < 0) {
     av_strerror(ret, err.data(), ERR_LEN);
     qCritical() << "Could not open output file, code=" << err.data();
-    ed->export_error = tr("could not open output file (%1)").arg(QString::number(ret));
+    error_ = tr("could not open output file (%1)").arg(QString::number(ret));
     return false;
   }
 
@@ -424,23 +559,31 @@ bool ExportThread::setupContainer()
 
 bool ExportThread::setUpContext(RenderThread& rt, Viewer& vwr)
 {
-  if ( (vwr.viewer_widget == nullptr) || (vwr.viewer_widget->context() == nullptr) || (ed == nullptr) ) {
+  if ( (vwr.viewer_widget == nullptr) || (vwr.viewer_widget->context() == nullptr) ) {
     return false;
   }
   auto ctxt = vwr.viewer_widget->context();
 
   QObject::disconnect(&rt, SIGNAL(ready()), vwr.viewer_widget, SLOT(queue_repaint()));
-  QObject::connect(&rt, SIGNAL(ready()), this, SLOT(wake()));
 
   vwr.pause();
   vwr.seek(start_frame);
   vwr.reset_all_audio();
 
-  ctxt->moveToThread(this);
+  return setUpContext(rt, *ctxt);
+}
+
 
-  if (!ctxt->makeCurrent(&surface)) {
+bool ExportThread::setUpContext(RenderThread& rt, QOpenGLContext& ctxt)
+{
+  QObject::connect(&rt, SIGNAL(ready()), this, SLOT(wake()));
+  global::sequence->playhead_ = start_frame;
+
+  ctxt.moveToThread(this);
+
+  if (!ctxt.makeCurrent(&surface)) {
     qCritical() << "Make current failed";
-    ed->export_error = tr("could not make OpenGL context current");
+    error_ = tr("could not make OpenGL context current");
     return false;
   }
   return true;
@@ -453,30 +596,69 @@ void ExportThread::setDownContext(RenderThread& rt, Viewer& vwr) const
     return;
   }
 
-  auto ctxt = vwr.viewer_widget->context();
-  ctxt->doneCurrent();
-  ctxt->moveToThread(QCoreApplication::instance()->thread());
+  setDownContext(rt, *vwr.viewer_widget->context());
   QObject::connect(&rt, SIGNAL(ready()), vwr.viewer_widget, SLOT(queue_repaint()));
 }
 
+
+void ExportThread::setDownContext(RenderThread& rt, QOpenGLContext& ctxt) const
+{
+  ctxt.doneCurrent();
+  ctxt.moveToThread(QCoreApplication::instance()->thread());
+  QObject::disconnect(&rt, SIGNAL(ready()), this, SLOT(wake()));
+}
+
+
+void ExportThread::setRenderer(RenderThread* renderer, QOpenGLContext* share)
+{
+  renderer_ = renderer;
+  share_ctx_ = share;
+  if (share_ctx_ != nullptr) {
+    share_ctx_->moveToThread(this);
+  }
+}
+
+
+const QString& ExportThread::error() const
+{
+  return error_;
+}
+
+
 void ExportThread::run()
 {
-  RenderThread* renderer = PanelManager::sequenceViewer().viewer_widget->get_renderer();
+  // without the viewer when given a renderer, so nothing is shown or drawn for the user
+  const bool headless = (renderer_ != nullptr) && (share_ctx_ != nullptr);
+  RenderThread* renderer = headless ? renderer_ : PanelManager::sequenceViewer().viewer_widget->get_renderer();
   if (renderer == nullptr) {
     qCritical() << "No render thread available";
     return;
   }
   renderer->setAsExporting(true);
 
-  continue_encode_ = setUpContext(*renderer, PanelManager::sequenceViewer());
+  continue_encode_ = headless ? setUpContext(*renderer, *share_ctx_)
+                              : setUpContext(*renderer, PanelManager::sequenceViewer());
+  if (headless && continue_encode_) {
+    // the viewer's renderer already has its context, which the readback format depends on
+    renderer->setShareContext(share_ctx_);
+  }
   continue_encode_ = continue_encode_ && setupContainer();
 
   if (video_params_.enabled && continue_encode_) {
     continue_encode_ = setupVideo();
+    if (continue_encode_) {
+      setupReadback(*renderer);
+      setupSegments();
+    }
   }
 
+  // audio is rendered straight from the clips where possible, rather than through playback in step with the frames.
+  // Playback mixes stereo, whereas the offline render is of the sequence's layout
+  const bool offline_audio = audio_params_.enabled && chestnut::playback::OfflineAudioRender::supports(*global::sequence);
   if (audio_params_.enabled && continue_encode_) {
-    continue_encode_ = setupAudio();
+    const auto sequence_layout = (global::sequence->audioLayout() > 0)
+                                 ? static_cast<uint64_t>(global::sequence->audioLayout()) : AV_CH_LAYOUT_STEREO;
+    continue_encode_ = setupAudio(offline_audio ? sequence_layout : AV_CH_LAYOUT_STEREO);
   }
 
   if (continue_encode_) {
@@ -484,32 +666,58 @@ void ExportThread::run()
     if (ret < 0) {
       av_strerror(ret, err.data(), ERR_LEN);
       qCritical() << "Could not write output file header, code=" << err.data();
-      ed->export_error = tr("could not write output file header (%1)").arg(QString::number(ret));
+      error_ = tr("could not write output file header (%1)").arg(QString::number(ret));
       continue_encode_ = false;
     }
   }
 
 
+  std::unique_ptr<chestnut::playback::OfflineAudioRender> audio_render;
+  if (offline_audio && continue_encode_) {
+    audio_render = std::make_unique<chestnut::playback::OfflineAudioRender>(global::sequence, start_frame, end_frame + 1);
+    audio_render->enableMetering();
+  }
+
   long file_audio_samples = 0;
   qint64 start_time, frame_time, avg_time, eta, total_time = 0;
   long remaining_frames, frame_count = 1;
 
+  if (continue_encode_) {
+    startPipeline();
+  }
+  readbacks_taken_ = renderer->readbacks();
+
   mutex.lock();
 
+  // each frame is rendered here and read back while the next is, then converted, encoded and muxed by the stages after
   while (global::sequence->playhead_ <= end_frame && continue_encode_) {
     start_time = QDateTime::currentMSecsSinceEpoch();
 
-    if (audio_params_.enabled) {
+    if (audio_params_.enabled && (audio_render == nullptr)) {
+      StageClock::Lap lap(clocks_.audio_);
       compose_audio(nullptr, global::sequence, true);
     }
 
+    FramePtr rendered;
     if (video_params_.enabled) {
+      StageClock::Lap lap(clocks_.render_);
+      // a frame of the pool for each in flight, rather than one overwritten by each render
+      rendered.reset(FramePool::instance().acquire(global::sequence->width(), global::sequence->height(),
+                                                   readback_format_));
+      if (rendered == nullptr) {
+        qCritical() << "Failed to allocate frame to render into";
+        fail(tr("could not allocate frame"));
+        break;
+      }
+      // read back with its rows and planes packed
+      av_image_fill_arrays(rendered->data, rendered->linesize, rendered->data[0], readback_format_, rendered->width,
+                           rendered->height, 1);
       do {
-        // TODO optimize by rendering the next frame while encoding the last
-        renderer->start_render(nullptr, global::sequence, false, video_frame->data[0]);
-        continue_encode_ = waitCond.wait(&mutex, WAIT_TIMEOUT_MILLIS);
-        if (!continue_encode_) {
+        // the caller's context is shared with, where not the viewer's which already is
+        renderer->start_render(share_ctx_, global::sequence, false, rendered->data[0]);
+        if (!waitCond.wait(&mutex, WAIT_TIMEOUT_MILLIS)) {
           qCritical() << "Timeout occured waiting for RenderThread";
+          fail(tr("timed out waiting for frame to render"));
           break;
         }
       } while (renderer->did_texture_fail());
@@ -518,32 +726,25 @@ void ExportThread::run()
       }
     }
 
-    // encode last frame while rendering next frame
     double timecode_secs = static_cast<double> (global::sequence->playhead_ - start_frame) / global::sequence->frameRate();
     if (video_params_.enabled) {
-      // change pixel format
-      sws_scale(sws_ctx, video_frame->data, video_frame->linesize, 0, video_frame->height, sws_frame->data, sws_frame->linesize);
-      sws_frame->pts = qRound(timecode_secs/av_q2d(video_stream->time_base));
-
-      // send to encoder
-      continue_encode_ = encode(fmt_ctx, vcodec_ctx, sws_frame, &video_pkt, video_stream, false);
+      // counted in frames, as the encoders' time-base is, rather than in the stream's which the muxer may have changed
+      rendered->pts = qRound64(timecode_secs/av_q2d(vcodec_ctx->time_base));
+      reading_.push_back(std::move(rendered));
+      if (!deliverReadbacks(*renderer)) {
+        break;
+      }
     }
     if (audio_params_.enabled) {
+      StageClock::Lap lap(clocks_.audio_);
       // do we need to encode more audio samples?
       while (continue_encode_ && (file_audio_samples <= (timecode_secs * audio_params_.sampling_rate))) {
-        // copy samples from audio buffer to AVFrame
-        int adjusted_read = audio_ibuffer_read % AUDIO_IBUFFER_SIZE;
-        int copylen = qMin(aframe_bytes, AUDIO_IBUFFER_SIZE - adjusted_read);
-        memcpy(audio_frame->data[0], audio_ibuffer + adjusted_read, static_cast<size_t>(copylen));
-        memset(audio_ibuffer + adjusted_read, 0, static_cast<size_t>(copylen));
-        audio_ibuffer_read += copylen;
-
-        if (copylen < aframe_bytes) {
-          // copy remainder
-          auto remainder_len = static_cast<size_t>(aframe_bytes - copylen);
-          memcpy(audio_frame->data[0] + copylen, audio_ibuffer, remainder_len);
-          memset(audio_ibuffer, 0, remainder_len);
-          audio_ibuffer_read += remainder_len;
+        // take mixed samples into the AVFrame
+        const auto samples = static_cast<size_t>(aframe_bytes) / sizeof(float);
+        if (audio_render != nullptr) {
+          audio_render->render(reinterpret_cast<float*>(audio_frame->data[0]), samples);
+        } else {
+          chestnut::playback::AudioMixer::instance().read(reinterpret_cast<float*>(audio_frame->data[0]), samples);
         }
 
         // convert to export sample format
@@ -551,13 +752,15 @@ void ExportThread::run()
         swr_frame->pts = file_audio_samples;
 
         // send to encoder
-        continue_encode_ = encode(fmt_ctx, acodec_ctx, swr_frame, &audio_pkt, audio_stream, true);
+        if (!encode(acodec_ctx, swr_frame, audio_stream, true)) {
+          break;
+        }
 
         file_audio_samples += swr_frame->nb_samples;
       }
     }
 
-    // encoding stats
+    // encoding stats. The stages overlap, so the time of each frame here is that of the slowest stage
     frame_time = (QDateTime::currentMSecsSinceEpoch() - start_time);
     total_time += frame_time;
     remaining_frames = (end_frame - global::sequence->playhead_);
@@ -565,7 +768,7 @@ void ExportThread::run()
     eta = (remaining_frames * avg_time);
 
     emit progress_changed(qRound((static_cast<double>(global::sequence->playhead_ - start_frame)
-                                  / static_cast<double>(end_frame - start_frame)) * 100), eta);
+                                  / static_cast<double>(end_frame - start_frame)) * 100), eta, stageTimes(frame_count));
     global::sequence->playhead_++;
     frame_count++;
   }
@@ -573,17 +776,13 @@ void ExportThread::run()
 
   mutex.unlock();
 
-  if (continue_encode_) {
-    if (video_params_.enabled) {
-      vpkt_alloc = true;
-    }
-
-    if (audio_params_.enabled) {
-      apkt_alloc = true;
-    }
+  if (video_params_.enabled) {
+    finishReadbacks(*renderer);
   }
 
-  MainWindow::instance().set_rendering_state(false);
+  if (!headless) {
+    MainWindow::instance().set_rendering_state(false);
+  }
 
   if (audio_params_.enabled && continue_encode_) {
     // flush swresample
@@ -593,51 +792,49 @@ void ExportThread::run()
         break;
       }
       swr_frame->pts = file_audio_samples;
-      continue_encode_ = encode(fmt_ctx, acodec_ctx, swr_frame, &audio_pkt, audio_stream, true);
+      if (!encode(acodec_ctx, swr_frame, audio_stream, true)) {
+        break;
+      }
       file_audio_samples += swr_frame->nb_samples;
     } while (swr_frame->nb_samples > 0);
-  }
 
-  bool continueVideo = true;
-  bool continueAudio = true;
-  if (continue_encode_) {
-    // flush remaining packets
-    while (continueVideo && continueAudio) {
-      if (continueVideo && video_params_.enabled) {
-        continueVideo = encode(fmt_ctx, vcodec_ctx, nullptr, &video_pkt, video_stream, false);
-      }
-      if (continueAudio && audio_params_.enabled) {
-        continueAudio = encode(fmt_ctx, acodec_ctx, nullptr, &audio_pkt, audio_stream, true);
-      }
+    // flush remaining packets. The video encoder is flushed by its stage, once it has the last frame
+    if (continue_encode_) {
+      encode(acodec_ctx, nullptr, audio_stream, true);
     }
+  }
+
+  // the video stages are drained and the muxer has every packet before the trailer
+  finishPipeline();
 
+  if (continue_encode_) {
     auto ret = av_write_trailer(fmt_ctx);
     if (ret < 0) {
       av_strerror(ret, err.data(), ERR_LEN);
       qCritical() << "Could not write output file trailer, code=" << err.data();
-      ed->export_error = tr("could not write output file trailer (%1)").arg(QString::number(ret));
+      error_ = tr("could not write output file trailer (%1)").arg(QString::number(ret));
       continue_encode_ = false;
     }
 
-    emit progress_changed(100, 0);
+    const auto times = stageTimes(frame_count - 1);
+    emit progress_changed(100, 0, times);
+
+    qInfo() << "Exported, ms per frame: render =" << times.render_ << "audio =" << times.audio_
+            << "convert =" << times.convert_ << "encode =" << times.encode_ << "mux =" << times.mux_;
+    if ( (audio_render != nullptr) && (audio_render->meter() != nullptr) ) {
+      const auto levels = audio_render->meter()->levels();
+      qInfo() << "Exported audio, integrated loudness (LUFS) =" << levels.integrated_
+              << "true peak =" << *std::max_element(levels.true_peak_.begin(), levels.true_peak_.end());
+    }
   }
 
   avio_closep(&fmt_ctx->pb);
 
-  if (vpkt_alloc) {
-    av_packet_unref(&video_pkt);
-  }
-  if (video_frame != nullptr) {
-    av_frame_free(&video_frame);
-  }
   if (vcodec_ctx != nullptr) {
     avcodec_close(vcodec_ctx);
     avcodec_free_context(&vcodec_ctx);
   }
 
-  if (apkt_alloc) {
-    av_packet_unref(&audio_pkt);
-  }
   if (audio_frame != nullptr) {
     av_frame_free(&audio_frame);
   }
@@ -650,17 +847,300 @@ void ExportThread::run()
 
   if (sws_ctx != nullptr) {
     sws_freeContext(sws_ctx);
-    av_frame_free(&sws_frame);
   }
   if (swr_ctx != nullptr) {
     swr_free(&swr_ctx);
     av_frame_free(&swr_frame);
   }
 
-  setDownContext(*renderer, PanelManager::sequenceViewer());
+  renderer->setReadbackFormat(AV_PIX_FMT_NONE, AVCOL_SPC_UNSPECIFIED, AVCOL_RANGE_UNSPECIFIED);
+  if (headless) {
+    setDownContext(*renderer, *share_ctx_);
+  } else {
+    setDownContext(*renderer, PanelManager::sequenceViewer());
+  }
   renderer->setAsExporting(false);
 }
 
+
+bool ExportThread::deliverReadbacks(const RenderThread& renderer)
+{
+  const auto read = renderer.readbacks();
+  if (renderer.readbackFailed()) {
+    qCritical() << "Failed to read back frame";
+    fail(tr("could not read back frame"));
+    return false;
+  }
+  while (!reading_.empty() && (readbacks_taken_ < read)) {
+    ++readbacks_taken_;
+    FramePtr frame = std::move(reading_.front());
+    reading_.pop_front();
+    // waits while the stages after are behind
+    if (!rendered_->push(std::move(frame))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+void ExportThread::finishReadbacks(RenderThread& renderer)
+{
+  const auto timeout = QDateTime::currentMSecsSinceEpoch() + WAIT_TIMEOUT_MILLIS;
+  while (continue_encode_ && deliverReadbacks(renderer) && !reading_.empty()) {
+    if (QDateTime::currentMSecsSinceEpoch() > timeout) {
+      qCritical() << "Timeout occured waiting for frames to be read back";
+      fail(tr("timed out waiting for frame to be read back"));
+      break;
+    }
+    msleep(1);
+  }
+  // those left are no longer filled, so can be freed
+  renderer.dropReadbacks();
+  reading_.clear();
+}
+
+
+void ExportThread::startPipeline()
+{
+  rendered_ = std::make_unique<StageQueue<FramePtr>>(FRAMES_IN_FLIGHT);
+  converted_ = std::make_unique<StageQueue<FramePtr>>(FRAMES_IN_FLIGHT);
+  packets_ = std::make_unique<StageQueue<PacketPtr>>(PACKETS_IN_FLIGHT);
+  if (video_params_.enabled) {
+    convert_thread_ = std::thread(&ExportThread::convertFrames, this);
+    encode_thread_ = std::thread((segment_frames_ > 0) ? &ExportThread::encodeSegments : &ExportThread::encodeFrames,
+                                 this);
+  }
+  mux_thread_ = std::thread(&ExportThread::muxPackets, this);
+}
+
+
+void ExportThread::finishPipeline()
+{
+  if (rendered_ == nullptr) {
+    return;
+  }
+  if (!continue_encode_) {
+    abortPipeline();
+  }
+  // each stage closes the queue after it once it has emptied the one before
+  rendered_->close();
+  for (auto thread : {&convert_thread_, &encode_thread_}) {
+    if (thread->joinable()) {
+      thread->join();
+    }
+  }
+  // audio and video packets alike were queued by now
+  packets_->close();
+  if (mux_thread_.joinable()) {
+    mux_thread_.join();
+  }
+  rendered_.reset();
+  converted_.reset();
+  packets_.reset();
+}
+
+
+void ExportThread::abortPipeline()
+{
+  for (auto queue : {rendered_.get(), converted_.get()}) {
+    if (queue != nullptr) {
+      queue->abort();
+    }
+  }
+  if (packets_ != nullptr) {
+    packets_->abort();
+  }
+  QMutexLocker locker(&segments_mutex_);
+  for (auto& segment : segments_) {
+    segment->frames_.abort();
+  }
+}
+
+
+void ExportThread::convertFrames()
+{
+  FramePtr rendered;
+  while (rendered_->pop(rendered)) {
+    if (sws_ctx == nullptr) {
+      // converted as drawn
+      if (!converted_->push(std::move(rendered))) {
+        break;
+      }
+      continue;
+    }
+    FramePtr converted;
+    {
+      StageClock::Lap lap(clocks_.convert_);
+      converted.reset(FramePool::instance().acquire(video_params_.width_, video_params_.height_, vcodec_ctx->pix_fmt));
+      if (converted == nullptr) {
+        qCritical() << "Failed to allocate frame to convert into";
+        fail(tr("could not allocate frame"));
+        break;
+      }
+      // change pixel format
+      sws_scale(sws_ctx, rendered->data, rendered->linesize, 0, rendered->height, converted->data, converted->linesize);
+      converted->pts = rendered->pts;
+    }
+    // back to the pool, to be rendered into again
+    rendered.reset();
+    if (!converted_->push(std::move(converted))) {
+      break;
+    }
+  }
+  converted_->close();
+}
+
+
+void ExportThread::encodeFrames()
+{
+  FramePtr frame;
+  while (converted_->pop(frame)) {
+    StageClock::Lap lap(clocks_.encode_);
+    if (!encode(vcodec_ctx, frame.get(), video_stream, true)) {
+      return;
+    }
+    frame.reset();
+  }
+  if (continue_encode_) {
+    StageClock::Lap lap(clocks_.encode_);
+    encode(vcodec_ctx, nullptr, video_stream, true);
+  }
+}
+
+
+void ExportThread::encodeSegments()
+{
+  Segment* current = nullptr;
+  FramePtr frame;
+  while (converted_->pop(frame)) {
+    const auto index = chestnut::io::segmentIndex(frame->pts, segment_frames_);
+    if ( (current == nullptr) || (index != current->index_) ) {
+      if (current != nullptr) {
+        current->frames_.close();
+      }
+      // no more encoding at once than there are workers for, the oldest finishing first as it started first
+      while (true) {
+        {
+          QMutexLocker locker(&segments_mutex_);
+          if (static_cast<int>(segments_.size()) < segment_workers_) {
+            // its frames are held while its encoder is behind, so the renderer can go on to the next segment's
+            auto segment = std::make_unique<Segment>(static_cast<size_t>(segment_frames_));
+            segment->index_ = index;
+            current = segment.get();
+            segments_.push_back(std::move(segment));
+            break;
+          }
+        }
+        stitchSegment();
+      }
+      current->thread_ = std::thread(&ExportThread::encodeSegment, this, std::ref(*current));
+    }
+    if (!current->frames_.push(std::move(frame))) {
+      break;
+    }
+  }
+  if (current != nullptr) {
+    current->frames_.close();
+  }
+  // each is waited for even if the export was stopped, so none is left running
+  while (stitchSegment()) {}
+}
+
+
+void ExportThread::encodeSegment(Segment& segment)
+{
+  QString error;
+  auto codec_ctx = openVideoEncoder(segment_threads_, nullptr, error);
+  if (codec_ctx == nullptr) {
+    fail(error);
+    return;
+  }
+  FramePtr frame;
+  while (segment.frames_.pop(frame)) {
+    StageClock::Lap lap(clocks_.encode_);
+    if (!encode(codec_ctx, frame.get(), video_stream, true, &segment.packets_)) {
+      break;
+    }
+    frame.reset();
+  }
+  if (continue_encode_) {
+    StageClock::Lap lap(clocks_.encode_);
+    // flushed, so the segment ends with its last GOP complete and the next can follow on from it
+    encode(codec_ctx, nullptr, video_stream, true, &segment.packets_);
+  }
+  avcodec_free_context(&codec_ctx);
+}
+
+
+bool ExportThread::stitchSegment()
+{
+  Segment* oldest = nullptr;
+  {
+    QMutexLocker locker(&segments_mutex_);
+    if (segments_.empty()) {
+      return false;
+    }
+    oldest = segments_.front().get();
+  }
+  if (oldest->thread_.joinable()) {
+    oldest->thread_.join();
+  }
+  // after those of the segment before, so the stream is as though encoded by one encoder. Nothing is re-encoded
+  for (auto& packet : oldest->packets_) {
+    if (!continue_encode_ || !packets_->push(std::move(packet))) {
+      break;
+    }
+  }
+  QMutexLocker locker(&segments_mutex_);
+  segments_.pop_front();
+  return true;
+}
+
+
+void ExportThread::muxPackets()
+{
+  PacketPtr packet;
+  while (packets_->pop(packet)) {
+    StageClock::Lap lap(clocks_.mux_);
+    const auto ret = av_interleaved_write_frame(fmt_ctx, packet.get());
+    if (ret < 0) {
+      av_strerror(ret, err.data(), ERR_LEN);
+      qCritical() << "Failed to write packet, code=" << err.data();
+      fail(tr("could not write to output file (%1)").arg(QString::number(ret)));
+      return;
+    }
+  }
+}
+
+
+void ExportThread::fail(const QString& error)
+{
+  {
+    QMutexLocker locker(&error_mutex_);
+    // the first failure is the cause of any others
+    if (!failed_) {
+      failed_ = true;
+      error_ = error;
+    }
+  }
+  continue_encode_ = false;
+  abortPipeline();
+}
+
+
+chestnut::io::ExportStageTimes ExportThread::stageTimes(const int64_t frames) const
+{
+  chestnut::io::ExportStageTimes times;
+  times.render_ = clocks_.render_.perFrame(frames);
+  times.audio_ = clocks_.audio_.perFrame(frames);
+  times.convert_ = clocks_.convert_.perFrame(frames);
+  // spread between the segments encoding at once
+  times.encode_ = clocks_.encode_.perFrame(frames) / std::max(segment_workers_, 1);
+  times.mux_ = clocks_.mux_.perFrame(frames);
+  return times;
+}
+
 void ExportThread::wake()
 {
   waitCond.wakeAll();
@@ -719,7 +1199,7 @@ void ExportThread::setupH264Encoder(AVCodecContext& ctx, const Params& video_par
 }
 
 
-void ExportThread::setupMPEG2Encoder(AVCodecContext& ctx, AVStream& stream, const Params& video_params) const
+void ExportThread::setupMPEG2Encoder(AVCodecContext& ctx, AVStream* stream, const Params& video_params) const
 {
   const auto brate = qRound(video_params.bitrate_ * 1E6);
   // libav complains when using bits as unit. no documentation on what unit actually is
@@ -727,11 +1207,14 @@ void ExportThread::setupMPEG2Encoder(AVCodecContext& ctx, AVStream& stream, cons
   ctx.rc_max_available_vbv_use = 1.0;
   ctx.rc_min_vbv_overflow_use = 1.0;
 
-  auto props = reinterpret_cast<AVCPBProperties*>(av_stream_new_side_data(&stream, AV_PKT_DATA_CPB_PROPERTIES, NULL));
-  props->avg_bitrate = brate;
-  props->buffer_size = brate;
-  props->max_bitrate = brate;
-  props->min_bitrate = brate;
+  // of the stream, set up once rather than by each segment's encoder
+  if (stream != nullptr) {
+    auto props = reinterpret_cast<AVCPBProperties*>(av_stream_new_side_data(stream, AV_PKT_DATA_CPB_PROPERTIES, NULL));
+    props->avg_bitrate = brate;
+    props->buffer_size = brate;
+    props->max_bitrate = brate;
+    props->min_bitrate = brate;
+  }
 
   if (video_params.profile_ == MPEG2_SIMPLE_PROFILE) {
     ctx.profile = FF_PROFILE_MPEG2_SIMPLE;
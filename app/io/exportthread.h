@@ -22,13 +22,17 @@
 #include <QOffscreenSurface>
 #include <QMutex>
 #include <QWaitCondition>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
 
-
+#include "io/exportpipeline.h"
 #include "ui/renderthread.h"
 #include "panels/viewer.h"
 #include "coderconstants.h"
 
-class ExportDialog;
+class QOpenGLContext;
 struct AVFormatContext;
 struct AVCodecContext;
 struct AVFrame;
@@ -98,36 +102,93 @@ class ExportThread : public QThread {
 
     QOffscreenSurface surface;
 
-    ExportDialog* ed {nullptr};
-
     std::atomic_bool continue_encode_{true};
+
+    /**
+     * @brief           Render with a renderer of the caller's rather than the sequence viewer's, for exporting
+     *                  without the viewer. Both are moved to this thread's use until the export is done
+     * @param renderer  Running, and not drawing for anything else
+     * @param share     Created by the caller, for the renderer's context to share with. Moved to this thread
+     */
+    void setRenderer(RenderThread* renderer, QOpenGLContext* share);
+    /**
+     * @return Why the export failed, if it did
+     */
+    const QString& error() const;
   protected:
     void run() override;
   signals:
-    void progress_changed(int value, qint64 remaining_ms);
+    void progress_changed(int value, qint64 remaining_ms, chestnut::io::ExportStageTimes stage_times);
   public slots:
     void wake();
   private:
-    bool encode(AVFormatContext* ofmt_ctx, AVCodecContext* codec_ctx, AVFrame* frame,
-                AVPacket* packet, AVStream* stream, bool rescale);
+    struct FrameDeleter
+    {
+      void operator()(AVFrame* frame) const;
+    };
+    struct PacketDeleter
+    {
+      void operator()(AVPacket* packet) const;
+    };
+    using FramePtr = std::unique_ptr<AVFrame, FrameDeleter>;
+    using PacketPtr = std::unique_ptr<AVPacket, PacketDeleter>;
+
+    /**
+     * @brief A run of whole GOPs encoded by an encoder of its own, on a thread of its own
+     */
+    struct Segment
+    {
+      explicit Segment(const size_t frames) : frames_(frames) {}
+      // of the segments of the export, counting from the first
+      int64_t index_ {0};
+      chestnut::io::StageQueue<FramePtr> frames_;
+      // held until those of the segments before are muxed
+      std::vector<PacketPtr> packets_;
+      std::thread thread_;
+    };
+
+    /**
+     * @brief           Send a frame to an encoder and queue the packets it gives back for muxing
+     * @param codec_ctx
+     * @param frame     Null to flush the encoder
+     * @param stream    Of the encoder
+     * @param rescale   Packets from the encoder's time-base to the stream's
+     * @param held      Where given, the packets are added to it instead
+     * @return          true==success
+     */
+    bool encode(AVCodecContext* codec_ctx, AVFrame* frame, AVStream* stream, bool rescale,
+                std::vector<PacketPtr>* held = nullptr);
     bool setupVideo();
-    bool setupAudio();
+    /**
+     * @brief         Open a video encoder of the export's parameters
+     * @param threads Of the encoder
+     * @param stream  Of the encoder, given to set up the stream too
+     * @param error   Shown to the user, on failure
+     * @return        Null on failure
+     */
+    AVCodecContext* openVideoEncoder(const int threads, AVStream* stream, QString& error);
+    /**
+     * @brief Split the export into segments encoded at once, where its GOPs are closed and the encoder is the CPU's
+     */
+    void setupSegments();
+    /**
+     * @brief         Open the audio encoder and the conversion to it
+     * @param layout  AV_CH_LAYOUT_* of the mixed samples
+     * @return        true==success
+     */
+    bool setupAudio(const uint64_t layout);
     bool setupContainer();
 
     AVFormatContext* fmt_ctx = nullptr;
     AVStream* video_stream = nullptr;
     AVCodec* vcodec = nullptr;
     AVCodecContext* vcodec_ctx = nullptr;
-    AVFrame* video_frame= nullptr;
-    AVFrame* sws_frame = nullptr;
     SwsContext* sws_ctx = nullptr;
     AVStream* audio_stream = nullptr;
     AVCodec* acodec = nullptr;
     AVFrame* audio_frame = nullptr;
     AVFrame* swr_frame = nullptr;
     AVCodecContext* acodec_ctx = nullptr;
-    AVPacket video_pkt;
-    AVPacket audio_pkt;
     SwrContext* swr_ctx = nullptr;
 
     int aframe_bytes {0};
@@ -135,13 +196,85 @@ class ExportThread : public QThread {
     QMutex mutex;
     QWaitCondition waitCond;
 
-    bool vpkt_alloc = false;
-    bool apkt_alloc = false;
+    // between the stages after rendering, each of which runs on a thread of its own
+    std::unique_ptr<chestnut::io::StageQueue<FramePtr>> rendered_;
+    std::unique_ptr<chestnut::io::StageQueue<FramePtr>> converted_;
+    std::unique_ptr<chestnut::io::StageQueue<PacketPtr>> packets_;
+    std::thread convert_thread_;
+    std::thread encode_thread_;
+    std::thread mux_thread_;
+    struct {
+      chestnut::io::StageClock render_;
+      chestnut::io::StageClock audio_;
+      chestnut::io::StageClock convert_;
+      chestnut::io::StageClock encode_;
+      chestnut::io::StageClock mux_;
+    } clocks_;
+    QMutex error_mutex_;
+    bool failed_ {false};
+    QString error_;
+    // of the caller's, when not the sequence viewer's
+    RenderThread* renderer_ {nullptr};
+    QOpenGLContext* share_ctx_ {nullptr};
+    // rendered frames being read back, oldest first
+    std::deque<FramePtr> reading_;
+    // of the renderer's readbacks, those of frames passed on to be converted
+    uint64_t readbacks_taken_ {0};
+    // of the frames read back
+    AVPixelFormat readback_format_ {AV_PIX_FMT_RGBA};
+    // encoding or waiting to be muxed, oldest first
+    std::deque<std::unique_ptr<Segment>> segments_;
+    QMutex segments_mutex_;
+    // 0==the export is encoded as one
+    int64_t segment_frames_ {0};
+    int segment_workers_ {0};
+    // of each segment's encoder
+    int segment_threads_ {0};
+
+    /**
+     * @brief           Pass the frames read back by now on to be converted
+     * @param renderer
+     * @return          false==the export was stopped
+     */
+    bool deliverReadbacks(const RenderThread& renderer);
+    /**
+     * @brief Wait for the last frames to be read back and pass them on
+     */
+    void finishReadbacks(RenderThread& renderer);
+    void startPipeline();
+    /**
+     * @brief Let the stages finish what was queued and end them or, if the export was stopped, end them at once
+     */
+    void finishPipeline();
+    void abortPipeline();
+    // the stages' loops
+    void convertFrames();
+    void encodeFrames();
+    /**
+     * @brief Hand the frames to segments, starting a segment's encoder with its first frame, and pass each segment's
+     *        packets on to be muxed once it and those before it are done
+     */
+    void encodeSegments();
+    void encodeSegment(Segment& segment);
+    /**
+     * @brief   Wait for the oldest segment to finish and pass its packets on to be muxed
+     * @return  false==there were no segments
+     */
+    bool stitchSegment();
+    void muxPackets();
+    /**
+     * @brief       Stop the export, from whichever stage failed
+     * @param error Shown to the user, unless an earlier failure's is
+     */
+    void fail(const QString& error);
+    chestnut::io::ExportStageTimes stageTimes(const int64_t frames) const;
 
     bool setUpContext(RenderThread& rt, Viewer& vwr);
+    bool setUpContext(RenderThread& rt, QOpenGLContext& ctxt);
     void setDownContext(RenderThread& rt, Viewer& vwr) const;
+    void setDownContext(RenderThread& rt, QOpenGLContext& ctxt) const;
     void setupH264Encoder(AVCodecContext& ctx, const Params& video_params_) const;
-    void setupMPEG2Encoder(AVCodecContext& ctx, AVStream& stream, const Params& video_params_) const;
+    void setupMPEG2Encoder(AVCodecContext& ctx, AVStream* stream, const Params& video_params_) const;
     void setupMPEG4Encoder(AVCodecContext& ctx, const Params& video_params_) const;
     void setupDNXHDEncoder(AVCodecContext& ctx, const Params& video_params_) const;
 
@@ -158,6 +291,12 @@ class ExportThread : public QThread {
 
 
     void setupScaler();
+    /**
+     * @brief           Have frames read back in the encoder's format where they can be, otherwise as RGBA converted
+     *                  by the scaler
+     * @param renderer
+     */
+    void setupReadback(RenderThread& renderer);
 };
 
 #endif // EXPORTTHREAD_H
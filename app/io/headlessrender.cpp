@@ -0,0 +1,272 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "headlessrender.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
+#include <QThread>
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <utility>
+
+#include "io/exportpresets.h"
+#include "io/exportthread.h"
+#include "panels/panelmanager.h"
+#include "panels/project.h"
+#include "playback/audio.h"
+#include "playback/audioscrubber.h"
+#include "playback/offlineaudiorender.h"
+#include "playback/playback.h"
+#include "project/clip.h"
+#include "project/footage.h"
+#include "project/media.h"
+#include "ui/renderthread.h"
+#include "debug.h"
+
+using chestnut::io::HeadlessRender;
+using panels::PanelManager;
+
+namespace
+{
+  // between looking for the footage's previews to be done
+  constexpr unsigned long PREVIEW_POLL_MILLIS = 50;
+}
+
+
+HeadlessRender::HeadlessRender(Options options) : QObject(nullptr), options_(std::move(options))
+{
+
+}
+
+
+bool HeadlessRender::setUpPlatform()
+{
+  if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  const auto platform = qgetenv("QT_QPA_PLATFORM");
+  // the EGL platforms, eglfs and minimalegl, need no window system and are left to succeed or fail on their own
+  const bool glx = platform.startsWith("offscreen") || platform.startsWith("xcb");
+  if (glx && qEnvironmentVariableIsEmpty("DISPLAY")) {
+    std::cerr << "The \"" << platform.constData() << "\" Qt platform needs an X server to create an OpenGL context "
+              << "with, and DISPLAY is not set. Run under Xvfb, e.g. xvfb-run -a, or set QT_QPA_PLATFORM to an EGL "
+              << "platform" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+
+int HeadlessRender::exec()
+{
+  const auto preset = findExportPreset(options_.preset_.isEmpty() ? exportPresets().front().name_ : options_.preset_);
+  if (!preset) {
+    std::cerr << "Unknown preset: " << options_.preset_.toStdString() << ". Presets are:" << std::endl;
+    for (const auto& known : exportPresets()) {
+      std::cerr << "\t" << known.name_.toStdString() << "\t" << known.description_.toStdString() << std::endl;
+    }
+    return EXIT_USAGE;
+  }
+  if (options_.output_.isEmpty()) {
+    std::cerr << "No output file given" << std::endl;
+    return EXIT_USAGE;
+  }
+
+  if (!loadProject()) {
+    std::cerr << "Failed to load project: " << options_.project_.toStdString() << std::endl;
+    return EXIT_PROJECT;
+  }
+  const auto sequence = findSequence();
+  if (sequence == nullptr) {
+    std::cerr << "No sequence named: " << options_.sequence_.toStdString() << ". Sequences are:" << std::endl;
+    for (const auto& item : PanelManager::projectViewer().list_all_project_sequences()) {
+      if (auto sqn = item->object<Sequence>()) {
+        std::cerr << "\t" << sqn->name().toStdString() << std::endl;
+      }
+    }
+    return EXIT_USAGE;
+  }
+  if (!mediaReady(*sequence)) {
+    return EXIT_MEDIA;
+  }
+  return exportSequence(sequence, *preset);
+}
+
+
+void HeadlessRender::printProgress(int value, qint64 remaining_ms,
+                                   const chestnut::io::ExportStageTimes& stage_times) const
+{
+  const std::array<std::pair<const char*, double>, 5> stages {{{"render", stage_times.render_},
+                                                               {"audio", stage_times.audio_},
+                                                               {"convert", stage_times.convert_},
+                                                               {"encode", stage_times.encode_},
+                                                               {"mux", stage_times.mux_}}};
+  const auto slowest = std::max_element(stages.begin(), stages.end(),
+                                        [] (const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; });
+  const auto seconds = remaining_ms / 1000;
+  // a line each, as read from a job's log rather than a terminal
+  std::cout << "Progress: " << value << "% ETA: " << (seconds / 3600) << ":"
+            << QString::number((seconds / 60) % 60).rightJustified(2, '0').toStdString() << ":"
+            << QString::number(seconds % 60).rightJustified(2, '0').toStdString() << " " << slowest->first << ": "
+            << QString::number(slowest->second, 'f', 1).toStdString() << "ms" << std::endl;
+}
+
+
+bool HeadlessRender::loadProject() const
+{
+  const QFileInfo info(options_.project_);
+  if (!info.exists()) {
+    qCritical() << "Project file does not exist, path =" << options_.project_;
+    return false;
+  }
+  // media is found relative to it
+  project_url = info.absoluteFilePath();
+  auto& project = PanelManager::projectViewer();
+  if (!project.read_project(project_url)) {
+    return false;
+  }
+  // the previews are generated on a thread of their own, which reports back through this thread's events
+  project.refresh();
+  while (project.generatingPreviews()) {
+    QCoreApplication::processEvents(QEventLoop::AllEvents, static_cast<int>(PREVIEW_POLL_MILLIS));
+    QThread::msleep(PREVIEW_POLL_MILLIS);
+  }
+  return true;
+}
+
+
+SequencePtr HeadlessRender::findSequence() const
+{
+  if (options_.sequence_.isEmpty()) {
+    // as open when the project was saved
+    return global::sequence;
+  }
+  for (const auto& item : PanelManager::projectViewer().list_all_project_sequences()) {
+    auto sqn = item->object<Sequence>();
+    if ( (sqn != nullptr) && (sqn->name() == options_.sequence_) ) {
+      return sqn;
+    }
+  }
+  return nullptr;
+}
+
+
+bool HeadlessRender::mediaReady(Sequence& sequence) const
+{
+  bool ready = true;
+  for (const auto& clp : sequence.clips()) {
+    if ( (clp == nullptr) || (clp->timeline_info.media == nullptr)
+         || (clp->timeline_info.media->type() != MediaType::FOOTAGE) ) {
+      continue;
+    }
+    const auto ftg = clp->timeline_info.media->object<Footage>();
+    // its clips would be left out of the frames rather than the export failing
+    if ( (ftg != nullptr) && !ftg->ready_ ) {
+      std::cerr << "Media could not be opened: " << ftg->location().toStdString() << std::endl;
+      ready = false;
+    }
+  }
+  return ready;
+}
+
+
+int HeadlessRender::exportSequence(const SequencePtr& sequence, const ExportPreset& preset)
+{
+  Q_ASSERT(sequence);
+  const bool audio = preset.audio_codec_ >= 0;
+  if (audio && !chestnut::playback::OfflineAudioRender::supports(*sequence)) {
+    // nested sequences and reversed clips are mixed by playback, which needs a device to mix for
+    init_audio();
+    if (!is_audio_device_set()) {
+      std::cerr << "The sequence's audio needs an audio device to be mixed, and there is none" << std::endl;
+      return EXIT_EXPORT;
+    }
+  }
+
+  // the renderer's context shares with this one. Of no profile, so compatibility, as the renderer draws with the
+  // fixed-function pipeline
+  QOpenGLContext share;
+  share.setFormat(QSurfaceFormat::defaultFormat());
+  if (!share.create()) {
+    std::cerr << "Could not create an OpenGL context on the \"" << qgetenv("QT_QPA_PLATFORM").constData()
+              << "\" Qt platform. Software rendering can be forced with LIBGL_ALWAYS_SOFTWARE=1" << std::endl;
+    return EXIT_GL;
+  }
+  qInfo() << "Rendering with OpenGL" << share.format().majorVersion() << "." << share.format().minorVersion();
+
+  // created here, as the renderer is drawn for from the viewer's settings and panels are only made on this thread
+  PanelManager::sequenceViewer();
+  global::sequence = sequence;
+
+  RenderThread renderer;
+  renderer.start(QThread::HighPriority);
+
+  ExportThread et;
+  et.filename = options_.output_;
+  et.video_params_.enabled = preset.video_codec_ >= 0;
+  if (et.video_params_.enabled) {
+    et.video_params_.codec_ = preset.video_codec_;
+    et.video_params_.width_ = sequence->width();
+    et.video_params_.height_ = sequence->height();
+    et.video_params_.frame_rate_ = sequence->frameRate();
+    et.video_params_.compression_type_ = preset.constant_quality_ ? CompressionType::CRF : CompressionType::CBR;
+    et.video_params_.bitrate_ = preset.quality_;
+    et.video_params_.gop_length_ = std::max(qRound(sequence->frameRate() * preset.gop_seconds_), 1);
+    et.video_params_.closed_gop_ = true;
+    et.video_params_.b_frames_ = preset.b_frames_;
+    et.video_params_.profile_ = preset.profile_;
+    et.video_params_.level_ = preset.level_;
+  }
+  et.audio_params_.enabled = audio;
+  if (audio) {
+    et.audio_params_.codec = preset.audio_codec_;
+    et.audio_params_.sampling_rate = sequence->audioFrequency();
+    et.audio_params_.bitrate = preset.audio_bitrate_;
+  }
+  et.start_frame = 0;
+  et.end_frame = sequence->endFrame();
+  et.setRenderer(&renderer, &share);
+
+  qRegisterMetaType<chestnut::io::ExportStageTimes>();
+  QObject::connect(&et, &ExportThread::progress_changed, this, &HeadlessRender::printProgress);
+  QEventLoop loop;
+  QObject::connect(&et, &QThread::finished, &loop, &QEventLoop::quit);
+
+  std::cout << "Exporting \"" << sequence->name().toStdString() << "\" to " << options_.output_.toStdString()
+            << " with preset " << preset.name_.toStdString() << std::endl;
+  // clips are opened on their originals rather than proxies while rendering, and their effects run by the export alone
+  chestnut::playback::AudioScrubber::instance().stop();
+  sequence->closeActiveClips();
+  e_rendering = true;
+  et.start();
+  loop.exec();
+  e_rendering = false;
+  sequence->closeActiveClips();
+  renderer.cancel();
+
+  if (!et.continue_encode_) {
+    std::cerr << "Export failed: " << et.error().toStdString() << std::endl;
+    return EXIT_EXPORT;
+  }
+  std::cout << "Exported " << options_.output_.toStdString() << std::endl;
+  return EXIT_OK;
+}
@@ -0,0 +1,100 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef HEADLESSRENDER_H
+#define HEADLESSRENDER_H
+
+#include <QObject>
+#include <QString>
+
+#include "io/exportpipeline.h"
+#include "project/sequence.h"
+
+namespace chestnut::io
+{
+  struct ExportPreset;
+
+  /**
+   * @brief Export a sequence of a project from the command line, with no window shown. The sequence is rendered in
+   *        an offscreen context of its own through the same pipeline as the export dialog's, with progress printed to
+   *        stdout. Software GL, such as Mesa's llvmpipe, suffices. Qt's offscreen and xcb platforms create their GL
+   *        contexts through GLX, so need an X server, which Xvfb provides on a machine without a display
+   */
+  class HeadlessRender : public QObject
+  {
+      Q_OBJECT
+    public:
+      // of the process, for the job running it
+      enum ExitCode
+      {
+        EXIT_OK = 0,
+        EXIT_USAGE = 1,
+        EXIT_PROJECT = 2,
+        EXIT_MEDIA = 3,
+        EXIT_GL = 4,
+        EXIT_EXPORT = 5
+      };
+
+      struct Options
+      {
+        QString project_;
+        // the project's open sequence, where empty
+        QString sequence_;
+        QString output_;
+        QString preset_;
+      };
+
+      explicit HeadlessRender(Options options);
+
+      /**
+       * @brief   Choose the offscreen Qt platform unless one was chosen, and check an X server is there for it to
+       *          create GL contexts with. Before the application is created
+       * @return  true==a context can be created, as far as can be known without one
+       */
+      static bool setUpPlatform();
+
+      HeadlessRender() = delete;
+      HeadlessRender(const HeadlessRender&) = delete;
+      HeadlessRender& operator=(const HeadlessRender&) = delete;
+
+      /**
+       * @brief   Load the project, wait for its media to be ready and export the sequence. The event loop runs meanwhile
+       * @return  ExitCode
+       */
+      int exec();
+
+    private slots:
+      void printProgress(int value, qint64 remaining_ms, const chestnut::io::ExportStageTimes& stage_times) const;
+
+    private:
+      const Options options_;
+
+      bool loadProject() const;
+      /**
+       * @return The sequence named in the options, or null
+       */
+      SequencePtr findSequence() const;
+      /**
+       * @param sequence
+       * @return          true==the footage of each of the sequence's clips can be rendered
+       */
+      bool mediaReady(Sequence& sequence) const;
+      int exportSequence(const SequencePtr& sequence, const ExportPreset& preset);
+  };
+}
+
+#endif // HEADLESSRENDER_H
@@ -17,9 +17,11 @@
  */
 #include "ui/mainwindow.h"
 #include <QApplication>
+#include <array>
 #include <iostream>
 #include <QLoggingCategory>
 
+#include <getopt.h>
 #include <unistd.h>
 
 #include "chestnut.h"
@@ -27,6 +29,8 @@
 #include "project/effect.h"
 #include "panels/panelmanager.h"
 #include "io/path.h"
+#include "io/headlessrender.h"
+#include "io/exportpresets.h"
 #include "database.h"
 
 extern "C" {
@@ -37,15 +41,31 @@ extern "C" {
 constexpr auto APP_NAME = "Chestnut";
 constexpr auto DB_FILENAME = "chestnut.db";
 
+// long options only, so numbered beyond the short
+enum LongOption
+{
+  OPT_RENDER = 256,
+  OPT_SEQUENCE,
+  OPT_OUT,
+  OPT_PRESET
+};
+
 int main(int argc, char *argv[])
 {
   auto launch_fullscreen = false;
   QString load_proj;
+  chestnut::io::HeadlessRender::Options render;
   int c;
 
   av_log_set_level(AV_LOG_PANIC);
 
-  while ((c = getopt(argc, argv, "fhi:l:sv")) != -1)
+  const std::array<option, 5> long_options {{{"render", required_argument, nullptr, OPT_RENDER},
+                                             {"sequence", required_argument, nullptr, OPT_SEQUENCE},
+                                             {"out", required_argument, nullptr, OPT_OUT},
+                                             {"preset", required_argument, nullptr, OPT_PRESET},
+                                             {nullptr, 0, nullptr, 0}}};
+
+  while ((c = getopt_long(argc, argv, "fhi:l:sv", long_options.data(), nullptr)) != -1)
   {
     switch (c) {
       case 'f':
@@ -58,8 +78,22 @@ int main(int argc, char *argv[])
                "\n\t-h \t\tShow this help and exit"
                "\n\t-i <filename> \tLoad a project file"
                "\n\t-l <level> \t\tSet the logging level (fatal, critical, warning, info, debug)"
-               "\n\t-s  \t\tDisable shaders\n\n",
-               argv[0]);
+               "\n\t-s  \t\tDisable shaders"
+               "\n\nRendering without a window:"
+               "\n\t--render <filename> \tExport a sequence of a project file, then exit"
+               "\n\t--sequence <name> \tThe sequence to export, otherwise that open when the project was saved"
+               "\n\t--out <filename> \tThe file exported to. Its extension sets the container"
+               "\n\t--preset <name> \tThe encoding settings exported with (default %s)"
+               "\n\nExit codes: 0 exported, 1 bad arguments, 2 project not loaded, 3 media missing, 4 no OpenGL,"
+               " 5 export failed."
+               "\nThe \"offscreen\" Qt platform is used unless QT_QPA_PLATFORM is set. It creates OpenGL contexts through"
+               "\nGLX, so needs an X server: without a display, run under Xvfb (xvfb-run -a). Software OpenGL suffices"
+               "\n(LIBGL_ALWAYS_SOFTWARE=1 with Mesa).\n\nPresets:\n",
+               argv[0], chestnut::io::exportPresets().front().name_.toUtf8().constData());
+        for (const auto& preset : chestnut::io::exportPresets()) {
+          printf("\t%s \t%s\n", preset.name_.toUtf8().constData(), preset.description_.toUtf8().constData());
+        }
+        printf("\n");
         return 0;
       case 'i':
         // input file to load
@@ -93,6 +127,18 @@ int main(int argc, char *argv[])
         // Disable shader effects
         shaders_are_enabled = false;
         break;
+      case OPT_RENDER:
+        render.project_ = optarg;
+        break;
+      case OPT_SEQUENCE:
+        render.sequence_ = optarg;
+        break;
+      case OPT_OUT:
+        render.output_ = optarg;
+        break;
+      case OPT_PRESET:
+        render.preset_ = optarg;
+        break;
       case 'v':
         std::cout << APP_NAME << "-" << chestnut::version::MAJOR << "." << chestnut::version::MINOR << "." << chestnut::version::PATCH;
         if (!std::string(chestnut::version::PREREL).empty()) {
@@ -118,6 +164,10 @@ int main(int argc, char *argv[])
 #endif
 
 
+  const bool headless = !render.project_.isEmpty();
+  if (headless && !chestnut::io::HeadlessRender::setUpPlatform()) {
+    return chestnut::io::HeadlessRender::EXIT_GL;
+  }
 
   QApplication a(argc, argv);
   QApplication::setWindowIcon(QIcon(":/icons/chestnut.png"));
@@ -131,6 +181,14 @@ int main(int argc, char *argv[])
   const auto db = chestnut::Database::instance(path);
   Q_ASSERT(db != nullptr);
 
+  if (headless) {
+    // the panels the project is loaded into are made but never shown, and there is no main window
+    chestnut::io::HeadlessRender job(render);
+    const auto code = job.exec();
+    panels::PanelManager::tearDown();
+    return code;
+  }
+
   const QString name(APP_NAME);
   MainWindow& w = MainWindow::instance(nullptr, name);
   w.initialise();
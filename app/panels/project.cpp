@@ -47,6 +47,9 @@ extern "C" {
 #include "panels/panelmanager.h"
 #include "panels/viewer.h"
 #include "playback/playback.h"
+#include "playback/decoderpool.h"
+#include "playback/framecache.h"
+#include "playback/framepool.h"
 #include "project/effect.h"
 #include "project/transition.h"
 #include "project/sequence.h"
@@ -94,6 +97,8 @@ constexpr bool XML_SAVE_FORMATTING = true; // creates bigger files
 
 using panels::PanelManager;
 using chestnut::project::PreviewGeneratorThread;
+using chestnut::project::ProxyGeneratorThread;
+using chestnut::project::AudioConformThread;
 
 Project::Project(QWidget *parent) :
   QDockWidget(parent)
@@ -102,6 +107,11 @@ Project::Project(QWidget *parent) :
   qRegisterMetaType<FootageWPtr>();
   connect(preview_gen_, &PreviewGeneratorThread::previewGenerated, this, &Project::setItemIcon);
   connect(preview_gen_, &PreviewGeneratorThread::previewFailed, this, &Project::setItemMissing);
+  proxy_gen_ = new ProxyGeneratorThread(this);
+  connect(proxy_gen_, &ProxyGeneratorThread::proxyStarted, this, &Project::setItemProxyStatus);
+  connect(proxy_gen_, &ProxyGeneratorThread::proxyGenerated, this, &Project::setItemProxyStatus);
+  connect(proxy_gen_, &ProxyGeneratorThread::proxyFailed, this, &Project::setItemProxyStatus);
+  conform_gen_ = new AudioConformThread(this);
 
   setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
 
@@ -455,12 +465,39 @@ void Project::refresh()
   }
 }
 
+bool Project::generatingPreviews() const
+{
+  // each footage's throbber stops once its previews are generated or have failed to be
+  return !media_throbbers_.empty();
+}
+
 void Project::updatePanel()
 {
   tree_view_->viewport()->update();
   icon_view_->viewport()->update();
 }
 
+
+void Project::queueProxies()
+{
+  Q_ASSERT(proxy_gen_);
+  for (const auto& mda : model().items()) {
+    if (mda && (mda->type() == MediaType::FOOTAGE)) {
+      proxy_gen_->addToQueue(mda->object<Footage>());
+    }
+  }
+}
+
+void Project::queueConforms()
+{
+  Q_ASSERT(conform_gen_);
+  for (const auto& mda : model().items()) {
+    if (mda && (mda->type() == MediaType::FOOTAGE)) {
+      conform_gen_->addToQueue(mda->object<Footage>());
+    }
+  }
+}
+
 bool delete_clips_in_clipboard_with_media(ComboAction* ca, MediaPtr m)
 {
   int delete_count = 0;
@@ -897,6 +934,11 @@ void Project::clear()
 
   // delete everything else
   model().clear();
+
+  // no clip is left to reuse the decoders or frames of this project's footage
+  chestnut::playback::DecoderPool::instance().clear();
+  chestnut::playback::FrameCache::instance().clear();
+  chestnut::playback::FramePool::instance().clear();
 }
 
 void Project::new_project()
@@ -909,14 +951,12 @@ void Project::new_project()
   MainWindow::instance().setWindowModified(false);
 }
 
-void Project::load_project(const bool autorecovery)
+bool Project::read_project(const QString& path)
 {
-  new_project();
-
-  QFile file(project_url);
+  QFile file(path);
   if (!file.open(QIODevice::ReadOnly)) {
-    qCritical() << "Could not open file";
-    return;
+    qCritical() << "Could not open file" << path;
+    return false;
   }
 
   bool success = false;
@@ -934,8 +974,19 @@ void Project::load_project(const bool autorecovery)
   }
 
   file.close();
+  return success;
+}
+
+void Project::load_project(const bool autorecovery)
+{
+  new_project();
+
+  if (!QFile::exists(project_url)) {
+    qCritical() << "Could not open file";
+    return;
+  }
 
-  if (success) {
+  if (read_project(project_url)) {
     if (autorecovery) {
       MainWindow::instance().updateTitle("untitled");
     } else {
@@ -1118,6 +1169,14 @@ void Project::setItemIcon(FootageWPtr item)
     }
     // setting a default icon for image/video is pointless as those clips have one generated
     setModelItemIcon(ftg, icon);
+    if (global::config.use_proxies) {
+      Q_ASSERT(proxy_gen_);
+      proxy_gen_->addToQueue(ftg);
+    }
+    if (global::config.conform_audio) {
+      Q_ASSERT(conform_gen_);
+      conform_gen_->addToQueue(ftg);
+    }
   }
 }
 
@@ -1130,6 +1189,15 @@ void Project::setItemMissing(FootageWPtr item)
   }
 }
 
+void Project::setItemProxyStatus(FootageWPtr item)
+{
+  if (auto ftg = item.lock()) {
+    model().refresh(ftg);
+    // clips showing this footage switch to the proxy on their next draw
+    PanelManager::refreshPanels(false);
+  }
+}
+
 void Project::add_recent_project(QString url)
 {
   bool found = false;
@@ -32,6 +32,8 @@
 #include "project/sequence.h"
 #include "project/media.h"
 #include "project/previewgeneratorthread.h"
+#include "project/proxygeneratorthread.h"
+#include "project/audioconformthread.h"
 
 class Footage;
 
@@ -107,6 +109,12 @@ public:
 
     void new_project();
     void load_project(const bool autorecovery);
+    /**
+     * @brief       Read a project file into the model, without updating any panel or prompting on failure
+     * @param path
+     * @return      true==success
+     */
+    bool read_project(const QString& path);
     void save_project(const bool autorecovery);
 
     MediaPtr newFolder(const QString& name="");
@@ -123,11 +131,24 @@ public:
      * Redraw/setup viewer using the models items
      */
     void refresh();
+    /**
+     * @brief   Identify if any footage is still waiting on its previews, without which its clips aren't rendered
+     * @return  true==generating
+     */
+    bool generatingPreviews() const;
 
     /**
      * @brief Force an widget redraw of the Project panel
      */
     void updatePanel();
+    /**
+     * @brief Queue all footage in the project for generation of proxies it doesn't have yet
+     */
+    void queueProxies();
+    /**
+     * @brief Queue all footage in the project for its audio to be conformed to the configured sample rate
+     */
+    void queueConforms();
 
 public slots:
     void import_dialog();
@@ -147,6 +168,8 @@ private:
     QVector<MediaPtr> last_imported_media;
     inline static std::unique_ptr<ProjectModel> model_ {nullptr};
     chestnut::project::PreviewGeneratorThread* preview_gen_ {nullptr};
+    chestnut::project::ProxyGeneratorThread* proxy_gen_ {nullptr};
+    chestnut::project::AudioConformThread* conform_gen_ {nullptr};
     QMap<MediaPtr, MediaThrobber*> media_throbbers_;
     /**
      * @brief Stores the filter that was used on the last import of media
@@ -174,6 +197,7 @@ private slots:
     void make_new_menu();
     void setItemIcon(FootageWPtr item);
     void setItemMissing(FootageWPtr item);
+    void setItemProxyStatus(FootageWPtr item);
 };
 
 class MediaThrobber : public QObject {
@@ -26,6 +26,7 @@
 #include <QPushButton>
 
 #include "playback/audio.h"
+#include "playback/audioscrubber.h"
 #include "timeline.h"
 #include "panels/panelmanager.h"
 #include "io/config.h"
@@ -301,7 +302,11 @@ void Viewer::seek(const int64_t p)
     }
   }
   reset_all_audio();
-  audio_scrub = true;
+  // grains rendered offline where the sequence allows, otherwise a frame cached through playback
+  if (!global::config.enable_audio_scrubbing
+      || !chestnut::playback::AudioScrubber::instance().scrub(sequence_, p)) {
+    audio_scrub = true;
+  }
   update_parents(update_fx);
 }
 
@@ -424,6 +429,8 @@ void Viewer::play()
       seek(get_seq_in());
     }
 
+    // the clips' effects are played from here on, so no longer rendered for scrubbing
+    chestnut::playback::AudioScrubber::instance().stop();
     reset_all_audio();
     if (is_recording_cued() && !start_recording()) {
       qCritical() << "Failed to record audio";
@@ -464,27 +471,29 @@ void Viewer::pause()
       stop_recording();
 
       // import audio
-      QStringList file_list;
-      file_list.append(get_recorded_audio_filename());
+      const QStringList file_list = get_recorded_audio_filenames();
       PanelManager::projectViewer().process_file_list(file_list);
 
-      // add it to the sequence
-      auto clp = std::make_shared<Clip>(sequence_);
-      auto mda = PanelManager::projectViewer().getImportedMedia(0);
-      auto ftg = mda->object<Footage>();
-
-      clp->timeline_info.media = mda; // latest media
-      clp->timeline_info.media_stream = 0;
-      clp->timeline_info.in = recording_start;
-      clp->timeline_info.out = recording_start + ftg->totalLengthInFrames(sequence_->frameRate());
-      clp->timeline_info.clip_in = 0;
-      clp->timeline_info.track_ = recording_track;
-      clp->timeline_info.color = PAUSE_COLOR;
-      clp->timeline_info.name_ = mda->name();
-
+      // add it to the sequence, a track for each file from the one recorded on
       QVector<ClipPtr> add_clips;
-      add_clips.append(clp);
-      e_undo_stack.push(new AddClipsCommand(sequence_, add_clips)); // add clip
+      for (int i = 0; i < PanelManager::projectViewer().getMediaSize(); ++i) {
+        auto clp = std::make_shared<Clip>(sequence_);
+        auto mda = PanelManager::projectViewer().getImportedMedia(i);
+        auto ftg = mda->object<Footage>();
+
+        clp->timeline_info.media = mda; // latest media
+        clp->timeline_info.media_stream = 0;
+        clp->timeline_info.in = recording_start;
+        clp->timeline_info.out = recording_start + ftg->totalLengthInFrames(sequence_->frameRate());
+        clp->timeline_info.clip_in = 0;
+        clp->timeline_info.track_ = recording_track + i;
+        clp->timeline_info.color = PAUSE_COLOR;
+        clp->timeline_info.name_ = mda->name();
+        add_clips.append(clp);
+      }
+      if (!add_clips.empty()) {
+        e_undo_stack.push(new AddClipsCommand(sequence_, add_clips)); // add clips
+      }
     }
   }
 }
@@ -575,6 +584,12 @@ bool Viewer::usingEffects() const
   return !fx_mute_;
 }
 
+
+chestnut::playback::Prefetcher& Viewer::prefetcher()
+{
+  return prefetcher_;
+}
+
 void Viewer::update_viewer()
 {
   update_header_zoom();
@@ -1008,6 +1023,7 @@ void Viewer::setSequence(const bool main, SequencePtr seq)
 
   main_sequence = main;
   sequence_ = main ? global::sequence : std::move(seq);
+  prefetcher_.reset();
 
   const bool null_sequence = (sequence_ == nullptr);
 
@@ -28,6 +28,7 @@
 #include "project/sequence.h"
 #include "project/media.h"
 #include "ui/markerdockwidget.h"
+#include "playback/prefetcher.h"
 
 class Timeline;
 class ViewerWidget;
@@ -110,6 +111,11 @@ class Viewer : public QDockWidget, public ui::MarkerDockWidget
     void enableFXMute(const bool value);
 
     bool usingEffects() const;
+    /**
+     * @brief   Follows the playhead of the viewed sequence, to open clips before it reaches them
+     * @return  prefetcher
+     */
+    chestnut::playback::Prefetcher& prefetcher();
 
   protected:
     void resizeEvent(QResizeEvent *event) override;
@@ -174,6 +180,7 @@ class Viewer : public QDockWidget, public ui::MarkerDockWidget
     int64_t previous_playhead {-1};
 
     std::atomic_bool fx_mute_ {false};
+    chestnut::playback::Prefetcher prefetcher_;
 
     void update_window_title();
     void clean_created_seq();
@@ -0,0 +1,313 @@
+#include "audiomixertest.h"
+#include <QtTest>
+#include <thread>
+#include <vector>
+#include <limits>
+
+#include "playback/audiomixer.h"
+#include "playback/mixkernels.h"
+
+using chestnut::playback::AudioMixer;
+using chestnut::playback::AudioRingBuffer;
+
+namespace
+{
+  constexpr size_t CAPACITY = 64;
+  constexpr float S16_SCALE = 32768.0f;
+}
+
+AudioMixerTest::AudioMixerTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void AudioMixerTest::testCaseRingWrap()
+{
+  AudioRingBuffer ring(CAPACITY);
+  std::vector<float> src(48);
+  std::vector<float> dst(48);
+  for (int pass = 0; pass < 4; ++pass) {
+    std::fill(src.begin(), src.end(), pass);
+    QCOMPARE(ring.write(src.data(), src.size()), src.size());
+    QCOMPARE(ring.read(dst.data(), dst.size()), dst.size());
+    QCOMPARE(dst, src);
+  }
+  QCOMPARE(ring.readPosition(), static_cast<int64_t>(4 * 48));
+  QCOMPARE(ring.underruns(), static_cast<uint64_t>(0));
+  QCOMPARE(ring.overruns(), static_cast<uint64_t>(0));
+}
+
+
+void AudioMixerTest::testCaseRingUnderrun()
+{
+  AudioRingBuffer ring(CAPACITY);
+  const std::vector<float> src(8, 5);
+  ring.write(src.data(), src.size());
+  std::vector<float> dst(16, -1);
+  QCOMPARE(ring.read(dst.data(), dst.size()), static_cast<size_t>(8));
+  QCOMPARE(dst.at(7), 5.0f);
+  // padded with silence
+  QCOMPARE(dst.at(8), 0.0f);
+  QCOMPARE(dst.at(15), 0.0f);
+  QCOMPARE(ring.underruns(), static_cast<uint64_t>(1));
+  QCOMPARE(ring.readPosition(), static_cast<int64_t>(16));
+}
+
+
+void AudioMixerTest::testCaseRingOverrun()
+{
+  AudioRingBuffer ring(CAPACITY);
+  const std::vector<float> src(CAPACITY + 10, 1);
+  QCOMPARE(ring.write(src.data(), src.size()), CAPACITY);
+  QCOMPARE(ring.space(), static_cast<size_t>(0));
+  QCOMPARE(ring.overruns(), static_cast<uint64_t>(1));
+}
+
+
+void AudioMixerTest::testCaseRingCatchUp()
+{
+  AudioRingBuffer ring(CAPACITY);
+  const std::vector<float> src(4, 1);
+  ring.write(src.data(), src.size());
+  // the consumer may skip samples not yet written
+  ring.skip(10);
+  QCOMPARE(ring.available(), static_cast<size_t>(0));
+  QCOMPARE(ring.catchUp(), static_cast<int64_t>(10));
+  QCOMPARE(ring.writePosition(), static_cast<int64_t>(10));
+  QCOMPARE(ring.space(), CAPACITY);
+}
+
+
+void AudioMixerTest::testCaseRingThreaded()
+{
+  constexpr int TOTAL = 20000;
+  AudioRingBuffer ring(CAPACITY);
+  std::thread producer([&ring] {
+    float next = 0;
+    while (next < TOTAL) {
+      if (ring.write(&next, 1) == 1) {
+        ++next;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  bool ordered = true;
+  float expected = 0;
+  float sample = 0;
+  while (expected < TOTAL) {
+    if (ring.peek(&sample, 1) == 1) {
+      ordered = ordered && (sample == expected);
+      ring.skip(1);
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  QVERIFY(ordered);
+}
+
+
+void AudioMixerTest::testCaseMixSum()
+{
+  AudioMixer mixer(CAPACITY);
+  auto first = mixer.addBus();
+  auto second = mixer.addBus();
+  const std::vector<int16_t> a(16, 100);
+  const std::vector<int16_t> b(8, -30);
+  QCOMPARE(mixer.stage(*first, 0, a.data(), a.size()), a.size());
+  // second clip starts later in the sequence
+  QCOMPARE(mixer.stage(*second, 4, b.data(), b.size()), b.size());
+  mixer.finish(*first, true);
+  mixer.finish(*second, true);
+  mixer.mix(false);
+
+  std::vector<float> dst(16);
+  QCOMPARE(mixer.read(dst.data(), dst.size()), dst.size());
+  QCOMPARE(dst.at(0), 100 / S16_SCALE);
+  QCOMPARE(dst.at(4), 70 / S16_SCALE);
+  QCOMPARE(dst.at(11), 70 / S16_SCALE);
+  QCOMPARE(dst.at(12), 100 / S16_SCALE);
+  QCOMPARE(mixer.position(), static_cast<int64_t>(16));
+  QCOMPARE(mixer.underruns(), static_cast<uint64_t>(0));
+}
+
+
+void AudioMixerTest::testCaseMixClamp()
+{
+  AudioMixer mixer(CAPACITY);
+  auto first = mixer.addBus();
+  auto second = mixer.addBus();
+  const std::vector<int16_t> loud(2, 30000);
+  const std::vector<int16_t> quiet(2, -30000);
+  mixer.stage(*first, 0, loud.data(), 1);
+  mixer.stage(*second, 0, loud.data(), 1);
+  mixer.stage(*first, 1, quiet.data(), 1);
+  mixer.stage(*second, 1, quiet.data(), 1);
+  mixer.mix(false);
+
+  // clipped only when converted for the device
+  std::vector<int16_t> dst(2);
+  QCOMPARE(mixer.peek(dst.data(), dst.size()), dst.size());
+  QCOMPARE(dst.at(0), std::numeric_limits<int16_t>::max());
+  QCOMPARE(dst.at(1), std::numeric_limits<int16_t>::min());
+  std::vector<float> mixed(2);
+  QCOMPARE(mixer.read(mixed.data(), mixed.size()), mixed.size());
+  QCOMPARE(mixed.at(0), 60000 / S16_SCALE);
+}
+
+
+void AudioMixerTest::testCaseMixHeadroom()
+{
+  AudioMixer mixer(CAPACITY);
+  auto first = mixer.addBus();
+  auto second = mixer.addBus();
+  auto third = mixer.addBus();
+  const std::vector<int16_t> loud(1, 30000);
+  const std::vector<int16_t> quiet(1, -30000);
+  // beyond full scale part way through the sum, but not at the end of it
+  mixer.stage(*first, 0, loud.data(), 1);
+  mixer.stage(*second, 0, loud.data(), 1);
+  mixer.stage(*third, 0, quiet.data(), 1);
+  mixer.mix(false);
+
+  std::vector<int16_t> dst(1);
+  QCOMPARE(mixer.peek(dst.data(), dst.size()), dst.size());
+  QCOMPARE(dst.at(0), static_cast<int16_t>(30000));
+}
+
+
+void AudioMixerTest::testCaseMixWaitsForBus()
+{
+  AudioMixer mixer(CAPACITY);
+  auto fast = mixer.addBus();
+  auto slow = mixer.addBus();
+  const std::vector<int16_t> src(16, 1);
+  mixer.stage(*fast, 0, src.data(), 16);
+  mixer.stage(*slow, 0, src.data(), 4);
+  mixer.mix(false);
+
+  std::vector<int16_t> dst(16);
+  // only as far as both have staged
+  QCOMPARE(mixer.peek(dst.data(), dst.size()), static_cast<size_t>(4));
+
+  mixer.stage(*slow, 4, src.data(), 12);
+  mixer.mix(false);
+  QCOMPARE(mixer.peek(dst.data(), dst.size()), dst.size());
+  mixer.consume(dst.size(), dst.size());
+  QCOMPARE(dst.at(15), static_cast<int16_t>(2));
+
+  // a removed bus isn't waited on
+  mixer.stage(*fast, 16, src.data(), 8);
+  mixer.removeBus(slow);
+  mixer.mix(false);
+  std::vector<float> mixed(8);
+  QCOMPARE(mixer.read(mixed.data(), mixed.size()), mixed.size());
+}
+
+
+void AudioMixerTest::testCaseMixRealtime()
+{
+  AudioMixer mixer(CAPACITY);
+  auto late = mixer.addBus();
+  mixer.mix(false);
+  std::vector<float> dst(CAPACITY);
+  std::vector<int16_t> device(CAPACITY);
+  QCOMPARE(mixer.peek(device.data(), device.size()), static_cast<size_t>(0));
+
+  // playback doesn't wait on a clip that hasn't staged anything
+  mixer.mix(true);
+  QVERIFY(mixer.peek(device.data(), device.size()) > 0);
+  QCOMPARE(device.at(0), static_cast<int16_t>(0));
+
+  // a read short of samples with clips playing is an underrun
+  mixer.read(dst.data(), dst.size());
+  QCOMPARE(mixer.underruns(), static_cast<uint64_t>(1));
+  mixer.removeBus(late);
+  mixer.read(dst.data(), dst.size());
+  QCOMPARE(mixer.underruns(), static_cast<uint64_t>(1));
+}
+
+
+void AudioMixerTest::testCaseStageOutOfOrder()
+{
+  AudioMixer mixer(CAPACITY);
+  auto bus = mixer.addBus();
+  const std::vector<int16_t> first(8, 1);
+  const std::vector<int16_t> second(8, 2);
+  mixer.stage(*bus, 0, first.data(), first.size());
+  // e.g. after a seek, what was staged before is dropped
+  mixer.stage(*bus, 0, second.data(), second.size());
+  mixer.finish(*bus, true);
+  mixer.mix(false);
+
+  std::vector<int16_t> dst(8);
+  QCOMPARE(mixer.peek(dst.data(), dst.size()), dst.size());
+  mixer.consume(dst.size(), dst.size());
+  QCOMPARE(dst, second);
+
+  // more than the bus holds
+  const std::vector<int16_t> many(CAPACITY, 3);
+  QVERIFY(mixer.stage(*bus, 8, many.data(), many.size()) < many.size());
+  QVERIFY(mixer.overruns() > 0);
+
+  mixer.clear();
+  QCOMPARE(mixer.position(), static_cast<int64_t>(0));
+  QCOMPARE(mixer.peek(dst.data(), dst.size()), static_cast<size_t>(0));
+}
+
+
+void AudioMixerTest::testCaseClearWhileStaged()
+{
+  AudioMixer mixer(CAPACITY);
+  auto bus = mixer.addBus();
+  const std::vector<int16_t> before(8, 1);
+  mixer.stage(*bus, 0, before.data(), before.size());
+  mixer.finish(*bus, true);
+
+  // the bus is left for its clip to reset, so what it staged before isn't mixed, nor does it hold the mix
+  mixer.clear();
+  mixer.mix(false);
+  std::vector<int16_t> dst(8);
+  QCOMPARE(mixer.peek(dst.data(), dst.size()), static_cast<size_t>(0));
+
+  // restaged where it follows on from before, it is still reset, so nothing from before it is mixed
+  const std::vector<int16_t> after(8, 2);
+  QCOMPARE(mixer.stage(*bus, 8, after.data(), after.size()), after.size());
+  mixer.finish(*bus, true);
+  mixer.mix(false);
+  QCOMPARE(mixer.peek(dst.data(), dst.size()), dst.size());
+  QCOMPARE(dst, std::vector<int16_t>(8, 0));
+  mixer.consume(dst.size(), dst.size());
+  QCOMPARE(mixer.peek(dst.data(), dst.size()), dst.size());
+  QCOMPARE(dst, after);
+}
+
+
+void AudioMixerTest::testCaseStereoGains()
+{
+  // four frames to a vector, and three more left to the scalar tail
+  constexpr size_t frames = 19;
+  std::vector<float> samples(frames * 2);
+  std::vector<float> left(frames);
+  std::vector<float> right(frames);
+  for (size_t i = 0; i < frames; ++i) {
+    samples.at(i * 2) = 0.01f * (i + 1);
+    samples.at((i * 2) + 1) = -0.02f * (i + 1);
+    left.at(i) = 0.5f + (0.025f * i);
+    right.at(i) = 1.5f - (0.05f * i);
+  }
+  auto expected = samples;
+  for (size_t i = 0; i < frames; ++i) {
+    expected.at(i * 2) *= left.at(i);
+    expected.at((i * 2) + 1) *= right.at(i);
+  }
+
+  chestnut::playback::kernel::applyStereoGains(samples.data(), left.data(), right.data(), frames);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    QCOMPARE(samples.at(i), expected.at(i));
+  }
+}
@@ -0,0 +1,31 @@
+#ifndef AUDIOMIXERTEST_H
+#define AUDIOMIXERTEST_H
+
+#include <QObject>
+
+class AudioMixerTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit AudioMixerTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseRingWrap();
+    void testCaseRingUnderrun();
+    void testCaseRingOverrun();
+    void testCaseRingCatchUp();
+    void testCaseRingThreaded();
+    void testCaseMixSum();
+    void testCaseMixClamp();
+    void testCaseMixHeadroom();
+    void testCaseMixWaitsForBus();
+    void testCaseMixRealtime();
+    void testCaseStageOutOfOrder();
+    void testCaseClearWhileStaged();
+    void testCaseStereoGains();
+
+};
+
+#endif // AUDIOMIXERTEST_H
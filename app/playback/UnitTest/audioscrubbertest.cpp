@@ -0,0 +1,167 @@
+#include "audioscrubbertest.h"
+#include <QtTest>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "playback/audioscrubber.h"
+#include "playback/playback.h"
+
+using chestnut::playback::AudioScrubber;
+
+namespace
+{
+  constexpr double FRAME_RATE = 25.0;
+  constexpr int32_t FREQUENCY = 48000;
+  constexpr int WAIT_MILLIS = 5000;
+  // sample frames of a grain of one frame
+  constexpr size_t GRAIN_FRAMES = FREQUENCY / 25;
+  constexpr double AMPLITUDE = 0.5;
+
+  /**
+   * @brief           Interleaved float stereo, the same in each channel
+   * @param frames
+   * @param frequency Of a sine, or 0 for a constant level
+   * @return          samples
+   */
+  std::shared_ptr<const std::vector<float>> makeSamples(const size_t frames, const double frequency)
+  {
+    auto samples = std::make_shared<std::vector<float>>(frames * 2);
+    for (size_t i = 0; i < frames; ++i) {
+      const auto level = (frequency > 0.0) ? AMPLITUDE * std::sin(2.0 * M_PI * frequency * i / FREQUENCY) : AMPLITUDE;
+      samples->at(i * 2) = static_cast<float>(level);
+      samples->at((i * 2) + 1) = static_cast<float>(level);
+    }
+    return samples;
+  }
+
+  /**
+   * @brief Play out whatever an earlier case left, so each starts with nothing sounding
+   */
+  void drain(AudioScrubber& scrubber)
+  {
+    std::vector<int16_t> samples(FREQUENCY * 2);
+    while (scrubber.active()) {
+      scrubber.pull(samples.data(), FREQUENCY, FREQUENCY, 0);
+    }
+  }
+}
+
+AudioScrubberTest::AudioScrubberTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void AudioScrubberTest::testCaseNoSequence()
+{
+  QVERIFY(!AudioScrubber::instance().scrub(nullptr, 0));
+}
+
+
+void AudioScrubberTest::testCaseRendering()
+{
+  // an export's seeks render nothing, so leave the clips' effects to it
+  auto& scrubber = AudioScrubber::instance();
+  drain(scrubber);
+  auto seq = std::make_shared<Sequence>();
+  seq->setFrameRate(FRAME_RATE);
+  seq->setAudioFrequency(FREQUENCY);
+  const auto grains = scrubber.latency().grains_;
+  e_rendering = true;
+  QVERIFY(scrubber.scrub(seq, 30));
+  QThread::msleep(100);
+  e_rendering = false;
+  QVERIFY(!scrubber.active());
+  QCOMPARE(scrubber.latency().grains_, grains);
+}
+
+
+void AudioScrubberTest::testCaseGrain()
+{
+  auto& scrubber = AudioScrubber::instance();
+  auto seq = std::make_shared<Sequence>();
+  seq->setFrameRate(FRAME_RATE);
+  seq->setAudioFrequency(FREQUENCY);
+  const auto grains = scrubber.latency().grains_;
+
+  QVERIFY(scrubber.scrub(seq, 30));
+  QElapsedTimer timer;
+  timer.start();
+  while (!scrubber.active() && (timer.elapsed() < WAIT_MILLIS)) {
+    QThread::msleep(1);
+  }
+  QVERIFY(scrubber.active());
+
+  // a grain of one frame of silence, at a device rate other than the sequence's
+  std::vector<int16_t> samples(4410 * 2, 1);
+  scrubber.pull(samples.data(), 441, 44100, 0);
+  QCOMPARE(scrubber.latency().grains_, grains + 1);
+  QVERIFY(scrubber.latency().max_ > 0.0);
+  scrubber.pull(samples.data(), 4410, 44100, 0);
+  for (const auto smpl : samples) {
+    QCOMPARE(smpl, static_cast<int16_t>(0));
+  }
+  QVERIFY(!scrubber.active());
+}
+
+
+void AudioScrubberTest::testCaseCrossfade()
+{
+  auto& scrubber = AudioScrubber::instance();
+  drain(scrubber);
+  const auto samples = makeSamples(GRAIN_FRAMES * 4, 0.0);
+  constexpr size_t PULLED = 480;
+  std::vector<int16_t> output(PULLED * 2 * 2);
+
+  // a grain, and partway through it the next from further on in the same steady sound
+  scrubber.play(samples, 0, GRAIN_FRAMES, FREQUENCY);
+  scrubber.pull(output.data(), PULLED, FREQUENCY, 0);
+  scrubber.play(samples, GRAIN_FRAMES, GRAIN_FRAMES, FREQUENCY);
+  scrubber.pull(output.data() + (PULLED * 2), PULLED, FREQUENCY, 0);
+
+  // past the fade in of the first, the level holds through the crossfade without a dip or a click
+  const auto level = AMPLITUDE * 32768.0;
+  const size_t faded_in = FREQUENCY / 200;
+  for (size_t i = faded_in; i < PULLED * 2; ++i) {
+    const auto left = output.at(i * 2);
+    QCOMPARE(output.at((i * 2) + 1), left);
+    QVERIFY(std::abs(left - level) < (level * 0.01));
+    QVERIFY(std::abs(left - output.at((i - 1) * 2)) < 100);
+  }
+  drain(scrubber);
+}
+
+
+void AudioScrubberTest::testCaseResampled()
+{
+  auto& scrubber = AudioScrubber::instance();
+  drain(scrubber);
+  constexpr double TONE = 1000.0;
+  const auto samples = makeSamples(GRAIN_FRAMES, TONE);
+  // at twice the rate of the samples, so each is interpolated between two of the grain
+  constexpr int DEVICE_RATE = FREQUENCY * 2;
+  const size_t expected = (GRAIN_FRAMES - 1) * 2;
+  std::vector<int16_t> output((expected + 100) * 2, 1);
+
+  scrubber.play(samples, 0, GRAIN_FRAMES, FREQUENCY);
+  scrubber.pull(output.data(), expected + 100, DEVICE_RATE, 0);
+  QVERIFY(!scrubber.active());
+
+  // away from the fades at its ends, the tone as it would be sampled at the device's rate
+  const size_t fade = DEVICE_RATE / 200;
+  for (size_t i = fade; i < (expected - fade); ++i) {
+    const auto reference = AMPLITUDE * 32768.0 * std::sin(2.0 * M_PI * TONE * i / DEVICE_RATE);
+    QVERIFY(std::abs(output.at(i * 2) - reference) < 64.0);
+  }
+  // as long as the grain is, played at the device's rate
+  int tail = 0;
+  for (size_t i = expected - fade; i < expected; ++i) {
+    tail = std::max(tail, std::abs(static_cast<int>(output.at(i * 2))));
+  }
+  QVERIFY(tail > 1000);
+  for (size_t i = expected; i < (expected + 100); ++i) {
+    QCOMPARE(output.at(i * 2), static_cast<int16_t>(0));
+  }
+}
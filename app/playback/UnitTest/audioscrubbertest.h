@@ -0,0 +1,23 @@
+#ifndef AUDIOSCRUBBERTEST_H
+#define AUDIOSCRUBBERTEST_H
+
+#include <QObject>
+
+class AudioScrubberTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit AudioScrubberTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseNoSequence();
+    void testCaseRendering();
+    void testCaseGrain();
+    void testCaseCrossfade();
+    void testCaseResampled();
+
+};
+
+#endif // AUDIOSCRUBBERTEST_H
@@ -0,0 +1,112 @@
+#include "decodeschedulertest.h"
+#include <QtTest>
+#include <QSemaphore>
+
+#include "playback/decodescheduler.h"
+
+using chestnut::playback::DecodeScheduler;
+using chestnut::playback::DecodePriority;
+
+namespace
+{
+  DecodePriority priority(const int64_t distance, const bool visible=true, const bool audio=false)
+  {
+    DecodePriority prio;
+    prio.distance_ = distance;
+    prio.visible_ = visible;
+    prio.audio_ = audio;
+    return prio;
+  }
+}
+
+DecodeSchedulerTest::DecodeSchedulerTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void DecodeSchedulerTest::testCaseRunsAll()
+{
+  DecodeScheduler scheduler(4);
+  std::atomic<int> count {0};
+  for (int i = 0; i < 1000; ++i) {
+    scheduler.submit([&count] { ++count; }, priority(i % 10));
+  }
+  scheduler.waitForIdle();
+  QCOMPARE(count.load(), 1000);
+  QCOMPARE(scheduler.completed(), static_cast<uint64_t>(1000));
+}
+
+
+void DecodeSchedulerTest::testCasePriorityOrder()
+{
+  DecodeScheduler scheduler(1);
+  QSemaphore started;
+  QSemaphore release;
+  // occupy the only worker while the rest are queued
+  scheduler.submit([&] { started.release(); release.acquire(); }, priority(0));
+  started.acquire();
+
+  QVector<int> order;
+  scheduler.submit([&order] { order.append(1); }, priority(10, false));
+  scheduler.submit([&order] { order.append(2); }, priority(10));
+  scheduler.submit([&order] { order.append(3); }, priority(0));
+  scheduler.submit([&order] { order.append(4); }, priority(50, false, true));
+  release.release();
+  scheduler.waitForIdle();
+
+  // audio first, then visible clips nearest the playhead, then hidden clips
+  QCOMPARE(order, QVector<int>({4, 3, 2, 1}));
+}
+
+
+void DecodeSchedulerTest::testCaseFifoWithinPriority()
+{
+  DecodeScheduler scheduler(1);
+  QSemaphore started;
+  QSemaphore release;
+  scheduler.submit([&] { started.release(); release.acquire(); }, priority(0));
+  started.acquire();
+
+  QVector<int> order;
+  for (int i = 0; i < 5; ++i) {
+    scheduler.submit([&order, i] { order.append(i); }, priority(3));
+  }
+  release.release();
+  scheduler.waitForIdle();
+
+  QCOMPARE(order, QVector<int>({0, 1, 2, 3, 4}));
+}
+
+
+void DecodeSchedulerTest::testCaseStealing()
+{
+  DecodeScheduler scheduler(2);
+  QSemaphore queued;
+  QSemaphore release;
+  std::atomic<int> count {0};
+  // jobs submitted from a worker go on its own queue. with that worker busy, the other has to take them
+  scheduler.submit([&] {
+    for (int i = 0; i < 10; ++i) {
+      scheduler.submit([&count] { ++count; }, priority(1));
+    }
+    queued.release();
+    release.acquire();
+  }, priority(0));
+  queued.acquire();
+  QTRY_COMPARE(count.load(), 10);
+  release.release();
+  scheduler.waitForIdle();
+
+  // the first job may itself have been taken by the other worker
+  QVERIFY(scheduler.stolen() >= 10);
+}
+
+
+void DecodeSchedulerTest::testCaseWorkerCount()
+{
+  DecodeScheduler fixed(3);
+  QCOMPARE(fixed.workerCount(), static_cast<size_t>(3));
+  DecodeScheduler per_core(0);
+  QVERIFY(per_core.workerCount() >= 1);
+}
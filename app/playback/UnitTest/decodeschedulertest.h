@@ -0,0 +1,23 @@
+#ifndef DECODESCHEDULERTEST_H
+#define DECODESCHEDULERTEST_H
+
+#include <QObject>
+
+class DecodeSchedulerTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit DecodeSchedulerTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseRunsAll();
+    void testCasePriorityOrder();
+    void testCaseFifoWithinPriority();
+    void testCaseStealing();
+    void testCaseWorkerCount();
+
+};
+
+#endif // DECODESCHEDULERTEST_H
@@ -0,0 +1,137 @@
+#include "framecachetest.h"
+#include <QtTest>
+
+#include "playback/framecache.h"
+#include "io/config.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+using chestnut::playback::FrameCache;
+using chestnut::playback::FrameCacheKey;
+
+namespace
+{
+  const FrameCacheKey KEY {"/tmp/footage.mov", 0};
+  constexpr int64_t DURATION = 10;
+
+  AVFrame* makeFrame(const int64_t pts, const int size=16)
+  {
+    AVFrame* frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_GRAY8;
+    frame->width = size;
+    frame->height = size;
+    av_frame_get_buffer(frame, 0);
+    frame->pts = pts;
+    return frame;
+  }
+}
+
+FrameCacheTest::FrameCacheTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+void FrameCacheTest::init()
+{
+  global::config.frame_cache_size = Config().frame_cache_size;
+  FrameCache::instance().clear();
+}
+
+
+void FrameCacheTest::testCaseFindWithinDuration()
+{
+  auto& cache = FrameCache::instance();
+  cache.insert(KEY, makeFrame(0), DURATION);
+  cache.insert(KEY, makeFrame(10), DURATION);
+  auto frm = cache.find(KEY, 5);
+  QVERIFY(frm != nullptr);
+  QCOMPARE(frm->pts, static_cast<int64_t>(0));
+  frm = cache.find(KEY, 10);
+  QVERIFY(frm != nullptr);
+  QCOMPARE(frm->pts, static_cast<int64_t>(10));
+  QVERIFY(cache.find(KEY, 20) == nullptr);
+  QVERIFY(cache.find(FrameCacheKey{"/tmp/other.mov", 0}, 0) == nullptr);
+}
+
+
+void FrameCacheTest::testCaseFindGap()
+{
+  auto& cache = FrameCache::instance();
+  cache.insert(KEY, makeFrame(0), DURATION);
+  cache.insert(KEY, makeFrame(100), DURATION);
+  QVERIFY(cache.find(KEY, 50) == nullptr);
+  auto frm = cache.closest(KEY, 50);
+  QVERIFY(frm != nullptr);
+  QCOMPARE(frm->pts, static_cast<int64_t>(0));
+}
+
+
+void FrameCacheTest::testCaseRun()
+{
+  auto& cache = FrameCache::instance();
+  for (int64_t pts = 0; pts < 50; pts += DURATION) {
+    cache.insert(KEY, makeFrame(pts), DURATION);
+  }
+  cache.insert(KEY, makeFrame(200), DURATION);
+
+  auto run = cache.run(KEY, 20, 10);
+  QVERIFY(run.has_value());
+  QCOMPARE(run->before_, 2);
+  QCOMPARE(run->after_, 2);
+  QCOMPARE(run->first_pts_, static_cast<int64_t>(0));
+  QCOMPARE(run->last_pts_, static_cast<int64_t>(40));
+
+  run = cache.run(KEY, 20, 1);
+  QVERIFY(run.has_value());
+  QCOMPARE(run->before_, 1);
+  QCOMPARE(run->after_, 1);
+
+  QVERIFY(!cache.run(KEY, 100, 10).has_value());
+}
+
+
+void FrameCacheTest::testCaseEviction()
+{
+  global::config.frame_cache_size = 3; // MiB
+  constexpr int size = 1024; // ~1MiB a frame
+  auto& cache = FrameCache::instance();
+  cache.insert(KEY, makeFrame(0, size), DURATION);
+  cache.insert(KEY, makeFrame(10, size), DURATION);
+  // most recent use keeps the first frame
+  QVERIFY(cache.find(KEY, 0) != nullptr);
+  cache.insert(KEY, makeFrame(20, size), DURATION);
+  QVERIFY(cache.find(KEY, 0) != nullptr);
+  QVERIFY(cache.find(KEY, 10) == nullptr);
+  QVERIFY(cache.find(KEY, 20) != nullptr);
+  QVERIFY(cache.bytes() <= 3 * 1024 * 1024);
+}
+
+
+void FrameCacheTest::testCaseHitsMisses()
+{
+  auto& cache = FrameCache::instance();
+  cache.insert(KEY, makeFrame(0), DURATION);
+  cache.find(KEY, 0);
+  cache.find(KEY, 1);
+  cache.find(KEY, 50);
+  QCOMPARE(cache.hits(), static_cast<uint64_t>(2));
+  QCOMPARE(cache.misses(), static_cast<uint64_t>(1));
+}
+
+
+void FrameCacheTest::testCasePurge()
+{
+  auto& cache = FrameCache::instance();
+  const FrameCacheKey other {"/tmp/other.mov", 0};
+  cache.insert(KEY, makeFrame(0), DURATION);
+  cache.insert(other, makeFrame(0), DURATION);
+  auto held = cache.find(KEY, 0);
+  cache.purge(KEY.location_);
+  QVERIFY(cache.find(KEY, 0) == nullptr);
+  QVERIFY(cache.find(other, 0) != nullptr);
+  // frames in use outlive their removal from the cache
+  QVERIFY(held != nullptr);
+  QCOMPARE(held->pts, static_cast<int64_t>(0));
+}
@@ -0,0 +1,25 @@
+#ifndef FRAMECACHETEST_H
+#define FRAMECACHETEST_H
+
+#include <QObject>
+
+class FrameCacheTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit FrameCacheTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void init();
+    void testCaseFindWithinDuration();
+    void testCaseFindGap();
+    void testCaseRun();
+    void testCaseEviction();
+    void testCaseHitsMisses();
+    void testCasePurge();
+
+};
+
+#endif // FRAMECACHETEST_H
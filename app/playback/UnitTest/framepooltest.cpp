@@ -0,0 +1,92 @@
+#include "framepooltest.h"
+#include <QtTest>
+
+#include "playback/framepool.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+using chestnut::playback::FramePool;
+
+FramePoolTest::FramePoolTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+void FramePoolTest::init()
+{
+  FramePool::instance().clear();
+}
+
+
+void FramePoolTest::testCaseAcquire()
+{
+  AVFrame* frame = FramePool::instance().acquire(64, 48, AV_PIX_FMT_RGB24);
+  QVERIFY(frame != nullptr);
+  QCOMPARE(frame->width, 64);
+  QCOMPARE(frame->height, 48);
+  QCOMPARE(frame->format, static_cast<int>(AV_PIX_FMT_RGB24));
+  QVERIFY(frame->data[0] != nullptr);
+  QVERIFY(frame->linesize[0] >= 64 * 3);
+  QVERIFY(frame->buf[0] != nullptr);
+  QVERIFY(frame->buf[0]->size >= frame->linesize[0] * 48);
+  av_frame_free(&frame);
+}
+
+
+void FramePoolTest::testCaseReuse()
+{
+  auto& pool = FramePool::instance();
+  AVFrame* frame = pool.acquire(32, 32, AV_PIX_FMT_RGBA);
+  QVERIFY(frame != nullptr);
+  const auto buffer = frame->data[0];
+  av_frame_free(&frame);
+
+  const auto hits = pool.hits();
+  const auto misses = pool.misses();
+  frame = pool.acquire(32, 32, AV_PIX_FMT_RGBA);
+  QVERIFY(frame != nullptr);
+  QCOMPARE(frame->data[0], buffer);
+  QCOMPARE(pool.hits(), hits + 1);
+  QCOMPARE(pool.misses(), misses);
+  av_frame_free(&frame);
+}
+
+
+void FramePoolTest::testCaseGeometry()
+{
+  auto& pool = FramePool::instance();
+  AVFrame* frame = pool.acquire(32, 32, AV_PIX_FMT_RGBA);
+  QVERIFY(frame != nullptr);
+  av_frame_free(&frame);
+
+  // neither a different size nor format can use the buffer just returned
+  const auto misses = pool.misses();
+  frame = pool.acquire(64, 32, AV_PIX_FMT_RGBA);
+  QVERIFY(frame != nullptr);
+  av_frame_free(&frame);
+  frame = pool.acquire(32, 32, AV_PIX_FMT_RGB24);
+  QVERIFY(frame != nullptr);
+  av_frame_free(&frame);
+  QCOMPARE(pool.misses(), misses + 2);
+}
+
+
+void FramePoolTest::testCaseResidentBytes()
+{
+  auto& pool = FramePool::instance();
+  const auto resident = pool.residentBytes();
+  AVFrame* first = pool.acquire(128, 128, AV_PIX_FMT_RGBA);
+  AVFrame* second = pool.acquire(128, 128, AV_PIX_FMT_RGBA);
+  QVERIFY( (first != nullptr) && (second != nullptr) );
+  QVERIFY(pool.residentBytes() >= resident + (2 * 128 * 128 * 4));
+  QVERIFY(pool.peakBytes() >= pool.residentBytes());
+
+  // buffers are kept by the pool until it is cleared
+  av_frame_free(&first);
+  av_frame_free(&second);
+  QVERIFY(pool.residentBytes() >= resident + (2 * 128 * 128 * 4));
+  pool.clear();
+  QCOMPARE(pool.residentBytes(), static_cast<size_t>(0));
+}
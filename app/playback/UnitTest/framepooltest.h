@@ -0,0 +1,23 @@
+#ifndef FRAMEPOOLTEST_H
+#define FRAMEPOOLTEST_H
+
+#include <QObject>
+
+class FramePoolTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit FramePoolTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void init();
+    void testCaseAcquire();
+    void testCaseReuse();
+    void testCaseGeometry();
+    void testCaseResidentBytes();
+
+};
+
+#endif // FRAMEPOOLTEST_H
@@ -0,0 +1,177 @@
+#include "loudnessmetertest.h"
+#include <QtTest>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "playback/audiofilter.h"
+#include "playback/loudnessmeter.h"
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+}
+
+using chestnut::playback::LoudnessMeter;
+
+namespace
+{
+  constexpr int RATE = 48000;
+  constexpr double PI = 3.14159265358979323846;
+
+  // interleaved stereo, the same in both channels
+  std::vector<float> sine(const double frequency, const double amplitude, const double phase, const int frames)
+  {
+    std::vector<float> samples(static_cast<size_t>(frames) * LoudnessMeter::CHANNELS);
+    for (int i = 0; i < frames; ++i) {
+      const auto value = static_cast<float>(amplitude * std::sin((2.0 * PI * frequency * i / RATE) + phase));
+      samples.at(static_cast<size_t>(i) * 2) = value;
+      samples.at((static_cast<size_t>(i) * 2) + 1) = value;
+    }
+    return samples;
+  }
+
+  // interleaved 5.1, the sine in one channel and silence in the rest
+  std::vector<float> sineIn(const size_t channel, const int frames)
+  {
+    constexpr size_t channels = 6;
+    const auto tone = sine(997.0, 0.5, 0.0, frames);
+    std::vector<float> samples(static_cast<size_t>(frames) * channels, 0.0f);
+    for (size_t i = 0; i < static_cast<size_t>(frames); ++i) {
+      samples.at((i * channels) + channel) = tone.at(i * LoudnessMeter::CHANNELS);
+    }
+    return samples;
+  }
+}
+
+LoudnessMeterTest::LoudnessMeterTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void LoudnessMeterTest::testCaseSilence()
+{
+  LoudnessMeter meter(RATE);
+  const std::vector<float> silence(RATE * 2 * LoudnessMeter::CHANNELS, 0.0f);
+  meter.process(silence.data(), silence.size() / LoudnessMeter::CHANNELS);
+  const auto levels = meter.levels();
+  QVERIFY(std::isinf(levels.momentary_));
+  QVERIFY(std::isinf(levels.short_term_));
+  QVERIFY(std::isinf(levels.integrated_));
+  QCOMPARE(levels.peak_.at(0), 0.0f);
+  QCOMPARE(levels.rms_.at(1), 0.0f);
+  QCOMPARE(levels.true_peak_.at(0), 0.0f);
+}
+
+
+void LoudnessMeterTest::testCaseSine()
+{
+  // a 997Hz sine at -6dBFS in both channels is -6.02 LUFS by the calibration of BS.1770
+  LoudnessMeter meter(RATE);
+  const auto samples = sine(997.0, 0.5, 0.0, RATE * 4);
+  meter.process(samples.data(), samples.size() / LoudnessMeter::CHANNELS);
+  const auto levels = meter.levels();
+  QVERIFY(std::abs(levels.momentary_ - -6.02) < 0.1);
+  QVERIFY(std::abs(levels.short_term_ - -6.02) < 0.1);
+  QVERIFY(std::abs(levels.integrated_ - -6.02) < 0.1);
+  for (size_t c = 0; c < LoudnessMeter::CHANNELS; ++c) {
+    QVERIFY(std::abs(levels.peak_.at(c) - 0.5f) < 0.01f);
+    QVERIFY(std::abs(levels.max_peak_.at(c) - 0.5f) < 0.01f);
+    QVERIFY(std::abs(levels.rms_.at(c) - 0.3536f) < 0.01f);
+    QVERIFY(levels.true_peak_.at(c) >= levels.max_peak_.at(c));
+  }
+}
+
+
+void LoudnessMeterTest::testCaseGated()
+{
+  // silence after the tone is gated out of the integrated loudness, but not the momentary
+  LoudnessMeter meter(RATE);
+  const auto samples = sine(997.0, 0.5, 0.0, RATE * 3);
+  meter.process(samples.data(), samples.size() / LoudnessMeter::CHANNELS);
+  const std::vector<float> silence(samples.size(), 0.0f);
+  meter.process(silence.data(), silence.size() / LoudnessMeter::CHANNELS);
+  const auto levels = meter.levels();
+  QVERIFY(std::isinf(levels.momentary_));
+  QVERIFY(std::abs(levels.integrated_ - -6.02) < 0.5);
+  QCOMPARE(levels.peak_.at(0), 0.0f);
+  QVERIFY(levels.max_peak_.at(0) > 0.49f);
+}
+
+
+void LoudnessMeterTest::testCaseTruePeak()
+{
+  // at a quarter of the rate with this phase every sample falls at 0.707 of the peak between them
+  LoudnessMeter meter(RATE);
+  const auto samples = sine(RATE / 4.0, 1.0, PI / 4.0, RATE / 10);
+  meter.process(samples.data(), samples.size() / LoudnessMeter::CHANNELS);
+  const auto levels = meter.levels();
+  QVERIFY(std::abs(levels.max_peak_.at(0) - 0.7071f) < 0.001f);
+  QVERIFY(std::abs(levels.true_peak_.at(0) - 1.0f) < 0.05f);
+  QVERIFY(std::abs(levels.true_peak_.at(1) - 1.0f) < 0.05f);
+}
+
+
+void LoudnessMeterTest::testCaseChunked()
+{
+  // measured in pieces not aligned to the blocks, the same as all at once
+  const auto samples = sine(440.0, 0.25, 0.0, RATE * 2);
+  LoudnessMeter whole(RATE);
+  whole.process(samples.data(), samples.size() / LoudnessMeter::CHANNELS);
+  LoudnessMeter chunked(RATE);
+  const size_t frames = samples.size() / LoudnessMeter::CHANNELS;
+  for (size_t done = 0; done < frames;) {
+    const auto count = std::min(static_cast<size_t>(1237), frames - done);
+    chunked.process(samples.data() + (done * LoudnessMeter::CHANNELS), count);
+    done += count;
+  }
+  const auto a = whole.levels();
+  const auto b = chunked.levels();
+  QVERIFY(std::abs(a.momentary_ - b.momentary_) < 1e-6);
+  QVERIFY(std::abs(a.integrated_ - b.integrated_) < 1e-6);
+  QCOMPARE(a.peak_, b.peak_);
+  QCOMPARE(a.true_peak_, b.true_peak_);
+}
+
+
+void LoudnessMeterTest::testCaseReset()
+{
+  LoudnessMeter meter(RATE);
+  const auto samples = sine(997.0, 0.5, 0.0, RATE);
+  meter.process(samples.data(), samples.size() / LoudnessMeter::CHANNELS);
+  QVERIFY(!std::isinf(meter.levels().integrated_));
+  meter.reset();
+  const auto levels = meter.levels();
+  QVERIFY(std::isinf(levels.momentary_));
+  QVERIFY(std::isinf(levels.integrated_));
+  QCOMPARE(levels.max_peak_.at(0), 0.0f);
+  QCOMPARE(meter.sampleRate(), RATE);
+}
+
+
+void LoudnessMeterTest::testCaseSurroundWeights()
+{
+  // front left, front right, centre, LFE, side left, side right
+  const auto weights = chestnut::playback::loudnessWeights(AV_CH_LAYOUT_5POINT1);
+  QCOMPARE(weights, std::vector<double>({1.0, 1.0, 1.0, 0.0, 1.41, 1.41}));
+
+  const auto measure = [&weights] (const size_t channel) {
+    LoudnessMeter meter(RATE, weights);
+    const auto samples = sineIn(channel, RATE * 4);
+    meter.process(samples.data(), samples.size() / weights.size());
+    return meter.levels();
+  };
+  const auto front = measure(0);
+  const auto lfe = measure(3);
+  const auto surround = measure(4);
+  QCOMPARE(static_cast<int>(front.peak_.size()), 6);
+  // a -6dBFS sine in one channel of weight 1.0 is 3dB below the same in two
+  QVERIFY(std::abs(front.integrated_ - -9.03) < 0.1);
+  // surrounds weigh 1.41, so 1.5dB louder
+  QVERIFY(std::abs((surround.integrated_ - front.integrated_) - (10.0 * std::log10(1.41))) < 0.01);
+  // the LFE is left out of the loudness, though not its levels
+  QVERIFY(std::isinf(lfe.integrated_));
+  QVERIFY(std::isinf(lfe.momentary_));
+  QVERIFY(std::abs(lfe.peak_.at(3) - 0.5f) < 0.01f);
+  QCOMPARE(lfe.peak_.at(0), 0.0f);
+}
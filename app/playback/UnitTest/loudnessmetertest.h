@@ -0,0 +1,25 @@
+#ifndef LOUDNESSMETERTEST_H
+#define LOUDNESSMETERTEST_H
+
+#include <QObject>
+
+class LoudnessMeterTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit LoudnessMeterTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseSilence();
+    void testCaseSine();
+    void testCaseGated();
+    void testCaseTruePeak();
+    void testCaseChunked();
+    void testCaseReset();
+    void testCaseSurroundWeights();
+
+};
+
+#endif // LOUDNESSMETERTEST_H
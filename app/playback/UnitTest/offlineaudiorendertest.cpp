@@ -0,0 +1,172 @@
+#include "offlineaudiorendertest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <vector>
+
+#include "playback/offlineaudiorender.h"
+#include "project/clip.h"
+#include "project/media.h"
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+}
+
+using chestnut::playback::OfflineAudioRender;
+
+namespace
+{
+  constexpr double FRAME_RATE = 25.0;
+  constexpr int32_t FREQUENCY = 48000;
+  // interleaved stereo samples in a frame
+  constexpr int64_t FRAME_SAMPLES = 2 * FREQUENCY / 25;
+  constexpr qint64 WAV_HEADER_BYTES = 44;
+  constexpr qint64 WAV_EXTENSIBLE_HEADER_BYTES = 68;
+
+  SequencePtr makeSequence()
+  {
+    auto seq = std::make_shared<Sequence>();
+    seq->setFrameRate(FRAME_RATE);
+    seq->setAudioFrequency(FREQUENCY);
+    return seq;
+  }
+}
+
+OfflineAudioRenderTest::OfflineAudioRenderTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void OfflineAudioRenderTest::testCaseEmptySequence()
+{
+  auto seq = makeSequence();
+  OfflineAudioRender render(seq, 10, 20);
+  QCOMPARE(render.sampleRate(), FREQUENCY);
+  QCOMPARE(render.length(), 10 * FRAME_SAMPLES);
+  QCOMPARE(render.position(), static_cast<int64_t>(0));
+
+  std::vector<float> samples(static_cast<size_t>(render.length() + 100), 1.0f);
+  QCOMPARE(render.render(samples.data(), samples.size()), static_cast<size_t>(render.length()));
+  QCOMPARE(render.position(), render.length());
+  for (const auto smpl : samples) {
+    QCOMPARE(smpl, 0.0f);
+  }
+  // past the end is all silence
+  std::fill(samples.begin(), samples.end(), 1.0f);
+  QCOMPARE(render.render(samples.data(), samples.size()), static_cast<size_t>(0));
+  QCOMPARE(samples.front(), 0.0f);
+}
+
+
+void OfflineAudioRenderTest::testCaseGeneratedClipSilent()
+{
+  auto seq = makeSequence();
+  auto clp = std::make_shared<Clip>(seq);
+  clp->timeline_info.track_ = 0;
+  clp->timeline_info.in = 5;
+  clp->timeline_info.out = 15;
+  QVERIFY(seq->addClip(clp));
+
+  // without effects a clip without media generates nothing
+  OfflineAudioRender render(seq, 0, 20);
+  std::vector<float> samples(static_cast<size_t>(render.length()), 1.0f);
+  QCOMPARE(render.render(samples.data(), samples.size()), samples.size());
+  for (const auto smpl : samples) {
+    QCOMPARE(smpl, 0.0f);
+  }
+}
+
+
+void OfflineAudioRenderTest::testCaseSupports()
+{
+  auto seq = makeSequence();
+  QVERIFY(OfflineAudioRender::supports(*seq));
+
+  auto clp = std::make_shared<Clip>(seq);
+  clp->timeline_info.track_ = 0;
+  clp->timeline_info.out = 10;
+  QVERIFY(seq->addClip(clp));
+  QVERIFY(OfflineAudioRender::supports(*seq));
+
+  clp->timeline_info.reverse = true;
+  QVERIFY(!OfflineAudioRender::supports(*seq));
+  clp->timeline_info.reverse = false;
+
+  auto mda = std::make_shared<Media>();
+  mda->setSequence(makeSequence());
+  clp->timeline_info.media = mda;
+  QVERIFY(!OfflineAudioRender::supports(*seq));
+}
+
+
+void OfflineAudioRenderTest::testCaseBounce()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto path = dir.filePath("bounce.wav");
+
+  auto seq = makeSequence();
+  OfflineAudioRender render(seq, 0, 50);
+  std::atomic_bool running {true};
+  int last_progress = -1;
+  QVERIFY(render.bounce(path, running, [&] (const int percent) {
+    QVERIFY(percent >= last_progress);
+    last_progress = percent;
+  }));
+  QCOMPARE(last_progress, 100);
+
+  QFile file(path);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  QCOMPARE(file.size(), WAV_HEADER_BYTES + 50 * FRAME_SAMPLES * static_cast<qint64>(sizeof(int16_t)));
+  const auto header = file.read(WAV_HEADER_BYTES);
+  QCOMPARE(header.left(4), QByteArray("RIFF"));
+  QCOMPARE(header.mid(8, 8), QByteArray("WAVEfmt "));
+  QCOMPARE(header.mid(36, 4), QByteArray("data"));
+}
+
+
+void OfflineAudioRenderTest::testCaseBounceCancelled()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto path = dir.filePath("bounce.wav");
+
+  auto seq = makeSequence();
+  OfflineAudioRender render(seq, 0, 500);
+  std::atomic_bool running {true};
+  QVERIFY(!render.bounce(path, running, [&running] (const int) { running = false; }));
+  QVERIFY(!QFile::exists(path));
+}
+
+
+void OfflineAudioRenderTest::testCaseBounceSurround()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto path = dir.filePath("bounce.wav");
+
+  auto seq = makeSequence();
+  seq->setAudioLayout(AV_CH_LAYOUT_5POINT1);
+  OfflineAudioRender render(seq, 0, 10);
+  QCOMPARE(render.channels(), 6);
+  QCOMPARE(render.channelLayout(), static_cast<uint64_t>(AV_CH_LAYOUT_5POINT1));
+  // three times the samples of stereo
+  QCOMPARE(render.length(), 10 * FRAME_SAMPLES * 3);
+  render.enableMetering();
+  std::atomic_bool running {true};
+  QVERIFY(render.bounce(path, running));
+  QVERIFY(render.meter() != nullptr);
+  // metered on each channel rather than a stereo downmix
+  QCOMPARE(render.meter()->channels(), 6);
+
+  QFile file(path);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  QCOMPARE(file.size(), WAV_EXTENSIBLE_HEADER_BYTES + render.length() * static_cast<qint64>(sizeof(int16_t)));
+  const auto header = file.read(WAV_EXTENSIBLE_HEADER_BYTES);
+  QCOMPARE(header.mid(8, 8), QByteArray("WAVEfmt "));
+  // WAVE_FORMAT_EXTENSIBLE, 6 channels
+  QCOMPARE(header.mid(20, 4), QByteArray("\xFE\xFF\x06\x00", 4));
+  // the channel mask is the layout's
+  QCOMPARE(header.mid(40, 4), QByteArray("\x0F\x06\x00\x00", 4));
+  QCOMPARE(header.mid(60, 4), QByteArray("data"));
+}
@@ -0,0 +1,24 @@
+#ifndef OFFLINEAUDIORENDERTEST_H
+#define OFFLINEAUDIORENDERTEST_H
+
+#include <QObject>
+
+class OfflineAudioRenderTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit OfflineAudioRenderTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseEmptySequence();
+    void testCaseGeneratedClipSilent();
+    void testCaseSupports();
+    void testCaseBounce();
+    void testCaseBounceCancelled();
+    void testCaseBounceSurround();
+
+};
+
+#endif // OFFLINEAUDIORENDERTEST_H
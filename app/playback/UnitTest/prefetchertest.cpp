@@ -0,0 +1,109 @@
+#include "prefetchertest.h"
+#include <QtTest>
+
+#include "playback/prefetcher.h"
+
+using chestnut::playback::Prefetcher;
+using chestnut::playback::PrefetchWindow;
+
+namespace
+{
+  constexpr double RATE = 25.0;
+  constexpr int64_t FRAME_MSECS = 40;
+}
+
+PrefetcherTest::PrefetcherTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void PrefetcherTest::testCaseDefaultWindow()
+{
+  Prefetcher pre;
+  QCOMPARE(pre.direction(), 1);
+  QCOMPARE(pre.speed(), 1.0);
+  const auto win = pre.window(100, RATE, 2.0);
+  QCOMPARE(win.begin_, static_cast<int64_t>(100));
+  QCOMPARE(win.end_, static_cast<int64_t>(150));
+}
+
+
+void PrefetcherTest::testCaseBackwards()
+{
+  Prefetcher pre;
+  int64_t msecs = 0;
+  for (int64_t playhead = 200; playhead > 190; --playhead) {
+    pre.update(playhead, RATE, msecs);
+    msecs += FRAME_MSECS;
+  }
+  QCOMPARE(pre.direction(), -1);
+  const auto win = pre.window(190, RATE, 2.0);
+  QCOMPARE(win.begin_, static_cast<int64_t>(140));
+  QCOMPARE(win.end_, static_cast<int64_t>(190));
+}
+
+
+void PrefetcherTest::testCaseSpeed()
+{
+  Prefetcher pre;
+  int64_t msecs = 0;
+  int64_t playhead = 0;
+  for (int i = 0; i < 30; ++i) {
+    pre.update(playhead, RATE, msecs);
+    playhead += 4;
+    msecs += FRAME_MSECS;
+  }
+  QCOMPARE(pre.direction(), 1);
+  QVERIFY(pre.speed() > 3.9);
+  QVERIFY(pre.speed() <= 4.0);
+  const auto win = pre.window(0, RATE, 1.0);
+  QCOMPARE(win.begin_, static_cast<int64_t>(0));
+  QVERIFY(win.end_ >= 98);
+  QVERIFY(win.end_ <= 100);
+}
+
+
+void PrefetcherTest::testCaseJumpIgnored()
+{
+  Prefetcher pre;
+  pre.update(1000, RATE, 0);
+  pre.update(1001, RATE, FRAME_MSECS);
+  // a seek to the start is not a move backwards at great speed
+  pre.update(0, RATE, FRAME_MSECS * 2);
+  QCOMPARE(pre.direction(), 1);
+  QCOMPARE(pre.speed(), 1.0);
+  pre.update(1, RATE, FRAME_MSECS * 3);
+  QCOMPARE(pre.direction(), 1);
+}
+
+
+void PrefetcherTest::testCaseIdle()
+{
+  Prefetcher pre;
+  int64_t msecs = 0;
+  int64_t playhead = 1000;
+  for (int i = 0; i < 10; ++i) {
+    playhead -= 8;
+    msecs += FRAME_MSECS;
+    pre.update(playhead, RATE, msecs);
+  }
+  QVERIFY(pre.speed() > 1.0);
+  pre.update(playhead, RATE, msecs + 1000);
+  QCOMPARE(pre.speed(), 1.0);
+  // the direction of the last move is kept
+  QCOMPARE(pre.direction(), -1);
+  pre.reset();
+  QCOMPARE(pre.direction(), 1);
+}
+
+
+void PrefetcherTest::testCaseOverlaps()
+{
+  const PrefetchWindow win {100, 150};
+  QVERIFY(win.overlaps(150, 200));
+  QVERIFY(win.overlaps(50, 101));
+  QVERIFY(win.overlaps(0, 1000));
+  QVERIFY(!win.overlaps(151, 200));
+  QVERIFY(!win.overlaps(50, 100));
+}
@@ -0,0 +1,24 @@
+#ifndef PREFETCHERTEST_H
+#define PREFETCHERTEST_H
+
+#include <QObject>
+
+class PrefetcherTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit PrefetcherTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseDefaultWindow();
+    void testCaseBackwards();
+    void testCaseSpeed();
+    void testCaseJumpIgnored();
+    void testCaseIdle();
+    void testCaseOverlaps();
+
+};
+
+#endif // PREFETCHERTEST_H
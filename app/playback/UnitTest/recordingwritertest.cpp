@@ -0,0 +1,86 @@
+#include "recordingwritertest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <vector>
+
+#include "playback/recordingwriter.h"
+
+using chestnut::playback::RecordingWriter;
+
+namespace
+{
+  // the samples begin aligned, after the header and its padding
+  constexpr qint64 HEADER_BYTES = 4096;
+}
+
+RecordingWriterTest::RecordingWriterTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void RecordingWriterTest::testCaseSplitTracks()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QStringList paths {dir.filePath("left.wav"), dir.filePath("right.wav")};
+
+  constexpr int frames = 1000;
+  std::vector<int16_t> samples;
+  for (int16_t i = 0; i < frames; ++i) {
+    samples.push_back(i);
+    samples.push_back(static_cast<int16_t>(-i));
+  }
+  const auto data = reinterpret_cast<const char*>(samples.data());
+  const auto bytes = static_cast<qint64>(samples.size() * sizeof(int16_t));
+
+  RecordingWriter writer;
+  QVERIFY(writer.start(paths, 2, 48000));
+  // a write ending part way through a frame is completed by the next
+  QCOMPARE(writer.write(data, 7), static_cast<qint64>(7));
+  QCOMPARE(writer.write(data + 7, bytes - 7), bytes - 7);
+  QVERIFY(writer.finish());
+  QCOMPARE(writer.written(), static_cast<int64_t>(frames));
+  QCOMPARE(writer.overflows(), static_cast<uint64_t>(0));
+  QCOMPARE(writer.paths(), paths);
+
+  for (int c = 0; c < 2; ++c) {
+    QFile file(paths.at(c));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    // the space allocated ahead is given back
+    QCOMPARE(file.size(), HEADER_BYTES + frames * static_cast<qint64>(sizeof(int16_t)));
+    const auto header = file.read(HEADER_BYTES);
+    QCOMPARE(header.left(4), QByteArray("RIFF"));
+    QCOMPARE(header.mid(8, 8), QByteArray("WAVEfmt "));
+    // mono
+    QCOMPARE(header.mid(22, 2), QByteArray("\x01\x00", 2));
+    QCOMPARE(header.mid(HEADER_BYTES - 8, 4), QByteArray("data"));
+
+    const auto recorded = file.readAll();
+    const auto mono = reinterpret_cast<const int16_t*>(recorded.constData());
+    for (int i = 0; i < frames; ++i) {
+      QCOMPARE(mono[i], samples.at(static_cast<size_t>((i * 2) + c)));
+    }
+  }
+}
+
+
+void RecordingWriterTest::testCaseOverflow()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  // holding 4 seconds, so far less than is written at once
+  constexpr int rate = 100;
+  constexpr int frames = 10000;
+  const std::vector<int16_t> samples(frames, 1000);
+
+  RecordingWriter writer;
+  QVERIFY(writer.start({dir.filePath("take.wav")}, 1, rate));
+  const auto bytes = static_cast<qint64>(samples.size() * sizeof(int16_t));
+  // taken whole regardless, as the input mustn't wait
+  QCOMPARE(writer.write(reinterpret_cast<const char*>(samples.data()), bytes), bytes);
+  QVERIFY(writer.overflows() > 0);
+  QVERIFY(writer.finish());
+  QCOMPARE(static_cast<uint64_t>(writer.written()) + writer.overflows(), static_cast<uint64_t>(frames));
+}
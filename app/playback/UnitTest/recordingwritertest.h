@@ -0,0 +1,20 @@
+#ifndef RECORDINGWRITERTEST_H
+#define RECORDINGWRITERTEST_H
+
+#include <QObject>
+
+class RecordingWriterTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit RecordingWriterTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseSplitTracks();
+    void testCaseOverflow();
+
+};
+
+#endif // RECORDINGWRITERTEST_H
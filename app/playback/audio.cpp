@@ -28,8 +28,11 @@
 
 #include "io/config.h"
 #include "panels/panelmanager.h"
-#include "ui/audiomonitor.h"
 #include "playback/playback.h"
+#include "playback/audiomixer.h"
+#include "playback/audiometer.h"
+#include "playback/audioscrubber.h"
+#include "playback/recordingwriter.h"
 #include "debug.h"
 
 
@@ -37,19 +40,30 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 }
 using panels::PanelManager;
+using chestnut::playback::AudioMixer;
+using chestnut::playback::AudioMeter;
+using chestnut::playback::AudioScrubber;
+using chestnut::playback::RecordingWriter;
+
+namespace
+{
+  // 2048 stereo frames, ~43ms at 48kHz
+  constexpr int CHUNK_SAMPLES = 4096;
+  // kept queued in the device while scrubbing, so a grain is heard soon after it's pulled
+  constexpr int SCRUB_QUEUE_MILLIS = 10;
+  constexpr int FRAME_BYTES = 2 * static_cast<int>(sizeof(qint16));
+}
 
 QAudioOutput* audio_output;
 QIODevice* audio_io_device;
 bool audio_device_set = false;
 bool audio_scrub = false;
-QMutex audio_write_lock;
 QAudioInput* audio_input = nullptr;
-QFile output_recording;
+// drained to disk on its own thread, so the input isn't held up by the disk
+RecordingWriter recording_writer;
 bool audio_rendering = false;
 bool recording = false;
 
-qint8 audio_ibuffer[AUDIO_IBUFFER_SIZE];
-int audio_ibuffer_read = 0;
 long audio_ibuffer_frame = 0;
 double audio_ibuffer_timecode = 0;
 
@@ -98,6 +112,8 @@ void init_audio() {
     } else {
         audio_device_set = true;
 
+        AudioMeter::instance().start(audio_format.sampleRate());
+
         // start sender thread
         audio_thread = new AudioSenderThread();
         QObject::connect(audio_output, SIGNAL(notify()), audio_thread, SLOT(notifyReceiver()));
@@ -110,6 +126,8 @@ void init_audio() {
 void stop_audio() {
     if (audio_device_set) {
         audio_thread->stop();
+        audio_thread = nullptr;
+        AudioMeter::instance().stop();
 
         audio_output->stop();
         delete audio_output;
@@ -118,11 +136,9 @@ void stop_audio() {
 }
 
 void clear_audio_ibuffer() {
+    // the sender reads the mixer with this held
     if (audio_thread != nullptr) audio_thread->lock.lock();
-    audio_write_lock.lock();
-    memset(audio_ibuffer, 0, AUDIO_IBUFFER_SIZE);
-    audio_ibuffer_read = 0;
-    audio_write_lock.unlock();
+    AudioMixer::instance().clear();
     if (audio_thread != nullptr) audio_thread->lock.unlock();
 }
 
@@ -139,7 +155,7 @@ int get_buffer_offset_from_frame(double framerate, long frame) {
     }
 }
 
-AudioSenderThread::AudioSenderThread() : close(false) {
+AudioSenderThread::AudioSenderThread() : close(false), chunk(CHUNK_SAMPLES) {
     connect(this, SIGNAL(finished()), this, SLOT(deleteLater()));
 }
 
@@ -154,156 +170,70 @@ void AudioSenderThread::notifyReceiver() {
 }
 
 void AudioSenderThread::run() {
+    const int chunk_bytes = chunk.size() * static_cast<int>(sizeof(qint16));
+    lock.lock();
     // start data loop
-    send_audio_to_output(0, AUDIO_IBUFFER_SIZE);
+    send_audio_to_output();
 
-    lock.lock();
     while (true) {
         cond.wait(&lock);
         if (close) {
             break;
         } else if (PanelManager::sequenceViewer().playing || PanelManager::footageViewer().playing || audio_scrub) {
-            int written_bytes = 0;
-
-            int adjusted_read_index = audio_ibuffer_read % AUDIO_IBUFFER_SIZE;
-            int max_write = AUDIO_IBUFFER_SIZE - adjusted_read_index;
-            int actual_write = send_audio_to_output(adjusted_read_index, max_write);
-            written_bytes += actual_write;
-            if (actual_write == max_write) {
-                // got all the bytes, write again
-                written_bytes += send_audio_to_output(0, AUDIO_IBUFFER_SIZE);
-            }
-
+            // keep sending while the device takes whole chunks
+            while (send_audio_to_output() == chunk_bytes) {}
             audio_scrub = false;
+        } else if (AudioScrubber::instance().active()) {
+            send_scrub_to_output();
         }
     }
     lock.unlock();
-}
-
-int AudioSenderThread::send_audio_to_output(int offset, int max) {
-    // send audio to device
-    int actual_write = audio_io_device->write((const char*) audio_ibuffer+offset, max);
 
-    int audio_ibuffer_limit = audio_ibuffer_read + actual_write;
-
-    // send samples to audio monitor cache
-    // TODO make this work for the footage viewer - currently, enabling it causes crash due to an ASSERT
-    SequencePtr s;
-    /*if (panel_footage_viewer->playing) {
-        s = panel_footage_viewer->seq;
-    }*/
-    if (PanelManager::sequenceViewer().playing) {
-        s = PanelManager::sequenceViewer().getSequence();
+    const auto& mixer = AudioMixer::instance();
+    if ( (mixer.underruns() > 0) || (mixer.overruns() > 0) ) {
+        qInfo() << "Audio output underruns =" << mixer.underruns() << "overruns =" << mixer.overruns();
     }
-    if (s != nullptr) {
-        if (PanelManager::timeLine().audio_monitor->sample_cache_offset == -1) {
-            PanelManager::timeLine().audio_monitor->sample_cache_offset = s->playhead_;
-        }
-        int channel_count = av_get_channel_layout_nb_channels(s->audioLayout());
-        long sample_cache_playhead = PanelManager::timeLine().audio_monitor->sample_cache_offset
-            + (PanelManager::timeLine().audio_monitor->sample_cache.size() / channel_count);
-        int next_buffer_offset, buffer_offset_adjusted, i;
-        int buffer_offset = get_buffer_offset_from_frame(s->frameRate(), sample_cache_playhead);
-        if (samples.size() != channel_count) samples.resize(channel_count);
-        samples.fill(0);
-
-        // TODO: I don't like this, but i'm not sure if there's a smarter way to do it
-        while (buffer_offset < audio_ibuffer_limit) {
-            sample_cache_playhead++;
-            next_buffer_offset = qMin(get_buffer_offset_from_frame(s->frameRate(), sample_cache_playhead), audio_ibuffer_limit);
-            while (buffer_offset < next_buffer_offset) {
-                for (i=0;i<samples.size();i++) {
-                    buffer_offset_adjusted = buffer_offset%AUDIO_IBUFFER_SIZE;
-                    samples[i] = qMax(qAbs((qint16) (((audio_ibuffer[buffer_offset_adjusted+1] & 0xFF) << 8) | (audio_ibuffer[buffer_offset_adjusted] & 0xFF))), samples[i]);
-                    buffer_offset += 2;
-                }
-            }
-            PanelManager::timeLine().audio_monitor->sample_cache.append(samples);
-            buffer_offset = next_buffer_offset;
-        }
+    const auto latency = AudioScrubber::instance().latency();
+    if (latency.grains_ > 0) {
+        qInfo() << "Audio scrub grains =" << latency.grains_ << "latency (ms) mean =" << latency.mean_
+                << "max =" << latency.max_;
     }
-
-    memset(audio_ibuffer+offset, 0, actual_write);
-
-    audio_ibuffer_read = audio_ibuffer_limit;
-
-    return actual_write;
 }
 
-void int32_to_char_array(qint32 i, char* array) {
-    memcpy(array, &i, 4);
-}
-
-void write_wave_header(QFile& f, const QAudioFormat& format) {
-    qint32 int32bit;
-    char arr[4];
-
-    // 4 byte riff header
-    f.write("RIFF");
-
-    // 4 byte file size, filled in later
-    for (int i=0;i<4;i++) f.putChar(0);
-
-    // 4 byte file type header + 4 byte format chunk marker
-    f.write("WAVEfmt");
-    f.putChar(0x20);
-
-    // 4 byte length of the above format data (always 16 bytes)
-    f.putChar(16);
-    for (int i=0;i<3;i++) f.putChar(0);
-
-    // 2 byte type format (1 is PCM)
-    f.putChar(1);
-    f.putChar(0);
-
-    // 2 byte channel count
-    int32bit = format.channelCount();
-    int32_to_char_array(int32bit, arr);
-    f.write(arr, 2);
-
-    // 4 byte integer for sample rate
-    int32bit = format.sampleRate();
-    int32_to_char_array(int32bit, arr);
-    f.write(arr, 4);
-
-    // 4 byte integer for bytes per second
-    int32bit = (format.sampleRate() * format.sampleSize() * format.channelCount()) / 8;
-    int32_to_char_array(int32bit, arr);
-    f.write(arr, 4);
-
-    // 2 byte integer for bytes per sample per channel
-    int32bit = (format.sampleSize() * format.channelCount()) / 8;
-    int32_to_char_array(int32bit, arr);
-    f.write(arr, 2);
-
-    // 2 byte integer for bits per sample (16)
-    int32bit = format.sampleSize();
-    int32_to_char_array(int32bit, arr);
-    f.write(arr, 2);
+int AudioSenderThread::send_audio_to_output() {
+    // send audio to device. only samples the device took are taken from the mixer
+    auto& mixer = AudioMixer::instance();
+    const size_t mixed = mixer.peek(chunk.data(), static_cast<size_t>(chunk.size()));
+    const qint64 written = audio_io_device->write(reinterpret_cast<const char*>(chunk.constData()),
+                                                  chunk.size() * static_cast<int>(sizeof(qint16)));
+    if (written <= 0) {
+        return 0;
+    }
+    const auto taken = static_cast<size_t>(written) / sizeof(qint16);
+    mixer.consume(taken, qMin(mixed, taken));
+    const int actual_write = static_cast<int>(written);
 
-    // data chunk header
-    f.write("data");
+    // measured off this thread
+    AudioMeter::instance().push(chunk.constData(), taken);
 
-    // 4 byte integer for data chunk size (filled in later)?
-    for (int i=0;i<4;i++) f.putChar(0);
+    return actual_write;
 }
 
-void write_wave_trailer(QFile& f) {
-    char arr[4];
-
-    f.seek(4);
-
-    // 4 bytes for total file size - 8 bytes
-    qint32 file_size = f.size() - 8;
-    int32_to_char_array(file_size, arr);
-    f.write(arr, 4);
-
-    f.seek(40);
-
-    // 4 bytes for data chunk size (file size - header)
-    file_size = f.size() - 44;
-    int32_to_char_array(file_size, arr);
-    f.write(arr, 4);
+int AudioSenderThread::send_scrub_to_output() {
+    // only a little is queued in the device, so the next grain isn't heard after a long wait
+    const int rate = audio_output->format().sampleRate();
+    const int queued = (audio_output->bufferSize() - audio_output->bytesFree()) / FRAME_BYTES;
+    const int frames = qMin((rate * SCRUB_QUEUE_MILLIS / 1000) - queued, chunk.size() / 2);
+    if (frames <= 0) {
+        return 0;
+    }
+    AudioScrubber::instance().pull(chunk.data(), static_cast<size_t>(frames), rate, queued);
+    const qint64 written = audio_io_device->write(reinterpret_cast<const char*>(chunk.constData()), frames * FRAME_BYTES);
+    if (written <= 0) {
+        return 0;
+    }
+    AudioMeter::instance().push(chunk.constData(), static_cast<size_t>(written) / sizeof(qint16));
+    return static_cast<int>(written);
 }
 
 bool start_recording() {
@@ -319,19 +249,6 @@ bool start_recording() {
         return false;
     }
 
-    QString audio_filename;
-    int file_number = 0;
-    do {
-        file_number++;
-        audio_filename = audio_path + "/" + QCoreApplication::translate("Audio", "Recording") + " " + QString::number(file_number) + ".wav";
-    } while (QFile(audio_filename).exists());
-
-    output_recording.setFileName(audio_filename);
-    if (!output_recording.open(QFile::WriteOnly)) {
-        qCritical() << "Failed to open output file. Does Chestnut have permission to write to this directory?";
-        return false;
-    }
-
     QAudioFormat audio_format = audio_output->format();
     if (global::config.recording_mode != audio_format.channelCount()) {
         audio_format.setChannelCount(global::config.recording_mode);
@@ -341,9 +258,34 @@ bool start_recording() {
         qWarning() << "Default format not supported, using nearest";
         audio_format = info.nearestFormat(audio_format);
     }
-    write_wave_header(output_recording, audio_format);
-    audio_input = new QAudioInput(audio_format);
-    audio_input->start(&output_recording);
+    if ( (audio_format.sampleSize() != 16) || (audio_format.sampleType() != QAudioFormat::SignedInt)
+         || (audio_format.byteOrder() != QAudioFormat::LittleEndian) ) {
+        qCritical() << "Audio input doesn't support 16-bit recording";
+        return false;
+    }
+
+    // a file for each channel when recorded to a track of each, otherwise one for all
+    const int takes = global::config.split_recording_channels ? audio_format.channelCount() : 1;
+    QStringList audio_filenames;
+    int file_number = 0;
+    bool exists;
+    do {
+        file_number++;
+        audio_filenames.clear();
+        exists = false;
+        const QString name = audio_path + "/" + QCoreApplication::translate("Audio", "Recording") + " " + QString::number(file_number);
+        for (int i=0;i<takes;i++) {
+            audio_filenames.append(name + ((takes > 1) ? QString("-%1").arg(i + 1) : QString()) + ".wav");
+            exists = exists || QFile(audio_filenames.last()).exists();
+        }
+    } while (exists);
+
+    if (!recording_writer.start(audio_filenames, audio_format.channelCount(), audio_format.sampleRate())) {
+        qCritical() << "Failed to open output file. Does Chestnut have permission to write to this directory?";
+        return false;
+    }
+    audio_input = new QAudioInput(info, audio_format);
+    audio_input->start(&recording_writer);
     recording = true;
 
     return true;
@@ -353,9 +295,9 @@ void stop_recording() {
     if (recording) {
         audio_input->stop();
 
-        write_wave_trailer(output_recording);
-
-        output_recording.close();
+        if (!recording_writer.finish()) {
+            qCritical() << "Recording incomplete";
+        }
 
         delete audio_input;
         audio_input = nullptr;
@@ -363,6 +305,6 @@ void stop_recording() {
     }
 }
 
-QString get_recorded_audio_filename() {
-    return output_recording.fileName();
+QStringList get_recorded_audio_filenames() {
+    return recording_writer.paths();
 }
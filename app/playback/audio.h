@@ -19,13 +19,11 @@
 #define AUDIO_H
 
 #include <QVector>
+#include <QStringList>
 #include <QThread>
 #include <QWaitCondition>
 #include <QMutex>
 
-
-constexpr int AUDIO_IBUFFER_SIZE = 192000;
-
 class QIODevice;
 class QAudioOutput;
 
@@ -43,18 +41,19 @@ public:
 public slots:
 	void notifyReceiver();
 private:
-	QVector<qint16> samples;
-	int send_audio_to_output(int offset, int max);
+	// mixed samples sent to the device in one write
+	QVector<qint16> chunk;
+	int send_audio_to_output();
+	// grains of audio scrubbing, while not playing
+	int send_scrub_to_output();
 };
 
 //FIXME: christ almighty. Get rid of the globals, somehow.
 extern QAudioOutput* audio_output;
 extern QIODevice* audio_io_device;
 extern AudioSenderThread* audio_thread;
-extern QMutex audio_write_lock;
 
-extern qint8 audio_ibuffer[AUDIO_IBUFFER_SIZE];
-extern int audio_ibuffer_read;
+// the frame and time of the sequence at position 0 of the audio mixer
 extern long audio_ibuffer_frame;
 extern double audio_ibuffer_timecode;
 extern bool audio_scrub;
@@ -74,6 +73,7 @@ int get_buffer_offset_from_frame(double framerate, long frame);
 
 bool start_recording();
 void stop_recording();
-QString get_recorded_audio_filename();
+// of each track recorded
+QStringList get_recorded_audio_filenames();
 
 #endif // AUDIO_H
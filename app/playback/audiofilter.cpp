@@ -0,0 +1,166 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "audiofilter.h"
+
+#include <QtMath>
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+
+#include "debug.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavfilter/avfilter.h>
+#include <libavutil/opt.h>
+#include <libswresample/swresample.h>
+}
+
+namespace
+{
+  constexpr auto ERR_LEN = 256;
+  constexpr AVSampleFormat SAMPLE_FORMAT = AV_SAMPLE_FMT_S16;
+}
+
+
+bool chestnut::playback::buildAudioFilterGraph(AVFilterGraph& graph,
+                                               const AVStream& stream,
+                                               const AVCodecContext& codec_ctx,
+                                               const int sample_rate,
+                                               const uint64_t channel_layout,
+                                               const double speed,
+                                               const bool maintain_pitch,
+                                               AVFilterContext*& src,
+                                               AVFilterContext*& sink)
+{
+  std::array<char, ERR_LEN> err{};
+  const uint64_t source_layout = (codec_ctx.channel_layout != 0)
+                                 ? codec_ctx.channel_layout
+                                 : static_cast<uint64_t>(av_get_default_channel_layout(stream.codecpar->channels));
+  char filter_args[512];
+  snprintf(filter_args, sizeof(filter_args), "time_base=%d/%d:sample_rate=%d:sample_fmt=%s:channel_layout=0x%" PRIx64,
+           stream.time_base.num,
+           stream.time_base.den,
+           stream.codecpar->sample_rate,
+           av_get_sample_fmt_name(codec_ctx.sample_fmt),
+           source_layout
+           );
+
+  avfilter_graph_create_filter(&src, avfilter_get_by_name("abuffer"), "in", filter_args, nullptr, &graph);
+  avfilter_graph_create_filter(&sink, avfilter_get_by_name("abuffersink"), "out", nullptr, nullptr, &graph);
+
+  enum AVSampleFormat sample_fmts[] = { SAMPLE_FORMAT,  static_cast<AVSampleFormat>(-1) };
+  if (av_opt_set_int_list(sink, "sample_fmts", sample_fmts, -1, AV_OPT_SEARCH_CHILDREN) < 0) {
+    qCritical() << "Could not set output sample format";
+  }
+
+  int64_t channel_layouts[] = { static_cast<int64_t>(channel_layout), -1 };
+  if (av_opt_set_int_list(sink, "channel_layouts", channel_layouts, -1, AV_OPT_SEARCH_CHILDREN) < 0) {
+    qCritical() << "Could not set output channel layout";
+  }
+
+  int target_sample_rate = sample_rate;
+
+  if (qFuzzyCompare(speed, 1.0)) {
+    avfilter_link(src, 0, sink, 0);
+  } else if (maintain_pitch) {
+    AVFilterContext* previous_filter = src;
+    AVFilterContext* last_filter = src;
+
+    char speed_param[10];
+
+    double base = (speed > 1.0) ? 2.0 : 0.5;
+
+    double speedlog = log(speed) / log(base);
+    int whole2 = qFloor(speedlog);
+    speedlog -= whole2;
+
+    if (whole2 > 0) {
+      snprintf(speed_param, sizeof(speed_param), "%f", base);
+      for (int i=0;i<whole2;i++) {
+        AVFilterContext* tempo_filter = nullptr;
+        avfilter_graph_create_filter(&tempo_filter, avfilter_get_by_name("atempo"), "atempo", speed_param, nullptr, &graph);
+        avfilter_link(previous_filter, 0, tempo_filter, 0);
+        previous_filter = tempo_filter;
+      }
+    }
+
+    snprintf(speed_param, sizeof(speed_param), "%f", qPow(base, speedlog));
+    last_filter = nullptr;
+    avfilter_graph_create_filter(&last_filter, avfilter_get_by_name("atempo"), "atempo", speed_param, nullptr, &graph);
+    avfilter_link(previous_filter, 0, last_filter, 0);
+
+    avfilter_link(last_filter, 0, sink, 0);
+  } else {
+    target_sample_rate = qRound64(target_sample_rate / speed);
+    avfilter_link(src, 0, sink, 0);
+  }
+
+  int sample_rates[] = { target_sample_rate, 0 };
+  if (av_opt_set_int_list(sink, "sample_rates", sample_rates, 0, AV_OPT_SEARCH_CHILDREN) < 0) {
+    qCritical() << "Could not set output sample rates";
+  }
+
+  if (const auto ret = avfilter_graph_config(&graph, nullptr); ret < 0) {
+    av_strerror(ret, err.data(), ERR_LEN);
+    qCritical() << "Failed to configure audio filtergraph, msg =" << err.data();
+    return false;
+  }
+  return true;
+}
+
+
+std::vector<float> chestnut::playback::remixMatrix(const uint64_t from, const uint64_t to)
+{
+  const int channels = av_get_channel_layout_nb_channels(from);
+  const int remixed = av_get_channel_layout_nb_channels(to);
+  if ( (channels <= 0) || (remixed <= 0) ) {
+    return {};
+  }
+  // centre and surrounds at -3dB, no LFE, normalised so a full-scale remix doesn't clip
+  std::vector<double> matrix(static_cast<size_t>(channels * remixed));
+  if (const auto ret = swr_build_matrix(from, to, M_SQRT1_2, M_SQRT1_2, 0.0, 1.0, 1.0, matrix.data(), channels,
+                                        AV_MATRIX_ENCODING_NONE, nullptr); ret < 0) {
+    std::array<char, ERR_LEN> err{};
+    av_strerror(ret, err.data(), ERR_LEN);
+    qWarning() << "Could not build remix matrix, msg =" << err.data();
+    return {};
+  }
+  return std::vector<float>(matrix.begin(), matrix.end());
+}
+
+
+std::vector<double> chestnut::playback::loudnessWeights(const uint64_t layout)
+{
+  const int channels = av_get_channel_layout_nb_channels(layout);
+  std::vector<double> weights;
+  weights.reserve(static_cast<size_t>(std::max(channels, 0)));
+  for (int i = 0; i < channels; ++i) {
+    const auto channel = av_channel_layout_extract_channel(layout, i);
+    if ( (channel & (AV_CH_LOW_FREQUENCY | AV_CH_LOW_FREQUENCY_2)) != 0) {
+      weights.push_back(0.0);
+    } else if ( (channel & (AV_CH_SIDE_LEFT | AV_CH_SIDE_RIGHT
+                            | AV_CH_BACK_LEFT | AV_CH_BACK_RIGHT | AV_CH_BACK_CENTER)) != 0) {
+      weights.push_back(1.41);
+    } else {
+      weights.push_back(1.0);
+    }
+  }
+  return weights;
+}
@@ -0,0 +1,71 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIOFILTER_H
+#define AUDIOFILTER_H
+
+#include <cstdint>
+#include <vector>
+
+struct AVStream;
+struct AVCodecContext;
+struct AVFilterGraph;
+struct AVFilterContext;
+
+namespace chestnut::playback
+{
+  /**
+   * @brief                 Add the filters that bring decoded audio of a stream to interleaved 16-bit samples in a
+   *                        channel layout at a sample rate, played at a speed
+   * @param graph           Allocated graph to configure
+   * @param stream          Source of the samples
+   * @param codec_ctx       Decoder of the stream
+   * @param sample_rate     Of the filtered samples
+   * @param channel_layout  Of the filtered samples, AV_CH_LAYOUT_*
+   * @param speed           Of playback, 1.0 being as recorded
+   * @param maintain_pitch  Change the tempo, rather than resample, for a speed other than 1.0
+   * @param src             Set to the filter decoded frames are added to
+   * @param sink            Set to the filter filtered frames are taken from
+   * @return                true==success
+   */
+  bool buildAudioFilterGraph(AVFilterGraph& graph,
+                             const AVStream& stream,
+                             const AVCodecContext& codec_ctx,
+                             const int sample_rate,
+                             const uint64_t channel_layout,
+                             const double speed,
+                             const bool maintain_pitch,
+                             AVFilterContext*& src,
+                             AVFilterContext*& sink);
+
+  /**
+   * @brief       The gains that remix one channel layout to another, as libswresample would
+   * @param from  AV_CH_LAYOUT_*
+   * @param to    AV_CH_LAYOUT_*
+   * @return      A row of gains, one for each channel of from, for each channel of to. Empty on failure
+   */
+  std::vector<float> remixMatrix(const uint64_t from, const uint64_t to);
+
+  /**
+   * @brief         The weight of each channel's energy in its loudness, as ITU-R BS.1770 gives them
+   * @param layout  AV_CH_LAYOUT_*
+   * @return        One for each channel of layout: 0.0 for the LFE, 1.41 for the surrounds and 1.0 for the rest
+   */
+  std::vector<double> loudnessWeights(const uint64_t layout);
+}
+
+#endif // AUDIOFILTER_H
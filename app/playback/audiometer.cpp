@@ -0,0 +1,131 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "audiometer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "playback/mixkernels.h"
+
+using chestnut::playback::AudioMeter;
+using chestnut::playback::LoudnessMeter;
+
+namespace
+{
+  // 1 second of 48kHz stereo
+  constexpr size_t RING_CAPACITY = 96000;
+  // the most pushed at once without allocating on the output thread
+  constexpr size_t PUSH_SAMPLES = 8192;
+  // measured at once, in samples
+  constexpr size_t MEASURE_SAMPLES = 4800;
+  // between looking for samples, a fraction of a meter block
+  constexpr auto POLL_INTERVAL = std::chrono::milliseconds(10);
+}
+
+
+AudioMeter& AudioMeter::instance()
+{
+  static AudioMeter meter;
+  return meter;
+}
+
+
+AudioMeter::AudioMeter() : ring_(RING_CAPACITY), converted_(PUSH_SAMPLES)
+{
+
+}
+
+
+AudioMeter::~AudioMeter()
+{
+  stop();
+}
+
+
+void AudioMeter::start(const int sample_rate)
+{
+  stop();
+  ring_.reset();
+  meter_ = std::make_unique<LoudnessMeter>(sample_rate);
+  publish();
+  running_ = true;
+  thread_ = std::thread(&AudioMeter::run, this);
+}
+
+
+void AudioMeter::stop()
+{
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+
+void AudioMeter::push(const int16_t* samples, const size_t count)
+{
+  if (!running_ || (count > converted_.size()) || (ring_.space() < count)) {
+    // dropped whole, so the channels stay in step
+    return;
+  }
+  kernel::fromS16(samples, converted_.data(), count);
+  ring_.write(converted_.data(), count);
+}
+
+
+void AudioMeter::reset()
+{
+  reset_ = true;
+}
+
+
+LoudnessMeter::Levels AudioMeter::levels() const
+{
+  QMutexLocker locker(&levels_mutex_);
+  return levels_;
+}
+
+
+void AudioMeter::run()
+{
+  std::vector<float> samples(MEASURE_SAMPLES);
+  while (running_) {
+    if (reset_.exchange(false)) {
+      ring_.skip(ring_.available());
+      meter_->reset();
+      publish();
+    }
+    // whole frames only, the remainder staying for the next read
+    const size_t count = std::min(ring_.available(), samples.size()) & ~static_cast<size_t>(1);
+    if (count == 0) {
+      std::this_thread::sleep_for(POLL_INTERVAL);
+      continue;
+    }
+    ring_.read(samples.data(), count);
+    meter_->process(samples.data(), count / LoudnessMeter::CHANNELS);
+    publish();
+  }
+}
+
+
+void AudioMeter::publish()
+{
+  const auto levels = meter_->levels();
+  QMutexLocker locker(&levels_mutex_);
+  levels_ = levels;
+}
@@ -0,0 +1,91 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIOMETER_H
+#define AUDIOMETER_H
+
+#include <QMutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "playback/audioringbuffer.h"
+#include "playback/loudnessmeter.h"
+
+namespace chestnut::playback
+{
+  /**
+   * @brief Meters the samples sent to the audio output. The output copies them into a ring without locking, and they
+   *        are measured on a thread of the meter's own, so metering costs the realtime thread no more than the copy
+   */
+  class AudioMeter
+  {
+    public:
+      /**
+       * @brief   The meter of the audio output
+       * @return  meter
+       */
+      static AudioMeter& instance();
+
+      AudioMeter();
+      ~AudioMeter();
+
+      AudioMeter(const AudioMeter&) = delete;
+      AudioMeter& operator=(const AudioMeter&) = delete;
+
+      /**
+       * @brief             Start measuring. Nothing may be pushed meanwhile
+       * @param sample_rate Of the samples pushed
+       */
+      void start(const int sample_rate);
+      /**
+       * @brief Stop measuring. Nothing may be pushed meanwhile
+       */
+      void stop();
+      /**
+       * @brief         Copy samples sent to the output, for measuring. Lock-free, only one thread may do so
+       * @param samples Interleaved stereo
+       * @param count   Number of samples
+       */
+      void push(const int16_t* samples, const size_t count);
+      /**
+       * @brief Start a new measurement, dropping samples pushed but not yet measured
+       */
+      void reset();
+      /**
+       * @return  The levels last measured
+       */
+      LoudnessMeter::Levels levels() const;
+
+    private:
+      AudioRingBuffer ring_;
+      // pushed samples as converted for the ring
+      std::vector<float> converted_;
+      std::unique_ptr<LoudnessMeter> meter_;
+      std::thread thread_;
+      std::atomic_bool running_ {false};
+      std::atomic_bool reset_ {false};
+      mutable QMutex levels_mutex_;
+      LoudnessMeter::Levels levels_;
+
+      void run();
+      void publish();
+  };
+}
+
+#endif // AUDIOMETER_H
@@ -0,0 +1,216 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "audiomixer.h"
+
+#include <QtGlobal>
+#include <algorithm>
+
+#include "playback/mixkernels.h"
+
+using chestnut::playback::AudioMixer;
+using chestnut::playback::MixBus;
+using chestnut::playback::MixBusPtr;
+
+namespace
+{
+  // 1 second of 48kHz stereo
+  constexpr size_t OUTPUT_CAPACITY = 96000;
+  // with less mixed than this the output is about to run dry, in samples
+  constexpr int64_t LOW_WATER = 3000;
+}
+
+
+MixBus::MixBus(const size_t capacity) : ring_(capacity)
+{
+
+}
+
+
+AudioMixer& AudioMixer::instance()
+{
+  static AudioMixer mixer(OUTPUT_CAPACITY);
+  return mixer;
+}
+
+
+AudioMixer::AudioMixer(const size_t capacity) : output_(capacity)
+{
+
+}
+
+
+MixBusPtr AudioMixer::addBus()
+{
+  // a clip stages no further ahead than the lookahead
+  auto bus = std::make_shared<MixBus>(lookahead());
+  QMutexLocker locker(&mutex_);
+  // holds the mix back until the clip has staged at its own position
+  bus->ring_.reset(output_.writePosition());
+  buses_.push_back(bus);
+  bus_count_ = buses_.size();
+  return bus;
+}
+
+
+void AudioMixer::removeBus(const MixBusPtr& bus)
+{
+  QMutexLocker locker(&mutex_);
+  buses_.erase(std::remove(buses_.begin(), buses_.end(), bus), buses_.end());
+  bus_count_ = buses_.size();
+}
+
+
+size_t AudioMixer::stage(MixBus& bus, const int64_t position, const int16_t* samples, const size_t count)
+{
+  auto& ring = bus.ring_;
+  if (bus.cleared_ || (position != ring.writePosition())) {
+    // cleared or not following on from what was staged, so restart the bus there. the mixer may be reading it
+    QMutexLocker locker(&mutex_);
+    ring.reset(position);
+    bus.cleared_ = false;
+  }
+  auto& converted = bus.converted_;
+  converted.resize(qMin(count, ring.space()));
+  kernel::fromS16(samples, converted.data(), converted.size());
+  const size_t staged = ring.write(converted.data(), converted.size());
+  if (staged < count) {
+    overruns_ += count - staged;
+  }
+  return staged;
+}
+
+
+void AudioMixer::finish(MixBus& bus, const bool finished)
+{
+  bus.finished_ = finished;
+}
+
+
+void AudioMixer::mix(const bool realtime)
+{
+  QMutexLocker locker(&mutex_);
+  const int64_t from = output_.catchUp();
+  const int64_t read = output_.readPosition();
+  const int64_t limit = qMin(from + static_cast<int64_t>(output_.space()), read + static_cast<int64_t>(lookahead()));
+
+  // mix only as far as every clip has staged
+  int64_t to = limit;
+  for (const auto& bus : buses_) {
+    if (bus->cleared_) {
+      // yet to stage anything since
+      to = qMin(to, from);
+    } else if (!bus->finished_) {
+      to = qMin(to, bus->ring_.writePosition());
+    }
+  }
+  if (realtime) {
+    // ... unless the output would otherwise run dry. late clips lose what's mixed without them
+    to = qMax(to, qMin(limit, read + LOW_WATER));
+  }
+  if (to <= from) {
+    return;
+  }
+
+  const auto count = static_cast<size_t>(to - from);
+  sums_.assign(count, 0.0f);
+  for (const auto& bus : buses_) {
+    if (bus->cleared_) {
+      continue;
+    }
+    auto& ring = bus->ring_;
+    const int64_t begin = ring.readPosition();
+    if (begin < from) {
+      // already mixed without these
+      ring.skip(static_cast<size_t>(from - begin));
+    }
+    const int64_t start = qMax(from, begin);
+    if (start >= to) {
+      continue;
+    }
+    staged_.resize(static_cast<size_t>(to - start));
+    const size_t len = ring.peek(staged_.data(), staged_.size());
+    kernel::accumulate(staged_.data(), sums_.data() + (start - from), len);
+    ring.skip(len);
+  }
+  output_.write(sums_.data(), count);
+}
+
+
+size_t AudioMixer::read(float* dst, const size_t count)
+{
+  const size_t mixed = output_.peek(dst, count);
+  std::fill(dst + mixed, dst + count, 0.0f);
+  consume(count, mixed);
+  return mixed;
+}
+
+
+size_t AudioMixer::peek(int16_t* dst, const size_t count)
+{
+  peeked_.resize(count);
+  const size_t mixed = output_.peek(peeked_.data(), count);
+  std::fill(peeked_.begin() + static_cast<std::ptrdiff_t>(mixed), peeked_.end(), 0.0f);
+  kernel::toS16(peeked_.data(), dst, count);
+  return mixed;
+}
+
+
+void AudioMixer::consume(const size_t count, const size_t mixed)
+{
+  // silence with no clips playing is expected
+  if ( (count > mixed) && (bus_count_ > 0) ) {
+    ++underruns_;
+  }
+  output_.skip(count);
+}
+
+
+int64_t AudioMixer::position() const
+{
+  return output_.readPosition();
+}
+
+
+size_t AudioMixer::lookahead() const
+{
+  return output_.capacity() / 2;
+}
+
+
+void AudioMixer::clear()
+{
+  QMutexLocker locker(&mutex_);
+  output_.reset();
+  // a clip may be writing its bus, so only its own thread may reset it
+  for (const auto& bus : buses_) {
+    bus->cleared_ = true;
+    bus->finished_ = false;
+  }
+}
+
+
+uint64_t AudioMixer::underruns() const
+{
+  return underruns_;
+}
+
+
+uint64_t AudioMixer::overruns() const
+{
+  return overruns_;
+}
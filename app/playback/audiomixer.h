@@ -0,0 +1,165 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <QMutex>
+#include <memory>
+#include <vector>
+#include <atomic>
+
+#include "playback/audioringbuffer.h"
+
+namespace chestnut::playback
+{
+  class AudioMixer;
+
+  /**
+   * @brief Samples of one clip staged for mixing, written only by the thread caching that clip
+   */
+  class MixBus
+  {
+    public:
+      explicit MixBus(const size_t capacity);
+
+      MixBus() = delete;
+      MixBus(const MixBus&) = delete;
+      MixBus& operator=(const MixBus&) = delete;
+
+    private:
+      friend class AudioMixer;
+      AudioRingBuffer ring_;
+      // staged samples as converted for the ring
+      std::vector<float> converted_;
+      // the clip has nothing more to stage, so the mix doesn't wait on it
+      std::atomic_bool finished_ {false};
+      // the mixer was cleared, so the ring is reset by the clip's thread when it next stages. until then nothing
+      // staged is mixed
+      std::atomic_bool cleared_ {false};
+  };
+
+  using MixBusPtr = std::shared_ptr<MixBus>;
+
+  /**
+   * @brief Sums the staged samples of all clips into a ring read by the audio output.
+   *        Clips stage and mix from the decode threads, which contend only amongst themselves. The output reads the
+   *        ring without locking. Samples are mixed as float, so are only clipped when converted for the device.
+   *        They are mixed interleaved, as staged and as read
+   */
+  class AudioMixer
+  {
+    public:
+      /**
+       * @brief   The mixer used for playback and export
+       * @return  mixer
+       */
+      static AudioMixer& instance();
+
+      /**
+       * @param capacity  Of the output ring, in samples
+       */
+      explicit AudioMixer(const size_t capacity);
+
+      AudioMixer() = delete;
+      AudioMixer(const AudioMixer&) = delete;
+      AudioMixer& operator=(const AudioMixer&) = delete;
+
+      /**
+       * @brief   Create a bus for a clip to stage its samples in
+       * @return  bus, mixed until removed
+       */
+      MixBusPtr addBus();
+      void removeBus(const MixBusPtr& bus);
+
+      /**
+       * @brief           Stage samples of a clip
+       * @param bus       The clip's
+       * @param position  Output position of the first sample
+       * @param samples
+       * @param count     Number of samples
+       * @return          Number staged, fewer than count when the bus is full
+       */
+      size_t stage(MixBus& bus, const int64_t position, const int16_t* samples, const size_t count);
+      /**
+       * @brief           Mark whether a clip has staged all of its samples
+       * @param bus
+       * @param finished
+       */
+      void finish(MixBus& bus, const bool finished);
+      /**
+       * @brief           Mix what has been staged into the output
+       * @param realtime  Output is being played, so clips too late for it are not waited on
+       */
+      void mix(const bool realtime);
+
+      /**
+       * @brief         Read the output. Lock-free, only one thread may do so
+       * @param dst
+       * @param count   Number of samples
+       * @return        Number of samples mixed, the remainder being silence
+       */
+      size_t read(float* dst, const size_t count);
+      /**
+       * @brief         Copy the output without taking it, padded with silence, converted to 16-bit for the device
+       * @param dst
+       * @param count   Number of samples
+       * @return        Number of samples mixed
+       */
+      size_t peek(int16_t* dst, const size_t count);
+      /**
+       * @brief         Take samples of the output after peek()
+       * @param count   Number of samples taken
+       * @param mixed   Number that peek() found mixed
+       */
+      void consume(const size_t count, const size_t mixed);
+      /**
+       * @return  Output position of the next sample read
+       */
+      int64_t position() const;
+      /**
+       * @return  How far past position() clips are to stage samples, in samples
+       */
+      size_t lookahead() const;
+
+      /**
+       * @brief Drop everything mixed and staged, restarting at position 0. The output must not be read meanwhile.
+       *        Clips may still be staging, as each bus is only reset by its own clip's thread
+       */
+      void clear();
+
+      // reads of the output short of samples while clips were playing
+      uint64_t underruns() const;
+      // samples offered to buses that were full
+      uint64_t overruns() const;
+
+    private:
+      AudioRingBuffer output_;
+      // held by whoever mixes, stages out of order or changes the buses. never the output
+      QMutex mutex_;
+      std::vector<MixBusPtr> buses_;
+      std::atomic<size_t> bus_count_ {0};
+      std::vector<float> sums_;
+      std::vector<float> staged_;
+      // output being converted, by the reader only
+      std::vector<float> peeked_;
+      std::atomic<uint64_t> underruns_ {0};
+      std::atomic<uint64_t> overruns_ {0};
+  };
+}
+
+#endif // AUDIOMIXER_H
@@ -0,0 +1,147 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "audioringbuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+using chestnut::playback::AudioRingBuffer;
+
+
+AudioRingBuffer::AudioRingBuffer(const size_t capacity)
+  : samples_(std::max(capacity, static_cast<size_t>(1)), 0)
+{
+
+}
+
+
+size_t AudioRingBuffer::write(const float* src, const size_t count)
+{
+  const int64_t pos = write_.load(std::memory_order_relaxed);
+  const size_t len = std::min(count, space());
+  if (len < count) {
+    ++overruns_;
+  }
+  const size_t start = index(pos);
+  const size_t first = std::min(len, samples_.size() - start);
+  memcpy(samples_.data() + start, src, first * sizeof(float));
+  memcpy(samples_.data(), src + first, (len - first) * sizeof(float));
+  // publish the samples before the position
+  write_.store(pos + static_cast<int64_t>(len), std::memory_order_release);
+  return len;
+}
+
+
+int64_t AudioRingBuffer::catchUp()
+{
+  const int64_t rd = read_.load(std::memory_order_acquire);
+  const int64_t wr = write_.load(std::memory_order_relaxed);
+  if (wr < rd) {
+    write_.store(rd, std::memory_order_release);
+    return rd;
+  }
+  return wr;
+}
+
+
+int64_t AudioRingBuffer::writePosition() const
+{
+  return write_.load(std::memory_order_acquire);
+}
+
+
+size_t AudioRingBuffer::space() const
+{
+  return samples_.size() - available();
+}
+
+
+size_t AudioRingBuffer::read(float* dst, const size_t count)
+{
+  const size_t len = peek(dst, count);
+  if (len < count) {
+    ++underruns_;
+    std::fill(dst + len, dst + count, 0);
+  }
+  skip(count);
+  return len;
+}
+
+
+size_t AudioRingBuffer::peek(float* dst, const size_t count) const
+{
+  const int64_t pos = read_.load(std::memory_order_relaxed);
+  const size_t len = std::min(count, available());
+  const size_t start = index(pos);
+  const size_t first = std::min(len, samples_.size() - start);
+  memcpy(dst, samples_.data() + start, first * sizeof(float));
+  memcpy(dst + first, samples_.data(), (len - first) * sizeof(float));
+  return len;
+}
+
+
+void AudioRingBuffer::skip(const size_t count)
+{
+  // release, so the producer doesn't overwrite samples before they've been copied
+  read_.fetch_add(static_cast<int64_t>(count), std::memory_order_release);
+}
+
+
+int64_t AudioRingBuffer::readPosition() const
+{
+  return read_.load(std::memory_order_acquire);
+}
+
+
+size_t AudioRingBuffer::available() const
+{
+  const int64_t diff = write_.load(std::memory_order_acquire) - read_.load(std::memory_order_acquire);
+  return (diff > 0) ? static_cast<size_t>(diff) : 0;
+}
+
+
+void AudioRingBuffer::reset(const int64_t position)
+{
+  read_ = position;
+  write_ = position;
+}
+
+
+size_t AudioRingBuffer::capacity() const
+{
+  return samples_.size();
+}
+
+
+uint64_t AudioRingBuffer::underruns() const
+{
+  return underruns_;
+}
+
+
+uint64_t AudioRingBuffer::overruns() const
+{
+  return overruns_;
+}
+
+
+size_t AudioRingBuffer::index(const int64_t position) const
+{
+  const auto size = static_cast<int64_t>(samples_.size());
+  return static_cast<size_t>(((position % size) + size) % size);
+}
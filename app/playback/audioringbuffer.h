@@ -0,0 +1,108 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIORINGBUFFER_H
+#define AUDIORINGBUFFER_H
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace chestnut::playback
+{
+  /**
+   * @brief A lock-free ring of interleaved float samples between one producer thread and one consumer thread.
+   *        Positions are absolute sample counts, so either side can refer to a point in time by them
+   */
+  class AudioRingBuffer
+  {
+    public:
+      /**
+       * @param capacity  Number of samples held at most
+       */
+      explicit AudioRingBuffer(const size_t capacity);
+
+      AudioRingBuffer() = delete;
+      AudioRingBuffer(const AudioRingBuffer&) = delete;
+      AudioRingBuffer& operator=(const AudioRingBuffer&) = delete;
+
+      /* producer */
+
+      /**
+       * @brief         Append samples after those already written
+       * @param src
+       * @param count   Number of samples
+       * @return        Number written, fewer than count if there wasn't the space (an overrun)
+       */
+      size_t write(const float* src, const size_t count);
+      /**
+       * @brief   Move the write position up to the read position, if the consumer has passed it
+       * @return  write position
+       */
+      int64_t catchUp();
+      int64_t writePosition() const;
+      size_t space() const;
+
+      /* consumer */
+
+      /**
+       * @brief         Take samples, silence filling in for any not yet written
+       * @param dst
+       * @param count   Number of samples
+       * @return        Number of samples written by the producer, fewer than count on an underrun
+       */
+      size_t read(float* dst, const size_t count);
+      /**
+       * @brief         Copy samples without taking them
+       * @param dst
+       * @param count   Number of samples at most
+       * @return        Number copied
+       */
+      size_t peek(float* dst, const size_t count) const;
+      /**
+       * @brief         Move the read position on, which may pass the write position
+       * @param count   Number of samples
+       */
+      void skip(const size_t count);
+      int64_t readPosition() const;
+      size_t available() const;
+
+      /**
+       * @brief           Empty, with both positions at a point. Neither side may be in use
+       * @param position
+       */
+      void reset(const int64_t position = 0);
+
+      size_t capacity() const;
+      // reads short of samples
+      uint64_t underruns() const;
+      // writes short of space
+      uint64_t overruns() const;
+
+    private:
+      std::vector<float> samples_;
+      std::atomic<int64_t> read_ {0};
+      std::atomic<int64_t> write_ {0};
+      std::atomic<uint64_t> underruns_ {0};
+      std::atomic<uint64_t> overruns_ {0};
+
+      size_t index(const int64_t position) const;
+  };
+}
+
+#endif // AUDIORINGBUFFER_H
@@ -0,0 +1,307 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "audioscrubber.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "playback/audio.h"
+#include "playback/audiofilter.h"
+#include "playback/mixkernels.h"
+#include "playback/offlineaudiorender.h"
+#include "playback/playback.h"
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+}
+
+using chestnut::playback::AudioScrubber;
+
+namespace
+{
+  constexpr int CHANNELS = 2;
+  // of a window of the sequence's audio rendered at once
+  constexpr double WINDOW_SECONDS = 0.25;
+  // windows either side of the playhead kept
+  constexpr long KEPT_WINDOWS = 8;
+  // of the crossfade between grains and the fades at their ends
+  constexpr double FADE_SECONDS = 0.005;
+}
+
+
+AudioScrubber& AudioScrubber::instance()
+{
+  static AudioScrubber scrubber;
+  return scrubber;
+}
+
+
+AudioScrubber::AudioScrubber()
+{
+  thread_ = std::thread(&AudioScrubber::run, this);
+}
+
+
+AudioScrubber::~AudioScrubber()
+{
+  QMutexLocker lock(&mutex_);
+  running_ = false;
+  lock.unlock();
+  wait_cond_.wakeAll();
+  thread_.join();
+}
+
+
+bool AudioScrubber::scrub(SequencePtr sequence, const long frame)
+{
+  if ( (sequence == nullptr) || !OfflineAudioRender::supports(*sequence) ) {
+    return false;
+  }
+  if (e_rendering) {
+    // an export is running the clips' effects. nothing is heard of the seeks it makes
+    return true;
+  }
+  QMutexLocker lock(&mutex_);
+  request_sequence_ = std::move(sequence);
+  request_frame_ = std::max(frame, 0L);
+  requested_ = Clock::now();
+  pending_ = true;
+  stopped_ = false;
+  lock.unlock();
+  wait_cond_.wakeAll();
+  return true;
+}
+
+
+void AudioScrubber::play(std::shared_ptr<const std::vector<float>> samples, const size_t offset, const size_t frames,
+                         const int rate)
+{
+  Q_ASSERT(samples != nullptr);
+  Q_ASSERT(((offset + frames) * CHANNELS) <= samples->size());
+  auto grain = std::make_shared<Grain>();
+  grain->window_ = std::move(samples);
+  grain->offset_ = offset;
+  grain->frames_ = frames;
+  grain->rate_ = rate;
+  grain->requested_ = Clock::now();
+  present(grain);
+}
+
+
+void AudioScrubber::invalidate()
+{
+  QMutexLocker lock(&mutex_);
+  invalidated_ = true;
+}
+
+
+void AudioScrubber::stop()
+{
+  QMutexLocker lock(&mutex_);
+  pending_ = false;
+  stopped_ = true;
+  while (rendering_) {
+    idle_cond_.wait(&mutex_);
+  }
+}
+
+
+void AudioScrubber::pull(int16_t* dst, const size_t frames, const int rate, const int64_t queued)
+{
+  Q_ASSERT(dst != nullptr);
+  Q_ASSERT(rate > 0);
+  const auto latest = std::atomic_load(&grain_);
+  if ( (latest != nullptr) && (latest != started_) ) {
+    started_ = latest;
+    auto& current = voices_.at(0);
+    if (current.grain_ != nullptr) {
+      auto& previous = voices_.at(1);
+      previous = current;
+      previous.fade_ = std::max(qRound(rate * FADE_SECONDS), 1);
+    }
+    current = Voice{latest, 0.0, -1};
+
+    // the wait for the grain to be rendered and reach the output, and then the wait for the device to play it
+    const auto waited = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - latest->requested_);
+    const int64_t micros = waited.count() + ((queued * 1000000) / rate);
+    latency_sum_ += micros;
+    latency_max_ = std::max(latency_max_.load(), micros);
+    ++grains_;
+  }
+
+  const size_t count = frames * CHANNELS;
+  if (mixed_.size() < count) {
+    mixed_.resize(count);
+  }
+  std::fill_n(mixed_.begin(), count, 0.0f);
+  const auto fade = static_cast<double>(std::max(qRound(rate * FADE_SECONDS), 1));
+  for (auto& voice : voices_) {
+    const auto grain = voice.grain_;
+    if (grain == nullptr) {
+      continue;
+    }
+    const double step = static_cast<double>(grain->rate_) / rate;
+    const double grain_fade = grain->rate_ * FADE_SECONDS;
+    const auto last = static_cast<double>(grain->frames_ - 1);
+    const float* samples = grain->window_->data() + (grain->offset_ * CHANNELS);
+    for (size_t i = 0; i < frames; ++i) {
+      const double position = voice.position_;
+      if ( (position >= last) || (voice.fade_ == 0) ) {
+        voice.grain_ = nullptr;
+        break;
+      }
+      // interpolated, for a sequence at a rate other than the device's
+      const auto index = static_cast<size_t>(position);
+      const auto frac = static_cast<float>(position - index);
+      double envelope = std::min({1.0, (position + 1.0) / grain_fade, (last - position) / grain_fade});
+      if (voice.fade_ > 0) {
+        envelope *= voice.fade_ / fade;
+        --voice.fade_;
+      }
+      for (size_t c = 0; c < CHANNELS; ++c) {
+        const float a = samples[(index * CHANNELS) + c];
+        const float b = samples[((index + 1) * CHANNELS) + c];
+        mixed_[(i * CHANNELS) + c] += (a + ((b - a) * frac)) * static_cast<float>(envelope);
+      }
+      voice.position_ += step;
+    }
+  }
+  kernel::toS16(mixed_.data(), dst, count);
+}
+
+
+bool AudioScrubber::active() const
+{
+  return (voices_.at(0).grain_ != nullptr) || (voices_.at(1).grain_ != nullptr)
+      || (std::atomic_load(&grain_) != started_);
+}
+
+
+AudioScrubber::Latency AudioScrubber::latency() const
+{
+  Latency latency;
+  latency.grains_ = grains_;
+  if (latency.grains_ > 0) {
+    latency.mean_ = latency_sum_ / 1000.0 / latency.grains_;
+    latency.max_ = latency_max_ / 1000.0;
+  }
+  return latency;
+}
+
+
+void AudioScrubber::run()
+{
+  QMutexLocker lock(&mutex_);
+  while (running_) {
+    if (!pending_) {
+      wait_cond_.wait(&mutex_);
+      continue;
+    }
+    const auto sequence = request_sequence_;
+    const auto frame = request_frame_;
+    const auto requested = requested_;
+    pending_ = false;
+    rendering_ = true;
+    if (invalidated_ || (sequence != sequence_)) {
+      windows_.clear();
+      sequence_ = sequence;
+      invalidated_ = false;
+    }
+    lock.unlock();
+
+    const long length = windowFrames();
+    const long index = frame / length;
+    const auto win = window(index);
+    const int rate = sequence_->audioFrequency();
+    const auto window_frames = static_cast<int64_t>(win->size() / CHANNELS);
+    const auto offset = std::min<int64_t>(qRound64((frame - (index * length)) / sequence_->frameRate() * rate), window_frames);
+    const auto frames = std::min<int64_t>(qRound64(rate / sequence_->frameRate()), window_frames - offset);
+    if (frames > 1) {
+      auto grain = std::make_shared<Grain>();
+      grain->window_ = win;
+      grain->offset_ = static_cast<size_t>(offset);
+      grain->frames_ = static_cast<size_t>(frames);
+      grain->rate_ = rate;
+      grain->requested_ = requested;
+      present(grain);
+    }
+
+    // the windows the playhead is dragged on to, unless it already has been
+    for (const auto next : {index + 1, index - 1}) {
+      lock.relock();
+      const bool waiting = pending_ || invalidated_ || stopped_ || !running_;
+      lock.unlock();
+      if (waiting) {
+        break;
+      }
+      if (next >= 0) {
+        window(next);
+      }
+    }
+    for (auto it = windows_.begin(); it != windows_.end();) {
+      if (std::abs(it->first - index) > KEPT_WINDOWS) {
+        it = windows_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    lock.relock();
+    rendering_ = false;
+    idle_cond_.wakeAll();
+  }
+}
+
+
+void AudioScrubber::present(GrainPtr grain)
+{
+  std::atomic_store(&grain_, std::move(grain));
+  if (audio_thread != nullptr) {
+    audio_thread->notifyReceiver();
+  }
+}
+
+
+AudioScrubber::WindowPtr AudioScrubber::window(const long index)
+{
+  if (const auto it = windows_.find(index); it != windows_.end()) {
+    return it->second;
+  }
+  // a frame longer than the step between windows, so a grain starting in one ends in it too
+  const long length = windowFrames();
+  OfflineAudioRender render(sequence_, index * length, ((index + 1) * length) + 1);
+  auto win = std::make_shared<Window>(static_cast<size_t>(render.length()));
+  render.render(win->data(), win->size());
+  if (render.channels() != CHANNELS) {
+    // grains are played on the stereo device, so a window of other channels is downmixed once as it's rendered
+    const auto frames = win->size() / static_cast<size_t>(render.channels());
+    const auto matrix = remixMatrix(render.channelLayout(), AV_CH_LAYOUT_STEREO);
+    auto remixed = std::make_shared<Window>(frames * CHANNELS, 0.0f);
+    if (!matrix.empty()) {
+      kernel::remix(win->data(), render.channels(), matrix.data(), CHANNELS, remixed->data(), frames);
+    }
+    win = remixed;
+  }
+  windows_[index] = win;
+  return win;
+}
+
+
+long AudioScrubber::windowFrames() const
+{
+  return std::max(qRound(sequence_->frameRate() * WINDOW_SECONDS), 1);
+}
@@ -0,0 +1,180 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIOSCRUBBER_H
+#define AUDIOSCRUBBER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "project/sequence.h"
+
+namespace chestnut::playback
+{
+  /**
+   * @brief Plays the audio under the playhead as it is dragged. A sequence's audio is rendered offline a short window
+   *        at a time, clips reading their footage's conformed audio where there is some, and the windows around the
+   *        playhead are kept in memory. Each move of the playhead plays a grain of one frame from them, crossfaded
+   *        from the last, pulled by the audio output a little at a time so it is heard without waiting on playback
+   */
+  class AudioScrubber
+  {
+    public:
+      struct Latency
+      {
+        // from a move of the playhead until its grain is heard, in milliseconds
+        double mean_ {0.0};
+        double max_ {0.0};
+        uint64_t grains_ {0};
+      };
+
+      /**
+       * @brief   The scrubber of the audio output
+       * @return  scrubber
+       */
+      static AudioScrubber& instance();
+
+      AudioScrubber();
+      ~AudioScrubber();
+
+      AudioScrubber(const AudioScrubber&) = delete;
+      AudioScrubber& operator=(const AudioScrubber&) = delete;
+
+      /**
+       * @brief           Play a grain of a sequence's audio, replacing any requested but not yet rendered
+       * @param sequence
+       * @param frame     Of the playhead
+       * @return          false==the sequence can't be scrubbed this way. Nothing is played while rendering
+       */
+      bool scrub(SequencePtr sequence, const long frame);
+      /**
+       * @brief         Play a grain of samples already rendered, crossfaded from the last as a scrub's is
+       * @param samples Interleaved float stereo
+       * @param offset  Of the grain in the samples, in sample frames
+       * @param frames  Of the grain
+       * @param rate    Of the samples
+       */
+      void play(std::shared_ptr<const std::vector<float>> samples, const size_t offset, const size_t frames,
+                const int rate);
+      /**
+       * @brief Drop the windows rendered, as the sequence has been edited
+       */
+      void invalidate();
+      /**
+       * @brief Drop the request not yet rendered and wait for any window being rendered, so the sequence's clips and
+       *        effects are left to playback and edits. Rendering resumes with the next scrub()
+       */
+      void stop();
+
+      /* audio output, from one thread only */
+
+      /**
+       * @brief         Take the grains' samples, mixed and converted for the device
+       * @param dst     Interleaved 16-bit stereo
+       * @param frames  Number of sample frames
+       * @param rate    Sample rate of the device
+       * @param queued  Sample frames written to the device but not yet heard, to measure latency by
+       */
+      void pull(int16_t* dst, const size_t frames, const int rate, const int64_t queued);
+      /**
+       * @return  true==there are grains to pull
+       */
+      bool active() const;
+
+      /**
+       * @return  Measured of the grains pulled so far
+       */
+      Latency latency() const;
+
+    private:
+      using Window = std::vector<float>;
+      using WindowPtr = std::shared_ptr<const Window>;
+      using Clock = std::chrono::steady_clock;
+
+      struct Grain
+      {
+        WindowPtr window_;
+        // in the window, in sample frames
+        size_t offset_ {0};
+        size_t frames_ {0};
+        int rate_ {0};
+        Clock::time_point requested_;
+      };
+      using GrainPtr = std::shared_ptr<const Grain>;
+
+      struct Voice
+      {
+        GrainPtr grain_;
+        // in the grain, in its sample frames
+        double position_ {0.0};
+        // output sample frames until faded out, when replaced by a newer grain
+        int fade_ {-1};
+      };
+
+      std::thread thread_;
+      std::atomic_bool running_ {true};
+      QMutex mutex_;
+      QWaitCondition wait_cond_;
+      // the latest request, not yet rendered
+      SequencePtr request_sequence_;
+      long request_frame_ {0};
+      Clock::time_point requested_;
+      bool pending_ {false};
+      bool invalidated_ {false};
+      bool stopped_ {false};
+      // a window is being rendered from the sequence
+      bool rendering_ {false};
+      QWaitCondition idle_cond_;
+
+      // rendering thread only
+      SequencePtr sequence_;
+      std::map<long, WindowPtr> windows_;
+
+      // the latest grain rendered, taken up by the output
+      GrainPtr grain_;
+      // output only
+      GrainPtr started_;
+      std::array<Voice, 2> voices_;
+      std::vector<float> mixed_;
+      std::atomic<int64_t> latency_sum_ {0};
+      std::atomic<int64_t> latency_max_ {0};
+      std::atomic<uint64_t> grains_ {0};
+
+      void run();
+      /**
+       * @brief       Replace the grain the output takes up next
+       * @param grain
+       */
+      void present(GrainPtr grain);
+      /**
+       * @brief       The window of the sequence's audio, rendering it if it hasn't been
+       * @param index Of the window
+       * @return      Interleaved float stereo at the sequence's rate
+       */
+      WindowPtr window(const long index);
+      long windowFrames() const;
+  };
+}
+
+#endif // AUDIOSCRUBBER_H
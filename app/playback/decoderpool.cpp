@@ -0,0 +1,237 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "decoderpool.h"
+
+#include <QtGlobal>
+#include <array>
+
+#include "io/config.h"
+#include "debug.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+using chestnut::playback::DecoderContext;
+using chestnut::playback::DecoderContextPtr;
+using chestnut::playback::DecoderPool;
+
+namespace
+{
+  constexpr auto ERR_LEN = 256;
+}
+
+DecoderContext::DecoderContext(QString location, const int stream_index)
+  : location_(std::move(location)),
+    stream_index_(stream_index)
+{
+
+}
+
+DecoderContext::~DecoderContext()
+{
+  avcodec_free_context(&codec_ctx_);
+  av_dict_free(&opts_);
+  avformat_close_input(&format_ctx_);
+}
+
+
+bool DecoderContext::open()
+{
+  const auto filename = location_.toUtf8();
+  std::array<char, ERR_LEN> err{};
+
+  int err_code = avformat_open_input(&format_ctx_, filename.data(), nullptr, nullptr);
+  if (err_code != 0) {
+    av_strerror(err_code, err.data(), ERR_LEN);
+    qCritical() << "Could not open" << location_ << "-" << err.data();
+    return false;
+  }
+
+  err_code = avformat_find_stream_info(format_ctx_, nullptr);
+  if (err_code < 0) {
+    av_strerror(err_code, err.data(), ERR_LEN);
+    qCritical() << "Could not open" << location_ << "-" << err.data();
+    return false;
+  }
+
+  av_dump_format(format_ctx_, 0, filename.data(), 0);
+
+  if ( (stream_index_ < 0) || (static_cast<unsigned int>(stream_index_) >= format_ctx_->nb_streams) ) {
+    qCritical() << "Stream index out of range, index =" << stream_index_ << "file =" << location_;
+    return false;
+  }
+
+  stream_ = format_ctx_->streams[stream_index_];
+  if ( (stream_ == nullptr) || (stream_->codecpar == nullptr) ) {
+    qCritical() << "Stream Info instance(s) are null";
+    return false;
+  }
+  codec_ = avcodec_find_decoder(stream_->codecpar->codec_id);
+  codec_ctx_ = avcodec_alloc_context3(codec_);
+  avcodec_parameters_to_context(codec_ctx_, stream_->codecpar);
+
+  // optimized decoding settings
+  if ((stream_->codecpar->codec_id != AV_CODEC_ID_PNG &&
+       stream_->codecpar->codec_id != AV_CODEC_ID_APNG &&
+       stream_->codecpar->codec_id != AV_CODEC_ID_TIFF
+   #ifndef DISABLE_PSD
+       && stream_->codecpar->codec_id != AV_CODEC_ID_PSD)
+  #else
+       )
+  #endif
+      || !global::config.disable_multithreading_for_images) {
+    av_dict_set(&opts_, "threads", "auto", 0);
+  }
+  if (stream_->codecpar->codec_id == AV_CODEC_ID_H264) {
+    av_dict_set(&opts_, "tune", "fastdecode", 0);
+    av_dict_set(&opts_, "tune", "zerolatency", 0);
+  }
+
+  // Open codec
+  if (avcodec_open2(codec_ctx_, codec_, &opts_) < 0) {
+    qCritical() << "Could not open codec";
+    return false;
+  }
+  return true;
+}
+
+
+void DecoderContext::flush()
+{
+  if (codec_ctx_ != nullptr) {
+    avcodec_flush_buffers(codec_ctx_);
+  }
+  last_pts_ = NO_PTS;
+  drained_ = false;
+}
+
+
+bool DecoderContext::canContinueTo(const int64_t timestamp, const int64_t window) const
+{
+  const int64_t pts = last_pts_;
+  if (drained_ || (pts == NO_PTS)) {
+    return false;
+  }
+  return (pts < timestamp) && ((timestamp - pts) <= window);
+}
+
+
+DecoderPool& DecoderPool::instance()
+{
+  static DecoderPool pool;
+  return pool;
+}
+
+
+DecoderContextPtr DecoderPool::lease(const QString& location, const int stream_index, const double target_secs)
+{
+  QMutexLocker locker(&mutex_);
+  auto chosen = idle_.end();
+  int64_t chosen_pts = INT64_MIN;
+  for (auto it = idle_.begin(); it != idle_.end(); ++it) {
+    const auto& ctx = *it;
+    if ( (ctx->stream_index_ != stream_index) || (ctx->location_ != location) ) {
+      continue;
+    }
+    if (chosen == idle_.end()) {
+      // most recently released
+      chosen = it;
+    }
+    const int64_t pts = ctx->last_pts_;
+    if ( (target_secs < 0) || (pts == DecoderContext::NO_PTS) || ctx->drained_) {
+      continue;
+    }
+    // prefer the decoder closest to, but not beyond, the target
+    const int64_t target_ts = qRound64(target_secs * av_q2d(av_inv_q(ctx->stream_->time_base)))
+                              + qMax(static_cast<int64_t>(0), ctx->stream_->start_time);
+    if ( (pts < target_ts) && (pts > chosen_pts) ) {
+      chosen = it;
+      chosen_pts = pts;
+    }
+  }
+
+  if (chosen != idle_.end()) {
+    auto ctx = *chosen;
+    idle_.erase(chosen);
+    qDebug() << "Leased pooled decoder, file =" << location << "stream =" << stream_index;
+    return ctx;
+  }
+  locker.unlock();
+
+  auto ctx = std::make_shared<DecoderContext>(location, stream_index);
+  if (!ctx->open()) {
+    return nullptr;
+  }
+  return ctx;
+}
+
+
+void DecoderPool::release(DecoderContextPtr ctx)
+{
+  if (ctx == nullptr) {
+    return;
+  }
+  if (ctx->drained_) {
+    ctx->flush();
+  }
+
+  std::list<DecoderContextPtr> evicted;
+  QMutexLocker locker(&mutex_);
+  idle_.push_front(std::move(ctx));
+  const auto capacity = static_cast<size_t>(qMax(0, global::config.decoder_pool_size));
+  while (idle_.size() > capacity) {
+    evicted.push_back(idle_.back());
+    idle_.pop_back();
+  }
+  locker.unlock();
+  // evicted decoders are closed here, outside of the lock
+}
+
+
+void DecoderPool::purge(const QString& location)
+{
+  std::list<DecoderContextPtr> evicted;
+  QMutexLocker locker(&mutex_);
+  for (auto it = idle_.begin(); it != idle_.end();) {
+    if ((*it)->location_ == location) {
+      evicted.push_back(*it);
+      it = idle_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  locker.unlock();
+}
+
+
+void DecoderPool::clear()
+{
+  std::list<DecoderContextPtr> evicted;
+  QMutexLocker locker(&mutex_);
+  evicted.swap(idle_);
+  locker.unlock();
+}
+
+
+size_t DecoderPool::idleCount() const
+{
+  QMutexLocker locker(&mutex_);
+  return idle_.size();
+}
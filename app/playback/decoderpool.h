@@ -0,0 +1,131 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DECODERPOOL_H
+#define DECODERPOOL_H
+
+#include <QString>
+#include <QMutex>
+#include <memory>
+#include <list>
+#include <atomic>
+#include <cstdint>
+
+struct AVFormatContext;
+struct AVStream;
+struct AVCodec;
+struct AVCodecContext;
+struct AVDictionary;
+
+namespace chestnut::playback
+{
+  /**
+   * @brief The demuxer and decoder of a single footage stream
+   */
+  class DecoderContext
+  {
+    public:
+      DecoderContext(QString location, const int stream_index);
+      ~DecoderContext();
+
+      DecoderContext() = delete;
+      DecoderContext(const DecoderContext&) = delete;
+      DecoderContext(const DecoderContext&&) = delete;
+      DecoderContext& operator=(const DecoderContext&) = delete;
+      DecoderContext& operator=(const DecoderContext&&) = delete;
+
+      /**
+       * @brief   Open the source file and the decoder for the stream
+       * @return  true==success
+       */
+      bool open();
+      /**
+       * @brief Flush the decoder. Its position in the stream is unknown afterwards
+       */
+      void flush();
+      /**
+       * @brief             Identify if decoding on from the current position reaches a timestamp quicker than a seek
+       * @param timestamp   Target, in stream timebase
+       * @param window      Furthest distance to decode through, in stream timebase
+       * @return            true==decoder is positioned shortly before the timestamp
+       */
+      bool canContinueTo(const int64_t timestamp, const int64_t window) const;
+
+      const QString location_;
+      const int stream_index_;
+      AVFormatContext* format_ctx_ {nullptr};
+      AVStream* stream_ {nullptr};
+      AVCodec* codec_ {nullptr};
+      AVCodecContext* codec_ctx_ {nullptr};
+      AVDictionary* opts_ {nullptr};
+      static constexpr int64_t NO_PTS = INT64_MIN;
+      // pts of the last frame received from the decoder
+      std::atomic<int64_t> last_pts_ {NO_PTS};
+      // the decoder has been sent the flush packet at the end of the stream
+      std::atomic_bool drained_ {false};
+  };
+
+  using DecoderContextPtr = std::shared_ptr<DecoderContext>;
+
+  /**
+   * @brief Keeps opened decoders of footage streams so that clips of the same footage can reuse them
+   *        instead of opening the file for each clip
+   */
+  class DecoderPool
+  {
+    public:
+      static DecoderPool& instance();
+
+      DecoderPool(const DecoderPool&) = delete;
+      DecoderPool& operator=(const DecoderPool&) = delete;
+
+      /**
+       * @brief               Obtain exclusive use of a decoder for a footage stream
+       * @param location      Path of the footage
+       * @param stream_index  File index of the stream
+       * @param target_secs   Where the decoder will be used. An idle decoder positioned shortly before is preferred
+       * @return              Decoder or null on failure to open
+       */
+      DecoderContextPtr lease(const QString& location, const int stream_index, const double target_secs=-1.0);
+      /**
+       * @brief       Return a decoder to the pool for it to be reused
+       * @param ctx
+       */
+      void release(DecoderContextPtr ctx);
+      /**
+       * @brief           Close all idle decoders of a footage
+       * @param location  Path of the footage
+       */
+      void purge(const QString& location);
+      /**
+       * @brief Close all idle decoders
+       */
+      void clear();
+      /**
+       * @brief   The number of decoders opened and waiting to be leased
+       * @return  count
+       */
+      size_t idleCount() const;
+    private:
+      DecoderPool() = default;
+      mutable QMutex mutex_;
+      // most recently released first
+      std::list<DecoderContextPtr> idle_;
+  };
+}
+
+#endif // DECODERPOOL_H
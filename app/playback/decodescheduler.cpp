@@ -0,0 +1,186 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "decodescheduler.h"
+
+#include <QtGlobal>
+
+#include "io/config.h"
+#include "debug.h"
+
+using chestnut::playback::DecodeScheduler;
+using chestnut::playback::DecodePriority;
+
+namespace
+{
+  // identifies the worker the calling thread is, if any
+  thread_local const DecodeScheduler* current_scheduler = nullptr;
+  thread_local size_t current_worker = 0;
+}
+
+
+bool DecodePriority::operator<(const DecodePriority& rhs) const
+{
+  if (audio_ != rhs.audio_) {
+    return audio_;
+  }
+  if (visible_ != rhs.visible_) {
+    return visible_;
+  }
+  return distance_ < rhs.distance_;
+}
+
+
+DecodeScheduler& DecodeScheduler::instance()
+{
+  static DecodeScheduler scheduler(static_cast<size_t>(qMax(0, global::config.decode_threads)));
+  return scheduler;
+}
+
+
+DecodeScheduler::DecodeScheduler(const size_t worker_count)
+{
+  const size_t count = (worker_count > 0) ? worker_count : qMax(1U, std::thread::hardware_concurrency());
+  workers_.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  // all queues exist before any worker looks to steal from them
+  for (size_t i = 0; i < count; ++i) {
+    workers_.at(i)->thread_ = std::thread(&DecodeScheduler::run, this, i);
+  }
+  qInfo() << "Started decode scheduler, workers:" << count;
+}
+
+
+DecodeScheduler::~DecodeScheduler()
+{
+  QMutexLocker locker(&idle_mutex_);
+  running_ = false;
+  const auto abandoned = queued_;
+  locker.unlock();
+  work_cond_.wakeAll();
+  for (auto& worker : workers_) {
+    worker->thread_.join();
+  }
+  qInfo() << "Stopped decode scheduler, jobs completed:" << completed_.load() << "stolen:" << stolen_.load()
+          << "abandoned:" << abandoned;
+}
+
+
+void DecodeScheduler::submit(Task task, const DecodePriority& priority)
+{
+  if (!task) {
+    return;
+  }
+  const size_t index = (current_scheduler == this) ? current_worker : (next_worker_++ % workers_.size());
+  auto& worker = *workers_.at(index);
+
+  QMutexLocker locker(&idle_mutex_);
+  ++queued_;
+  QMutexLocker worker_locker(&worker.mutex_);
+  worker.jobs_.push_back({std::move(task), priority, next_sequence_++});
+  worker_locker.unlock();
+  locker.unlock();
+  work_cond_.wakeOne();
+}
+
+
+void DecodeScheduler::waitForIdle()
+{
+  QMutexLocker locker(&idle_mutex_);
+  while ( (queued_ > 0) || (active_ > 0) ) {
+    idle_cond_.wait(&idle_mutex_);
+  }
+}
+
+
+size_t DecodeScheduler::workerCount() const
+{
+  return workers_.size();
+}
+
+
+uint64_t DecodeScheduler::stolen() const
+{
+  return stolen_;
+}
+
+
+uint64_t DecodeScheduler::completed() const
+{
+  return completed_;
+}
+
+
+void DecodeScheduler::run(const size_t index)
+{
+  current_scheduler = this;
+  current_worker = index;
+
+  while (running_) {
+    Job job {};
+    bool found = take(*workers_.at(index), job);
+    bool stolen = false;
+    for (size_t i = 1; !found && (i < workers_.size()); ++i) {
+      found = take(*workers_.at((index + i) % workers_.size()), job);
+      stolen = found;
+    }
+
+    QMutexLocker locker(&idle_mutex_);
+    if (!found) {
+      while (running_ && (queued_ == 0)) {
+        work_cond_.wait(&idle_mutex_);
+      }
+      continue;
+    }
+    --queued_;
+    ++active_;
+    locker.unlock();
+
+    if (stolen) {
+      ++stolen_;
+    }
+    job.task_();
+    ++completed_;
+
+    locker.relock();
+    --active_;
+    if ( (queued_ == 0) && (active_ == 0) ) {
+      idle_cond_.wakeAll();
+    }
+  }
+}
+
+
+bool DecodeScheduler::take(Worker& worker, Job& job)
+{
+  QMutexLocker locker(&worker.mutex_);
+  if (worker.jobs_.empty()) {
+    return false;
+  }
+  auto urgent = worker.jobs_.begin();
+  for (auto it = std::next(urgent); it != worker.jobs_.end(); ++it) {
+    if ( (it->priority_ < urgent->priority_)
+         || (!(urgent->priority_ < it->priority_) && (it->sequence_ < urgent->sequence_)) ) {
+      urgent = it;
+    }
+  }
+  job = std::move(*urgent);
+  worker.jobs_.erase(urgent);
+  return true;
+}
@@ -0,0 +1,140 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DECODESCHEDULER_H
+#define DECODESCHEDULER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <deque>
+
+namespace chestnut::playback
+{
+  /**
+   * @brief How soon the result of a decode job is needed
+   */
+  struct DecodePriority
+  {
+    // frames until the playhead reaches the job's clip
+    int64_t distance_ {0};
+    // the clip is in the sequence shown by the viewer, not a nested one
+    bool visible_ {true};
+    // gaps in audio are heard, so it goes before video
+    bool audio_ {false};
+
+    /**
+     * @brief     Identify if this is more urgent than another
+     * @param rhs
+     * @return    true==run before rhs
+     */
+    bool operator<(const DecodePriority& rhs) const;
+  };
+
+  /**
+   * @brief A fixed number of worker threads running decode and cache jobs of all clips, most urgent first.
+   *        Each worker has its own queue and takes jobs from the others when that is empty
+   */
+  class DecodeScheduler
+  {
+    public:
+      using Task = std::function<void()>;
+
+      /**
+       * @brief   The scheduler used for playback, sized by the configuration
+       * @return  scheduler
+       */
+      static DecodeScheduler& instance();
+
+      /**
+       * @param worker_count  Number of threads. 0 for one per core
+       */
+      explicit DecodeScheduler(const size_t worker_count);
+      ~DecodeScheduler();
+
+      DecodeScheduler() = delete;
+      DecodeScheduler(const DecodeScheduler&) = delete;
+      DecodeScheduler(const DecodeScheduler&&) = delete;
+      DecodeScheduler& operator=(const DecodeScheduler&) = delete;
+      DecodeScheduler& operator=(const DecodeScheduler&&) = delete;
+
+      /**
+       * @brief           Queue a job. Jobs queued from a worker stay on that worker's queue unless taken by another
+       * @param task
+       * @param priority
+       */
+      void submit(Task task, const DecodePriority& priority);
+      /**
+       * @brief Block until all queued jobs have been run
+       */
+      void waitForIdle();
+
+      size_t workerCount() const;
+      // number of jobs run by a worker other than the one they were queued on
+      uint64_t stolen() const;
+      uint64_t completed() const;
+
+    private:
+      struct Job
+      {
+        Task task_;
+        DecodePriority priority_;
+        // order of submission, to keep jobs of equal priority first in, first out
+        uint64_t sequence_;
+      };
+
+      struct Worker
+      {
+        QMutex mutex_;
+        std::deque<Job> jobs_;
+        std::thread thread_;
+      };
+
+      std::vector<std::unique_ptr<Worker>> workers_;
+      std::atomic_bool running_ {true};
+      QMutex idle_mutex_;
+      QWaitCondition work_cond_;
+      QWaitCondition idle_cond_;
+      // jobs queued and not yet taken
+      size_t queued_ {0};
+      // jobs taken and not yet finished
+      size_t active_ {0};
+      std::atomic<uint64_t> next_sequence_ {0};
+      std::atomic<size_t> next_worker_ {0};
+      std::atomic<uint64_t> stolen_ {0};
+      std::atomic<uint64_t> completed_ {0};
+
+      /**
+       * @brief       The worker method for the threads
+       * @param index Worker's own queue
+       */
+      void run(const size_t index);
+      /**
+       * @brief         Remove the most urgent job of a worker
+       * @param worker
+       * @param job     Set to the job taken
+       * @return        true==a job was taken
+       */
+      bool take(Worker& worker, Job& job);
+  };
+}
+
+#endif // DECODESCHEDULER_H
@@ -0,0 +1,293 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "framecache.h"
+
+#include <QtGlobal>
+
+#include "io/config.h"
+#include "debug.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+using chestnut::playback::FrameCache;
+using chestnut::playback::FrameCacheKey;
+using chestnut::playback::FramePtr;
+using chestnut::playback::CachedRun;
+
+namespace
+{
+  constexpr size_t BYTES_PER_MEGABYTE = 1024 * 1024;
+
+  size_t frameBytes(const AVFrame& frame)
+  {
+    size_t sz = 0;
+    for (const auto buf : frame.buf) {
+      if (buf != nullptr) {
+        sz += static_cast<size_t>(buf->size);
+      }
+    }
+    return sz;
+  }
+
+  void freeFrame(AVFrame* frame)
+  {
+    av_frame_free(&frame);
+  }
+}
+
+
+bool FrameCacheKey::operator<(const FrameCacheKey& rhs) const
+{
+  if (stream_index_ != rhs.stream_index_) {
+    return stream_index_ < rhs.stream_index_;
+  }
+  if (pix_fmt_ != rhs.pix_fmt_) {
+    return pix_fmt_ < rhs.pix_fmt_;
+  }
+  return location_ < rhs.location_;
+}
+
+bool FrameCacheKey::operator==(const FrameCacheKey& rhs) const
+{
+  return (stream_index_ == rhs.stream_index_) && (pix_fmt_ == rhs.pix_fmt_) && (location_ == rhs.location_);
+}
+
+
+FrameCache& FrameCache::instance()
+{
+  static FrameCache cache;
+  return cache;
+}
+
+
+FramePtr FrameCache::insert(const FrameCacheKey& key, AVFrame* frame, const int64_t duration)
+{
+  if (frame == nullptr) {
+    return nullptr;
+  }
+  FramePtr ptr(frame, freeFrame);
+  const auto budget = static_cast<size_t>(qMax(0, global::config.frame_cache_size)) * BYTES_PER_MEGABYTE;
+
+  std::list<FramePtr> evicted;
+  QMutexLocker locker(&mutex_);
+  auto& frames = streams_[key];
+  if (auto existing = frames.find(frame->pts); existing != frames.end()) {
+    bytes_ -= existing->second.bytes_;
+    lru_.erase(existing->second.lru_);
+    evicted.push_back(existing->second.frame_);
+    frames.erase(existing);
+  }
+
+  Entry entry;
+  entry.frame_ = ptr;
+  entry.duration_ = (frame->pkt_duration > 0) ? frame->pkt_duration : duration;
+  entry.bytes_ = frameBytes(*frame);
+  lru_.emplace_front(key, frame->pts);
+  entry.lru_ = lru_.begin();
+  bytes_ += entry.bytes_;
+  frames.emplace(frame->pts, std::move(entry));
+
+  evict(budget, evicted);
+  locker.unlock();
+  // evicted frames not in use elsewhere are freed here, outside of the lock
+  return ptr;
+}
+
+
+FramePtr FrameCache::find(const FrameCacheKey& key, const int64_t pts)
+{
+  QMutexLocker locker(&mutex_);
+  if (const auto frames = streams_.find(key); frames != streams_.end()) {
+    if (const auto it = displayed(frames->second, pts); it != frames->second.end()) {
+      auto& entry = frames->second.at(it->first);
+      touch(entry);
+      ++hits_;
+      return entry.frame_;
+    }
+  }
+  ++misses_;
+  return nullptr;
+}
+
+
+FramePtr FrameCache::closest(const FrameCacheKey& key, const int64_t pts) const
+{
+  QMutexLocker locker(&mutex_);
+  const auto frames = streams_.find(key);
+  if ( (frames == streams_.end()) || frames->second.empty()) {
+    return nullptr;
+  }
+  auto it = frames->second.upper_bound(pts);
+  if (it != frames->second.begin()) {
+    --it;
+  }
+  return it->second.frame_;
+}
+
+
+FramePtr FrameCache::first(const FrameCacheKey& key)
+{
+  QMutexLocker locker(&mutex_);
+  if (auto frames = streams_.find(key); (frames != streams_.end()) && !frames->second.empty()) {
+    auto& entry = frames->second.begin()->second;
+    touch(entry);
+    ++hits_;
+    return entry.frame_;
+  }
+  ++misses_;
+  return nullptr;
+}
+
+
+std::optional<CachedRun> FrameCache::run(const FrameCacheKey& key, const int64_t pts, const int limit) const
+{
+  QMutexLocker locker(&mutex_);
+  const auto frames = streams_.find(key);
+  if (frames == streams_.end()) {
+    return {};
+  }
+  const auto start = displayed(frames->second, pts);
+  if (start == frames->second.end()) {
+    return {};
+  }
+
+  // a frame follows on from another if it starts before the other's duration has doubled
+  const auto contiguous = [] (const Frames::const_iterator& earlier, const Frames::const_iterator& later) {
+    return (later->first - earlier->first) < (earlier->second.duration_ * 2);
+  };
+
+  CachedRun result {start->first, start->first, 0, 0};
+  for (auto it = start; (it != frames->second.begin()) && (result.before_ < limit); --it) {
+    const auto prev = std::prev(it);
+    if (!contiguous(prev, it)) {
+      break;
+    }
+    result.first_pts_ = prev->first;
+    ++result.before_;
+  }
+  for (auto it = start; result.after_ < limit; ++it) {
+    const auto next = std::next(it);
+    if ( (next == frames->second.end()) || !contiguous(it, next)) {
+      break;
+    }
+    result.last_pts_ = next->first;
+    ++result.after_;
+  }
+  return result;
+}
+
+
+void FrameCache::purge(const QString& location)
+{
+  std::list<FramePtr> evicted;
+  QMutexLocker locker(&mutex_);
+  for (auto it = streams_.begin(); it != streams_.end();) {
+    if (it->first.location_ != location) {
+      ++it;
+      continue;
+    }
+    for (auto& [pts, entry] : it->second) {
+      bytes_ -= entry.bytes_;
+      lru_.erase(entry.lru_);
+      evicted.push_back(std::move(entry.frame_));
+    }
+    it = streams_.erase(it);
+  }
+  locker.unlock();
+  // evicted frames are freed here, outside of the lock
+}
+
+
+void FrameCache::clear()
+{
+  QMutexLocker locker(&mutex_);
+  const uint64_t total = hits_ + misses_;
+  if (total > 0) {
+    qInfo() << "Frame cache cleared, hits =" << hits_.load() << "misses =" << misses_.load()
+            << "hit rate =" << (static_cast<double>(hits_) / total);
+  }
+  std::map<FrameCacheKey, Frames> evicted;
+  evicted.swap(streams_);
+  lru_.clear();
+  bytes_ = 0;
+  hits_ = 0;
+  misses_ = 0;
+  locker.unlock();
+}
+
+
+size_t FrameCache::bytes() const
+{
+  QMutexLocker locker(&mutex_);
+  return bytes_;
+}
+
+
+uint64_t FrameCache::hits() const
+{
+  return hits_;
+}
+
+
+uint64_t FrameCache::misses() const
+{
+  return misses_;
+}
+
+
+FrameCache::Frames::const_iterator FrameCache::displayed(const Frames& frames, const int64_t pts) const
+{
+  auto it = frames.upper_bound(pts);
+  if (it == frames.begin()) {
+    return frames.end();
+  }
+  --it;
+  if ( (pts - it->first) >= it->second.duration_) {
+    // there's a gap between the earlier frame and the timestamp
+    return frames.end();
+  }
+  return it;
+}
+
+
+void FrameCache::touch(Entry& entry)
+{
+  lru_.splice(lru_.begin(), lru_, entry.lru_);
+}
+
+
+void FrameCache::evict(const size_t budget, std::list<FramePtr>& evicted)
+{
+  // the most recently inserted frame is always kept
+  while ( (bytes_ > budget) && (lru_.size() > 1) ) {
+    const auto& [key, pts] = lru_.back();
+    auto frames = streams_.find(key);
+    Q_ASSERT(frames != streams_.end());
+    auto entry = frames->second.find(pts);
+    Q_ASSERT(entry != frames->second.end());
+    bytes_ -= entry->second.bytes_;
+    evicted.push_back(std::move(entry->second.frame_));
+    frames->second.erase(entry);
+    if (frames->second.empty()) {
+      streams_.erase(frames);
+    }
+    lru_.pop_back();
+  }
+}
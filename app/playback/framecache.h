@@ -0,0 +1,149 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <QString>
+#include <QMutex>
+#include <memory>
+#include <map>
+#include <list>
+#include <atomic>
+#include <optional>
+
+struct AVFrame;
+
+namespace chestnut::playback
+{
+  using FramePtr = std::shared_ptr<AVFrame>;
+
+  /**
+   * @brief Identifies the decoded (and filtered) frames of a footage stream
+   */
+  struct FrameCacheKey
+  {
+    QString location_;
+    int stream_index_ {-1};
+    // AVPixelFormat the frames were converted to, as clips of the same stream may differ
+    int pix_fmt_ {-1};
+
+    bool operator<(const FrameCacheKey& rhs) const;
+    bool operator==(const FrameCacheKey& rhs) const;
+  };
+
+  /**
+   * @brief A run of cached frames without any gaps between them
+   */
+  struct CachedRun
+  {
+    int64_t first_pts_;
+    int64_t last_pts_;
+    // number of frames in the run before the frame searched for
+    int before_;
+    // number of frames in the run after the frame searched for
+    int after_;
+  };
+
+  /**
+   * @brief Process-wide store of decoded video frames, shared by all clips of a footage stream.
+   *        Least recently used frames are evicted once the size exceeds the configured budget
+   */
+  class FrameCache
+  {
+    public:
+      static FrameCache& instance();
+
+      FrameCache(const FrameCache&) = delete;
+      FrameCache& operator=(const FrameCache&) = delete;
+
+      /**
+       * @brief           Add a frame to the cache. Any frame with the same pts is replaced
+       * @param key
+       * @param frame     Frame to take ownership of
+       * @param duration  Duration of the frame if it does not carry its own, in stream timebase
+       * @return          The cached frame
+       */
+      FramePtr insert(const FrameCacheKey& key, AVFrame* frame, const int64_t duration);
+      /**
+       * @brief       Obtain the frame to be displayed at a timestamp. Counted as a hit or miss
+       * @param key
+       * @param pts
+       * @return      Frame or null if not cached
+       */
+      FramePtr find(const FrameCacheKey& key, const int64_t pts);
+      /**
+       * @brief       Obtain the cached frame nearest to a timestamp, preferring an earlier one
+       * @param key
+       * @param pts
+       * @return      Frame or null if nothing of the stream is cached
+       */
+      FramePtr closest(const FrameCacheKey& key, const int64_t pts) const;
+      /**
+       * @brief   Obtain the cached frame of a stream of a single, infinite length frame e.g. an image
+       * @param key
+       * @return  Frame or null
+       */
+      FramePtr first(const FrameCacheKey& key);
+      /**
+       * @brief       Find the gapless run of cached frames containing the frame displayed at a timestamp
+       * @param key
+       * @param pts
+       * @param limit Maximum number of frames to walk either side
+       * @return      the run or empty if the frame is not cached
+       */
+      std::optional<CachedRun> run(const FrameCacheKey& key, const int64_t pts, const int limit) const;
+      /**
+       * @brief     Remove all frames of a footage
+       * @param location
+       */
+      void purge(const QString& location);
+      /**
+       * @brief Remove all frames
+       */
+      void clear();
+
+      size_t bytes() const;
+      uint64_t hits() const;
+      uint64_t misses() const;
+
+    private:
+      FrameCache() = default;
+
+      struct Entry {
+        FramePtr frame_;
+        int64_t duration_;
+        size_t bytes_;
+        std::list<std::pair<FrameCacheKey, int64_t>>::iterator lru_;
+      };
+      using Frames = std::map<int64_t, Entry>;
+
+      mutable QMutex mutex_;
+      std::map<FrameCacheKey, Frames> streams_;
+      // most recently used first
+      std::list<std::pair<FrameCacheKey, int64_t>> lru_;
+      size_t bytes_ {0};
+      std::atomic<uint64_t> hits_ {0};
+      std::atomic<uint64_t> misses_ {0};
+
+      Frames::const_iterator displayed(const Frames& frames, const int64_t pts) const;
+      void touch(Entry& entry);
+      void evict(const size_t budget, std::list<FramePtr>& evicted);
+  };
+}
+
+#endif // FRAMECACHE_H
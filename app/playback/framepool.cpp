@@ -0,0 +1,159 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "framepool.h"
+
+#include <tuple>
+
+#include "debug.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/buffer.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/mem.h>
+}
+
+using chestnut::playback::FramePool;
+
+namespace
+{
+  constexpr int ALIGNMENT = 32;
+  constexpr double BYTES_PER_MEGABYTE = 1024 * 1024;
+
+  // buffers can outlive the pool, so these are not members
+  std::atomic<uint64_t> allocations {0};
+  std::atomic<size_t> resident_bytes {0};
+  std::atomic<size_t> peak_bytes {0};
+
+  void freeBuffer(void* opaque, uint8_t* data)
+  {
+    // the buffer's size is carried as its opaque
+    resident_bytes -= static_cast<size_t>(reinterpret_cast<intptr_t>(opaque));
+    av_free(data);
+  }
+
+  AVBufferRef* allocBuffer(void* /*opaque*/, int size)
+  {
+    auto data = static_cast<uint8_t*>(av_malloc(static_cast<size_t>(size)));
+    if (data == nullptr) {
+      return nullptr;
+    }
+    AVBufferRef* buf = av_buffer_create(data, size, freeBuffer, reinterpret_cast<void*>(static_cast<intptr_t>(size)), 0);
+    if (buf == nullptr) {
+      av_free(data);
+      return nullptr;
+    }
+    ++allocations;
+    const size_t resident = (resident_bytes += static_cast<size_t>(size));
+    size_t peak = peak_bytes;
+    while ( (resident > peak) && !peak_bytes.compare_exchange_weak(peak, resident)) {}
+    return buf;
+  }
+}
+
+
+bool FramePool::Key::operator<(const Key& rhs) const
+{
+  return std::tie(width_, height_, format_) < std::tie(rhs.width_, rhs.height_, rhs.format_);
+}
+
+
+FramePool& FramePool::instance()
+{
+  static FramePool pool;
+  return pool;
+}
+
+
+AVFrame* FramePool::acquire(const int width, const int height, const int format)
+{
+  const auto pix_fmt = static_cast<AVPixelFormat>(format);
+  const int size = av_image_get_buffer_size(pix_fmt, width, height, ALIGNMENT);
+  if (size <= 0) {
+    qWarning() << "Unable to size frame buffer, width:" << width << "height:" << height << "format:" << format;
+    return nullptr;
+  }
+
+  QMutexLocker locker(&mutex_);
+  auto& pool = pools_[{width, height, format}];
+  if (pool == nullptr) {
+    pool = av_buffer_pool_init2(size, nullptr, allocBuffer, nullptr);
+  }
+  AVBufferRef* buf = (pool != nullptr) ? av_buffer_pool_get(pool) : nullptr;
+  locker.unlock();
+  if (buf == nullptr) {
+    qCritical() << "Could not allocate frame buffer, width:" << width << "height:" << height << "format:" << format;
+    return nullptr;
+  }
+  ++acquired_;
+
+  AVFrame* frame = av_frame_alloc();
+  if (frame == nullptr) {
+    av_buffer_unref(&buf);
+    return nullptr;
+  }
+  frame->width = width;
+  frame->height = height;
+  frame->format = format;
+  frame->buf[0] = buf;
+  av_image_fill_arrays(frame->data, frame->linesize, buf->data, pix_fmt, width, height, ALIGNMENT);
+  frame->extended_data = frame->data;
+  return frame;
+}
+
+
+void FramePool::clear()
+{
+  QMutexLocker locker(&mutex_);
+  if (acquired_ > 0) {
+    qInfo() << "Frame pool cleared, hits =" << hits() << "misses =" << misses()
+            << "hit rate =" << (static_cast<double>(hits()) / acquired_)
+            << "peak MiB =" << (peakBytes() / BYTES_PER_MEGABYTE);
+  }
+  for (auto& [key, pool] : pools_) {
+    // freed once its last buffer is returned
+    av_buffer_pool_uninit(&pool);
+  }
+  pools_.clear();
+}
+
+
+uint64_t FramePool::hits() const
+{
+  const uint64_t acquired = acquired_;
+  const uint64_t allocated = allocations;
+  return (acquired > allocated) ? (acquired - allocated) : 0;
+}
+
+
+uint64_t FramePool::misses() const
+{
+  return allocations;
+}
+
+
+size_t FramePool::residentBytes() const
+{
+  return resident_bytes;
+}
+
+
+size_t FramePool::peakBytes() const
+{
+  return peak_bytes;
+}
@@ -0,0 +1,81 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QMutex>
+#include <map>
+#include <atomic>
+#include <cstdint>
+
+struct AVFrame;
+struct AVBufferPool;
+
+namespace chestnut::playback
+{
+  /**
+   * @brief Process-wide pools of image buffers, one per frame geometry and pixel format. Buffers of freed frames go
+   *        back to their pool for the next frame rather than back to the system
+   */
+  class FramePool
+  {
+    public:
+      static FramePool& instance();
+
+      FramePool(const FramePool&) = delete;
+      FramePool& operator=(const FramePool&) = delete;
+
+      /**
+       * @brief         Obtain a frame with its image buffer from the pool of its geometry and format
+       * @param width
+       * @param height
+       * @param format  AVPixelFormat
+       * @return        Frame or null on failure. Freeing it returns the buffer to the pool
+       */
+      AVFrame* acquire(const int width, const int height, const int format);
+      /**
+       * @brief Drop all pools. Buffers still in use are freed once their frames are
+       */
+      void clear();
+
+      // frames given buffers previously used
+      uint64_t hits() const;
+      // frames given newly allocated buffers
+      uint64_t misses() const;
+      // size of all buffers allocated and not yet freed, whether in use or pooled
+      size_t residentBytes() const;
+      size_t peakBytes() const;
+
+    private:
+      FramePool() = default;
+
+      struct Key
+      {
+        int width_;
+        int height_;
+        int format_;
+        bool operator<(const Key& rhs) const;
+      };
+
+      mutable QMutex mutex_;
+      std::map<Key, AVBufferPool*> pools_;
+      std::atomic<uint64_t> acquired_ {0};
+  };
+}
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,291 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "loudnessmeter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+#include "playback/mixkernels.h"
+
+using chestnut::playback::LoudnessMeter;
+
+namespace
+{
+  constexpr double PI = 3.14159265358979323846;
+  // blocks in each window
+  constexpr size_t MOMENTARY_BLOCKS = 4;
+  constexpr size_t SHORT_TERM_BLOCKS = 30;
+  constexpr size_t RMS_BLOCKS = 3;
+  constexpr double ABSOLUTE_GATE = -70.0; // LUFS
+  constexpr double RELATIVE_GATE = -10.0; // LU
+
+  double mean(const std::deque<double>& values, const size_t count)
+  {
+    const auto from = values.end() - static_cast<std::ptrdiff_t>(count);
+    return std::accumulate(from, values.end(), 0.0) / count;
+  }
+}
+
+
+LoudnessMeter::LoudnessMeter(const int sample_rate, std::vector<double> weights)
+  : sample_rate_(std::max(sample_rate, 1)),
+    weights_(std::move(weights)),
+    block_frames_(std::max(static_cast<size_t>(sample_rate_ / 10), static_cast<size_t>(1)))
+{
+  if (weights_.empty()) {
+    weights_.assign(CHANNELS, 1.0);
+  }
+  reset();
+
+  // K-weighting of BS.1770, derived for the sample rate rather than taken as the 48kHz coefficients
+  {
+    constexpr double f0 = 1681.974450955533;
+    constexpr double gain = 3.999843853973347;
+    constexpr double q = 0.7071752369554196;
+    const double k = std::tan(PI * f0 / sample_rate_);
+    const double vh = std::pow(10.0, gain / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    const double a0 = 1.0 + (k / q) + (k * k);
+    auto& shelf = k_weighting_.at(0);
+    shelf.b0_ = (vh + (vb * k / q) + (k * k)) / a0;
+    shelf.b1_ = 2.0 * ((k * k) - vh) / a0;
+    shelf.b2_ = (vh - (vb * k / q) + (k * k)) / a0;
+    shelf.a1_ = 2.0 * ((k * k) - 1.0) / a0;
+    shelf.a2_ = (1.0 - (k / q) + (k * k)) / a0;
+  }
+  {
+    constexpr double f0 = 38.13547087602444;
+    constexpr double q = 0.5003270373238773;
+    const double k = std::tan(PI * f0 / sample_rate_);
+    const double a0 = 1.0 + (k / q) + (k * k);
+    auto& high_pass = k_weighting_.at(1);
+    high_pass.b0_ = 1.0;
+    high_pass.b1_ = -2.0;
+    high_pass.b2_ = 1.0;
+    high_pass.a1_ = 2.0 * ((k * k) - 1.0) / a0;
+    high_pass.a2_ = (1.0 - (k / q) + (k * k)) / a0;
+  }
+
+  // a Hann-windowed sinc, split into phases each normalised to unity gain. Each phase's taps are reversed so they
+  // line up with the history, oldest first
+  constexpr int length = OVERSAMPLING * TAPS;
+  const double centre = (length - 1) / 2.0;
+  for (int phase = 0; phase < OVERSAMPLING; ++phase) {
+    double sum = 0.0;
+    std::array<double, TAPS> taps {};
+    for (int k = 0; k < TAPS; ++k) {
+      const int n = phase + (OVERSAMPLING * k);
+      const double x = (n - centre) / OVERSAMPLING;
+      const double sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(PI * x) / (PI * x);
+      const double window = 0.5 - (0.5 * std::cos((2.0 * PI * (n + 0.5)) / length));
+      taps.at(static_cast<size_t>(k)) = sinc * window;
+      sum += taps.at(static_cast<size_t>(k));
+    }
+    for (int k = 0; k < TAPS; ++k) {
+      interpolator_.at(static_cast<size_t>((phase * TAPS) + (TAPS - 1 - k))) =
+          static_cast<float>(taps.at(static_cast<size_t>(k)) / sum);
+    }
+  }
+}
+
+
+void LoudnessMeter::process(const float* samples, const size_t frames)
+{
+  size_t done = 0;
+  while (done < frames) {
+    const size_t count = std::min(frames - done, block_frames_ - block_filled_);
+    const auto channels = weights_.size();
+    const float* from = samples + (done * channels);
+    if (channels == CHANNELS) {
+      kernel::stereoPeakSquares(from, count, block_peak_.data(), block_squares_.data());
+    } else {
+      for (size_t f = 0; f < count; ++f) {
+        for (size_t c = 0; c < channels; ++c) {
+          const float sample = from[(f * channels) + c];
+          block_peak_[c] = std::max(block_peak_[c], std::abs(sample));
+          block_squares_[c] += sample * sample;
+        }
+      }
+    }
+
+    double energy = 0.0;
+    for (size_t f = 0; f < count; ++f) {
+      for (size_t c = 0; c < channels; ++c) {
+        const float sample = from[(f * channels) + c];
+        double y = sample;
+        for (size_t stage = 0; stage < k_weighting_.size(); ++stage) {
+          const auto& bq = k_weighting_[stage];
+          auto& st = states_[c][stage];
+          const double x = y;
+          y = (bq.b0_ * x) + (bq.b1_ * st.x1_) + (bq.b2_ * st.x2_) - (bq.a1_ * st.y1_) - (bq.a2_ * st.y2_);
+          st.x2_ = st.x1_;
+          st.x1_ = x;
+          st.y2_ = st.y1_;
+          st.y1_ = y;
+        }
+        energy += weights_[c] * y * y;
+
+        auto& true_peak = levels_.true_peak_[c];
+        true_peak = std::max(true_peak, truePeak(c, sample));
+      }
+      history_pos_ = (history_pos_ + 1) % TAPS;
+    }
+    block_energy_ += energy;
+    block_filled_ += count;
+    done += count;
+
+    if (block_filled_ == block_frames_) {
+      completeBlock();
+    }
+  }
+}
+
+
+void LoudnessMeter::reset()
+{
+  const auto channels = weights_.size();
+  states_.assign(channels, {});
+  history_.assign(channels, {});
+  history_pos_ = 0;
+  block_filled_ = 0;
+  block_energy_ = 0.0;
+  block_peak_.assign(channels, 0.0f);
+  block_squares_.assign(channels, 0.0f);
+  block_energies_.clear();
+  block_mean_squares_.clear();
+  gating_energies_.clear();
+  levels_ = Levels(channels);
+}
+
+
+LoudnessMeter::Levels LoudnessMeter::levels() const
+{
+  auto levels = levels_;
+  // windows above the absolute gate, then those of them above the gate relative to their loudness
+  const double absolute = std::pow(10.0, (ABSOLUTE_GATE + 0.691) / 10.0);
+  double sum = 0.0;
+  size_t count = 0;
+  for (const auto energy : gating_energies_) {
+    if (energy > absolute) {
+      sum += energy;
+      ++count;
+    }
+  }
+  if (count == 0) {
+    return levels;
+  }
+  const double relative = (sum / count) * std::pow(10.0, RELATIVE_GATE / 10.0);
+  const double gate = std::max(absolute, relative);
+  sum = 0.0;
+  count = 0;
+  for (const auto energy : gating_energies_) {
+    if (energy > gate) {
+      sum += energy;
+      ++count;
+    }
+  }
+  if (count > 0) {
+    levels.integrated_ = loudness(sum / count);
+  }
+  return levels;
+}
+
+
+int LoudnessMeter::sampleRate() const
+{
+  return sample_rate_;
+}
+
+
+int LoudnessMeter::channels() const
+{
+  return static_cast<int>(weights_.size());
+}
+
+
+double LoudnessMeter::loudness(const double energy)
+{
+  if (energy <= 0.0) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  return -0.691 + (10.0 * std::log10(energy));
+}
+
+
+void LoudnessMeter::completeBlock()
+{
+  const auto frames = static_cast<double>(block_filled_);
+  block_energies_.push_back(block_energy_ / frames);
+  if (block_energies_.size() > SHORT_TERM_BLOCKS) {
+    block_energies_.pop_front();
+  }
+  std::vector<double> mean_squares(block_squares_.size());
+  for (size_t c = 0; c < block_squares_.size(); ++c) {
+    mean_squares[c] = block_squares_[c] / frames;
+  }
+  block_mean_squares_.push_back(std::move(mean_squares));
+  if (block_mean_squares_.size() > RMS_BLOCKS) {
+    block_mean_squares_.pop_front();
+  }
+
+  for (size_t c = 0; c < weights_.size(); ++c) {
+    levels_.peak_[c] = block_peak_[c];
+    levels_.max_peak_[c] = std::max(levels_.max_peak_[c], block_peak_[c]);
+    double squares = 0.0;
+    for (const auto& block : block_mean_squares_) {
+      squares += block[c];
+    }
+    levels_.rms_[c] = static_cast<float>(std::sqrt(squares / block_mean_squares_.size()));
+  }
+  // the windows overlap, moving on a block at a time
+  if (block_energies_.size() >= MOMENTARY_BLOCKS) {
+    const double momentary = mean(block_energies_, MOMENTARY_BLOCKS);
+    levels_.momentary_ = loudness(momentary);
+    gating_energies_.push_back(momentary);
+  }
+  if (block_energies_.size() >= SHORT_TERM_BLOCKS) {
+    levels_.short_term_ = loudness(mean(block_energies_, SHORT_TERM_BLOCKS));
+  }
+
+  block_filled_ = 0;
+  block_energy_ = 0.0;
+  std::fill(block_peak_.begin(), block_peak_.end(), 0.0f);
+  std::fill(block_squares_.begin(), block_squares_.end(), 0.0f);
+}
+
+
+float LoudnessMeter::truePeak(const size_t channel, const float sample)
+{
+  auto& history = history_[channel];
+  history[history_pos_] = sample;
+  history[history_pos_ + TAPS] = sample;
+  // the last TAPS samples, oldest first
+  const float* window = history.data() + history_pos_ + 1;
+  float peak = std::abs(sample);
+  for (int phase = 0; phase < OVERSAMPLING; ++phase) {
+    const float* taps = interpolator_.data() + (phase * TAPS);
+    float y = 0.0f;
+    for (int k = 0; k < TAPS; ++k) {
+      y += taps[k] * window[k];
+    }
+    peak = std::max(peak, std::abs(y));
+  }
+  return peak;
+}
@@ -0,0 +1,140 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LOUDNESSMETER_H
+#define LOUDNESSMETER_H
+
+#include <array>
+#include <deque>
+#include <limits>
+#include <vector>
+#include <cstddef>
+
+namespace chestnut::playback
+{
+  /**
+   * @brief Measures interleaved float samples for metering: sample peak, RMS, true peak, and the momentary, short-term
+   *        and integrated loudness of EBU R128 (ITU-R BS.1770). Stereo unless weights of other channels are given.
+   *        Used by one thread at a time
+   */
+  class LoudnessMeter
+  {
+    public:
+      static constexpr int CHANNELS = 2;
+
+      struct Levels
+      {
+        explicit Levels(const size_t channels = CHANNELS)
+          : peak_(channels), rms_(channels), max_peak_(channels), true_peak_(channels) {}
+        // of the last 100ms measured, linear
+        std::vector<float> peak_;
+        // of the last 300ms measured, linear
+        std::vector<float> rms_;
+        // the largest since reset, linear
+        std::vector<float> max_peak_;
+        // the largest between samples since reset, linear
+        std::vector<float> true_peak_;
+        // LUFS, -inf until measured or when gated as silence
+        double momentary_ {-std::numeric_limits<double>::infinity()};
+        double short_term_ {-std::numeric_limits<double>::infinity()};
+        double integrated_ {-std::numeric_limits<double>::infinity()};
+      };
+
+      /**
+       * @param sample_rate Of the samples measured
+       * @param weights     Of each channel's energy in the loudness, as BS.1770 weights them: 1.0 for the front
+       *                    channels, 1.41 for the surrounds and 0.0 to leave out the LFE. Stereo where empty
+       */
+      explicit LoudnessMeter(const int sample_rate, std::vector<double> weights = {});
+
+      LoudnessMeter() = delete;
+
+      /**
+       * @brief         Measure the next samples
+       * @param samples Interleaved, of channels() channels, full scale being [-1.0, 1.0]
+       * @param frames  Number of sample frames
+       */
+      void process(const float* samples, const size_t frames);
+      /**
+       * @brief Forget all measured, to start a new measurement
+       */
+      void reset();
+      /**
+       * @return  The levels measured so far. Integrated loudness is gated over all measured since reset
+       */
+      Levels levels() const;
+      int sampleRate() const;
+      int channels() const;
+
+      /**
+       * @param energy  Mean square, summed over the channels as weighted, of K-weighted samples
+       * @return        LUFS
+       */
+      static double loudness(const double energy);
+
+    private:
+      struct Biquad
+      {
+        double b0_ {1.0};
+        double b1_ {0.0};
+        double b2_ {0.0};
+        double a1_ {0.0};
+        double a2_ {0.0};
+      };
+      struct BiquadState
+      {
+        double x1_ {0.0};
+        double x2_ {0.0};
+        double y1_ {0.0};
+        double y2_ {0.0};
+      };
+      static constexpr int OVERSAMPLING = 4;
+      static constexpr int TAPS = 12;
+
+      int sample_rate_;
+      std::vector<double> weights_;
+      // sample frames in a 100ms block, the step of the loudness windows
+      size_t block_frames_;
+      // the pre-filter (high shelf) then the RLB high-pass
+      std::array<Biquad, 2> k_weighting_;
+      std::vector<std::array<BiquadState, 2>> states_;
+      // coefficients of each phase in turn
+      std::array<float, OVERSAMPLING * TAPS> interpolator_ {};
+      // the last TAPS samples of each channel, written twice over so a window is always contiguous
+      std::vector<std::array<float, TAPS * 2>> history_;
+      size_t history_pos_ {0};
+
+      // the block being measured
+      size_t block_filled_ {0};
+      double block_energy_ {0.0};
+      std::vector<float> block_peak_;
+      std::vector<float> block_squares_;
+
+      // of the last 3s of blocks, oldest first
+      std::deque<double> block_energies_;
+      // of the last 300ms of blocks, oldest first
+      std::deque<std::vector<double>> block_mean_squares_;
+      // of each 400ms window, a block apart, for the gated integrated loudness
+      std::vector<double> gating_energies_;
+      Levels levels_;
+
+      void completeBlock();
+      float truePeak(const size_t channel, const float sample);
+  };
+}
+
+#endif // LOUDNESSMETER_H
@@ -0,0 +1,252 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "mixkernels.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  constexpr float S16_SCALE = 32768.0f;
+  constexpr float S16_INV_SCALE = 1.0f / S16_SCALE;
+#if defined(__SSE2__)
+  constexpr size_t LANES = 4;
+#endif
+}
+
+
+void chestnut::playback::kernel::fromS16(const int16_t* src, float* dst, const size_t count)
+{
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 scale = _mm_set1_ps(S16_INV_SCALE);
+  for (; i + (LANES * 2) <= count; i += LANES * 2) {
+    const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    // sign-extend each half to 32 bits by placing the samples in the upper halves and shifting back down
+    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16);
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+    _mm_storeu_ps(dst + i + LANES, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] = src[i] * S16_INV_SCALE;
+  }
+}
+
+
+void chestnut::playback::kernel::toS16(const float* src, int16_t* dst, const size_t count)
+{
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 scale = _mm_set1_ps(S16_SCALE);
+  // bounded first, as the conversion to 32 bits would wrap mixes far beyond full scale
+  const __m128 lower = _mm_set1_ps(-2.0f);
+  const __m128 upper = _mm_set1_ps(2.0f);
+  const auto convert = [&] (const float* samples) {
+    const __m128 bounded = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples), lower), upper);
+    return _mm_cvtps_epi32(_mm_mul_ps(bounded, scale));
+  };
+  for (; i + (LANES * 2) <= count; i += LANES * 2) {
+    const __m128i lo = convert(src + i);
+    const __m128i hi = convert(src + i + LANES);
+    // packs saturates to the 16-bit range
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(lo, hi));
+  }
+#endif
+  for (; i < count; ++i) {
+    const float scaled = std::nearbyint(src[i] * S16_SCALE);
+    dst[i] = static_cast<int16_t>(std::clamp(scaled, static_cast<float>(INT16_MIN), static_cast<float>(INT16_MAX)));
+  }
+}
+
+
+void chestnut::playback::kernel::accumulate(const float* src, float* dst, const size_t count)
+{
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + LANES <= count; i += LANES) {
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] += src[i];
+  }
+}
+
+
+void chestnut::playback::kernel::applyGain(float* samples, const size_t count, const float gain)
+{
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 factor = _mm_set1_ps(gain);
+  for (; i + LANES <= count; i += LANES) {
+    _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), factor));
+  }
+#endif
+  for (; i < count; ++i) {
+    samples[i] *= gain;
+  }
+}
+
+
+void chestnut::playback::kernel::applyStereoGains(float* samples, const float* left, const float* right,
+                                                  const size_t frames)
+{
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + LANES <= frames; i += LANES) {
+    const __m128 l = _mm_loadu_ps(left + i);
+    const __m128 r = _mm_loadu_ps(right + i);
+    // interleave the gains as the samples are
+    float* frame = samples + (i * 2);
+    _mm_storeu_ps(frame, _mm_mul_ps(_mm_loadu_ps(frame), _mm_unpacklo_ps(l, r)));
+    _mm_storeu_ps(frame + LANES, _mm_mul_ps(_mm_loadu_ps(frame + LANES), _mm_unpackhi_ps(l, r)));
+  }
+#endif
+  for (; i < frames; ++i) {
+    samples[i * 2] *= left[i];
+    samples[(i * 2) + 1] *= right[i];
+  }
+}
+
+
+void chestnut::playback::kernel::applyFrameGains(float* samples, const float* gains, const int channels,
+                                                 const size_t frames)
+{
+  if (channels == 2) {
+    applyStereoGains(samples, gains, gains, frames);
+    return;
+  }
+  const auto width = static_cast<size_t>(channels);
+  size_t i = 0;
+#if defined(__SSE2__)
+  if (width == 1) {
+    for (; i + LANES <= frames; i += LANES) {
+      _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(gains + i)));
+    }
+  } else {
+    // each frame's gain across its channels, four at a time
+    for (; i < frames; ++i) {
+      const __m128 gain = _mm_set1_ps(gains[i]);
+      float* frame = samples + (i * width);
+      size_t c = 0;
+      for (; c + LANES <= width; c += LANES) {
+        _mm_storeu_ps(frame + c, _mm_mul_ps(_mm_loadu_ps(frame + c), gain));
+      }
+      for (; c < width; ++c) {
+        frame[c] *= gains[i];
+      }
+    }
+  }
+#endif
+  for (; i < frames; ++i) {
+    for (size_t c = 0; c < width; ++c) {
+      samples[(i * width) + c] *= gains[i];
+    }
+  }
+}
+
+
+void chestnut::playback::kernel::applyFrontGains(float* samples, const float* left, const float* right,
+                                                 const int channels, const size_t frames)
+{
+  if (channels == 2) {
+    applyStereoGains(samples, left, right, frames);
+    return;
+  }
+  const auto width = static_cast<size_t>(channels);
+  for (size_t i = 0; i < frames; ++i) {
+    samples[i * width] *= left[i];
+    samples[(i * width) + 1] *= right[i];
+  }
+}
+
+
+void chestnut::playback::kernel::remix(const float* src, const int channels, const float* matrix,
+                                       const int dst_channels, float* dst, const size_t frames)
+{
+  const auto width = static_cast<size_t>(channels);
+  const auto dst_width = static_cast<size_t>(dst_channels);
+  for (size_t i = 0; i < frames; ++i) {
+    const float* frame = src + (i * width);
+    for (size_t o = 0; o < dst_width; ++o) {
+      const float* row = matrix + (o * width);
+      size_t c = 0;
+      float sum = 0.0f;
+#if defined(__SSE2__)
+      __m128 acc = _mm_setzero_ps();
+      for (; c + LANES <= width; c += LANES) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(frame + c), _mm_loadu_ps(row + c)));
+      }
+      alignas(16) float lanes[LANES];
+      _mm_store_ps(lanes, acc);
+      sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+      for (; c < width; ++c) {
+        sum += frame[c] * row[c];
+      }
+      dst[(i * dst_width) + o] = sum;
+    }
+  }
+}
+
+
+void chestnut::playback::kernel::stereoPeakSquares(const float* samples, const size_t frames, float* peaks,
+                                                   float* squares)
+{
+  size_t i = 0;
+  float left_peak = peaks[0];
+  float right_peak = peaks[1];
+  float left_squares = 0.0f;
+  float right_squares = 0.0f;
+#if defined(__SSE2__)
+  const __m128 magnitude = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+  __m128 peak = _mm_setzero_ps();
+  __m128 sum = _mm_setzero_ps();
+  // two frames at a time, so the lanes alternate left and right
+  for (; i + 2 <= frames; i += 2) {
+    const __m128 in = _mm_loadu_ps(samples + (i * 2));
+    peak = _mm_max_ps(peak, _mm_and_ps(in, magnitude));
+    sum = _mm_add_ps(sum, _mm_mul_ps(in, in));
+  }
+  alignas(16) float lanes[LANES];
+  _mm_store_ps(lanes, peak);
+  left_peak = std::max({left_peak, lanes[0], lanes[2]});
+  right_peak = std::max({right_peak, lanes[1], lanes[3]});
+  _mm_store_ps(lanes, sum);
+  left_squares = lanes[0] + lanes[2];
+  right_squares = lanes[1] + lanes[3];
+#endif
+  for (; i < frames; ++i) {
+    const float left = samples[i * 2];
+    const float right = samples[(i * 2) + 1];
+    left_peak = std::max(left_peak, std::abs(left));
+    right_peak = std::max(right_peak, std::abs(right));
+    left_squares += left * left;
+    right_squares += right * right;
+  }
+  peaks[0] = left_peak;
+  peaks[1] = right_peak;
+  squares[0] += left_squares;
+  squares[1] += right_squares;
+}
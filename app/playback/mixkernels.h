@@ -0,0 +1,108 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MIXKERNELS_H
+#define MIXKERNELS_H
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Sample loops of the audio mixer, vectorized where the target has SSE2. Mixed samples are float, full scale being
+ * [-1.0, 1.0]. Buffers need no particular alignment.
+ * Samples stay interleaved rather than planar: clips stage them so and the device and encoder take them so, and a sum
+ * or a gain of all channels runs over the buffer alike either way. Only the per-channel gains need to know the layout
+ */
+namespace chestnut::playback::kernel
+{
+  /**
+   * @brief       Convert 16-bit samples to float
+   * @param src
+   * @param dst
+   * @param count Number of samples
+   */
+  void fromS16(const int16_t* src, float* dst, const size_t count);
+  /**
+   * @brief       Convert float samples to 16-bit, saturating those beyond full scale
+   * @param src
+   * @param dst
+   * @param count Number of samples
+   */
+  void toS16(const float* src, int16_t* dst, const size_t count);
+  /**
+   * @brief       Add samples into others
+   * @param src
+   * @param dst   Summed into
+   * @param count Number of samples
+   */
+  void accumulate(const float* src, float* dst, const size_t count);
+  /**
+   * @brief         Scale samples in place
+   * @param samples
+   * @param count   Number of samples
+   * @param gain    Linear
+   */
+  void applyGain(float* samples, const size_t count, const float gain);
+  /**
+   * @brief         Scale interleaved stereo samples in place, by a gain per frame for each channel
+   * @param samples
+   * @param left    Linear, one per frame
+   * @param right   Linear, one per frame
+   * @param frames  Number of sample frames
+   */
+  void applyStereoGains(float* samples, const float* left, const float* right, const size_t frames);
+  /**
+   * @brief           Scale interleaved samples in place, by a gain per frame applied to all of its channels
+   * @param samples
+   * @param gains     Linear, one per frame
+   * @param channels  Of each frame
+   * @param frames    Number of sample frames
+   */
+  void applyFrameGains(float* samples, const float* gains, const int channels, const size_t frames);
+  /**
+   * @brief           Scale the first two channels (front left and right) of interleaved samples in place, by a gain
+   *                  per frame for each. Any other channels are left as they are
+   * @param samples
+   * @param left      Linear, one per frame
+   * @param right     Linear, one per frame
+   * @param channels  Of each frame, at least 2
+   * @param frames    Number of sample frames
+   */
+  void applyFrontGains(float* samples, const float* left, const float* right, const int channels,
+                       const size_t frames);
+  /**
+   * @brief               Remix interleaved samples to fewer (or more) channels
+   * @param src
+   * @param channels      Of each frame of src
+   * @param matrix        Gain of each src channel in each dst channel, a row of channels for each dst channel
+   * @param dst_channels  Of each frame of dst
+   * @param dst
+   * @param frames        Number of sample frames
+   */
+  void remix(const float* src, const int channels, const float* matrix, const int dst_channels, float* dst,
+             const size_t frames);
+  /**
+   * @brief         Measure interleaved stereo samples for metering
+   * @param samples
+   * @param frames  Number of sample frames
+   * @param peaks   Of each channel, raised to the largest magnitude measured
+   * @param squares Of each channel, added to by the sum of the squares measured
+   */
+  void stereoPeakSquares(const float* samples, const size_t frames, float* peaks, float* squares);
+}
+
+#endif // MIXKERNELS_H
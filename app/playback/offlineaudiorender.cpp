@@ -0,0 +1,621 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "offlineaudiorender.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "playback/audiofilter.h"
+#include "playback/decodescheduler.h"
+#include "playback/mixkernels.h"
+#include "project/clip.h"
+#include "project/footage.h"
+#include "debug.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+}
+
+using chestnut::playback::ClipAudioSource;
+using chestnut::playback::OfflineAudioRender;
+
+namespace
+{
+  constexpr auto ERR_LEN = 256;
+  // samples of each channel generated at a time for clips without media (tone, noise)
+  constexpr int GENERATED_SAMPLES = 2048;
+  // samples of each channel written to a bounce at a time
+  constexpr size_t BOUNCE_SAMPLES = 8192;
+  constexpr quint16 BITS_PER_SAMPLE = 16;
+  constexpr quint16 WAV_FORMAT_PCM = 1;
+  // for more than two channels, so the speakers can be given
+  constexpr quint16 WAV_FORMAT_EXTENSIBLE = 0xFFFE;
+  // KSDATAFORMAT_SUBTYPE_PCM, as laid out in the file
+  constexpr std::array<char, 16> WAV_SUBFORMAT_PCM {'\x01', '\x00', '\x00', '\x00', '\x00', '\x00', '\x10', '\x00',
+                                                    '\x80', '\x00', '\x00', '\xAA', '\x00', '\x38', '\x9B', '\x71'};
+
+  /**
+   * @param sequence
+   * @return          The sequence's channel layout, AV_CH_LAYOUT_*, or stereo if it is unset
+   */
+  uint64_t layoutOf(const Sequence& sequence)
+  {
+    if (sequence.audioLayout() <= 0) {
+      return AV_CH_LAYOUT_STEREO;
+    }
+    return static_cast<uint64_t>(sequence.audioLayout());
+  }
+
+  /**
+   * @brief           The output position of a sequence frame
+   * @param sequence
+   * @param frame
+   * @return          Interleaved samples, of all the sequence's channels, since the sequence's start
+   */
+  int64_t toSamples(const Sequence& sequence, const long frame)
+  {
+    return qRound64(frame / sequence.frameRate() * sequence.audioFrequency()) * sequence.audioChannels();
+  }
+
+  bool audible(const Clip& clip)
+  {
+    if ( (clip.mediaType() != ClipType::AUDIO) || !clip.timeline_info.enabled
+         || ( (clip.sequence != nullptr) && !clip.sequence->trackEnabled(clip.timeline_info.track_)) ) {
+      return false;
+    }
+    const auto& media = clip.timeline_info.media;
+    if (media == nullptr) {
+      return true;
+    }
+    if (media->type() != MediaType::FOOTAGE) {
+      return false;
+    }
+    const auto ftg = media->object<Footage>();
+    return (ftg != nullptr) && (ftg->audio_stream_from_file_index(clip.timeline_info.media_stream) != nullptr);
+  }
+
+  void failed(const int ret, const char* msg, const QString& path)
+  {
+    std::array<char, ERR_LEN> err{};
+    av_strerror(ret, err.data(), ERR_LEN);
+    qWarning() << msg << ", path:" << path << ", msg:" << err.data();
+  }
+}
+
+
+ClipAudioSource::ClipAudioSource(ClipPtr clip, const int64_t start)
+  : clip_(std::move(clip)),
+    position_(start)
+{
+  Q_ASSERT(clip_ != nullptr);
+  Q_ASSERT(clip_->sequence != nullptr);
+  layout_ = layoutOf(*clip_->sequence);
+  channels_ = clip_->sequence->audioChannels();
+  begin_ = toSamples(*clip_->sequence, clip_->timelineInWithTransition());
+  end_ = toSamples(*clip_->sequence, clip_->timelineOutWithTransition());
+  opened_ = open(std::max(start, begin_));
+}
+
+
+ClipAudioSource::~ClipAudioSource()
+{
+  avfilter_graph_free(&graph_);
+  av_frame_free(&frame_);
+  av_packet_free(&pkt_);
+  avcodec_free_context(&codec_ctx_);
+  avformat_close_input(&fmt_ctx_);
+}
+
+
+void ClipAudioSource::render(float* dst, const size_t count)
+{
+  Q_ASSERT(dst != nullptr);
+  size_t done = 0;
+  while (done < count) {
+    const auto remaining = static_cast<int64_t>(count - done);
+    if ( (position_ < begin_) || (position_ >= end_) ) {
+      // silent either side of the clip
+      const auto silent = (position_ < begin_) ? std::min(remaining, begin_ - position_) : remaining;
+      std::fill_n(dst + done, silent, 0.0f);
+      done += static_cast<size_t>(silent);
+      position_ += silent;
+      continue;
+    }
+
+    const auto available = static_cast<int64_t>(pending_.size() - pending_offset_);
+    if (available == 0) {
+      if (!fill()) {
+        // the media ended before the clip. silent from here on
+        opened_ = false;
+        std::fill_n(dst + done, remaining, 0.0f);
+        position_ += remaining;
+        done = count;
+      }
+      continue;
+    }
+
+    const auto taken = std::min({available, remaining, end_ - position_});
+    kernel::fromS16(pending_.data() + pending_offset_, dst + done, static_cast<size_t>(taken));
+    pending_offset_ += static_cast<size_t>(taken);
+    done += static_cast<size_t>(taken);
+    position_ += taken;
+  }
+}
+
+
+int64_t ClipAudioSource::begin() const
+{
+  return begin_;
+}
+
+
+int64_t ClipAudioSource::end() const
+{
+  return end_;
+}
+
+
+bool ClipAudioSource::open(const int64_t start)
+{
+  const auto& seq = *clip_->sequence;
+  filtered_ = start;
+  frame_ = av_frame_alloc();
+  if (frame_ == nullptr) {
+    qCritical() << "Failed to allocate frame";
+    return false;
+  }
+
+  // the media plays from the clip's in point, at its speed
+  const double offset_secs = static_cast<double>(start - begin_) / channels_ / seq.audioFrequency();
+  seek_secs_ = (clip_->clipInWithTransition() / seq.frameRate() + offset_secs) * speed();
+
+  const auto ftg = (clip_->timeline_info.media != nullptr) ? clip_->timeline_info.media->object<Footage>() : nullptr;
+  const auto ms = (ftg != nullptr) ? ftg->audio_stream_from_file_index(clip_->timeline_info.media_stream) : nullptr;
+  // conformed audio is stereo, so is only taken for a stereo sequence
+  if ( (ms != nullptr) && (channels_ == project::ConformedAudio::CHANNELS) ) {
+    if (const auto conformed = ms->conformedAudio(); (conformed != nullptr) && !clip_->timeline_info.reverse
+        && qFuzzyCompare(speed(), 1.0) && (conformed->sampleRate() == seq.audioFrequency())) {
+      conformed_ = conformed;
+      conform_position_ = std::max(static_cast<int64_t>(0), qRound64(seek_secs_ * seq.audioFrequency()));
+    }
+  }
+
+  if ( (clip_->timeline_info.media == nullptr) || (conformed_ != nullptr) ) {
+    // generated by the clip's effects into silence, or copied from the conformed samples
+    timed_ = true;
+    frame_->format = AV_SAMPLE_FMT_S16;
+    frame_->channel_layout = layout_;
+    frame_->channels = channels_;
+    frame_->sample_rate = seq.audioFrequency();
+    frame_->nb_samples = GENERATED_SAMPLES;
+    if (const auto ret = av_frame_get_buffer(frame_, 0); ret < 0) {
+      failed(ret, "Failed to allocate generated samples", "");
+      return false;
+    }
+    return true;
+  }
+
+  if (ms == nullptr) {
+    qCritical() << "Clip has no footage stream";
+    return false;
+  }
+  const auto path = ftg->location();
+  stream_index_ = clip_->timeline_info.media_stream;
+
+  if (const auto ret = avformat_open_input(&fmt_ctx_, path.toUtf8().data(), nullptr, nullptr); ret < 0) {
+    failed(ret, "Failed to open footage", path);
+    return false;
+  }
+  if (const auto ret = avformat_find_stream_info(fmt_ctx_, nullptr); ret < 0) {
+    failed(ret, "Failed to find stream info", path);
+    return false;
+  }
+  if ( (stream_index_ < 0) || (stream_index_ >= static_cast<int>(fmt_ctx_->nb_streams)) ) {
+    qWarning() << "No such stream, path:" << path << ", index:" << stream_index_;
+    return false;
+  }
+  for (unsigned int i = 0; i < fmt_ctx_->nb_streams; ++i) {
+    if (static_cast<int>(i) != stream_index_) {
+      fmt_ctx_->streams[i]->discard = AVDISCARD_ALL;
+    }
+  }
+  const auto stream = fmt_ctx_->streams[stream_index_];
+
+  const auto codec = avcodec_find_decoder(stream->codecpar->codec_id);
+  if (codec == nullptr) {
+    qWarning() << "No decoder for stream, path:" << path << ", index:" << stream_index_;
+    return false;
+  }
+  codec_ctx_ = avcodec_alloc_context3(codec);
+  if (codec_ctx_ == nullptr) {
+    qCritical() << "Failed to allocate decoder";
+    return false;
+  }
+  if (const auto ret = avcodec_parameters_to_context(codec_ctx_, stream->codecpar); ret < 0) {
+    failed(ret, "Failed to set decoder parameters", path);
+    return false;
+  }
+  if (const auto ret = avcodec_open2(codec_ctx_, codec, nullptr); ret < 0) {
+    failed(ret, "Failed to open decoder", path);
+    return false;
+  }
+
+  graph_ = avfilter_graph_alloc();
+  pkt_ = av_packet_alloc();
+  if ( (graph_ == nullptr) || (pkt_ == nullptr) ) {
+    qCritical() << "Failed to allocate filter graph or packet";
+    return false;
+  }
+  if (!buildAudioFilterGraph(*graph_, *stream, *codec_ctx_, seq.audioFrequency(), layout_, speed(),
+                             clip_->timeline_info.maintain_audio_pitch, src_, sink_)) {
+    return false;
+  }
+
+  const auto timestamp = qRound64(seek_secs_ / av_q2d(stream->time_base)) + std::max<int64_t>(0, stream->start_time);
+  if (const auto ret = av_seek_frame(fmt_ctx_, stream_index_, timestamp, AVSEEK_FLAG_BACKWARD); ret < 0) {
+    // decoded from the beginning instead
+    failed(ret, "Failed to seek", path);
+  }
+  return true;
+}
+
+
+bool ClipAudioSource::fill()
+{
+  if (!opened_) {
+    return false;
+  }
+
+  if (conformed_ != nullptr) {
+    const auto remaining = conformed_->length() - conform_position_;
+    if (remaining <= 0) {
+      return false;
+    }
+    frame_->nb_samples = static_cast<int>(std::min(static_cast<int64_t>(GENERATED_SAMPLES), remaining));
+    kernel::toS16(conformed_->samples(conform_position_), reinterpret_cast<int16_t*>(frame_->data[0]),
+                  static_cast<size_t>(frame_->nb_samples * channels_));
+    conform_position_ += frame_->nb_samples;
+    take(*frame_);
+    return true;
+  }
+
+  if (fmt_ctx_ == nullptr) {
+    memset(frame_->data[0], 0, static_cast<size_t>(frame_->nb_samples * channels_) * sizeof(int16_t));
+    take(*frame_);
+    return true;
+  }
+
+  const auto stream = fmt_ctx_->streams[stream_index_];
+  while (true) {
+    auto ret = av_buffersink_get_frame(sink_, frame_);
+    if (ret >= 0) {
+      take(*frame_);
+      av_frame_unref(frame_);
+      return true;
+    }
+    if ( (ret != AVERROR(EAGAIN)) || drained_) {
+      // the end of the media, or the filters failed
+      return false;
+    }
+
+    ret = avcodec_receive_frame(codec_ctx_, frame_);
+    if (ret == 0) {
+      if (!timed_) {
+        // decoding starts at the keyframe before the seek, so the samples up to it are dropped
+        const double frame_secs = (frame_->best_effort_timestamp - std::max<int64_t>(0, stream->start_time))
+                                  * av_q2d(stream->time_base);
+        const auto offset = qRound64((frame_secs - seek_secs_) / speed() * clip_->sequence->audioFrequency());
+        filtered_ = position_ + offset * channels_;
+        timed_ = true;
+      }
+      if (av_buffersrc_add_frame(src_, frame_) < 0) {
+        qWarning() << "Failed to filter decoded samples";
+        av_frame_unref(frame_);
+      }
+    } else if (ret == AVERROR_EOF) {
+      av_buffersrc_add_frame(src_, nullptr);
+      drained_ = true;
+    } else if (ret == AVERROR(EAGAIN)) {
+      // feed the decoder
+      bool sent = false;
+      while (!sent && (av_read_frame(fmt_ctx_, pkt_) >= 0)) {
+        if (pkt_->stream_index == stream_index_) {
+          avcodec_send_packet(codec_ctx_, pkt_);
+          sent = true;
+        }
+        av_packet_unref(pkt_);
+      }
+      if (!sent) {
+        avcodec_send_packet(codec_ctx_, nullptr);
+      }
+    } else {
+      failed(ret, "Failed to decode", "");
+      return false;
+    }
+  }
+}
+
+
+void ClipAudioSource::take(AVFrame& frame)
+{
+  if (av_frame_make_writable(&frame) < 0) {
+    qWarning() << "Filtered samples not writable, effects skipped";
+  } else {
+    const auto& seq = *clip_->sequence;
+    const double timecode = static_cast<double>(filtered_ - begin_) / channels_ / seq.audioFrequency()
+                            + clip_->clipInWithTransition() / seq.frameRate();
+    QVector<ClipPtr> nests;
+    clip_->apply_audio_effects(timecode, &frame, frame.nb_samples * channels_ * static_cast<int>(sizeof(int16_t)), nests);
+  }
+
+  if (pending_offset_ == pending_.size()) {
+    pending_.clear();
+    pending_offset_ = 0;
+  }
+
+  const auto count = static_cast<int64_t>(frame.nb_samples) * channels_;
+  const auto samples = reinterpret_cast<const int16_t*>(frame.data[0]);
+  // a gap before the first samples of the media is silent
+  const auto held = position_ + static_cast<int64_t>(pending_.size() - pending_offset_);
+  if (filtered_ > held) {
+    pending_.insert(pending_.end(), static_cast<size_t>(filtered_ - held), 0);
+  }
+  // samples before the position rendered were only decoded to reach it
+  const auto skipped = std::clamp<int64_t>(held - filtered_, 0, count);
+  pending_.insert(pending_.end(), samples + skipped, samples + count);
+  filtered_ += count;
+}
+
+
+double ClipAudioSource::speed() const
+{
+  double speed = clip_->timeline_info.speed;
+  if (const auto& media = clip_->timeline_info.media; (media != nullptr) && (media->type() == MediaType::FOOTAGE)) {
+    speed *= media->object<Footage>()->speed_;
+  }
+  return speed;
+}
+
+
+OfflineAudioRender::OfflineAudioRender(SequencePtr sequence, const long start_frame, const long end_frame)
+  : sequence_(std::move(sequence))
+{
+  Q_ASSERT(sequence_ != nullptr);
+  layout_ = layoutOf(*sequence_);
+  channels_ = sequence_->audioChannels();
+  start_ = toSamples(*sequence_, start_frame);
+  end_ = std::max(start_, toSamples(*sequence_, end_frame));
+  position_ = start_;
+  mixed_ = start_;
+
+  for (const auto& clp : sequence_->clips()) {
+    if ( (clp == nullptr) || !audible(*clp) ) {
+      continue;
+    }
+    if ( (clp->timelineOutWithTransition() <= start_frame) || (clp->timelineInWithTransition() >= end_frame) ) {
+      continue;
+    }
+    clips_.push_back(clp);
+  }
+  sources_.resize(clips_.size());
+  rendered_.resize(clips_.size());
+}
+
+
+OfflineAudioRender::~OfflineAudioRender() = default;
+
+
+bool OfflineAudioRender::supports(Sequence& sequence)
+{
+  for (const auto& clp : sequence.clips()) {
+    if ( (clp == nullptr) || (clp->mediaType() != ClipType::AUDIO) ) {
+      continue;
+    }
+    if (clp->timeline_info.reverse) {
+      return false;
+    }
+    if ( (clp->timeline_info.media != nullptr) && (clp->timeline_info.media->type() == MediaType::SEQUENCE) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+size_t OfflineAudioRender::render(float* dst, const size_t count)
+{
+  Q_ASSERT(dst != nullptr);
+  size_t done = 0;
+  while ( (done < count) && (position_ < end_) ) {
+    if (block_offset_ >= block_.size()) {
+      mixBlock();
+    }
+    const auto taken = std::min(count - done, block_.size() - block_offset_);
+    std::copy_n(block_.data() + block_offset_, taken, dst + done);
+    block_offset_ += taken;
+    done += taken;
+    position_ += static_cast<int64_t>(taken);
+  }
+  std::fill(dst + done, dst + count, 0.0f);
+  return done;
+}
+
+
+bool OfflineAudioRender::bounce(const QString& path, const std::atomic_bool& running, const Progress& progress)
+{
+  // the extensible header is written for more than two channels, giving the layout of their speakers
+  const bool extensible = channels_ > 2;
+  const quint32 fmt_bytes = extensible ? 40 : 16;
+  const auto data_bytes = length() * static_cast<int64_t>(sizeof(int16_t));
+  if (data_bytes > (std::numeric_limits<quint32>::max() - 20 - fmt_bytes)) {
+    qCritical() << "Too long to bounce to WAV, samples:" << length();
+    return false;
+  }
+
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qCritical() << "Failed to open file for bounce, path:" << path << ", msg:" << file.errorString();
+    return false;
+  }
+  QDataStream stream(&file);
+  stream.setByteOrder(QDataStream::LittleEndian);
+
+  const auto rate = static_cast<quint32>(sampleRate());
+  const auto block_align = static_cast<quint16>(channels_ * (BITS_PER_SAMPLE / 8));
+  stream.writeRawData("RIFF", 4);
+  stream << static_cast<quint32>(20 + fmt_bytes + data_bytes);
+  stream.writeRawData("WAVE", 4);
+  stream.writeRawData("fmt ", 4);
+  stream << fmt_bytes << (extensible ? WAV_FORMAT_EXTENSIBLE : WAV_FORMAT_PCM) << static_cast<quint16>(channels_)
+         << rate << (rate * block_align) << block_align << BITS_PER_SAMPLE;
+  if (extensible) {
+    // the speaker bits of the channel mask are those of the layout
+    stream << static_cast<quint16>(22) << BITS_PER_SAMPLE << static_cast<quint32>(layout_);
+    stream.writeRawData(WAV_SUBFORMAT_PCM.data(), static_cast<int>(WAV_SUBFORMAT_PCM.size()));
+  }
+  stream.writeRawData("data", 4);
+  stream << static_cast<quint32>(data_bytes);
+
+  std::vector<float> samples(BOUNCE_SAMPLES * static_cast<size_t>(channels_));
+  std::vector<int16_t> converted(samples.size());
+  while (position_ < end_) {
+    if (!running) {
+      file.remove();
+      return false;
+    }
+    const auto count = render(samples.data(), samples.size());
+    kernel::toS16(samples.data(), converted.data(), count);
+    stream.writeRawData(reinterpret_cast<const char*>(converted.data()), static_cast<int>(count * sizeof(int16_t)));
+    if (stream.status() != QDataStream::Ok) {
+      qCritical() << "Failed to write bounce, path:" << path << ", msg:" << file.errorString();
+      file.remove();
+      return false;
+    }
+    if (progress) {
+      progress(static_cast<int>((position() * 100) / std::max<int64_t>(1, length())));
+    }
+  }
+  return true;
+}
+
+
+void OfflineAudioRender::enableMetering()
+{
+  if (meter_ == nullptr) {
+    // each channel as it is, weighted by where it plays rather than as a downmix
+    if (auto weights = loudnessWeights(layout_); static_cast<int>(weights.size()) == channels_) {
+      meter_ = std::make_unique<LoudnessMeter>(sampleRate(), std::move(weights));
+    } else {
+      qWarning() << "Cannot meter a channel layout of" << layout_;
+    }
+  }
+}
+
+
+const chestnut::playback::LoudnessMeter* OfflineAudioRender::meter() const
+{
+  return meter_.get();
+}
+
+
+int OfflineAudioRender::sampleRate() const
+{
+  return sequence_->audioFrequency();
+}
+
+
+int OfflineAudioRender::channels() const
+{
+  return channels_;
+}
+
+
+uint64_t OfflineAudioRender::channelLayout() const
+{
+  return layout_;
+}
+
+
+int64_t OfflineAudioRender::position() const
+{
+  return position_ - start_;
+}
+
+
+int64_t OfflineAudioRender::length() const
+{
+  return end_ - start_;
+}
+
+
+void OfflineAudioRender::mixBlock()
+{
+  const auto from = mixed_;
+  const auto count = static_cast<size_t>(std::min<int64_t>((sampleRate() / 2) * channels_, end_ - from));
+  const auto to = from + static_cast<int64_t>(count);
+  block_.assign(count, 0.0f);
+  block_offset_ = 0;
+
+  std::vector<size_t> active;
+  for (size_t i = 0; i < clips_.size(); ++i) {
+    auto& source = sources_.at(i);
+    if (source == nullptr) {
+      const auto& clp = clips_.at(i);
+      if ( (toSamples(*sequence_, clp->timelineOutWithTransition()) <= from)
+           || (toSamples(*sequence_, clp->timelineInWithTransition()) >= to) ) {
+        continue;
+      }
+      source = std::make_unique<ClipAudioSource>(clp, from);
+    } else if (source->end() <= from) {
+      source.reset();
+      continue;
+    }
+    rendered_.at(i).resize(count);
+    active.push_back(i);
+  }
+
+  if (active.size() == 1) {
+    // nothing to render alongside it
+    sources_.at(active.front())->render(rendered_.at(active.front()).data(), count);
+  } else if (!active.empty()) {
+    if (workers_ == nullptr) {
+      workers_ = std::make_unique<DecodeScheduler>(0);
+    }
+    for (const auto i : active) {
+      workers_->submit([src = sources_.at(i).get(), dst = rendered_.at(i).data(), count] {
+        src->render(dst, count);
+      }, DecodePriority{});
+    }
+    workers_->waitForIdle();
+  }
+  // summed in the order of the clips, so a render is the same each time
+  for (const auto i : active) {
+    kernel::accumulate(rendered_.at(i).data(), block_.data(), count);
+  }
+  if (meter_ != nullptr) {
+    meter_->process(block_.data(), count / static_cast<size_t>(channels_));
+  }
+  mixed_ = to;
+}
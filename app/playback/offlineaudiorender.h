@@ -0,0 +1,228 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OFFLINEAUDIORENDER_H
+#define OFFLINEAUDIORENDER_H
+
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "project/sequence.h"
+#include "project/conformedaudio.h"
+#include "playback/loudnessmeter.h"
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVFilterGraph;
+struct AVFilterContext;
+struct AVPacket;
+struct AVFrame;
+
+namespace chestnut::playback
+{
+  class DecodeScheduler;
+
+  /**
+   * @brief Pulls the samples of one audio clip, through its effects and transitions, with its own decoder or from the
+   *        footage's conformed audio
+   */
+  class ClipAudioSource
+  {
+    public:
+      /**
+       * @param clip
+       * @param start Output position to start at, in samples
+       */
+      ClipAudioSource(ClipPtr clip, const int64_t start);
+      ~ClipAudioSource();
+
+      ClipAudioSource() = delete;
+      ClipAudioSource(const ClipAudioSource&) = delete;
+      ClipAudioSource(const ClipAudioSource&&) = delete;
+      ClipAudioSource& operator=(const ClipAudioSource&) = delete;
+      ClipAudioSource& operator=(const ClipAudioSource&&) = delete;
+
+      /**
+       * @brief         Render the clip's next samples
+       * @param dst     Interleaved in the sequence's layout, filled with the clip's samples or silence
+       * @param count   Number of samples
+       */
+      void render(float* dst, const size_t count);
+      /**
+       * @return  Output position of the clip's first sample
+       */
+      int64_t begin() const;
+      /**
+       * @return  Output position after the clip's last sample
+       */
+      int64_t end() const;
+
+    private:
+      ClipPtr clip_;
+      int64_t begin_ {0};
+      int64_t end_ {0};
+      // output position of the next sample rendered
+      int64_t position_ {0};
+      // the sequence's, which the clip is filtered to
+      uint64_t layout_ {0};
+      int channels_ {0};
+      AVFormatContext* fmt_ctx_ {nullptr};
+      AVCodecContext* codec_ctx_ {nullptr};
+      AVFilterGraph* graph_ {nullptr};
+      AVFilterContext* src_ {nullptr};
+      AVFilterContext* sink_ {nullptr};
+      AVPacket* pkt_ {nullptr};
+      AVFrame* frame_ {nullptr};
+      int stream_index_ {-1};
+      bool opened_ {false};
+      bool drained_ {false};
+      // read in place of decoding, when the footage has been conformed to the sequence's rate
+      project::ConformedAudioPtr conformed_;
+      // sample of each channel next taken from the conformed audio
+      int64_t conform_position_ {0};
+      // filtered samples, after effects, not yet rendered
+      std::vector<int16_t> pending_;
+      size_t pending_offset_ {0};
+      // position in the media seeked to, in seconds
+      double seek_secs_ {0.0};
+      // the first frame decoded after seeking has placed the samples filtered
+      bool timed_ {false};
+      // output position of the next sample filtered. Samples before position_ were decoded only to reach it
+      int64_t filtered_ {0};
+
+      /**
+       * @brief       Open the clip's footage and seek to an output position
+       * @param start
+       * @return      true==success
+       */
+      bool open(const int64_t start);
+      /**
+       * @brief   Decode, filter and apply the effects to more samples
+       * @return  false==no more samples
+       */
+      bool fill();
+      /**
+       * @brief           Run the clip's effects and transitions over filtered samples and hold them to be rendered
+       * @param frame     Interleaved 16-bit, in the sequence's layout
+       */
+      void take(AVFrame& frame);
+      double speed() const;
+  };
+
+
+  /**
+   * @brief Renders the audio of a sequence straight from its clips for export and bounce, faster than realtime.
+   *        Clips are decoded alongside each other with their own decoders, so playback and its mixer are untouched.
+   *        Samples are interleaved float in the sequence's channel layout and at its rate
+   */
+  class OfflineAudioRender
+  {
+    public:
+      using Progress = std::function<void(int)>;
+
+      /**
+       * @param sequence
+       * @param start_frame First frame of the sequence rendered
+       * @param end_frame   Frame after the last rendered
+       */
+      OfflineAudioRender(SequencePtr sequence, const long start_frame, const long end_frame);
+      ~OfflineAudioRender();
+
+      OfflineAudioRender() = delete;
+      OfflineAudioRender(const OfflineAudioRender&) = delete;
+      OfflineAudioRender(const OfflineAudioRender&&) = delete;
+      OfflineAudioRender& operator=(const OfflineAudioRender&) = delete;
+      OfflineAudioRender& operator=(const OfflineAudioRender&&) = delete;
+
+      /**
+       * @brief           Identify if the audio of a sequence can be rendered offline. Nested sequences and reversed
+       *                  clips are left to playback
+       * @param sequence
+       * @return          true==supported
+       */
+      static bool supports(Sequence& sequence);
+
+      /**
+       * @brief         Render the next samples
+       * @param dst
+       * @param count   Number of samples
+       * @return        Number rendered, the remainder past the end being silence
+       */
+      size_t render(float* dst, const size_t count);
+      /**
+       * @brief         Render all samples to a 16-bit WAV file, of the sequence's channels
+       * @param path
+       * @param running Checked between blocks, to abandon the bounce
+       * @param progress Called with the percentage rendered
+       * @return        true==success
+       */
+      bool bounce(const QString& path, const std::atomic_bool& running, const Progress& progress = nullptr);
+
+      /**
+       * @brief Measure the loudness of the samples as they're mixed, for a sequence rendered without playing it. Each
+       *        channel is measured as it is, weighted as BS.1770 weights surrounds and the LFE
+       */
+      void enableMetering();
+      /**
+       * @return  The meter of the samples mixed so far, or nullptr if not enabled
+       */
+      const LoudnessMeter* meter() const;
+
+      int sampleRate() const;
+      // of each frame of the samples rendered
+      int channels() const;
+      // AV_CH_LAYOUT_* of the samples rendered
+      uint64_t channelLayout() const;
+      // rendered samples so far
+      int64_t position() const;
+      // samples in all
+      int64_t length() const;
+
+    private:
+      SequencePtr sequence_;
+      int64_t start_ {0};
+      int64_t end_ {0};
+      uint64_t layout_ {0};
+      int channels_ {0};
+      // output position of the next sample taken
+      int64_t position_ {0};
+      // output position of the next block mixed
+      int64_t mixed_ {0};
+      // audible clips, in the order they're summed
+      std::vector<ClipPtr> clips_;
+      // of each clip, while it is within the blocks mixed
+      std::vector<std::unique_ptr<ClipAudioSource>> sources_;
+      std::vector<std::vector<float>> rendered_;
+      // mixed ahead of the samples taken
+      std::vector<float> block_;
+      size_t block_offset_ {0};
+      std::unique_ptr<LoudnessMeter> meter_;
+      // a thread for each core, rendering the clips of each block alongside each other. made for the first block of
+      // more than one clip and kept for the rest of the render
+      std::unique_ptr<DecodeScheduler> workers_;
+
+      /**
+       * @brief Mix the next block from the clips within it, rendered alongside each other by the workers
+       */
+      void mixBlock();
+  };
+}
+
+#endif // OFFLINEAUDIORENDER_H
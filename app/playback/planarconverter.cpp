@@ -0,0 +1,281 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "planarconverter.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QGenericMatrix>
+#include <array>
+#include <cstdint>
+
+#include "debug.h"
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+using chestnut::playback::PlanarConverter;
+
+namespace
+{
+  constexpr auto VERTEX_SHADER =
+      "#version 110\n"
+      "varying vec2 vTexCoord;\n"
+      "void main() {\n"
+      "  vTexCoord = gl_MultiTexCoord0.xy;\n"
+      "  gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;\n"
+      "}\n";
+
+  constexpr auto FRAGMENT_SHADER =
+      "#version 110\n"
+      "uniform sampler2D rgb;\n"
+      "uniform mat3 rgb_to_yuv;\n"
+      "uniform vec3 offset;\n"
+      "uniform vec3 red;\n"
+      "uniform vec3 green;\n"
+      "varying vec2 vTexCoord;\n"
+      "void main() {\n"
+      "  vec3 yuv = (rgb_to_yuv * texture2D(rgb, vTexCoord).rgb) + offset;\n"
+      "  gl_FragColor = vec4(dot(yuv, red), dot(yuv, green), 0.0, 1.0);\n"
+      "}\n";
+
+  const QVector3D LUMA {1.0f, 0.0f, 0.0f};
+  const QVector3D CB {0.0f, 1.0f, 0.0f};
+  const QVector3D CR {0.0f, 0.0f, 1.0f};
+  const QVector3D NONE {0.0f, 0.0f, 0.0f};
+}
+
+
+PlanarConverter::PlanarConverter(const int width, const int height, const int format, const int colorspace,
+                                 const int color_range)
+  : width_(width),
+    height_(height),
+    format_(format),
+    colorspace_(colorspace),
+    color_range_(color_range)
+{
+  const auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(format));
+  if ( (desc == nullptr) || !handles(format) ) {
+    qWarning() << "Unsupported format to convert to, format:" << format;
+    return;
+  }
+  const bool deep = desc->comp[0].depth > 8;
+  const auto bytes_per_sample = deep ? sizeof(uint16_t) : sizeof(uint8_t);
+  pixel_type_ = deep ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+  // chroma interleaved in one plane, as NV12 has it, or a plane each
+  const bool interleaved = desc->comp[1].plane == desc->comp[2].plane;
+  const auto chroma_width = AV_CEIL_RSHIFT(width, desc->log2_chroma_w);
+  const auto chroma_height = AV_CEIL_RSHIFT(height, desc->log2_chroma_h);
+
+  const auto add_plane = [&] (const int plane_width, const int plane_height, const QVector3D& red,
+                              const QVector3D& green) {
+    const bool two_components = !green.isNull();
+    Plane plane;
+    plane.width_ = plane_width;
+    plane.height_ = plane_height;
+    plane.red_ = red;
+    plane.green_ = green;
+    plane.pixel_format_ = two_components ? GL_RG : GL_RED;
+    plane.bytes_ = static_cast<size_t>(plane_width) * static_cast<size_t>(plane_height) * bytes_per_sample
+                   * (two_components ? 2 : 1);
+    plane.texture_ = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
+    plane.texture_->setSize(plane_width, plane_height);
+    if (two_components) {
+      plane.texture_->setFormat(deep ? QOpenGLTexture::RG16_UNorm : QOpenGLTexture::RG8_UNorm);
+    } else {
+      plane.texture_->setFormat(deep ? QOpenGLTexture::R16_UNorm : QOpenGLTexture::R8_UNorm);
+    }
+    plane.texture_->setMipLevels(1);
+    plane.texture_->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+    plane.texture_->allocateStorage(two_components ? QOpenGLTexture::RG : QOpenGLTexture::Red,
+                                    deep ? QOpenGLTexture::UInt16 : QOpenGLTexture::UInt8);
+    planes_.push_back(std::move(plane));
+  };
+  add_plane(width, height, LUMA, NONE);
+  if (interleaved) {
+    add_plane(chroma_width, chroma_height, CB, CR);
+  } else {
+    add_plane(chroma_width, chroma_height, CB, NONE);
+    add_plane(chroma_width, chroma_height, CR, NONE);
+  }
+
+  const auto f = QOpenGLContext::currentContext()->functions();
+  valid_ = true;
+  for (auto& plane : planes_) {
+    f->glGenFramebuffers(1, &plane.framebuffer_);
+    f->glBindFramebuffer(GL_FRAMEBUFFER, plane.framebuffer_);
+    f->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, plane.texture_->textureId(), 0);
+    valid_ = valid_ && (f->glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+  }
+  f->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (!valid_) {
+    qWarning() << "Planes incomplete as framebuffers, format:" << format;
+  }
+
+  const bool linked = program_.addShaderFromSourceCode(QOpenGLShader::Vertex, VERTEX_SHADER)
+                      && program_.addShaderFromSourceCode(QOpenGLShader::Fragment, FRAGMENT_SHADER)
+                      && program_.link();
+  if (!linked) {
+    qWarning() << "RGB to YUV shader failed to link, msg =" << program_.log();
+  }
+  valid_ = valid_ && linked;
+  coefficients_ = get_rgb_coefficients(format, colorspace, color_range, height);
+}
+
+
+PlanarConverter::~PlanarConverter()
+{
+  const auto ctx = QOpenGLContext::currentContext();
+  if (ctx == nullptr) {
+    return;
+  }
+  for (auto& plane : planes_) {
+    if (plane.framebuffer_ > 0) {
+      ctx->functions()->glDeleteFramebuffers(1, &plane.framebuffer_);
+    }
+  }
+}
+
+
+bool PlanarConverter::handles(const int format)
+{
+  switch (format) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUV422P:
+    case AV_PIX_FMT_YUV444P:
+    case AV_PIX_FMT_YUV420P10:
+    case AV_PIX_FMT_YUV422P10:
+    case AV_PIX_FMT_YUV444P10:
+    case AV_PIX_FMT_NV12:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+bool PlanarConverter::supported(const QOpenGLContext& ctx)
+{
+  // rendering into single- and two-channel textures
+  if (ctx.isOpenGLES()) {
+    return ctx.format().majorVersion() >= 3;
+  }
+  return ctx.format().version() >= qMakePair(3, 0);
+}
+
+
+bool PlanarConverter::isValid() const
+{
+  return valid_;
+}
+
+
+bool PlanarConverter::matches(const int width, const int height, const int format, const int colorspace,
+                              const int color_range) const
+{
+  return (width == width_) && (height == height_) && (format == format_) && (colorspace == colorspace_)
+      && (color_range == color_range_);
+}
+
+
+void PlanarConverter::draw(QOpenGLContext& ctx, const GLuint texture)
+{
+  const auto f = ctx.functions();
+  GLint framebuffer = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+  std::array<GLint, 4> viewport {};
+  glGetIntegerv(GL_VIEWPORT, viewport.data());
+  const bool blending = glIsEnabled(GL_BLEND);
+  // each sample written as converted, not blended with what was there
+  glDisable(GL_BLEND);
+
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glLoadIdentity();
+  glOrtho(0, 1, 0, 1, -1, 1);
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadIdentity();
+
+  f->glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  program_.bind();
+  program_.setUniformValue("rgb", 0);
+  program_.setUniformValue("rgb_to_yuv", QMatrix3x3(coefficients_.matrix_.data()));
+  program_.setUniformValue("offset", QVector3D(coefficients_.offset_.at(0),
+                                               coefficients_.offset_.at(1),
+                                               coefficients_.offset_.at(2)));
+  for (const auto& plane : planes_) {
+    f->glBindFramebuffer(GL_FRAMEBUFFER, plane.framebuffer_);
+    glViewport(0, 0, plane.width_, plane.height_);
+    program_.setUniformValue("red", plane.red_);
+    program_.setUniformValue("green", plane.green_);
+    // the subsampled planes are drawn at their size, so each chroma sample averages the pixels it covers
+    glBegin(GL_QUADS);
+    glTexCoord2f(0, 0);
+    glVertex2f(0, 0);
+    glTexCoord2f(1, 0);
+    glVertex2f(1, 0);
+    glTexCoord2f(1, 1);
+    glVertex2f(1, 1);
+    glTexCoord2f(0, 1);
+    glVertex2f(0, 1);
+    glEnd();
+  }
+  program_.release();
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glPopMatrix();
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glMatrixMode(GL_MODELVIEW);
+  glViewport(viewport.at(0), viewport.at(1), viewport.at(2), viewport.at(3));
+  if (blending) {
+    glEnable(GL_BLEND);
+  }
+  f->glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+}
+
+
+void PlanarConverter::readPixels(QOpenGLContext& ctx, GLvoid* pixels)
+{
+  const auto f = ctx.functions();
+  GLint framebuffer = 0;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &framebuffer);
+  // rows of odd widths are packed too
+  f->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  // an offset when reading into a buffer, so counted rather than stepped through as a pointer
+  auto at = reinterpret_cast<uintptr_t>(pixels);
+  for (const auto& plane : planes_) {
+    f->glBindFramebuffer(GL_READ_FRAMEBUFFER, plane.framebuffer_);
+    glReadPixels(0, 0, plane.width_, plane.height_, plane.pixel_format_, pixel_type_, reinterpret_cast<GLvoid*>(at));
+    at += plane.bytes_;
+  }
+  f->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  f->glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+}
+
+
+size_t PlanarConverter::size() const
+{
+  size_t bytes = 0;
+  for (const auto& plane : planes_) {
+    bytes += plane.bytes_;
+  }
+  return bytes;
+}
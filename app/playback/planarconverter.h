@@ -0,0 +1,120 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PLANARCONVERTER_H
+#define PLANARCONVERTER_H
+
+#include <QOpenGLTexture>
+#include <QOpenGLShaderProgram>
+#include <QVector3D>
+#include <memory>
+#include <vector>
+
+#include "io/avtogl.h"
+
+class QOpenGLContext;
+
+namespace chestnut::playback
+{
+  /**
+   * @brief The planes of a YUV format, each a texture drawn into from an RGB texture by a shader, so frames are read
+   *        back in the format they are encoded in rather than as RGBA. Only formats passing handles() are converted
+   */
+  class PlanarConverter
+  {
+    public:
+      /**
+       * @brief             Create the planes and shader in the current GL context
+       * @param width       Of the frames, and the textures drawn from
+       * @param height      Of the frames, and the textures drawn from
+       * @param format      AVPixelFormat of the frames
+       * @param colorspace  AVColorSpace to convert with
+       * @param color_range AVColorRange to convert to
+       */
+      PlanarConverter(const int width, const int height, const int format, const int colorspace,
+                      const int color_range);
+      ~PlanarConverter();
+
+      PlanarConverter() = delete;
+      PlanarConverter(const PlanarConverter&) = delete;
+      PlanarConverter& operator=(const PlanarConverter&) = delete;
+
+      /**
+       * @param format  AVPixelFormat
+       * @return        true==frames of the format can be converted to
+       */
+      static bool handles(const int format);
+      /**
+       * @brief     Identify if a GL context can draw into the planes
+       * @param ctx
+       * @return    true==supported
+       */
+      static bool supported(const QOpenGLContext& ctx);
+
+      /**
+       * @brief   The shader compiled and linked and the planes are complete framebuffers
+       * @return  true==usable
+       */
+      bool isValid() const;
+      bool matches(const int width, const int height, const int format, const int colorspace,
+                   const int color_range) const;
+      /**
+       * @brief         Draw a texture into the planes, converting it
+       * @param ctx     Current
+       * @param texture RGB, of the size of the frames
+       */
+      void draw(QOpenGLContext& ctx, const GLuint texture);
+      /**
+       * @brief         Read the planes back one after another, each with its rows packed, as av_image_fill_arrays()
+       *                lays out the planes of a frame with an alignment of 1
+       * @param ctx     Current
+       * @param pixels  Into the pixel-pack buffer bound at this offset or, with none bound, memory of size() bytes
+       */
+      void readPixels(QOpenGLContext& ctx, GLvoid* pixels);
+      /**
+       * @return Bytes of the planes read back
+       */
+      size_t size() const;
+
+    private:
+      struct Plane
+      {
+        std::unique_ptr<QOpenGLTexture> texture_;
+        GLuint framebuffer_ {0};
+        int width_ {0};
+        int height_ {0};
+        GLenum pixel_format_ {0};
+        // the components of the converted sample written to the red and green of the plane
+        QVector3D red_;
+        QVector3D green_;
+        size_t bytes_ {0};
+      };
+
+      const int width_;
+      const int height_;
+      const int format_;
+      const int colorspace_;
+      const int color_range_;
+      GLenum pixel_type_ {0};
+      std::vector<Plane> planes_;
+      QOpenGLShaderProgram program_;
+      bool valid_ {false};
+      RgbCoefficients coefficients_;
+  };
+}
+
+#endif // PLANARCONVERTER_H
@@ -0,0 +1,193 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "planartexture.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QGenericMatrix>
+#include <QVector3D>
+
+#include "playback/textureuploader.h"
+#include "debug.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+}
+
+using chestnut::playback::PlanarTexture;
+
+std::atomic_bool PlanarTexture::available_ {true};
+
+namespace
+{
+  constexpr auto VERTEX_SHADER =
+      "#version 110\n"
+      "varying vec2 vTexCoord;\n"
+      "void main() {\n"
+      "  vTexCoord = gl_MultiTexCoord0.xy;\n"
+      "  gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;\n"
+      "}\n";
+
+  constexpr auto FRAGMENT_SHADER =
+      "#version 110\n"
+      "uniform sampler2D y_plane;\n"
+      "uniform sampler2D u_plane;\n"
+      "uniform sampler2D v_plane;\n"
+      "uniform mat3 yuv_to_rgb;\n"
+      "uniform vec3 offset;\n"
+      "uniform float scale;\n"
+      "varying vec2 vTexCoord;\n"
+      "void main() {\n"
+      "  vec3 yuv = vec3(texture2D(y_plane, vTexCoord).r,\n"
+      "                  texture2D(u_plane, vTexCoord).r,\n"
+      "                  texture2D(v_plane, vTexCoord).r);\n"
+      "  gl_FragColor = vec4(clamp(yuv_to_rgb * ((yuv * scale) - offset), 0.0, 1.0), 1.0);\n"
+      "}\n";
+
+  constexpr int LUMA = 0;
+  constexpr int CB = 1;
+  constexpr int CR = 2;
+}
+
+
+PlanarTexture::PlanarTexture(const int width, const int height, const int format)
+  : format_(format),
+    height_(height),
+    bytes_per_sample_((get_gl_plane_pix_type_from_av(format) == QOpenGLTexture::UInt16) ? 2 : 1)
+{
+  const auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(format));
+  Q_ASSERT(desc);
+  for (size_t i = 0; i < planes_.size(); ++i) {
+    const bool chroma = (i != LUMA);
+    auto& plane = planes_.at(i);
+    plane = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
+    plane->setSize(chroma ? AV_CEIL_RSHIFT(width, desc->log2_chroma_w) : width,
+                   chroma ? AV_CEIL_RSHIFT(height, desc->log2_chroma_h) : height);
+    plane->setFormat(get_gl_plane_tex_fmt_from_av(format));
+    // drawn once into the clip's framebuffer at its own size, so no mipmaps
+    plane->setMipLevels(1);
+    plane->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+    plane->setWrapMode(QOpenGLTexture::ClampToEdge);
+    plane->allocateStorage(QOpenGLTexture::Red, get_gl_plane_pix_type_from_av(format));
+  }
+
+  linked_ = program_.addShaderFromSourceCode(QOpenGLShader::Vertex, VERTEX_SHADER)
+            && program_.addShaderFromSourceCode(QOpenGLShader::Fragment, FRAGMENT_SHADER)
+            && program_.link();
+  if (!linked_) {
+    qWarning() << "YUV shader failed to link, falling back to RGB, msg =" << program_.log();
+    available_ = false;
+  }
+  coefficients_ = get_yuv_coefficients(format_, AVCOL_SPC_UNSPECIFIED, AVCOL_RANGE_UNSPECIFIED, height_);
+}
+
+
+bool PlanarTexture::supported()
+{
+  const auto ctx = QOpenGLContext::currentContext();
+  bool result = false;
+  if (ctx == nullptr) {
+    result = false;
+  } else if (ctx->isOpenGLES()) {
+    result = ctx->format().majorVersion() >= 3;
+  } else {
+    // single-channel (R8/R16) textures
+    result = (ctx->format().version() >= qMakePair(3, 0)) || ctx->hasExtension(QByteArrayLiteral("GL_ARB_texture_rg"));
+  }
+  if (!result && available_) {
+    qInfo() << "GL context can't sample YUV planes, converting frames to RGB";
+  }
+  available_ = result;
+  return result;
+}
+
+
+bool PlanarTexture::available()
+{
+  return available_;
+}
+
+
+bool PlanarTexture::isValid() const
+{
+  return linked_;
+}
+
+
+void PlanarTexture::upload(const AVFrame& frame, TextureUploader& uploader)
+{
+  if (frame.format != format_) {
+    qWarning() << "Frame not in the format of the planes, format:" << frame.format << "expected:" << format_;
+    return;
+  }
+  if ( (frame.colorspace != colorspace_) || (frame.color_range != color_range_) ) {
+    coefficients_ = get_yuv_coefficients(format_, frame.colorspace, frame.color_range, height_);
+    colorspace_ = frame.colorspace;
+    color_range_ = frame.color_range;
+  }
+
+  const auto f = QOpenGLContext::currentContext()->functions();
+  const auto type = get_gl_plane_pix_type_from_av(format_);
+  for (size_t i = 0; i < planes_.size(); ++i) {
+    auto& plane = *planes_.at(i);
+    f->glPixelStorei(GL_UNPACK_ROW_LENGTH, frame.linesize[i] / bytes_per_sample_);
+    uploader.upload(plane, QOpenGLTexture::Red, frame.data[i], static_cast<size_t>(frame.linesize[i] * plane.height()),
+                    type);
+  }
+  f->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+
+GLuint PlanarTexture::textureId() const
+{
+  return planes_.at(LUMA)->textureId();
+}
+
+
+void PlanarTexture::bind(QOpenGLContext& ctx)
+{
+  const auto f = ctx.functions();
+  f->glActiveTexture(GL_TEXTURE0 + CB);
+  f->glBindTexture(GL_TEXTURE_2D, planes_.at(CB)->textureId());
+  f->glActiveTexture(GL_TEXTURE0 + CR);
+  f->glBindTexture(GL_TEXTURE_2D, planes_.at(CR)->textureId());
+  f->glActiveTexture(GL_TEXTURE0);
+
+  program_.bind();
+  program_.setUniformValue("y_plane", LUMA);
+  program_.setUniformValue("u_plane", CB);
+  program_.setUniformValue("v_plane", CR);
+  program_.setUniformValue("yuv_to_rgb", QMatrix3x3(coefficients_.matrix_.data()));
+  program_.setUniformValue("offset", QVector3D(coefficients_.offset_.at(0),
+                                               coefficients_.offset_.at(1),
+                                               coefficients_.offset_.at(2)));
+  program_.setUniformValue("scale", coefficients_.scale_);
+}
+
+
+void PlanarTexture::release(QOpenGLContext& ctx)
+{
+  program_.release();
+  const auto f = ctx.functions();
+  f->glActiveTexture(GL_TEXTURE0 + CR);
+  f->glBindTexture(GL_TEXTURE_2D, 0);
+  f->glActiveTexture(GL_TEXTURE0 + CB);
+  f->glBindTexture(GL_TEXTURE_2D, 0);
+  f->glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,109 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PLANARTEXTURE_H
+#define PLANARTEXTURE_H
+
+#include <QOpenGLTexture>
+#include <QOpenGLShaderProgram>
+#include <array>
+#include <memory>
+#include <atomic>
+
+#include "io/avtogl.h"
+
+struct AVFrame;
+class QOpenGLContext;
+
+namespace chestnut::playback
+{
+  class TextureUploader;
+
+  /**
+   * @brief The planes of YUV frames, each in a texture of its own, and the shader converting them to RGB while drawn.
+   *        Only formats passing is_gl_yuv_format() are handled
+   */
+  class PlanarTexture
+  {
+    public:
+      /**
+       * @brief         Create the textures and shader in the current GL context
+       * @param width   Of the frames
+       * @param height  Of the frames
+       * @param format  AVPixelFormat of the frames
+       */
+      PlanarTexture(const int width, const int height, const int format);
+
+      PlanarTexture() = delete;
+      PlanarTexture(const PlanarTexture&) = delete;
+      PlanarTexture& operator=(const PlanarTexture&) = delete;
+
+      /**
+       * @brief   Identify if the current GL context can sample single-channel textures. The result is kept for
+       *          available()
+       * @return  true==supported
+       */
+      static bool supported();
+      /**
+       * @brief   Identify, from any thread, if frames may be kept as YUV for the GL context last checked
+       * @return  true==available
+       */
+      static bool available();
+
+      /**
+       * @brief   The shader compiled and linked
+       * @return  true==usable
+       */
+      bool isValid() const;
+      /**
+       * @brief           Replace the planes with those of a frame
+       * @param frame     Frame in the format this was created for
+       * @param uploader
+       */
+      void upload(const AVFrame& frame, TextureUploader& uploader);
+      /**
+       * @brief   The texture of the luma plane, bound by the caller to unit 0 for drawing
+       * @return  texture id
+       */
+      GLuint textureId() const;
+      /**
+       * @brief     Bind the shader and the chroma planes, ready to draw the luma texture
+       * @param ctx
+       */
+      void bind(QOpenGLContext& ctx);
+      /**
+       * @brief     Undo bind()
+       * @param ctx
+       */
+      void release(QOpenGLContext& ctx);
+
+    private:
+      const int format_;
+      const int height_;
+      const int bytes_per_sample_;
+      std::array<std::unique_ptr<QOpenGLTexture>, 3> planes_;
+      QOpenGLShaderProgram program_;
+      bool linked_ {false};
+      YuvCoefficients coefficients_;
+      // of the frame the coefficients were made for
+      int colorspace_ {-1};
+      int color_range_ {-1};
+      static std::atomic_bool available_;
+  };
+}
+
+#endif // PLANARTEXTURE_H
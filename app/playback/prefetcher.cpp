@@ -0,0 +1,103 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "prefetcher.h"
+
+#include <QtGlobal>
+#include <QtMath>
+
+using chestnut::playback::Prefetcher;
+using chestnut::playback::PrefetchWindow;
+
+namespace
+{
+  // faster than this the playhead has jumped, not moved
+  constexpr double MAX_SPEED = 16.0;
+  // weight of the latest sample in the speed
+  constexpr double SMOOTHING = 0.25;
+  // a playhead still for longer is assumed to next move at normal speed
+  constexpr int64_t IDLE_MSECS = 500;
+  constexpr double MSECS_PER_SEC = 1000.0;
+}
+
+
+bool PrefetchWindow::overlaps(const int64_t in, const int64_t out) const
+{
+  return (in <= end_) && (out > begin_);
+}
+
+
+void Prefetcher::update(const int64_t playhead, const double frame_rate, const int64_t msecs)
+{
+  if ( (last_playhead_ < 0) || (frame_rate <= 0) ) {
+    last_playhead_ = playhead;
+    last_msecs_ = msecs;
+    return;
+  }
+  const int64_t delta = playhead - last_playhead_;
+  const int64_t elapsed = msecs - last_msecs_;
+  if (delta == 0) {
+    if (elapsed > IDLE_MSECS) {
+      speed_ = 1.0;
+    }
+    return;
+  }
+  if (elapsed <= 0) {
+    // more than one move within the clock's resolution
+    last_playhead_ = playhead;
+    return;
+  }
+
+  const double speed = (qAbs(delta) * MSECS_PER_SEC) / (elapsed * frame_rate);
+  if (speed <= MAX_SPEED) {
+    direction_ = (delta > 0) ? 1 : -1;
+    speed_ = qBound(1.0, speed_ + (SMOOTHING * (speed - speed_)), MAX_SPEED);
+  }
+  last_playhead_ = playhead;
+  last_msecs_ = msecs;
+}
+
+
+void Prefetcher::reset()
+{
+  last_playhead_ = -1;
+  last_msecs_ = -1;
+  direction_ = 1;
+  speed_ = 1.0;
+}
+
+
+int Prefetcher::direction() const
+{
+  return direction_;
+}
+
+
+double Prefetcher::speed() const
+{
+  return speed_;
+}
+
+
+PrefetchWindow Prefetcher::window(const int64_t playhead, const double frame_rate, const double seconds) const
+{
+  const auto span = static_cast<int64_t>(qCeil(qMax(0.0, seconds * frame_rate * speed_)));
+  if (direction_ < 0) {
+    return {playhead - span, playhead};
+  }
+  return {playhead, playhead + span};
+}
@@ -0,0 +1,87 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <cstdint>
+
+namespace chestnut::playback
+{
+  /**
+   * @brief Range of sequence frames the playhead is expected to reach soon
+   */
+  struct PrefetchWindow
+  {
+    // first and last frame, inclusive
+    int64_t begin_ {0};
+    int64_t end_ {-1};
+
+    /**
+     * @brief     Identify if any of a clip's frames are within the window
+     * @param in  First frame of the clip
+     * @param out Frame after the clip's last
+     * @return    true==overlaps
+     */
+    bool overlaps(const int64_t in, const int64_t out) const;
+  };
+
+  /**
+   * @brief Follows the playhead of a viewer to estimate the direction and speed it is moving in, for clips to be
+   *        opened and decoded before the playhead reaches them
+   */
+  class Prefetcher
+  {
+    public:
+      /**
+       * @brief             Record where the playhead is now
+       * @param playhead    Frame in the sequence
+       * @param frame_rate  Of the sequence
+       * @param msecs       Time of the sample, on any steady clock
+       */
+      void update(const int64_t playhead, const double frame_rate, const int64_t msecs);
+      /**
+       * @brief Forget the playhead's history, e.g. on a change of sequence
+       */
+      void reset();
+      /**
+       * @return  1==forwards, -1==backwards. Forwards until the playhead has moved
+       */
+      int direction() const;
+      /**
+       * @return  Multiple of real-time the playhead is moving at, never less than 1
+       */
+      double speed() const;
+      /**
+       * @brief             The frames to be reached from a playhead within a time, at the current direction and speed
+       * @param playhead    Frame in a sequence. Needn't be that of update(), e.g. a nested sequence's
+       * @param frame_rate  Of that sequence
+       * @param seconds     Time to look ahead
+       * @return            window, including the playhead
+       */
+      PrefetchWindow window(const int64_t playhead, const double frame_rate, const double seconds) const;
+
+    private:
+      int64_t last_playhead_ {-1};
+      // time of the last sample the playhead had moved in
+      int64_t last_msecs_ {-1};
+      int direction_ {1};
+      double speed_ {1.0};
+  };
+}
+
+#endif // PREFETCHER_H
@@ -0,0 +1,346 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "recordingwriter.h"
+
+#include <QDataStream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#endif
+
+#include "playback/mixkernels.h"
+#include "debug.h"
+
+using chestnut::playback::RecordingWriter;
+
+namespace
+{
+  // of the input held while the disk is slow, in seconds
+  constexpr int RING_SECONDS = 4;
+  // the most copied into the ring at once
+  constexpr size_t PUSH_FRAMES = 4096;
+  // written to the files at once. A multiple of the alignment for any number of channels
+  constexpr size_t BLOCK_FRAMES = 32768;
+  // samples start at this offset in the files, so the blocks are aligned with the filesystem's
+  constexpr qint64 ALIGNMENT = 4096;
+  // allocated ahead of the samples written
+  constexpr qint64 ALLOCATE_BYTES = 16 * 1024 * 1024;
+  // between looking for a block to write, a fraction of the time it takes to record one
+  constexpr auto POLL_INTERVAL = std::chrono::milliseconds(20);
+  constexpr quint16 BITS_PER_SAMPLE = 16;
+  constexpr quint16 WAV_FORMAT_PCM = 1;
+  constexpr quint32 FMT_BYTES = 16;
+  // RIFF and WAVE, the fmt chunk, the header of the padding chunk and that of the data chunk
+  constexpr qint64 CHUNK_HEADER_BYTES = 12 + 8 + FMT_BYTES + 8 + 8;
+}
+
+
+RecordingWriter::RecordingWriter() : QIODevice(nullptr)
+{
+
+}
+
+
+RecordingWriter::~RecordingWriter()
+{
+  finish();
+}
+
+
+bool RecordingWriter::start(const QStringList& paths, const int channels, const int sample_rate)
+{
+  finish();
+  if ( (channels <= 0) || (channels > MAX_CHANNELS) || paths.isEmpty() || ((channels % paths.size()) != 0)
+       || (sample_rate <= 0) ) {
+    qCritical() << "Unsupported recording, channels:" << channels << ", files:" << paths.size()
+                << ", rate:" << sample_rate;
+    return false;
+  }
+
+  channels_ = channels;
+  sample_rate_ = sample_rate;
+  takes_.clear();
+  const int take_channels = channels / paths.size();
+  for (const auto& path : paths) {
+    Take take;
+    take.file_ = std::make_unique<QFile>(path);
+    take.first_ = static_cast<int>(takes_.size()) * take_channels;
+    take.channels_ = take_channels;
+    // written straight to the file, in whole blocks
+    if (!take.file_->open(QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+      qCritical() << "Failed to open recording, path:" << path << ", msg:" << take.file_->errorString();
+      closeFiles();
+      return false;
+    }
+    if (paths.size() > 1) {
+      take.gathered_.resize(BLOCK_FRAMES * static_cast<size_t>(take_channels));
+    }
+    takes_.push_back(std::move(take));
+    // complete as it is, should the recording not be finished
+    if (!writeHeader(takes_.back()) || !allocate(takes_.back(), ALLOCATE_BYTES)) {
+      closeFiles();
+      return false;
+    }
+  }
+
+  ring_ = std::make_unique<AudioRingBuffer>(static_cast<size_t>(RING_SECONDS * sample_rate * channels));
+  staged_.resize(PUSH_FRAMES * static_cast<size_t>(channels));
+  converted_.resize(staged_.size());
+  partial_bytes_ = 0;
+  overflows_ = 0;
+  written_ = 0;
+  failed_ = false;
+  running_ = true;
+  QIODevice::open(QIODevice::WriteOnly);
+  thread_ = std::thread(&RecordingWriter::run, this);
+  return true;
+}
+
+
+bool RecordingWriter::finish()
+{
+  if (!thread_.joinable()) {
+    return !failed_;
+  }
+  QIODevice::close();
+  // the thread drains the ring before it ends
+  running_ = false;
+  thread_.join();
+
+  for (auto& take : takes_) {
+    // the space allocated beyond the samples is given back
+    if (!take.file_->resize(ALIGNMENT + take.data_bytes_) || !take.file_->seek(0) || !writeHeader(take)) {
+      qCritical() << "Failed to complete recording, path:" << take.file_->fileName()
+                  << ", msg:" << take.file_->errorString();
+      failed_ = true;
+    }
+  }
+  if (overflows_ > 0) {
+    qWarning() << "Recording overflowed, frames dropped:" << overflows_;
+  }
+  closeFiles();
+  return !failed_;
+}
+
+
+QStringList RecordingWriter::paths() const
+{
+  QStringList paths;
+  for (const auto& take : takes_) {
+    paths.append(take.file_->fileName());
+  }
+  return paths;
+}
+
+
+uint64_t RecordingWriter::overflows() const
+{
+  return overflows_;
+}
+
+
+int64_t RecordingWriter::written() const
+{
+  return written_;
+}
+
+
+bool RecordingWriter::isSequential() const
+{
+  return true;
+}
+
+
+qint64 RecordingWriter::readData(char* /*data*/, qint64 /*maxlen*/)
+{
+  return -1;
+}
+
+
+qint64 RecordingWriter::writeData(const char* data, qint64 len)
+{
+  if (!running_ || (len <= 0)) {
+    return len;
+  }
+  const auto frame_bytes = static_cast<size_t>(channels_) * sizeof(int16_t);
+  auto remaining = static_cast<size_t>(len);
+  if (partial_bytes_ > 0) {
+    const auto taken = std::min(frame_bytes - partial_bytes_, remaining);
+    memcpy(partial_.data() + partial_bytes_, data, taken);
+    partial_bytes_ += taken;
+    data += taken;
+    remaining -= taken;
+    if (partial_bytes_ < frame_bytes) {
+      return len;
+    }
+    push(partial_.data(), 1);
+    partial_bytes_ = 0;
+  }
+  const auto frames = remaining / frame_bytes;
+  push(data, frames);
+  partial_bytes_ = remaining - (frames * frame_bytes);
+  memcpy(partial_.data(), data + (frames * frame_bytes), partial_bytes_);
+  // all taken, whether or not there was the space for it, so the input never waits on the disk
+  return len;
+}
+
+
+void RecordingWriter::run()
+{
+  const auto channels = static_cast<size_t>(channels_);
+  std::vector<float> block(BLOCK_FRAMES * channels);
+  std::vector<int16_t> converted(block.size());
+  // whole blocks while recording, unless the ring is too small to hold two
+  const auto wanted = std::min(BLOCK_FRAMES, ring_->capacity() / channels / 2);
+  while (true) {
+    // checked first, so whatever was pushed before finishing is drained
+    const bool finishing = !running_;
+    const auto frames = std::min(ring_->available() / channels, BLOCK_FRAMES);
+    if ( (frames == 0) && finishing ) {
+      break;
+    }
+    if ( (frames < wanted) && !finishing ) {
+      std::this_thread::sleep_for(POLL_INTERVAL);
+      continue;
+    }
+    const auto count = frames * channels;
+    ring_->peek(block.data(), count);
+    ring_->skip(count);
+    if (failed_) {
+      // drained regardless, so the input isn't held up
+      continue;
+    }
+    kernel::toS16(block.data(), converted.data(), count);
+    for (auto& take : takes_) {
+      if (!write(take, converted.data(), frames)) {
+        qCritical() << "Failed to write recording, path:" << take.file_->fileName()
+                    << ", msg:" << take.file_->errorString();
+        failed_ = true;
+        break;
+      }
+    }
+    if (!failed_) {
+      written_ += static_cast<int64_t>(frames);
+    }
+  }
+}
+
+
+void RecordingWriter::push(const char* data, const size_t frames)
+{
+  const auto channels = static_cast<size_t>(channels_);
+  size_t done = 0;
+  while (done < frames) {
+    const auto count = std::min(frames - done, PUSH_FRAMES);
+    // whole frames only, so the channels stay in step
+    const auto fits = std::min(count, ring_->space() / channels);
+    if (fits < count) {
+      overflows_ += count - fits;
+    }
+    if (fits > 0) {
+      // staged first, as the bytes needn't be aligned for samples
+      memcpy(staged_.data(), data + (done * channels * sizeof(int16_t)), fits * channels * sizeof(int16_t));
+      kernel::fromS16(staged_.data(), converted_.data(), fits * channels);
+      ring_->write(converted_.data(), fits * channels);
+    }
+    done += count;
+  }
+}
+
+
+bool RecordingWriter::write(Take& take, const int16_t* samples, const size_t frames)
+{
+  const int16_t* from = samples;
+  if (!take.gathered_.empty()) {
+    const auto channels = static_cast<size_t>(channels_);
+    const auto take_channels = static_cast<size_t>(take.channels_);
+    for (size_t i = 0; i < frames; ++i) {
+      std::copy_n(samples + (i * channels) + static_cast<size_t>(take.first_), take_channels,
+                  take.gathered_.data() + (i * take_channels));
+    }
+    from = take.gathered_.data();
+  }
+  const auto bytes = static_cast<qint64>(frames * static_cast<size_t>(take.channels_) * sizeof(int16_t));
+  if ( (take.data_bytes_ + bytes > take.allocated_) && !allocate(take, take.data_bytes_ + bytes + ALLOCATE_BYTES) ) {
+    return false;
+  }
+  if (take.file_->write(reinterpret_cast<const char*>(from), bytes) != bytes) {
+    return false;
+  }
+  take.data_bytes_ += bytes;
+  return true;
+}
+
+
+bool RecordingWriter::allocate(Take& take, const qint64 data_bytes)
+{
+  const auto size = ALIGNMENT + data_bytes;
+#if defined(Q_OS_LINUX)
+  // reserved on the disk, rather than only sized as resizing does
+  if (posix_fallocate(take.file_->handle(), 0, size) == 0) {
+    take.allocated_ = data_bytes;
+    return true;
+  }
+#endif
+  if (!take.file_->resize(size)) {
+    qCritical() << "Failed to allocate recording, path:" << take.file_->fileName()
+                << ", msg:" << take.file_->errorString();
+    return false;
+  }
+  take.allocated_ = data_bytes;
+  return true;
+}
+
+
+bool RecordingWriter::writeHeader(Take& take)
+{
+  constexpr std::array<char, ALIGNMENT - CHUNK_HEADER_BYTES> padding {};
+  QByteArray bytes;
+  {
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    const auto rate = static_cast<quint32>(sample_rate_);
+    const auto block_align = static_cast<quint16>(take.channels_ * (BITS_PER_SAMPLE / 8));
+    out.writeRawData("RIFF", 4);
+    out << static_cast<quint32>(ALIGNMENT - 8 + take.data_bytes_);
+    out.writeRawData("WAVE", 4);
+    out.writeRawData("fmt ", 4);
+    out << FMT_BYTES << WAV_FORMAT_PCM << static_cast<quint16>(take.channels_) << rate << (rate * block_align)
+        << block_align << BITS_PER_SAMPLE;
+    // padding, so the samples begin aligned
+    out.writeRawData("JUNK", 4);
+    out << static_cast<quint32>(ALIGNMENT - CHUNK_HEADER_BYTES);
+    out.writeRawData(padding.data(), static_cast<int>(padding.size()));
+    out.writeRawData("data", 4);
+    out << static_cast<quint32>(take.data_bytes_);
+  }
+  Q_ASSERT(bytes.size() == ALIGNMENT);
+  return take.file_->write(bytes) == bytes.size();
+}
+
+
+void RecordingWriter::closeFiles()
+{
+  for (auto& take : takes_) {
+    take.file_->close();
+  }
+  ring_.reset();
+}
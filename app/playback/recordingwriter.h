@@ -0,0 +1,130 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef RECORDINGWRITER_H
+#define RECORDINGWRITER_H
+
+#include <QFile>
+#include <QIODevice>
+#include <QStringList>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "playback/audioringbuffer.h"
+
+namespace chestnut::playback
+{
+  /**
+   * @brief The device audio input records into. Samples written to it are copied into a ring without locking or
+   *        allocating, and a thread of the writer's own drains the ring to 16-bit WAV files in large writes, aligned
+   *        within the files and into space allocated ahead of them. The input's channels can be split between files,
+   *        to record a track of each at once
+   */
+  class RecordingWriter : public QIODevice
+  {
+    public:
+      // of the input, at most
+      static constexpr int MAX_CHANNELS = 8;
+
+      RecordingWriter();
+      ~RecordingWriter() override;
+
+      RecordingWriter(const RecordingWriter&) = delete;
+      RecordingWriter& operator=(const RecordingWriter&) = delete;
+
+      /**
+       * @brief             Create the files and start writing to them
+       * @param paths       Of each file. The input's channels are split evenly between them, in order
+       * @param channels    Of the input, interleaved 16-bit
+       * @param sample_rate Of the input
+       * @return            true==success
+       */
+      bool start(const QStringList& paths, const int channels, const int sample_rate);
+      /**
+       * @brief   Write all that was recorded and complete the files. Nothing may be written meanwhile
+       * @return  true==all recorded was written
+       */
+      bool finish();
+
+      QStringList paths() const;
+      // sample frames dropped as the ring was full, since starting
+      uint64_t overflows() const;
+      // sample frames written to each file, since starting
+      int64_t written() const;
+
+      bool isSequential() const override;
+
+    protected:
+      qint64 readData(char* data, qint64 maxlen) override;
+      qint64 writeData(const char* data, qint64 len) override;
+
+    private:
+      struct Take
+      {
+        std::unique_ptr<QFile> file_;
+        // first channel of the input in the file
+        int first_ {0};
+        int channels_ {0};
+        // of samples written
+        qint64 data_bytes_ {0};
+        // of samples the file has space allocated for
+        qint64 allocated_ {0};
+        // its channels of a block, when not all of the input's
+        std::vector<int16_t> gathered_;
+      };
+
+      std::unique_ptr<AudioRingBuffer> ring_;
+      std::vector<Take> takes_;
+      int channels_ {0};
+      int sample_rate_ {0};
+      std::thread thread_;
+      std::atomic_bool running_ {false};
+      std::atomic_bool failed_ {false};
+      std::atomic<uint64_t> overflows_ {0};
+      std::atomic<int64_t> written_ {0};
+      // written samples as staged and converted for the ring
+      std::vector<int16_t> staged_;
+      std::vector<float> converted_;
+      // a frame split between writes, until the rest of it is written
+      std::array<char, MAX_CHANNELS * sizeof(int16_t)> partial_ {};
+      size_t partial_bytes_ {0};
+
+      void run();
+      /**
+       * @brief         Copy whole frames into the ring, dropping those there isn't the space for
+       * @param data
+       * @param frames
+       */
+      void push(const char* data, const size_t frames);
+      /**
+       * @brief         Write a block to a file, extending its allocation first if need be
+       * @param take
+       * @param samples Interleaved, of all the input's channels
+       * @param frames
+       * @return        true==success
+       */
+      bool write(Take& take, const int16_t* samples, const size_t frames);
+      bool allocate(Take& take, const qint64 data_bytes);
+      bool writeHeader(Take& take);
+      void closeFiles();
+  };
+}
+
+#endif // RECORDINGWRITER_H
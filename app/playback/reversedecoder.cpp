@@ -0,0 +1,404 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "reversedecoder.h"
+
+#include <QtGlobal>
+#include <array>
+
+#include "playback/videofilter.h"
+#include "io/avtogl.h"
+#include "io/config.h"
+#include "debug.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+}
+
+using chestnut::playback::ReverseDecoder;
+using chestnut::playback::FramePtr;
+using chestnut::playback::DecoderPool;
+
+namespace
+{
+  constexpr auto ERR_LEN = 256;
+  constexpr size_t BYTES_PER_MEGABYTE = 1024 * 1024;
+
+  size_t frameBytes(const AVFrame& frame)
+  {
+    size_t sz = 0;
+    for (const auto buf : frame.buf) {
+      if (buf != nullptr) {
+        sz += static_cast<size_t>(buf->size);
+      }
+    }
+    return sz;
+  }
+
+  void freeFrame(AVFrame* frame)
+  {
+    av_frame_free(&frame);
+  }
+}
+
+
+ReverseDecoder::ReverseDecoder(FrameCacheKey key,
+                               DecoderContextPtr decoder,
+                               project::KeyframeIndexPtr index,
+                               const bool deinterlace,
+                               const bool top_field_first,
+                               const int64_t frame_duration)
+  : key_(std::move(key)),
+    decoder_(std::move(decoder)),
+    index_(std::move(index)),
+    deinterlace_(deinterlace),
+    top_field_first_(top_field_first),
+    frame_duration_(qMax(static_cast<int64_t>(1), frame_duration))
+{
+  Q_ASSERT(decoder_);
+  thread_ = std::thread(&ReverseDecoder::run, this);
+}
+
+
+ReverseDecoder::~ReverseDecoder()
+{
+  stop();
+}
+
+
+void ReverseDecoder::stop()
+{
+  QMutexLocker locker(&mutex_);
+  running_ = false;
+  locker.unlock();
+  request_cond_.wakeAll();
+  done_cond_.wakeAll();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+
+FramePtr ReverseDecoder::frame(const int64_t pts)
+{
+  FramePtr result;
+  bool prefetch = false;
+
+  QMutexLocker locker(&mutex_);
+  playhead_ = pts;
+  if (const auto it = displayed(pts); it != frames_.end()) {
+    result = it->second.frame_;
+  }
+
+  if (!frames_.empty() && !request_.has_value() && !prefetching_.has_value()) {
+    const int64_t earliest = frames_.cbegin()->first;
+    const int64_t start_time = (decoder_->stream_->start_time == AV_NOPTS_VALUE) ? 0 : decoder_->stream_->start_time;
+    const int64_t start_pts = qMax(static_cast<int64_t>(0), deinterlace_ ? (start_time << 1) : start_time);
+    if ( (earliest > start_pts) && (earliest <= pts) && (earliest != prefetched_) ) {
+      // prefetch the span before once the frames left to play are fewer than it holds
+      const int span = spanFrames(earliest);
+      int remaining = 0;
+      size_t remaining_bytes = 0;
+      for (auto it = frames_.cbegin(); (it != frames_.cend()) && (it->first <= pts) && (remaining <= span); ++it) {
+        ++remaining;
+        remaining_bytes += it->second.bytes_;
+      }
+      const auto budget = static_cast<size_t>(qMax(0, global::config.reverse_buffer_size)) * BYTES_PER_MEGABYTE;
+      const size_t span_bytes = (bytes_ / frames_.size()) * static_cast<size_t>(span);
+      if ( (remaining <= span) && ((remaining_bytes + span_bytes) <= budget) ) {
+        request_ = earliest;
+        prefetch = true;
+      }
+    }
+  }
+  locker.unlock();
+
+  if (prefetch) {
+    request_cond_.wakeAll();
+  }
+  return result;
+}
+
+
+bool ReverseDecoder::decode(const int64_t pts)
+{
+  QMutexLocker locker(&mutex_);
+  playhead_ = pts;
+  // the frame may be in the span already being prefetched
+  while (running_ && prefetching_.has_value() && (prefetching_.value() > pts)) {
+    done_cond_.wait(&mutex_);
+  }
+  if (displayed(pts) != frames_.end()) {
+    return true;
+  }
+  locker.unlock();
+
+  std::vector<FramePtr> frames;
+  if (!decodeSpan(*decoder_, pts + 1, frames)) {
+    qWarning() << "Failed to decode frames in reverse, path:" << key_.location_ << "pts:" << pts;
+  }
+  store(frames);
+
+  locker.relock();
+  return displayed(pts) != frames_.end();
+}
+
+
+FramePtr ReverseDecoder::closest(const int64_t pts) const
+{
+  QMutexLocker locker(&mutex_);
+  if (frames_.empty()) {
+    return nullptr;
+  }
+  auto it = frames_.upper_bound(pts);
+  if (it != frames_.begin()) {
+    --it;
+  }
+  return it->second.frame_;
+}
+
+
+size_t ReverseDecoder::bytes() const
+{
+  QMutexLocker locker(&mutex_);
+  return bytes_;
+}
+
+
+void ReverseDecoder::run()
+{
+  qDebug() << "Starting reverse decoder thread, path:" << key_.location_;
+  while (running_) {
+    QMutexLocker locker(&mutex_);
+    while (running_ && !request_.has_value()) {
+      request_cond_.wait(&mutex_);
+    }
+    if (!running_) {
+      break;
+    }
+    const int64_t end_pts = request_.value();
+    request_.reset();
+    prefetching_ = end_pts;
+    prefetched_ = end_pts;
+    locker.unlock();
+
+    if (prefetch_decoder_ == nullptr) {
+      prefetch_decoder_ = DecoderPool::instance().lease(key_.location_, key_.stream_index_);
+    }
+    std::vector<FramePtr> frames;
+    if (prefetch_decoder_ == nullptr) {
+      qWarning() << "No decoder to prefetch with, path:" << key_.location_;
+    } else if (!decodeSpan(*prefetch_decoder_, end_pts, frames)) {
+      qWarning() << "Failed to prefetch frames in reverse, path:" << key_.location_ << "pts:" << end_pts;
+    }
+    store(frames);
+
+    locker.relock();
+    prefetching_.reset();
+    locker.unlock();
+    done_cond_.wakeAll();
+  }
+
+  if (prefetch_decoder_ != nullptr) {
+    DecoderPool::instance().release(std::move(prefetch_decoder_));
+  }
+  qDebug() << "Exiting reverse decoder thread, path:" << key_.location_;
+}
+
+
+bool ReverseDecoder::decodeSpan(DecoderContext& ctx, const int64_t end_pts, std::vector<FramePtr>& frames) const
+{
+  std::array<char, ERR_LEN> err{};
+  const int64_t last_ts = streamTimestamp(end_pts - 1);
+  int64_t seek_ts = qMax(static_cast<int64_t>(0), last_ts - qRound64(av_q2d(av_inv_q(ctx.stream_->time_base))));
+  if (index_ != nullptr) {
+    if (const auto keyframe = index_->keyframeBefore(last_ts)) {
+      seek_ts = keyframe->pts_;
+    }
+  }
+
+  ctx.flush();
+  int ret = av_seek_frame(ctx.format_ctx_, ctx.stream_->index, seek_ts, AVSEEK_FLAG_BACKWARD);
+  if (ret < 0) {
+    av_strerror(ret, err.data(), ERR_LEN);
+    qWarning() << "Failed to seek, path:" << key_.location_ << "msg =" << err.data();
+    return false;
+  }
+
+  // a fresh graph, as the deinterlacer holds on to frames from before the seek
+  AVFilterGraph* graph = avfilter_graph_alloc();
+  AVFilterContext* src = nullptr;
+  AVFilterContext* sink = nullptr;
+  const int pix_fmt = (graph != nullptr)
+                      ? buildVideoFilterGraph(*graph, *ctx.stream_, deinterlace_, top_field_first_,
+                                              is_gl_yuv_format(key_.pix_fmt_), src, sink)
+                      : AV_PIX_FMT_NONE;
+  if (pix_fmt == AV_PIX_FMT_NONE) {
+    qCritical() << "Could not create filtergraph";
+    avfilter_graph_free(&graph);
+    return false;
+  }
+
+  FrameConverter converter(pix_fmt);
+  AVPacket* pkt = av_packet_alloc();
+  AVFrame* decoded = av_frame_alloc();
+  AVFrame* filtered = av_frame_alloc();
+  bool success = true;
+  bool reached = false;
+  while (!reached && running_) {
+    ret = avcodec_receive_frame(ctx.codec_ctx_, decoded);
+    if (ret == AVERROR(EAGAIN)) {
+      ret = av_read_frame(ctx.format_ctx_, pkt);
+      if (ret == AVERROR_EOF) {
+        avcodec_send_packet(ctx.codec_ctx_, nullptr);
+        ctx.drained_ = true;
+      } else if (ret < 0) {
+        av_strerror(ret, err.data(), ERR_LEN);
+        qCritical() << "Could not read frame, msg =" << err.data();
+        success = false;
+        break;
+      } else {
+        if (pkt->stream_index == ctx.stream_->index) {
+          ret = avcodec_send_packet(ctx.codec_ctx_, pkt);
+        }
+        av_packet_unref(pkt);
+        if (ret < 0) {
+          av_strerror(ret, err.data(), ERR_LEN);
+          qCritical() << "Failed to send packet to decoder, msg =" << err.data();
+          success = false;
+          break;
+        }
+      }
+      continue;
+    }
+
+    const bool end_of_stream = (ret == AVERROR_EOF);
+    if (end_of_stream) {
+      // flush the deinterlacer too
+      av_buffersrc_add_frame(src, nullptr);
+    } else if (ret < 0) {
+      av_strerror(ret, err.data(), ERR_LEN);
+      qCritical() << "Failed to receive frame from decoder, msg =" << err.data();
+      success = false;
+      break;
+    } else {
+      ctx.last_pts_ = decoded->pts;
+      if ((ret = av_buffersrc_add_frame(src, decoded)) < 0) {
+        av_strerror(ret, err.data(), ERR_LEN);
+        qCritical() << "Failed to add frame to buffer source, msg =" << err.data();
+        av_frame_unref(decoded);
+        success = false;
+        break;
+      }
+    }
+
+    while (!reached && (av_buffersink_get_frame(sink, filtered) >= 0)) {
+      if (filtered->pts >= end_pts) {
+        reached = true;
+      } else if (AVFrame* converted = converter.convert(*filtered)) {
+        frames.emplace_back(converted, freeFrame);
+      }
+      av_frame_unref(filtered);
+    }
+
+    if (end_of_stream) {
+      break;
+    }
+  }
+
+  av_frame_free(&filtered);
+  av_frame_free(&decoded);
+  av_packet_free(&pkt);
+  avfilter_graph_free(&graph);
+  return success;
+}
+
+
+void ReverseDecoder::store(std::vector<FramePtr>& frames)
+{
+  if (frames.empty()) {
+    return;
+  }
+  const auto budget = static_cast<size_t>(qMax(0, global::config.reverse_buffer_size)) * BYTES_PER_MEGABYTE;
+  std::vector<FramePtr> evicted;
+
+  QMutexLocker locker(&mutex_);
+  for (auto& frame : frames) {
+    const int64_t pts = frame->pts;
+    Entry entry {std::move(frame), 0};
+    entry.bytes_ = frameBytes(*entry.frame_);
+    if (auto existing = frames_.find(pts); existing != frames_.end()) {
+      bytes_ -= existing->second.bytes_;
+      evicted.push_back(std::move(existing->second.frame_));
+      existing->second = std::move(entry);
+    } else {
+      frames_.emplace(pts, std::move(entry));
+    }
+    bytes_ += frames_.at(pts).bytes_;
+  }
+
+  // frames already played go first, then those furthest from being played
+  while ( (bytes_ > budget) && (frames_.size() > 1) ) {
+    auto victim = std::prev(frames_.end());
+    if ( (playhead_ == DecoderContext::NO_PTS) || (victim->first <= playhead_) ) {
+      victim = frames_.begin();
+    }
+    bytes_ -= victim->second.bytes_;
+    evicted.push_back(std::move(victim->second.frame_));
+    frames_.erase(victim);
+  }
+  locker.unlock();
+  frames.clear();
+}
+
+
+ReverseDecoder::Frames::const_iterator ReverseDecoder::displayed(const int64_t pts) const
+{
+  auto it = frames_.upper_bound(pts);
+  if (it == frames_.begin()) {
+    return frames_.end();
+  }
+  --it;
+  if ( (pts - it->first) >= frame_duration_) {
+    // there's a gap between the earlier frame and the timestamp
+    return frames_.end();
+  }
+  return it;
+}
+
+
+int ReverseDecoder::spanFrames(const int64_t pts) const
+{
+  const int multiplier = deinterlace_ ? 2 : 1;
+  if (index_ != nullptr) {
+    if (const auto keyframe = index_->keyframeBefore(streamTimestamp(pts - 1)); keyframe && (keyframe->frames_ > 0)) {
+      return keyframe->frames_ * multiplier;
+    }
+  }
+  const int64_t second = qRound64(av_q2d(av_inv_q(decoder_->stream_->time_base))) * multiplier;
+  return static_cast<int>(qMax(static_cast<int64_t>(1), second / frame_duration_));
+}
+
+
+int64_t ReverseDecoder::streamTimestamp(const int64_t pts) const noexcept
+{
+  return deinterlace_ ? (pts >> 1) : pts;
+}
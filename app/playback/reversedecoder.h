@@ -0,0 +1,150 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef REVERSEDECODER_H
+#define REVERSEDECODER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <thread>
+#include <atomic>
+#include <map>
+#include <vector>
+#include <optional>
+
+#include "playback/decoderpool.h"
+#include "playback/framecache.h"
+#include "project/keyframeindex.h"
+
+namespace chestnut::playback
+{
+  /**
+   * @brief Plays a video stream backwards. Each GOP is decoded forward once, in full, into a buffer from which its
+   *        frames are handed out last first. The GOP before the earliest buffered is decoded ahead on a worker thread
+   */
+  class ReverseDecoder
+  {
+    public:
+      /**
+       * @param key             Footage stream and the pixel format its frames are kept in
+       * @param decoder         Decoder of the stream to decode with when a frame is not buffered
+       * @param index           Keyframes of the stream. Without it, spans of a second are decoded instead of GOPs
+       * @param deinterlace     Frames are deinterlaced, doubling the frame-rate and the timebase
+       * @param top_field_first Field order of the stream, if deinterlacing
+       * @param frame_duration  Duration of a frame, in timebase of the filtered frames
+       */
+      ReverseDecoder(FrameCacheKey key,
+                     DecoderContextPtr decoder,
+                     project::KeyframeIndexPtr index,
+                     const bool deinterlace,
+                     const bool top_field_first,
+                     const int64_t frame_duration);
+      ~ReverseDecoder();
+
+      ReverseDecoder() = delete;
+      ReverseDecoder(const ReverseDecoder&) = delete;
+      ReverseDecoder(const ReverseDecoder&&) = delete;
+      ReverseDecoder& operator=(const ReverseDecoder&) = delete;
+      ReverseDecoder& operator=(const ReverseDecoder&&) = delete;
+
+      /**
+       * @brief Stop the worker thread, once any span it is decoding is done. The frames buffered can still be had
+       */
+      void stop();
+      /**
+       * @brief     Obtain the buffered frame displayed at a timestamp. Once playback nears the earliest buffered
+       *            frame the span before it is prefetched
+       * @param pts Timestamp of the filtered frames
+       * @return    Frame or null if not buffered
+       */
+      FramePtr frame(const int64_t pts);
+      /**
+       * @brief     Decode the GOP containing a timestamp, up to and including the frame displayed then. Blocks
+       * @param pts Timestamp of the filtered frames
+       * @return    true==the frame is buffered
+       */
+      bool decode(const int64_t pts);
+      /**
+       * @brief     Obtain the buffered frame nearest to a timestamp, preferring an earlier one
+       * @param pts Timestamp of the filtered frames
+       * @return    Frame or null if nothing is buffered
+       */
+      FramePtr closest(const int64_t pts) const;
+      /**
+       * @brief   Size of all buffered frames
+       * @return  bytes
+       */
+      size_t bytes() const;
+
+    private:
+      struct Entry
+      {
+        FramePtr frame_;
+        size_t bytes_;
+      };
+      using Frames = std::map<int64_t, Entry>;
+
+      const FrameCacheKey key_;
+      DecoderContextPtr decoder_;
+      // leased by the worker thread
+      DecoderContextPtr prefetch_decoder_;
+      const project::KeyframeIndexPtr index_;
+      const bool deinterlace_;
+      const bool top_field_first_;
+      const int64_t frame_duration_;
+
+      std::thread thread_;
+      std::atomic_bool running_ {true};
+      mutable QMutex mutex_;
+      QWaitCondition request_cond_;
+      QWaitCondition done_cond_;
+      Frames frames_;
+      size_t bytes_ {0};
+      // most recent timestamp asked for. Frames after it have been played
+      int64_t playhead_ {DecoderContext::NO_PTS};
+      // the span ending at this timestamp is to be prefetched
+      std::optional<int64_t> request_;
+      // end of the span being prefetched
+      std::optional<int64_t> prefetching_;
+      // end of the last span prefetched, to not repeat it
+      int64_t prefetched_ {DecoderContext::NO_PTS};
+
+      /**
+       * @brief The worker method for the thread
+       */
+      void run();
+      /**
+       * @brief         Decode forward from the keyframe of the GOP preceding a timestamp
+       * @param ctx
+       * @param end_pts Timestamp of the filtered frames, before which decoding stops
+       * @param frames  Decoded frames, in presentation order
+       * @return        true==success
+       */
+      bool decodeSpan(DecoderContext& ctx, const int64_t end_pts, std::vector<FramePtr>& frames) const;
+      void store(std::vector<FramePtr>& frames);
+      Frames::const_iterator displayed(const int64_t pts) const;
+      /**
+       * @brief     Estimate the number of frames in the span ending at a timestamp
+       * @param pts Timestamp of the filtered frames
+       * @return    frame count
+       */
+      int spanFrames(const int64_t pts) const;
+      int64_t streamTimestamp(const int64_t pts) const noexcept;
+  };
+}
+
+#endif // REVERSEDECODER_H
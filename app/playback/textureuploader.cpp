@@ -0,0 +1,135 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "textureuploader.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QElapsedTimer>
+#include <cstring>
+
+#include "io/config.h"
+#include "debug.h"
+
+using chestnut::playback::TextureUploader;
+
+namespace
+{
+  constexpr double NSECS_PER_USEC = 1000.0;
+}
+
+
+TextureUploader::TextureUploader(const int buffer_count)
+{
+  for (int i = 0; i < qMax(1, buffer_count); ++i) {
+    buffers_.emplace_back(QOpenGLBuffer::PixelUnpackBuffer);
+    buffers_.back().setUsagePattern(QOpenGLBuffer::StreamDraw);
+  }
+}
+
+
+TextureUploader::~TextureUploader()
+{
+  if (uploads_ > 0) {
+    qDebug() << "Texture uploads =" << uploads_ << "buffered =" << buffered_
+             << "mean usecs =" << (upload_nsecs_ / NSECS_PER_USEC / uploads_);
+  }
+  for (auto& buffer : buffers_) {
+    buffer.destroy();
+  }
+}
+
+
+void TextureUploader::upload(QOpenGLTexture& texture, const QOpenGLTexture::PixelFormat format, const uint8_t* data,
+                             const size_t size, const QOpenGLTexture::PixelType type)
+{
+  QElapsedTimer timer;
+  timer.start();
+  if (!supported_.has_value()) {
+    supported_ = supported();
+    qInfo() << "Pixel-unpack buffers supported =" << supported_.value();
+  }
+
+  if (global::config.use_pbo_upload && supported_.value() && bufferedUpload(texture, format, data, size, type)) {
+    ++buffered_;
+  } else {
+    texture.setData(0, format, type, static_cast<const void*>(data));
+  }
+  ++uploads_;
+  upload_nsecs_ += timer.nsecsElapsed();
+}
+
+
+bool TextureUploader::supported()
+{
+  const auto ctx = QOpenGLContext::currentContext();
+  if (ctx == nullptr) {
+    return false;
+  }
+  if (ctx->isOpenGLES()) {
+    return ctx->format().majorVersion() >= 3;
+  }
+  return (ctx->format().version() >= qMakePair(2, 1)) || ctx->hasExtension(QByteArrayLiteral("GL_ARB_pixel_buffer_object"));
+}
+
+
+bool TextureUploader::bufferedUpload(QOpenGLTexture& texture, const QOpenGLTexture::PixelFormat format,
+                                     const uint8_t* data, const size_t size,
+                                     const QOpenGLTexture::PixelType type)
+{
+  auto& buffer = buffers_.at(next_);
+  next_ = (next_ + 1) % buffers_.size();
+
+  if (!buffer.isCreated() && !buffer.create()) {
+    qWarning() << "Failed to create pixel-unpack buffer, uploading directly";
+    supported_ = false;
+    return false;
+  }
+
+  const auto f = QOpenGLContext::currentContext()->functions();
+  const auto len = static_cast<int>(size);
+  buffer.bind();
+  // orphan the previous contents so the map doesn't wait on a transfer still reading from them
+  buffer.allocate(len);
+  void* dst = buffer.mapRange(0, len, QOpenGLBuffer::RangeWrite | QOpenGLBuffer::RangeInvalidateBuffer);
+  if (dst == nullptr) {
+    dst = buffer.map(QOpenGLBuffer::WriteOnly);
+  }
+  if (dst != nullptr) {
+    memcpy(dst, data, size);
+    if (!buffer.unmap()) {
+      // contents were lost e.g. by a mode switch
+      buffer.release();
+      return false;
+    }
+  } else {
+    buffer.write(0, data, len);
+  }
+
+  GLint previous = 0;
+  f->glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+  texture.bind();
+  // with a pixel-unpack buffer bound the data pointer is an offset into it
+  f->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture.width(), texture.height(), static_cast<GLenum>(format),
+                     static_cast<GLenum>(type), nullptr);
+  if ( (texture.mipLevels() > 1) && texture.isAutoMipMapGenerationEnabled()) {
+    texture.generateMipMaps();
+  }
+  f->glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous));
+  buffer.release();
+  return true;
+}
@@ -0,0 +1,80 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TEXTUREUPLOADER_H
+#define TEXTUREUPLOADER_H
+
+#include <QOpenGLBuffer>
+#include <QOpenGLTexture>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+namespace chestnut::playback
+{
+  /**
+   * @brief Uploads frames into a texture through a ring of pixel-unpack buffers. The copy into a buffer returns once
+   *        the data is with the driver, leaving the transfer into the texture to run alongside the rest of the
+   *        composition instead of stalling on a texture still being drawn from.
+   *        Uploads directly when buffers are unavailable or disabled in the config
+   */
+  class TextureUploader
+  {
+    public:
+      /**
+       * @param buffer_count  Number of buffers cycled through
+       */
+      explicit TextureUploader(const int buffer_count=3);
+      /**
+       * @brief Must be destroyed in the thread of the GL context it was used in
+       */
+      ~TextureUploader();
+
+      TextureUploader(const TextureUploader&) = delete;
+      TextureUploader& operator=(const TextureUploader&) = delete;
+
+      /**
+       * @brief         Replace the image of a texture. GL_UNPACK_ROW_LENGTH is to be set by the caller
+       * @param texture Texture with storage allocated for the image
+       * @param format  Pixel format of data
+       * @param data    Image of the size of the texture
+       * @param size    Length of data in bytes, including any padding of the rows
+       * @param type    Type of each component of data
+       */
+      void upload(QOpenGLTexture& texture, const QOpenGLTexture::PixelFormat format, const uint8_t* data,
+                  const size_t size, const QOpenGLTexture::PixelType type=QOpenGLTexture::UInt8);
+      /**
+       * @brief   Identify if the current GL context has pixel-unpack buffers
+       * @return  true==supported
+       */
+      static bool supported();
+
+    private:
+      std::vector<QOpenGLBuffer> buffers_;
+      size_t next_ {0};
+      // set on the first upload, in the render thread
+      std::optional<bool> supported_;
+      uint64_t uploads_ {0};
+      uint64_t buffered_ {0};
+      int64_t upload_nsecs_ {0};
+
+      bool bufferedUpload(QOpenGLTexture& texture, const QOpenGLTexture::PixelFormat format, const uint8_t* data,
+                          const size_t size, const QOpenGLTexture::PixelType type);
+  };
+}
+
+#endif // TEXTUREUPLOADER_H
@@ -0,0 +1,158 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "videofilter.h"
+
+#include <array>
+#include <cstdio>
+
+#include "playback/framepool.h"
+#include "io/avtogl.h"
+#include "debug.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavfilter/avfilter.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+using chestnut::playback::FrameConverter;
+
+namespace
+{
+  constexpr auto ERR_LEN = 256;
+}
+
+
+int chestnut::playback::buildVideoFilterGraph(AVFilterGraph& graph,
+                                              const AVStream& stream,
+                                              const bool deinterlace,
+                                              const bool top_field_first,
+                                              const bool keep_yuv,
+                                              AVFilterContext*& src,
+                                              AVFilterContext*& sink)
+{
+  std::array<char, ERR_LEN> err{};
+  char filter_args[512];
+  snprintf(filter_args, sizeof(filter_args), "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
+           stream.codecpar->width,
+           stream.codecpar->height,
+           stream.codecpar->format,
+           stream.time_base.num,
+           stream.time_base.den,
+           stream.codecpar->sample_aspect_ratio.num,
+           stream.codecpar->sample_aspect_ratio.den
+           );
+
+  avfilter_graph_create_filter(&src, avfilter_get_by_name("buffer"), "in", filter_args, nullptr, &graph);
+  avfilter_graph_create_filter(&sink, avfilter_get_by_name("buffersink"), "out", nullptr, nullptr, &graph);
+
+  AVFilterContext* last_filter = src;
+
+  if (deinterlace) {
+    AVFilterContext* yadif_filter;
+    char yadif_args[100];
+    snprintf(yadif_args, sizeof(yadif_args), "mode=3:parity=%d", (top_field_first ? 0 : 1));
+    //TODO: check return values
+    constexpr auto deinterlacer = "yadif";
+    avfilter_graph_create_filter(&yadif_filter,
+                                 avfilter_get_by_name(deinterlacer),
+                                 deinterlacer,
+                                 yadif_args,
+                                 nullptr,
+                                 &graph);
+    avfilter_link(last_filter, 0, yadif_filter, 0);
+    last_filter = yadif_filter;
+  }
+
+  enum AVPixelFormat valid_pix_fmts[] = {
+    AV_PIX_FMT_RGB24,
+    AV_PIX_FMT_RGBA,
+    AV_PIX_FMT_NONE
+  };
+
+  const auto pix_fmt = (keep_yuv && is_gl_yuv_format(stream.codecpar->format))
+                       ? static_cast<enum AVPixelFormat>(stream.codecpar->format)
+                       : avcodec_find_best_pix_fmt_of_list(valid_pix_fmts,
+                                                           static_cast<enum AVPixelFormat>(stream.codecpar->format),
+                                                           1,
+                                                           nullptr);
+  avfilter_link(last_filter, 0, sink, 0);
+
+  if (const auto ret = avfilter_graph_config(&graph, nullptr); ret < 0) {
+    av_strerror(ret, err.data(), ERR_LEN);
+    qCritical() << "Failed to configure video filtergraph, msg =" << err.data();
+    return AV_PIX_FMT_NONE;
+  }
+  return pix_fmt;
+}
+
+
+FrameConverter::FrameConverter(const int pix_fmt) : pix_fmt_(pix_fmt)
+{
+
+}
+
+
+FrameConverter::~FrameConverter()
+{
+  sws_freeContext(sws_ctx_);
+}
+
+
+AVFrame* FrameConverter::convert(const AVFrame& src)
+{
+  if (src.format == pix_fmt_) {
+    return av_frame_clone(&src);
+  }
+
+  sws_ctx_ = sws_getCachedContext(sws_ctx_,
+                                  src.width,
+                                  src.height,
+                                  static_cast<AVPixelFormat>(src.format),
+                                  src.width,
+                                  src.height,
+                                  static_cast<AVPixelFormat>(pix_fmt_),
+                                  SWS_BICUBIC,
+                                  nullptr,
+                                  nullptr,
+                                  nullptr);
+  if (sws_ctx_ == nullptr) {
+    qCritical() << "Could not create frame converter, format:" << src.format << "to:" << pix_fmt_;
+    return nullptr;
+  }
+  // as the scale filter would, honour the source's matrix and range
+  const int* coefficients = sws_getCoefficients((src.colorspace == AVCOL_SPC_UNSPECIFIED) ? SWS_CS_DEFAULT
+                                                                                          : src.colorspace);
+  sws_setColorspaceDetails(sws_ctx_,
+                           coefficients,
+                           (src.color_range == AVCOL_RANGE_JPEG) ? 1 : 0,
+                           coefficients,
+                           1,
+                           0,
+                           1 << 16,
+                           1 << 16);
+
+  AVFrame* dst = FramePool::instance().acquire(src.width, src.height, pix_fmt_);
+  if (dst == nullptr) {
+    return nullptr;
+  }
+  sws_scale(sws_ctx_, src.data, src.linesize, 0, src.height, dst->data, dst->linesize);
+  av_frame_copy_props(dst, &src);
+  return dst;
+}
@@ -0,0 +1,79 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef VIDEOFILTER_H
+#define VIDEOFILTER_H
+
+struct AVStream;
+struct AVFrame;
+struct AVFilterGraph;
+struct AVFilterContext;
+struct SwsContext;
+
+namespace chestnut::playback
+{
+  /**
+   * @brief                 Add the filters that prepare decoded frames of a stream for upload as a texture.
+   *                        Conversion to the returned pixel format is left to a FrameConverter
+   * @param graph           Allocated graph to configure
+   * @param stream          Source of the frames
+   * @param deinterlace     Double the frame-rate with yadif
+   * @param top_field_first Field order of the source, if deinterlacing
+   * @param keep_yuv        Leave planar YUV the shader converts as it is, rather than converting to RGB
+   * @param src             Set to the filter decoded frames are added to
+   * @param sink            Set to the filter filtered frames are taken from
+   * @return                Pixel format to upload the frames in, or AV_PIX_FMT_NONE on failure
+   */
+  int buildVideoFilterGraph(AVFilterGraph& graph,
+                            const AVStream& stream,
+                            const bool deinterlace,
+                            const bool top_field_first,
+                            const bool keep_yuv,
+                            AVFilterContext*& src,
+                            AVFilterContext*& sink);
+
+  /**
+   * @brief Converts filtered frames to the pixel format uploaded, into buffers of the FramePool
+   */
+  class FrameConverter
+  {
+    public:
+      /**
+       * @param pix_fmt Format to convert to
+       */
+      explicit FrameConverter(const int pix_fmt);
+      ~FrameConverter();
+
+      FrameConverter() = delete;
+      FrameConverter(const FrameConverter&) = delete;
+      FrameConverter(const FrameConverter&&) = delete;
+      FrameConverter& operator=(const FrameConverter&) = delete;
+      FrameConverter& operator=(const FrameConverter&&) = delete;
+
+      /**
+       * @brief     Convert a frame
+       * @param src
+       * @return    Frame in the target format or null on failure. Frames already in it are referenced, not copied
+       */
+      AVFrame* convert(const AVFrame& src);
+    private:
+      const int pix_fmt_;
+      SwsContext* sws_ctx_ {nullptr};
+  };
+}
+
+#endif // VIDEOFILTER_H
@@ -1,7 +1,136 @@
 #include "cliptest.h"
+#include <QTemporaryDir>
+#include <algorithm>
+
 #include "project/clip.h"
+#include "project/footage.h"
+#include "project/proxytranscoder.h"
 #include "project/transition.h"
 #include "project/undo.h"
+#include "io/config.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace
+{
+  constexpr int SOURCE_RATE = 25;
+  constexpr int SOURCE_FRAMES = 50;
+  constexpr int SOURCE_SIZE = 64;
+  constexpr int SOURCE_FREQUENCY = 48000;
+
+  /**
+   * @brief       Write footage with its audio as stream 0 and its video, each frame a keyframe, as stream 1
+   * @param path
+   * @return      true==written
+   */
+  bool writeSource(const QString& path)
+  {
+    const auto dst = path.toUtf8();
+    AVFormatContext* out = nullptr;
+    if (avformat_alloc_output_context2(&out, nullptr, "mov", dst.data()) < 0) {
+      return false;
+    }
+    AVCodecContext* enc = nullptr;
+    AVFrame* frame = av_frame_alloc();
+    AVPacket* pkt = av_packet_alloc();
+    bool written = false;
+    const auto finish = [&] {
+      av_packet_free(&pkt);
+      av_frame_free(&frame);
+      avcodec_free_context(&enc);
+      if ((out->oformat->flags & AVFMT_NOFILE) == 0) {
+        avio_closep(&out->pb);
+      }
+      avformat_free_context(out);
+      return written;
+    };
+
+    AVStream* audio = avformat_new_stream(out, nullptr);
+    audio->codecpar->codec_type = AVMEDIA_TYPE_AUDIO;
+    audio->codecpar->codec_id = AV_CODEC_ID_PCM_S16LE;
+    audio->codecpar->format = AV_SAMPLE_FMT_S16;
+    audio->codecpar->sample_rate = SOURCE_FREQUENCY;
+    audio->codecpar->channel_layout = AV_CH_LAYOUT_STEREO;
+    audio->codecpar->channels = 2;
+    audio->codecpar->bits_per_coded_sample = 16;
+    audio->codecpar->block_align = 4;
+    audio->time_base = {1, SOURCE_FREQUENCY};
+
+    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    enc = avcodec_alloc_context3(codec);
+    enc->width = SOURCE_SIZE;
+    enc->height = SOURCE_SIZE;
+    enc->pix_fmt = AV_PIX_FMT_YUVJ420P;
+    enc->time_base = {1, SOURCE_RATE};
+    enc->framerate = {SOURCE_RATE, 1};
+    if ((out->oformat->flags & AVFMT_GLOBALHEADER) != 0) {
+      enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+    if (avcodec_open2(enc, codec, nullptr) < 0) {
+      return finish();
+    }
+    AVStream* video = avformat_new_stream(out, nullptr);
+    video->time_base = enc->time_base;
+    if ( (avcodec_parameters_from_context(video->codecpar, enc) < 0)
+         || (avio_open(&out->pb, dst.data(), AVIO_FLAG_WRITE) < 0)
+         || (avformat_write_header(out, nullptr) < 0) ) {
+      return finish();
+    }
+
+    const auto drain = [&] {
+      while (avcodec_receive_packet(enc, pkt) >= 0) {
+        av_packet_rescale_ts(pkt, enc->time_base, video->time_base);
+        pkt->stream_index = video->index;
+        if (av_interleaved_write_frame(out, pkt) < 0) {
+          return false;
+        }
+      }
+      return true;
+    };
+    constexpr int samples = SOURCE_FREQUENCY / SOURCE_RATE;
+    frame->format = enc->pix_fmt;
+    frame->width = enc->width;
+    frame->height = enc->height;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+      return finish();
+    }
+    for (int i = 0; i < SOURCE_FRAMES; ++i) {
+      if (av_frame_make_writable(frame) < 0) {
+        return finish();
+      }
+      // each frame a different shade, so one can be told from another
+      for (int y = 0; y < SOURCE_SIZE; ++y) {
+        std::fill_n(frame->data[0] + (y * frame->linesize[0]), SOURCE_SIZE, static_cast<uint8_t>(i * 4));
+      }
+      for (int y = 0; y < SOURCE_SIZE / 2; ++y) {
+        std::fill_n(frame->data[1] + (y * frame->linesize[1]), SOURCE_SIZE / 2, 128);
+        std::fill_n(frame->data[2] + (y * frame->linesize[2]), SOURCE_SIZE / 2, 128);
+      }
+      frame->pts = i;
+      if ( (avcodec_send_frame(enc, frame) < 0) || !drain()) {
+        return finish();
+      }
+
+      if (av_new_packet(pkt, samples * 4) < 0) {
+        return finish();
+      }
+      std::fill_n(pkt->data, pkt->size, 0);
+      pkt->pts = static_cast<int64_t>(i) * samples;
+      pkt->dts = pkt->pts;
+      pkt->duration = samples;
+      pkt->stream_index = audio->index;
+      if (av_interleaved_write_frame(out, pkt) < 0) {
+        return finish();
+      }
+    }
+    avcodec_send_frame(enc, nullptr);
+    written = drain() && (av_write_trailer(out) == 0);
+    return finish();
+  }
+}
 
 
 ClipTest::ClipTest()
@@ -534,3 +663,53 @@ void ClipTest::testCasePlayheadToTimestampAfterRange()
   auto val = clp->playhead_to_seconds(25);
   QCOMPARE(val, 1.5);
 }
+
+
+void ClipTest::testCaseProxySeek()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto source = dir.filePath("source.mov");
+  QVERIFY(writeSource(source));
+
+  auto mda = std::make_shared<Media>();
+  auto ftg = std::make_shared<Footage>(source, mda);
+  ftg->parseStreams();
+  QVERIFY(mda->setFootage(ftg));
+  const auto ms = ftg->video_stream_from_file_index(1);
+  QVERIFY(ms != nullptr);
+  // the proxy holds only the video, as its stream 0
+  const auto proxy = ms->proxyPath();
+  QVERIFY(QDir().mkpath(QFileInfo(proxy).path()));
+  std::atomic_bool running {true};
+  QVERIFY(project::ProxyTranscoder(source, ms->file_index, proxy).transcode(SOURCE_SIZE / 2, running));
+  ms->proxy_status_ = project::ProxyStatus::READY;
+
+  const auto config = global::config;
+  global::config.use_proxies = true;
+  global::config.gpu_yuv_conversion = false;
+
+  auto seq = std::make_shared<Sequence>();
+  seq->setFrameRate(SOURCE_RATE);
+  Clip clp(seq);
+  clp.timeline_info.media = mda;
+  clp.timeline_info.media_stream = ms->file_index;
+  clp.timeline_info.track_ = -1;
+  clp.timeline_info.in = 0;
+  clp.timeline_info.out = SOURCE_FRAMES;
+  QVERIFY(clp.openWorker());
+  QVERIFY(clp.proxy_);
+  QCOMPARE(clp.media_handling_.stream_->index, 0);
+
+  // far enough from the start that the fresh decoder seeks rather than decodes on
+  const long target = (SOURCE_FRAMES * 3) / 4;
+  const int64_t target_ts = clp.playhead_to_timestamp(target);
+  clp.reset_cache(target);
+  // every frame of a proxy is a keyframe, so the seek lands on the target's own
+  QVERIFY(clp.media_handling_.frame_->pts <= target_ts);
+  QVERIFY((target_ts - clp.media_handling_.frame_->pts) < clp.frame_duration_);
+
+  clp.closeWorker();
+  global::config = config;
+  QFile::remove(proxy);
+}
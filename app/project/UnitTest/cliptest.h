@@ -76,6 +76,7 @@ class ClipTest : public QObject
 
      void testCasePlayheadToTimestampBeforeRange();
      void testCasePlayheadToTimestampAfterRange();
+     void testCaseProxySeek();
 };
 
 #endif // CLIPTEST_H
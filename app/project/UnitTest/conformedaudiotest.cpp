@@ -0,0 +1,124 @@
+#include "conformedaudiotest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "project/conformedaudio.h"
+#include "playback/offlineaudiorender.h"
+
+using project::ConformedAudio;
+
+namespace
+{
+  constexpr int32_t FREQUENCY = 48000;
+  constexpr double FRAME_RATE = 25.0;
+
+  /**
+   * @brief       Write a second of silence to a WAV file, to be conformed
+   * @param path
+   * @return      true==written
+   */
+  bool writeSource(const QString& path)
+  {
+    auto seq = std::make_shared<Sequence>();
+    seq->setFrameRate(FRAME_RATE);
+    seq->setAudioFrequency(FREQUENCY);
+    chestnut::playback::OfflineAudioRender render(seq, 0, static_cast<long>(FRAME_RATE));
+    std::atomic_bool running {true};
+    return render.bounce(path, running);
+  }
+}
+
+ConformedAudioTest::ConformedAudioTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void ConformedAudioTest::testCaseBuildLoad()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto source = dir.filePath("source.wav");
+  QVERIFY(writeSource(source));
+  const auto path = dir.filePath("conformed");
+  std::atomic_bool running {true};
+  QVERIFY(ConformedAudio::build(source, 0, FREQUENCY, path, running));
+  QVERIFY(!QFile::exists(path + ".part"));
+
+  ConformedAudio conformed;
+  QVERIFY(conformed.empty());
+  QVERIFY(conformed.load(path));
+  QVERIFY(!conformed.empty());
+  QCOMPARE(conformed.sampleRate(), FREQUENCY);
+  QCOMPARE(conformed.length(), static_cast<int64_t>(FREQUENCY));
+  const auto samples = conformed.samples(FREQUENCY / 2);
+  QCOMPARE(samples[0], 0.0f);
+  QCOMPARE(samples[1], 0.0f);
+}
+
+
+void ConformedAudioTest::testCaseBuildResampled()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto source = dir.filePath("source.wav");
+  QVERIFY(writeSource(source));
+  const auto path = dir.filePath("conformed");
+  std::atomic_bool running {true};
+  QVERIFY(ConformedAudio::build(source, 0, FREQUENCY / 2, path, running));
+
+  ConformedAudio conformed;
+  QVERIFY(conformed.load(path));
+  QCOMPARE(conformed.sampleRate(), FREQUENCY / 2);
+  // the resampler's delay is flushed, so within a sample of half the length
+  QVERIFY(qAbs(conformed.length() - (FREQUENCY / 2)) <= 1);
+}
+
+
+void ConformedAudioTest::testCaseBuildAbandoned()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto source = dir.filePath("source.wav");
+  QVERIFY(writeSource(source));
+  const auto path = dir.filePath("conformed");
+  std::atomic_bool running {false};
+  QVERIFY(!ConformedAudio::build(source, 0, FREQUENCY, path, running));
+  QVERIFY(!QFile::exists(path));
+  QVERIFY(!QFile::exists(path + ".part"));
+}
+
+
+void ConformedAudioTest::testCaseBuildMissing()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto path = dir.filePath("conformed");
+  std::atomic_bool running {true};
+  QVERIFY(!ConformedAudio::build("/a/path/that/does/not/exist", 0, FREQUENCY, path, running));
+  QVERIFY(!QFile::exists(path));
+}
+
+
+void ConformedAudioTest::testCaseLoadMissing()
+{
+  ConformedAudio conformed;
+  QVERIFY(!conformed.load("/a/path/that/does/not/exist"));
+  QVERIFY(conformed.empty());
+}
+
+
+void ConformedAudioTest::testCaseLoadUnrecognised()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto path = dir.filePath("conformed");
+  QFile file(path);
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write(QByteArray(64, 'x'));
+  file.close();
+
+  ConformedAudio conformed;
+  QVERIFY(!conformed.load(path));
+  QVERIFY(conformed.empty());
+}
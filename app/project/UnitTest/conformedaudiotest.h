@@ -0,0 +1,24 @@
+#ifndef CONFORMEDAUDIOTEST_H
+#define CONFORMEDAUDIOTEST_H
+
+#include <QObject>
+
+class ConformedAudioTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit ConformedAudioTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseBuildLoad();
+    void testCaseBuildResampled();
+    void testCaseBuildAbandoned();
+    void testCaseBuildMissing();
+    void testCaseLoadMissing();
+    void testCaseLoadUnrecognised();
+
+};
+
+#endif // CONFORMEDAUDIOTEST_H
@@ -1,9 +1,22 @@
 #include "effectfieldtest.h"
 
 #include <QtTest>
+#include <vector>
 
 #include "project/effectfield.h"
+#include "project/effect.h"
+#include "project/effectrow.h"
+#include "project/clip.h"
+#include "project/sequence.h"
 #include "ui/colorbutton.h"
+#include "ui/labelslider.h"
+
+namespace
+{
+  constexpr double FRAME_RATE = 25.0;
+  // of the values evaluated at once, as get_double_values() does
+  constexpr size_t STEP = 64;
+}
 
 EffectFieldTest::EffectFieldTest(QObject *parent) : QObject(parent)
 {
@@ -38,10 +51,109 @@ void EffectFieldTest::testCaseNextKey()
 
 void EffectFieldTest::testCaseSetValueColor()
 {
+  ColorButton button;
   EffectField fld(nullptr);
   fld.type_ = EffectFieldType::COLOR;
-  fld.ui_element = new ColorButton;
+  fld.ui_element = &button;
   auto val = "#FF000000";
   fld.setValue(val);
   QVERIFY(fld.get_color_value(0).toRgb() == QColor(val));
 }
+
+
+void EffectFieldTest::testCaseDoubleValuesUnkeyed()
+{
+  LabelSlider slider;
+  EffectField fld(nullptr);
+  fld.type_ = EffectFieldType::DOUBLE;
+  fld.ui_element = &slider;
+  fld.set_double_value(50);
+  std::vector<float> values(100, -1.0f);
+  fld.get_double_values(0, 1, values, [] (const double val) { return val * 2; });
+  QCOMPARE(values.front(), 100.0f);
+  QCOMPARE(values.back(), 100.0f);
+}
+
+
+void EffectFieldTest::testCaseDoubleValuesKeyed()
+{
+  auto seq = std::make_shared<Sequence>();
+  seq->setFrameRate(FRAME_RATE);
+  auto clp = std::make_shared<Clip>(seq);
+  Effect eff(clp);
+  eff.setupUi();
+  auto row = eff.add_row("gain");
+  QVERIFY(row != nullptr);
+  auto fld = row->add_field(EffectFieldType::DOUBLE, "gain");
+  row->setKeyframing(true);
+  // 0 to 100 over 10 frames
+  EffectKeyframe first;
+  first.time = 0;
+  first.type = KeyframeType::LINEAR;
+  first.data = 0.0;
+  fld->keyframes.append(first);
+  EffectKeyframe second = first;
+  second.time = 10;
+  second.data = 100.0;
+  fld->keyframes.append(second);
+
+  // between the keyframes, not a multiple of the step long, so the last block is short
+  constexpr double start = 0.1;
+  constexpr double end = 0.3;
+  std::vector<float> values(1000, -1.0f);
+  const double interval = (end - start) / values.size();
+  fld->get_double_values(start, end, values);
+  for (size_t i = 0; i < values.size(); ++i) {
+    const auto reference = 100.0 * (start + (interval * i)) * FRAME_RATE / 10.0;
+    QVERIFY(qAbs(values.at(i) - reference) < 1E-3);
+  }
+
+  // mapped, the values are evaluated once a step and ramped between
+  const auto square = [] (const double val) { return val * val; };
+  fld->get_double_values(start, end, values, square);
+  for (size_t i = 0; i < values.size(); i += STEP) {
+    QCOMPARE(values.at(i), static_cast<float>(square(fld->get_double_value(start + (interval * i), true))));
+  }
+  QVERIFY(qAbs(values.at(STEP / 2) - ((values.at(0) + values.at(STEP)) / 2)) < 1E-2);
+}
+
+
+void EffectFieldTest::testCaseDoubleValuesAcrossKeyframe()
+{
+  auto seq = std::make_shared<Sequence>();
+  seq->setFrameRate(FRAME_RATE);
+  auto clp = std::make_shared<Clip>(seq);
+  Effect eff(clp);
+  eff.setupUi();
+  auto row = eff.add_row("gain");
+  QVERIFY(row != nullptr);
+  auto fld = row->add_field(EffectFieldType::DOUBLE, "gain");
+  row->setKeyframing(true);
+  // held at 0 until it steps to 100 at frame 2
+  EffectKeyframe first;
+  first.time = 0;
+  first.type = KeyframeType::HOLD;
+  first.data = 0.0;
+  fld->keyframes.append(first);
+  EffectKeyframe second;
+  second.time = 2;
+  second.type = KeyframeType::LINEAR;
+  second.data = 100.0;
+  fld->keyframes.append(second);
+
+  // a frame is taken to be at its keyframe from half a frame before, 0.06s, which is in the block of 320 to 384
+  std::vector<float> values(1000, -1.0f);
+  fld->get_double_values(0.0, 0.16, values, [] (const double val) { return val / 100.0; });
+  for (size_t i = 0; i <= 320; ++i) {
+    QCOMPARE(values.at(i), 0.0f);
+  }
+  // the step is ramped across the block it falls in, rather than jumped
+  for (size_t i = 321; i < 384; ++i) {
+    QVERIFY(values.at(i) > values.at(i - 1));
+    QVERIFY(values.at(i) < 1.0f);
+  }
+  QVERIFY(qAbs(values.at(352) - 0.5f) < 1E-6f);
+  for (size_t i = 384; i < values.size(); ++i) {
+    QCOMPARE(values.at(i), 1.0f);
+  }
+}
@@ -15,6 +15,9 @@ class EffectFieldTest : public QObject
     void testCasePrevKey();
     void testCaseNextKey();
     void testCaseSetValueColor();
+    void testCaseDoubleValuesUnkeyed();
+    void testCaseDoubleValuesKeyed();
+    void testCaseDoubleValuesAcrossKeyframe();
 };
 
 #endif // EFFECTFIELDTEST_H
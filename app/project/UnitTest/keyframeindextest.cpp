@@ -0,0 +1,75 @@
+#include "keyframeindextest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "project/keyframeindex.h"
+
+using project::KeyframeIndex;
+
+KeyframeIndexTest::KeyframeIndexTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void KeyframeIndexTest::testCaseKeyframeBefore()
+{
+  // out of order, as keyframes can be read
+  const KeyframeIndex index({{200, 3000, 10}, {0, 100, 10}, {100, 1500, 10}});
+  QCOMPARE(index.size(), 3);
+  auto kf = index.keyframeBefore(150);
+  QVERIFY(kf.has_value());
+  QCOMPARE(kf->pts_, static_cast<int64_t>(100));
+  QCOMPARE(kf->pos_, static_cast<int64_t>(1500));
+  kf = index.keyframeBefore(100);
+  QVERIFY(kf.has_value());
+  QCOMPARE(kf->pts_, static_cast<int64_t>(100));
+  kf = index.keyframeBefore(5000);
+  QVERIFY(kf.has_value());
+  QCOMPARE(kf->pts_, static_cast<int64_t>(200));
+}
+
+
+void KeyframeIndexTest::testCaseKeyframeBeforeStart()
+{
+  const KeyframeIndex index({{10, 100, 10}});
+  QVERIFY(!index.keyframeBefore(5).has_value());
+  QVERIFY(!KeyframeIndex().keyframeBefore(5).has_value());
+}
+
+
+void KeyframeIndexTest::testCaseFramesToDecode()
+{
+  const KeyframeIndex::Entry kf {100, 0, 12};
+  QCOMPARE(KeyframeIndex::framesToDecode(kf, 100, 10), 1);
+  QCOMPARE(KeyframeIndex::framesToDecode(kf, 145, 10), 5);
+  // no further than the next keyframe
+  QCOMPARE(KeyframeIndex::framesToDecode(kf, 10000, 10), 12);
+}
+
+
+void KeyframeIndexTest::testCaseSaveLoad()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto path = dir.filePath("index");
+  const KeyframeIndex index({{0, 100, 25}, {1001, 4096, 25}, {2002, 9000, 13}});
+  QVERIFY(index.save(path));
+
+  KeyframeIndex loaded;
+  QVERIFY(loaded.load(path));
+  QCOMPARE(loaded.size(), index.size());
+  for (int i = 0; i < index.size(); ++i) {
+    QCOMPARE(loaded.entries().at(i).pts_, index.entries().at(i).pts_);
+    QCOMPARE(loaded.entries().at(i).pos_, index.entries().at(i).pos_);
+    QCOMPARE(loaded.entries().at(i).frames_, index.entries().at(i).frames_);
+  }
+}
+
+
+void KeyframeIndexTest::testCaseLoadMissing()
+{
+  KeyframeIndex index;
+  QVERIFY(!index.load("/a/path/that/does/not/exist"));
+  QVERIFY(index.empty());
+}
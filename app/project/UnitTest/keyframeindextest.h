@@ -0,0 +1,23 @@
+#ifndef KEYFRAMEINDEXTEST_H
+#define KEYFRAMEINDEXTEST_H
+
+#include <QObject>
+
+class KeyframeIndexTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit KeyframeIndexTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseKeyframeBefore();
+    void testCaseKeyframeBeforeStart();
+    void testCaseFramesToDecode();
+    void testCaseSaveLoad();
+    void testCaseLoadMissing();
+
+};
+
+#endif // KEYFRAMEINDEXTEST_H
@@ -19,7 +19,7 @@ void MediaTest::testCaseConstructor()
   QVERIFY(mda.name().isEmpty());
   QVERIFY(mda.childCount() == 0);
   QVERIFY(mda.child(0) == nullptr);
-  QVERIFY(mda.columnCount() == 3);
+  QVERIFY(mda.columnCount() == 4);
   QVERIFY(mda.data(0,0).isValid());
   QVERIFY(mda.row() == 0);
   QVERIFY(mda.parentItem() == nullptr);
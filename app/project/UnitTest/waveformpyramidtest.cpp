@@ -0,0 +1,109 @@
+#include "waveformpyramidtest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "project/waveformpyramid.h"
+
+using project::WaveformPyramid;
+
+namespace
+{
+  // the finest level summarises this many samples per peak
+  constexpr int FINEST = 128;
+
+  QVector<float> stereo(const int frames)
+  {
+    // left rises from silence to full scale, right is its inverse
+    QVector<float> samples;
+    for (int i = 0; i < frames; ++i) {
+      const float val = static_cast<float>(i) / frames;
+      samples.append(val);
+      samples.append(-val);
+    }
+    return samples;
+  }
+}
+
+WaveformPyramidTest::WaveformPyramidTest(QObject *parent) : QObject(parent)
+{
+
+}
+
+
+void WaveformPyramidTest::testCaseLevels()
+{
+  const WaveformPyramid pyramid(2, stereo(FINEST * 8));
+  QCOMPARE(pyramid.channels(), 2);
+  QCOMPARE(pyramid.length(), static_cast<int64_t>(FINEST * 8));
+  // 8, 4, 2 and 1 peaks
+  QCOMPARE(pyramid.levels().size(), 4);
+  QCOMPARE(pyramid.levels().front().samples_per_peak_, FINEST);
+  QCOMPARE(pyramid.levels().front().length_, static_cast<int64_t>(8));
+  QCOMPARE(pyramid.levels().back().samples_per_peak_, FINEST * 8);
+  QCOMPARE(pyramid.levels().back().length_, static_cast<int64_t>(1));
+
+  // the coarsest spans all
+  const auto whole = pyramid.peak(pyramid.levels().back(), 0, 1, 0);
+  QCOMPARE(whole.first, static_cast<int8_t>(0));
+  QCOMPARE(whole.second, static_cast<int8_t>(127));
+  QVERIFY(WaveformPyramid().empty());
+}
+
+
+void WaveformPyramidTest::testCaseLevelForZoom()
+{
+  const WaveformPyramid pyramid(2, stereo(FINEST * 8));
+  QCOMPARE(pyramid.level(1)->samples_per_peak_, FINEST);
+  QCOMPARE(pyramid.level(FINEST * 3)->samples_per_peak_, FINEST * 2);
+  QCOMPARE(pyramid.level(FINEST * 100)->samples_per_peak_, FINEST * 8);
+  QVERIFY(WaveformPyramid().level(1) == nullptr);
+}
+
+
+void WaveformPyramidTest::testCasePeak()
+{
+  const WaveformPyramid pyramid(2, stereo(FINEST * 8));
+  const auto& finest = pyramid.levels().front();
+  const auto first = pyramid.peak(finest, 0, 1, 1);
+  QCOMPARE(first.second, static_cast<int8_t>(0));
+  QVERIFY(first.first < 0);
+  // ranges are clamped to the level
+  const auto last = pyramid.peak(finest, 7, 100, 0);
+  QCOMPARE(last, pyramid.peak(finest, 7, 8, 0));
+  const auto beyond = pyramid.peak(finest, 8, 9, 0);
+  QCOMPARE(beyond.first, static_cast<int8_t>(0));
+  QCOMPARE(beyond.second, static_cast<int8_t>(0));
+}
+
+
+void WaveformPyramidTest::testCaseSaveLoad()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto path = dir.filePath("waveform");
+  const WaveformPyramid pyramid(2, stereo((FINEST * 5) + 3));
+  QVERIFY(pyramid.save(path));
+
+  WaveformPyramid loaded;
+  QVERIFY(loaded.load(path));
+  QCOMPARE(loaded.channels(), pyramid.channels());
+  QCOMPARE(loaded.length(), pyramid.length());
+  QCOMPARE(loaded.levels().size(), pyramid.levels().size());
+  for (int i = 0; i < pyramid.levels().size(); ++i) {
+    const auto& lhs = pyramid.levels().at(i);
+    const auto& rhs = loaded.levels().at(i);
+    QCOMPARE(rhs.length_, lhs.length_);
+    for (int64_t pk = 0; pk < lhs.length_; ++pk) {
+      QCOMPARE(loaded.peak(rhs, pk, pk + 1, 0), pyramid.peak(lhs, pk, pk + 1, 0));
+      QCOMPARE(loaded.peak(rhs, pk, pk + 1, 1), pyramid.peak(lhs, pk, pk + 1, 1));
+    }
+  }
+}
+
+
+void WaveformPyramidTest::testCaseLoadMissing()
+{
+  WaveformPyramid pyramid;
+  QVERIFY(!pyramid.load("/a/path/that/does/not/exist"));
+  QVERIFY(pyramid.empty());
+}
@@ -0,0 +1,23 @@
+#ifndef WAVEFORMPYRAMIDTEST_H
+#define WAVEFORMPYRAMIDTEST_H
+
+#include <QObject>
+
+class WaveformPyramidTest : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit WaveformPyramidTest(QObject *parent = nullptr);
+
+  signals:
+
+  private slots:
+    void testCaseLevels();
+    void testCaseLevelForZoom();
+    void testCasePeak();
+    void testCaseSaveLoad();
+    void testCaseLoadMissing();
+
+};
+
+#endif // WAVEFORMPYRAMIDTEST_H
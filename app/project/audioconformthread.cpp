@@ -0,0 +1,77 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "audioconformthread.h"
+
+#include "io/config.h"
+#include "debug.h"
+
+using chestnut::project::AudioConformThread;
+
+AudioConformThread::AudioConformThread(QObject* parent) : QObject(parent)
+{
+  thread_ = std::thread(&AudioConformThread::run, this);
+}
+
+AudioConformThread::~AudioConformThread()
+{
+  qInfo() << "Stopping Audio Conform thread";
+  QMutexLocker lock(&queue_mutex_);
+  running_ = false;
+  lock.unlock();
+  wait_cond_.wakeAll();
+  thread_.join();
+}
+
+void AudioConformThread::addToQueue(FootagePtr ftg)
+{
+  if ( (ftg == nullptr) || ftg->audioTracks().empty() ) {
+    return;
+  }
+  QMutexLocker lock(&queue_mutex_);
+  queue_.enqueue(ftg);
+  lock.unlock();
+  qDebug() << "Added footage to audio conform queue, file_path:" << ftg->location();
+  wait_cond_.wakeAll();
+}
+
+
+void AudioConformThread::run()
+{
+  qDebug() << "Starting Audio Conform thread";
+  QMutexLocker lock(&queue_mutex_);
+  while (running_) {
+    if (queue_.empty()) {
+      wait_cond_.wait(&queue_mutex_);
+      continue;
+    }
+    const auto item = queue_.dequeue();
+    lock.unlock();
+    if (auto ftg = item.lock()) {
+      // clips opened from here on read the conformed samples
+      if (ftg->conformAudio(global::config.audio_rate, running_)) {
+        qInfo() << "Footage conformed audio, file_path:" << ftg->location();
+      } else if (running_) {
+        qWarning() << "Footage failed to conform audio, file_path:" << ftg->location();
+      }
+    } else {
+      qDebug() << "Queued Footage has since been removed";
+    }
+    lock.relock();
+  }
+  qInfo() << "Exiting Audio Conform thread";
+}
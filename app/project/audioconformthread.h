@@ -0,0 +1,65 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIOCONFORMTHREAD_H
+#define AUDIOCONFORMTHREAD_H
+
+#include <thread>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+
+// for the FootageWPtr metatype
+#include "previewgeneratorthread.h"
+
+
+namespace chestnut::project
+{
+  /**
+   * @brief Conforms the audio of Footage, one at a time, to the configured sample rate so that clips read the samples
+   *        in place rather than decoding and resampling them on every play
+   */
+  class AudioConformThread : public QObject
+  {
+      Q_OBJECT
+    public:
+      explicit AudioConformThread(QObject* parent=nullptr);
+      ~AudioConformThread() override;
+
+      /**
+       * @brief       Add to the queue a Footage for its audio streams to be conformed in turn
+       * @param ftg
+       */
+      void addToQueue(FootagePtr ftg);
+
+    private:
+      std::thread thread_;
+      QQueue<FootageWPtr> queue_;
+      QMutex queue_mutex_;
+      QWaitCondition wait_cond_;
+      std::atomic_bool running_ {true};
+
+      /**
+       * @brief The worker method for the thread
+       */
+      void run();
+
+  };
+}
+
+#endif // AUDIOCONFORMTHREAD_H
@@ -19,6 +19,7 @@
 
 #include <QtMath>
 #include <filesystem>
+#include <algorithm>
 
 #include "project/effect.h"
 #include "project/transition.h"
@@ -26,6 +27,10 @@
 #include "io/config.h"
 #include "playback/playback.h"
 #include "playback/audio.h"
+#include "playback/audiomixer.h"
+#include "playback/videofilter.h"
+#include "playback/audiofilter.h"
+#include "playback/mixkernels.h"
 #include "project/sequence.h"
 #include "panels/panelmanager.h"
 #include "project/media.h"
@@ -50,12 +55,19 @@ using project::ScanMethod;
 constexpr bool WAIT_ON_CLOSE = true;
 constexpr AVSampleFormat SAMPLE_FORMAT = AV_SAMPLE_FMT_S16;
 constexpr int AUDIO_SAMPLES = 2048;
+// playback mixes for the output device in stereo, whatever the sequence's layout
+constexpr uint64_t PLAYBACK_LAYOUT = AV_CH_LAYOUT_STEREO;
 constexpr int AUDIO_BUFFER_PADDING = 2048;
 int32_t Clip::next_id = 0;
 
 namespace  {
   constexpr auto ERR_LEN = 256;
   std::array<char, ERR_LEN> err;
+
+  void freeFrame(AVFrame* frame)
+  {
+    av_frame_free(&frame);
+  }
 }
 
 double bytes_to_seconds(const int nb_bytes, const int nb_channels, const int sample_rate) {
@@ -166,6 +178,27 @@ bool Clip::usesCacher() const
           || ( (timeline_info.media != nullptr) && (timeline_info.media->type() == MediaType::FOOTAGE)));
 }
 
+
+bool Clip::formatStale() const
+{
+  if (!finished_opening || (mediaType() != ClipType::VISUAL) || !is_gl_yuv_format(pix_fmt)) {
+    return false;
+  }
+  return !global::config.gpu_yuv_conversion || !chestnut::playback::PlanarTexture::available() || imageEffects();
+}
+
+
+bool Clip::sourceStale() const
+{
+  if (!finished_opening || (mediaType() != ClipType::VISUAL) || (timeline_info.media == nullptr)
+      || (timeline_info.media->type() != MediaType::FOOTAGE)) {
+    return false;
+  }
+  const auto ftg = timeline_info.media->object<Footage>();
+  const auto ms = (ftg != nullptr) ? ftg->video_stream_from_file_index(timeline_info.media_stream) : nullptr;
+  return (ms != nullptr) && (proxy_ != useProxy(*ms));
+}
+
 /**
  * @brief open_worker
  * @return true==success
@@ -176,7 +209,7 @@ bool Clip::openWorker()
     if (timeline_info.track_ >= 0) {
       media_handling_.frame_ = av_frame_alloc();
       media_handling_.frame_->format = SAMPLE_FORMAT;
-      media_handling_.frame_->channel_layout = sequence->audioLayout();
+      media_handling_.frame_->channel_layout = PLAYBACK_LAYOUT;
       media_handling_.frame_->channels = av_get_channel_layout_nb_channels(media_handling_.frame_->channel_layout);
       media_handling_.frame_->sample_rate = current_audio_freq();
       media_handling_.frame_->nb_samples = AUDIO_SAMPLES;
@@ -189,7 +222,6 @@ bool Clip::openWorker()
   } else if (timeline_info.media->type() == MediaType::FOOTAGE) {
     // opens file resource for FFmpeg and prepares Clip struct for playback
     auto ftg = timeline_info.media->object<Footage>();
-    auto filename = ftg->location().toUtf8().data();
 
     const auto ms = (mediaType() == ClipType::VISUAL)
                     ? ftg->video_stream_from_file_index(timeline_info.media_stream)
@@ -198,162 +230,79 @@ bool Clip::openWorker()
       qCritical() << "Footage stream is NULL";
       return false;
     }
-    int errCode = avformat_open_input(
-                    &media_handling_.format_ctx_,
-                    filename,
-                    nullptr,
-                    nullptr
-                    );
-    if (errCode != 0) {
-      char err[1024];
-      av_strerror(errCode, err, 1024);
-      qCritical() << "Could not open" << filename << "-" << err;
+    // playback reads a proxy of the video in its place, once there is one
+    proxy_ = useProxy(*ms);
+    const auto location = proxy_ ? ms->proxyPath() : ftg->location();
+    const int stream_index = proxy_ ? 0 : ms->file_index;
+    // a pooled decoder of the same footage only needs a seek, not a full open
+    auto decoder = chestnut::playback::DecoderPool::instance().lease(location,
+                                                                     stream_index,
+                                                                     playhead_to_seconds(sequence->playhead_));
+    if (decoder == nullptr) {
+      qCritical() << "Could not obtain decoder for" << location;
       return false;
     }
+    media_handling_.format_ctx_ = decoder->format_ctx_;
+    media_handling_.stream_ = decoder->stream_;
+    media_handling_.codec_ = decoder->codec_;
+    media_handling_.codec_ctx_ = decoder->codec_ctx_;
+    std::atomic_store(&media_handling_.decoder_, std::move(decoder));
 
-    errCode = avformat_find_stream_info(media_handling_.format_ctx_, nullptr);
-    if (errCode < 0) {
-      char err[1024];
-      av_strerror(errCode, err, 1024);
-      qCritical() << "Could not open" << filename << "-" << err;
-      return false;
-    }
-
-    av_dump_format(media_handling_.format_ctx_, 0, filename, 0);
-
-    media_handling_.stream_ = media_handling_.format_ctx_->streams[ms->file_index];
-    if ( (media_handling_.stream_ == nullptr) || (media_handling_.stream_->codecpar == nullptr) ) {
-      qCritical() << "Stream Info instance(s) are null";
-      return false;
-    }
-    media_handling_.codec_ = avcodec_find_decoder(media_handling_.stream_->codecpar->codec_id);
-    media_handling_.codec_ctx_ = avcodec_alloc_context3(media_handling_.codec_);
-    avcodec_parameters_to_context(media_handling_.codec_ctx_, media_handling_.stream_->codecpar);
+    cache_key_ = {location, stream_index};
+    infinite_length_ = ms->infinite_length;
+    // the fields of a proxy were blended when it was scaled
+    deinterlacing_ = !proxy_ && (ms->fieldOrder() != media_handling::FieldOrder::PROGRESSIVE);
 
     if (ms->infinite_length) {
-      max_queue_size = 1;
+      upcoming_frames_ = 1;
     } else {
-      max_queue_size = 0;
       if (global::config.upcoming_queue_type == FRAME_QUEUE_TYPE_FRAMES) {
-        max_queue_size += qCeil(global::config.upcoming_queue_size);
+        upcoming_frames_ = qCeil(global::config.upcoming_queue_size);
       } else {
-        max_queue_size += qCeil(ms->video_frame_rate * ftg->speed_ * global::config.upcoming_queue_size);
-      }
-      if (global::config.previous_queue_type == FRAME_QUEUE_TYPE_FRAMES) {
-        max_queue_size += qCeil(global::config.previous_queue_size);
-      } else {
-        max_queue_size += qCeil(ms->video_frame_rate * ftg->speed_ * global::config.previous_queue_size);
+        upcoming_frames_ = qCeil(ms->video_frame_rate * ftg->speed_ * global::config.upcoming_queue_size);
       }
+      upcoming_frames_ = qMax(upcoming_frames_, 1);
     }
 
-
-    if (ms->fieldOrder() != media_handling::FieldOrder::PROGRESSIVE) {
-      max_queue_size *= 2;
-    }
-
-    media_handling_.opts_ = nullptr;
-
-    // optimized decoding settings
-    if ((media_handling_.stream_->codecpar->codec_id != AV_CODEC_ID_PNG &&
-         media_handling_.stream_->codecpar->codec_id != AV_CODEC_ID_APNG &&
-         media_handling_.stream_->codecpar->codec_id != AV_CODEC_ID_TIFF
-     #ifndef DISABLE_PSD
-         && media_handling_.stream_->codecpar->codec_id != AV_CODEC_ID_PSD)
-    #else
-         )
-    #endif
-        || !global::config.disable_multithreading_for_images) {
-      av_dict_set(&media_handling_.opts_, "threads", "auto", 0);
-    }
-    if (media_handling_.stream_->codecpar->codec_id == AV_CODEC_ID_H264) {
-      av_dict_set(&media_handling_.opts_, "tune", "fastdecode", 0);
-      av_dict_set(&media_handling_.opts_, "tune", "zerolatency", 0);
+    if (deinterlacing_) {
+      upcoming_frames_ *= 2;
     }
 
-    // Open codec
-    if (avcodec_open2(media_handling_.codec_ctx_, media_handling_.codec_, &media_handling_.opts_) < 0) {
-      qCritical() << "Could not open codec";
-    }
+    // the deinterlacer doubles both the frame rate and the timebase, so this holds for either
+    frame_duration_ = (ms->video_frame_rate > 0)
+                      ? qMax(static_cast<int64_t>(1),
+                             qRound64(av_q2d(av_inv_q(media_handling_.stream_->time_base)) / ms->video_frame_rate))
+                      : 1;
 
     // allocate filtergraph
     filter_graph = avfilter_graph_alloc();
     if (filter_graph == nullptr) {
       qCritical() << "Could not create filtergraph";
     }
-    char filter_args[512];
 
     if (media_handling_.stream_->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-      snprintf(filter_args, sizeof(filter_args), "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
-               media_handling_.stream_->codecpar->width,
-               media_handling_.stream_->codecpar->height,
-               media_handling_.stream_->codecpar->format,
-               media_handling_.stream_->time_base.num,
-               media_handling_.stream_->time_base.den,
-               media_handling_.stream_->codecpar->sample_aspect_ratio.num,
-               media_handling_.stream_->codecpar->sample_aspect_ratio.den
-               );
-
-      avfilter_graph_create_filter(&buffersrc_ctx, avfilter_get_by_name("buffer"), "in", filter_args, nullptr, filter_graph);
-      avfilter_graph_create_filter(&buffersink_ctx, avfilter_get_by_name("buffersink"), "out", nullptr, nullptr, filter_graph);
-
-      AVFilterContext* last_filter = buffersrc_ctx;
-
-      if (ms->fieldOrder() != media_handling::FieldOrder::PROGRESSIVE) {
-        AVFilterContext* yadif_filter;
-        char yadif_args[100];
-        snprintf(yadif_args,
-                 sizeof(yadif_args),
-                 "mode=3:parity=%d",
-                 ((ms->fieldOrder() == media_handling::FieldOrder::TOP_FIRST) ? 0 : 1));
-        //TODO: check return values
-        constexpr auto deinterlacer = "yadif";
-        avfilter_graph_create_filter(&yadif_filter,
-                                     avfilter_get_by_name(deinterlacer),
-                                     deinterlacer,
-                                     yadif_args,
-                                     nullptr,
-                                     filter_graph);
-        avfilter_link(last_filter, 0, yadif_filter, 0);
-        last_filter = yadif_filter;
+      const bool keep_yuv = global::config.gpu_yuv_conversion
+                            && chestnut::playback::PlanarTexture::available()
+                            && !imageEffects();
+      pix_fmt = chestnut::playback::buildVideoFilterGraph(*filter_graph,
+                                                          *media_handling_.stream_,
+                                                          deinterlacing_,
+                                                          ms->fieldOrder() == media_handling::FieldOrder::TOP_FIRST,
+                                                          keep_yuv,
+                                                          buffersrc_ctx,
+                                                          buffersink_ctx);
+      cache_key_.pix_fmt_ = pix_fmt;
+      converter_ = std::make_unique<chestnut::playback::FrameConverter>(pix_fmt);
+      if (timeline_info.reverse && !ms->infinite_length) {
+        std::atomic_store(&reverse_decoder_,
+                          std::make_shared<chestnut::playback::ReverseDecoder>(
+                            cache_key_,
+                            media_handling_.decoder_,
+                            proxy_ ? nullptr : ms->keyframeIndex(),
+                            deinterlacing_,
+                            ms->fieldOrder() == media_handling::FieldOrder::TOP_FIRST,
+                            frame_duration_));
       }
-
-      /* stabilization code */
-      bool stabilize = false;
-      if (stabilize) {
-        AVFilterContext* stab_filter;
-        int stab_ret = avfilter_graph_create_filter(&stab_filter,
-                                                    avfilter_get_by_name("vidstabtransform"),
-                                                    "vidstab",
-                                                    "input=/media/matt/Home/samples/transforms.trf", //FIXME: hardcoded location
-                                                    nullptr,
-                                                    filter_graph);
-        if (stab_ret < 0) {
-          char err[100];
-          av_strerror(stab_ret, err, sizeof(err));
-        } else {
-          avfilter_link(last_filter, 0, stab_filter, 0);
-          last_filter = stab_filter;
-        }
-      }
-
-      enum AVPixelFormat valid_pix_fmts[] = {
-        AV_PIX_FMT_RGB24,
-        AV_PIX_FMT_RGBA,
-        AV_PIX_FMT_NONE
-      };
-
-      pix_fmt = avcodec_find_best_pix_fmt_of_list(valid_pix_fmts, static_cast<enum AVPixelFormat>(media_handling_.stream_->codecpar->format), 1, nullptr);
-      const char* chosen_format = av_get_pix_fmt_name(static_cast<enum AVPixelFormat>(pix_fmt));
-      char format_args[100];
-      snprintf(format_args, sizeof(format_args), "pix_fmts=%s", chosen_format);
-
-      AVFilterContext* format_conv;
-      avfilter_graph_create_filter(&format_conv, avfilter_get_by_name("format"), "fmt", format_args, nullptr, filter_graph);
-      avfilter_link(last_filter, 0, format_conv, 0);
-
-      avfilter_link(format_conv, 0, buffersink_ctx, 0);
-
-      avfilter_graph_config(filter_graph, nullptr);
     } else if (media_handling_.stream_->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
       if (media_handling_.codec_ctx_->channel_layout == 0) {
         media_handling_.codec_ctx_->channel_layout = av_get_default_channel_layout(media_handling_.stream_->codecpar->channels);
@@ -366,87 +315,41 @@ bool Clip::openWorker()
 
         reverse_frame->format = SAMPLE_FORMAT;
         reverse_frame->nb_samples = current_audio_freq()*2;
-        reverse_frame->channel_layout = sequence->audioLayout();
-        reverse_frame->channels = av_get_channel_layout_nb_channels(sequence->audioLayout());
+        reverse_frame->channel_layout = PLAYBACK_LAYOUT;
+        reverse_frame->channels = av_get_channel_layout_nb_channels(PLAYBACK_LAYOUT);
         av_frame_get_buffer(reverse_frame, 0);
 
         queue.append(reverse_frame);
       }
 
-      snprintf(filter_args, sizeof(filter_args), "time_base=%d/%d:sample_rate=%d:sample_fmt=%s:channel_layout=0x%" PRIx64,
-               media_handling_.stream_->time_base.num,
-               media_handling_.stream_->time_base.den,
-               media_handling_.stream_->codecpar->sample_rate,
-               av_get_sample_fmt_name(media_handling_.codec_ctx_->sample_fmt),
-               media_handling_.codec_ctx_->channel_layout
-               );
-
-      avfilter_graph_create_filter(&buffersrc_ctx, avfilter_get_by_name("abuffer"), "in", filter_args, nullptr, filter_graph);
-      avfilter_graph_create_filter(&buffersink_ctx, avfilter_get_by_name("abuffersink"), "out", nullptr, nullptr, filter_graph);
-
-      enum AVSampleFormat sample_fmts[] = { SAMPLE_FORMAT,  static_cast<AVSampleFormat>(-1) };
-      if (av_opt_set_int_list(buffersink_ctx, "sample_fmts", sample_fmts, -1, AV_OPT_SEARCH_CHILDREN) < 0) {
-        qCritical() << "Could not set output sample format";
-      }
-
-      int64_t channel_layouts[] = { AV_CH_LAYOUT_STEREO, static_cast<AVSampleFormat>(-1) };
-      if (av_opt_set_int_list(buffersink_ctx, "channel_layouts", channel_layouts, -1, AV_OPT_SEARCH_CHILDREN) < 0) {
-        qCritical() << "Could not set output sample format";
-      }
-
-      int target_sample_rate = current_audio_freq();
-
-      double playback_speed = timeline_info.speed * ftg->speed_;
-
-      if (qFuzzyCompare(playback_speed, 1.0)) {
-        avfilter_link(buffersrc_ctx, 0, buffersink_ctx, 0);
-      } else if (timeline_info.maintain_audio_pitch) {
-        AVFilterContext* previous_filter = buffersrc_ctx;
-        AVFilterContext* last_filter = buffersrc_ctx;
-
-        char speed_param[10];
-
-        double base = (playback_speed > 1.0) ? 2.0 : 0.5;
-
-        double speedlog = log(playback_speed) / log(base);
-        int whole2 = qFloor(speedlog);
-        speedlog -= whole2;
-
-        if (whole2 > 0) {
-          snprintf(speed_param, sizeof(speed_param), "%f", base);
-          for (int i=0;i<whole2;i++) {
-            AVFilterContext* tempo_filter = nullptr;
-            avfilter_graph_create_filter(&tempo_filter, avfilter_get_by_name("atempo"), "atempo", speed_param, nullptr, filter_graph);
-            avfilter_link(previous_filter, 0, tempo_filter, 0);
-            previous_filter = tempo_filter;
-          }
-        }
-
-        snprintf(speed_param, sizeof(speed_param), "%f", qPow(base, speedlog));
-        last_filter = nullptr;
-        avfilter_graph_create_filter(&last_filter, avfilter_get_by_name("atempo"), "atempo", speed_param, nullptr, filter_graph);
-        avfilter_link(previous_filter, 0, last_filter, 0);
-        //				}
-
-        avfilter_link(last_filter, 0, buffersink_ctx, 0);
+      // conformed samples are already at the sequence's rate, so need neither decoding nor filtering at 1x
+      const double speed = timeline_info.speed * ftg->speed_;
+      if (const auto conformed = ms->conformedAudio(); (conformed != nullptr) && !timeline_info.reverse
+          && qFuzzyCompare(speed, 1.0) && (conformed->sampleRate() == current_audio_freq())) {
+        conformed_audio_ = conformed;
       } else {
-        target_sample_rate = qRound64(target_sample_rate / playback_speed);
-        avfilter_link(buffersrc_ctx, 0, buffersink_ctx, 0);
-      }
-
-      int sample_rates[] = { target_sample_rate, 0 };
-      if (av_opt_set_int_list(buffersink_ctx, "sample_rates", sample_rates, 0, AV_OPT_SEARCH_CHILDREN) < 0) {
-        qCritical() << "Could not set output sample rates";
+        chestnut::playback::buildAudioFilterGraph(*filter_graph,
+                                                  *media_handling_.stream_,
+                                                  *media_handling_.codec_ctx_,
+                                                  current_audio_freq(),
+                                                  PLAYBACK_LAYOUT,
+                                                  speed,
+                                                  timeline_info.maintain_audio_pitch,
+                                                  buffersrc_ctx,
+                                                  buffersink_ctx);
       }
 
-      avfilter_graph_config(filter_graph, nullptr);
-
       audio_playback.reset = true;
     }
 
     media_handling_.frame_ = av_frame_alloc();
   }
 
+  if (!timeline_info.isVideo()) {
+    // staged samples are mixed until the clip is closed
+    mix_bus_ = chestnut::playback::AudioMixer::instance().addBus();
+  }
+
   for (const auto& eff : effects) {
     eff->open();
   }
@@ -466,16 +369,31 @@ void Clip::closeWorker()
 
   if ( (timeline_info.media != nullptr) && (timeline_info.media->type() == MediaType::FOOTAGE) ) {
     clearQueue();
+    // frame() may still hold either, so the worker is stopped before the decoder it uses is pooled
+    if (const auto reverse = std::atomic_exchange(&reverse_decoder_,
+                                                  std::shared_ptr<chestnut::playback::ReverseDecoder>())) {
+      reverse->stop();
+    }
+    converter_.reset();
+    conformed_audio_.reset();
     // clear resources allocated via libav
     avfilter_graph_free(&filter_graph);
-    avcodec_close(media_handling_.codec_ctx_);
-    avcodec_free_context(&media_handling_.codec_ctx_);
-    av_dict_free(&media_handling_.opts_);
-    avformat_close_input(&media_handling_.format_ctx_);
+    if (pkt_written) {
+      av_packet_unref(media_handling_.pkt_);
+      pkt_written = false;
+    }
+    // the decoder is kept open for the next clip of this footage
+    chestnut::playback::DecoderPool::instance().release(
+          std::atomic_exchange(&media_handling_.decoder_, chestnut::playback::DecoderContextPtr()));
   }
 
   av_frame_free(&media_handling_.frame_);
 
+  if (mix_bus_ != nullptr) {
+    chestnut::playback::AudioMixer::instance().removeBus(mix_bus_);
+    mix_bus_ = nullptr;
+  }
+
   reset();
 
   qInfo() << "Clip closed on track" << timeline_info.track_.load() << "name: " << name();
@@ -495,8 +413,13 @@ bool Clip::open(const bool open_multithreaded) {
   if (usesCacher()) {
     multithreaded = open_multithreaded;
     if (multithreaded) {
+      // open_lock is held from opening until the resources are freed
       if (open_lock.tryLock()) {
-        this->start((mediaType() == ClipType::VISUAL) ? QThread::HighPriority : QThread::TimeCriticalPriority);
+        is_open = true;
+        cache_info.caching = true;
+        cache_info.requested = false;
+        cache_info.reset = false;
+        schedule(decodePriority(false));
       }
     } else {
       finished_opening = false;
@@ -528,6 +451,9 @@ void Clip::close(const bool wait) {
     if (texture != nullptr) {
       texture = nullptr;
     }
+    planar_texture = nullptr;
+    prefetched_ = -1;
+    uploader_.reset();
 
     for (const auto& eff : effects) {
       if ( (eff != nullptr) && eff->is_open()) {
@@ -545,10 +471,12 @@ void Clip::close(const bool wait) {
     if (usesCacher()) {
       if (multithreaded) {
         cache_info.caching = false;
-        can_cache.wakeAll();
         if (wait) {
-          open_lock.lock();
-          open_lock.unlock();
+          // rather than wait on the scheduler, free up here once any running job has finished
+          QMutexLocker locker(&lock);
+          stopCaching();
+        } else {
+          schedule(decodePriority(false));
         }
       } else {
         closeWorker();
@@ -591,20 +519,31 @@ bool Clip::cache(const long playhead, const bool do_reset, const bool scrubbing,
 
   if (multithreaded) {
     cache_info.playhead = playhead;
-    cache_info.reset = do_reset;
+    // a reset stands until a job has acted on it
+    cache_info.reset = cache_info.reset || do_reset;
     cache_info.nests = nests;
     cache_info.scrubbing = scrubbing;
-    if (cache_info.reset && !queue.empty()) {
+    if (cache_info.reset) {
       cache_info.interrupt = true;
     }
-
-    can_cache.wakeAll();
+    cache_info.requested = true;
+    schedule(decodePriority(nests.isEmpty()));
   } else {
     cache_worker(playhead, do_reset, scrubbing, nests);
   }
   return true;
 }
 
+bool Clip::prefetch(const long playhead)
+{
+  if (!is_open || !multithreaded || (prefetched_ == playhead)) {
+    return false;
+  }
+  prefetched_ = playhead;
+  QVector<ClipPtr> empty;
+  return cache(playhead, false, false, empty);
+}
+
 /**
  * @brief Nudge the clip
  * @param pos The amount + direction to nudge the clip
@@ -817,6 +756,8 @@ void Clip::reset()
   media_handling_.codec_ = nullptr;
   media_handling_.codec_ctx_ = nullptr;
   texture = nullptr;
+  planar_texture = nullptr;
+  uploader_.reset();
 }
 
 void Clip::resetAudio()
@@ -870,18 +811,6 @@ void Clip::clearQueue() {
   }
 }
 
-void Clip::removeEarliestFromQueue() {
-  int earliest_frame = 0;
-  for (int i=1;i<queue.size();i++) {
-    // TODO/NOTE: this will not work on sped up AND reversed video
-    if (queue.at(i)->pts < queue.at(earliest_frame)->pts) {
-      earliest_frame = i;
-    }
-  }
-  av_frame_free(&queue[earliest_frame]);
-  queue.removeAt(earliest_frame);
-}
-
 TransitionPtr Clip::openingTransition() const
 {
   return getTransition(ClipTransitionType::OPENING);
@@ -898,7 +827,10 @@ TransitionPtr Clip::closingTransition() const
  */
 void Clip::frame(const long playhead, bool& texture_failed)
 {
-  if (finished_opening && (media_handling_.stream_ != nullptr) ) {
+  // the clip may be closed on a scheduler thread meanwhile, so what is decoded with is pinned until done with
+  const auto decoder = std::atomic_load(&media_handling_.decoder_);
+  const auto reverse_decoder = std::atomic_load(&reverse_decoder_);
+  if (finished_opening && (decoder != nullptr) ) {
     const auto ftg = timeline_info.media->object<Footage>();
     if (!ftg) {
       qDebug() << "Null footage, playhead:" << playhead << "name:" << name();
@@ -915,110 +847,51 @@ void Clip::frame(const long playhead, bool& texture_failed)
       return;
     }
 
-    const auto [target_pts, second_pts] = [&] {
-      int64_t target = qMax(static_cast<int64_t>(0), playhead_to_timestamp(playhead));
-      int64_t second = qRound64(av_q2d(av_inv_q(media_handling_.stream_->time_base)));
-      if (ms->fieldOrder() != media_handling::FieldOrder::PROGRESSIVE) {
-        target *= 2;
-        second *= 2;
-      }
-      return std::make_tuple(target, second);
-    }();
+    // decoder timestamps are in stream timebase, filtered frames' may be in a finer one
+    const int64_t stream_pts = qMax(static_cast<int64_t>(0), playhead_to_timestamp(playhead));
+    const int64_t second_pts = qRound64(av_q2d(av_inv_q(decoder->stream_->time_base)));
+    const int64_t target_pts = frameTimestamp(playhead);
 
-    AVFrame* target_frame = nullptr;
+    auto& frame_cache = chestnut::playback::FrameCache::instance();
+    chestnut::playback::FramePtr target_frame;
 
     bool reset = false;
     bool use_cache = true;
 
-    QMutexLocker locker(&queue_lock);
-    if (!queue.empty()) {
-      if (ms->infinite_length) {
-        target_frame = queue.at(0);
-      } else {
-        // correct frame may be somewhere else in the queue
-        int closest_frame = 0;
-
-        for (int i = 1; i < queue.size(); i++) {
-          Q_ASSERT(queue.at(i));
-          if (queue.at(i)->pts == target_pts) {
-            closest_frame = i;
-            break;
-          }
-          if ( (queue.at(i)->pts > queue.at(closest_frame)->pts) && (queue.at(i)->pts < target_pts) ) {
-            closest_frame = i;
-          }
-        }
-
-        // remove all frames earlier than this one from the queue
-        target_frame = queue.at(closest_frame);
-        int64_t next_pts = INT64_MAX;
-        int64_t minimum_ts = target_frame->pts;
-
-        if (global::config.previous_queue_type == FRAME_QUEUE_TYPE_SECONDS) {
-          minimum_ts -= qFloor(second_pts * global::config.previous_queue_size);
-        }
-
-        int previous_frame_count = 0;
-        for (int i = 0; i < queue.size(); i++) {
-          Q_ASSERT(queue.at(i));
-          if ( (queue.at(i)->pts > target_frame->pts) && (queue.at(i)->pts < next_pts) ) {
-            next_pts = queue.at(i)->pts;
-          }
-          if ( (queue.at(i) != target_frame) && ((queue.at(i)->pts > minimum_ts) == timeline_info.reverse)) {
-            if (global::config.previous_queue_type == FRAME_QUEUE_TYPE_SECONDS) {
-              av_frame_free(&queue[i]); // may be a little heavy for the main thread?
-              queue.removeAt(i);
-              i--;
-            } else {
-              // TODO sort from largest to smallest
-              previous_frame_count++;
-            }
-          }
-        }//for
-
-        if (global::config.previous_queue_type == FRAME_QUEUE_TYPE_FRAMES) {
-          while (previous_frame_count > qCeil(global::config.previous_queue_size)) {
-            int smallest = 0;
-            for (int i=1 ; i < queue.size(); i++) {
-              Q_ASSERT(queue.at(i));
-              if (queue.at(i)->pts < queue.at(smallest)->pts) {
-                smallest = i;
-              }
-            }
-            av_frame_free(&queue[smallest]);
-            queue.removeAt(smallest);
-            previous_frame_count--;
-          }//while
-        }
-
-        if (next_pts == INT64_MAX) {
-          next_pts = target_frame->pts + target_frame->pkt_duration;
+    if (reverse_decoder != nullptr) {
+      // the reverse decoder keeps its own buffer, topped up from its worker
+      target_frame = reverse_decoder->frame(target_pts);
+      if (target_frame == nullptr) {
+        if (global::config.fast_seeking) {
+          target_frame = reverse_decoder->closest(target_pts);
         }
-
+        texture_failed = true;
+      } else {
+        use_cache = false;
+      }
+    } else if (ms->infinite_length) {
+      target_frame = frame_cache.first(cache_key_);
+      reset = (target_frame == nullptr);
+    } else {
+      target_frame = frame_cache.find(cache_key_, target_pts);
+      if (target_frame == nullptr) {
         // we didn't get the exact timestamp
-        if ( (target_frame->pts != target_pts) && ( (target_pts < target_frame->pts) || (target_pts > next_pts) )) {
-          const int64_t pts_diff = qAbs(target_pts - target_frame->pts);
-          if (reached_end && target_pts > target_frame->pts) {
-            reached_end = false;
-            use_cache = false;
-          } else if (target_pts != last_invalid_ts && (target_pts < target_frame->pts || pts_diff > second_pts)) {
-            if (!global::config.fast_seeking) {
-              target_frame = nullptr;
-            }
-            reset = true;
-            last_invalid_ts = target_pts;
-          } else {
-            if (queue.size() >= max_queue_size) {
-              removeEarliestFromQueue();
-            }
-            ignore_reverse = true;
-            target_frame = nullptr;
+        const auto closest = frame_cache.closest(cache_key_, target_pts);
+        if (reached_end && (closest != nullptr) && (target_pts > closest->pts)) {
+          reached_end = false;
+          use_cache = false;
+          target_frame = closest;
+        } else if (decoder->canContinueTo(stream_pts, second_pts)) {
+          // decoder is nearly there, wait for it
+          ignore_reverse = true;
+        } else if (target_pts != last_invalid_ts) {
+          if (global::config.fast_seeking) {
+            target_frame = closest;
           }
-        } else {
+          reset = true;
+          last_invalid_ts = target_pts;
         }
       }
-    } else {
-      reset = true;
     }
 
     if ( (target_frame == nullptr) || reset) {
@@ -1026,7 +899,14 @@ void Clip::frame(const long playhead, bool& texture_failed)
       texture_failed = true;
     }
 
-    if (target_frame != nullptr) {
+    if ( (target_frame != nullptr) && (uploader_ == nullptr) ) {
+      uploader_ = std::make_unique<chestnut::playback::TextureUploader>();
+    }
+
+    if ( (target_frame != nullptr) && (planar_texture != nullptr) ) {
+      // effects on the RGB image wait for the clip to be reopened in RGB, see formatStale()
+      planar_texture->upload(*target_frame, *uploader_);
+    } else if (target_frame != nullptr) {
       const int nb_components = av_pix_fmt_desc_get(static_cast<enum AVPixelFormat>(pix_fmt))->nb_components;
       glPixelStorei(GL_UNPACK_ROW_LENGTH, target_frame->linesize[0] / nb_components);
 
@@ -1048,7 +928,8 @@ void Clip::frame(const long playhead, bool& texture_failed)
         }
       }
 
-      texture->setData(0, get_gl_pix_fmt_from_av(pix_fmt), QOpenGLTexture::UInt8, static_cast<const void*>(data));
+      uploader_->upload(*texture, get_gl_pix_fmt_from_av(pix_fmt), data,
+                        static_cast<size_t>(target_frame->linesize[0] * target_frame->height));
 
       if (copied) {
         delete [] data;
@@ -1056,13 +937,12 @@ void Clip::frame(const long playhead, bool& texture_failed)
 
       glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     }
-    locker.unlock();
 
     // get more frames
     QVector<ClipPtr> empty;
     if (use_cache) {
       cache(playhead, reset, false, empty);
-    } else {
+    } else if (reverse_decoder == nullptr) {
       qDebug() << "Not using cache, playhead:" << playhead << "name:" << name();
     }
   } else {
@@ -1550,43 +1430,98 @@ void Clip::refactorFrameRate(ComboAction* ca, double multiplier, bool change_tim
   }//for
 }
 
-void Clip::run() {
-  // open_lock is used to prevent the clip from being destroyed before the cacher has closed it properly
-  lock.lock();
-  finished_opening = false;
-  is_open = true;
-  cache_info.caching = true;
-  cache_info.interrupt = false;
-
-  if (openWorker()) {
-    qInfo() << "Cache thread starting";
-    while (cache_info.caching) {
-      can_cache.wait(&lock);
-      if (!cache_info.caching) {
-        break;
-      }
-      while (true) {
-        cache_worker(cache_info.playhead, cache_info.reset, cache_info.scrubbing, cache_info.nests);
-        if (multithreaded && cache_info.interrupt && (timeline_info.isVideo()) ) {
-          cache_info.interrupt = false;
-        } else {
-          break;
-        }
-      }//while
-    }//while
+void Clip::schedule(const chestnut::playback::DecodePriority& priority)
+{
+  if (scheduled_.exchange(true)) {
+    // the queued job acts on the latest request
+    return;
+  }
+  chestnut::playback::DecodeScheduler::instance().submit([clp = weak_from_this()] {
+    if (auto c = clp.lock()) {
+      c->service();
+    }
+  }, priority);
+}
 
-    qWarning() << "caching thread stopped";
 
-    closeWorker();
+void Clip::service()
+{
+  QMutexLocker locker(&lock);
+  scheduled_ = false;
+
+  if (!cache_info.caching) {
+    stopCaching();
+    return;
+  }
+
+  if (!finished_opening) {
+    cache_info.interrupt = false;
+    if (!openWorker()) {
+      qCritical() << "Failed to open worker";
+      // free what was opened and allow another attempt
+      cache_info.caching = false;
+      stopCaching();
+      return;
+    }
+  }
+
+  if (!cache_info.requested) {
+    return;
+  }
+  cache_info.requested = false;
+  while (true) {
+    const bool reset = cache_info.reset;
+    cache_info.reset = false;
+    cache_worker(cache_info.playhead, reset, cache_info.scrubbing, cache_info.nests);
+    if (cache_info.interrupt && timeline_info.isVideo()) {
+      cache_info.interrupt = false;
+    } else {
+      break;
+    }
+  }//while
+}
 
-    lock.unlock();
+
+void Clip::stopCaching()
+{
+  // open_lock is used to prevent the clip from being destroyed before it has been closed properly
+  if (is_open) {
+    closeWorker();
     open_lock.unlock();
-  } else {
-    qCritical() << "Failed to open worker";
   }
 }
 
 
+chestnut::playback::DecodePriority Clip::decodePriority(const bool visible) const
+{
+  chestnut::playback::DecodePriority priority;
+  if (sequence != nullptr) {
+    // from either side, as the playhead may be moving backwards
+    const auto in = static_cast<int64_t>(timelineInWithTransition());
+    const auto out = static_cast<int64_t>(timelineOutWithTransition());
+    priority.distance_ = qMax(static_cast<int64_t>(0), qMax(in - sequence->playhead_, sequence->playhead_ - out + 1));
+  }
+  priority.visible_ = visible && (priority.distance_ == 0);
+  priority.audio_ = !timeline_info.isVideo();
+  return priority;
+}
+
+
+bool Clip::imageEffects() const
+{
+  return std::any_of(effects.cbegin(), effects.cend(), [] (const EffectPtr& eff) {
+    return (eff != nullptr) && eff->hasCapability(Capability::IMAGE);
+  });
+}
+
+
+bool Clip::useProxy(const project::FootageStream& ms)
+{
+  // export always renders from the originals
+  return global::config.use_proxies && !e_rendering && (ms.proxy_status_ == project::ProxyStatus::READY);
+}
+
+
 void Clip::apply_audio_effects(const double timecode_start, AVFrame* frame, const int nb_bytes, QVector<ClipPtr>& nests)
 {
   // perform all audio effects
@@ -1594,7 +1529,7 @@ void Clip::apply_audio_effects(const double timecode_start, AVFrame* frame, cons
 
   for (const auto& e : effects) {
     if (e != nullptr && e->is_enabled()) {
-      e->process_audio(timecode_start, timecode_end, frame->data[0], nb_bytes, 2);
+      e->process_audio(timecode_start, timecode_end, frame->data[0], nb_bytes, frame->channels);
     }
   }
   if (transition_.opening_ != nullptr) {
@@ -1638,6 +1573,34 @@ void Clip::apply_audio_effects(const double timecode_start, AVFrame* frame, cons
 
 
 
+bool Clip::take_conformed_audio(AVFrame& frame)
+{
+  Q_ASSERT(conformed_audio_);
+  const auto remaining = conformed_audio_->length() - audio_playback.conform_position;
+  if (remaining <= 0) {
+    return false;
+  }
+  frame.format = SAMPLE_FORMAT;
+  frame.channel_layout = AV_CH_LAYOUT_STEREO;
+  frame.channels = project::ConformedAudio::CHANNELS;
+  frame.sample_rate = current_audio_freq();
+  frame.nb_samples = static_cast<int>(qMin(static_cast<int64_t>(AUDIO_SAMPLES), remaining));
+  if (const auto ret = av_frame_get_buffer(&frame, 0); ret < 0) {
+    av_strerror(ret, err.data(), ERR_LEN);
+    qCritical() << "Could not allocate buffer for conformed audio, msg =" << err.data();
+    return false;
+  }
+  chestnut::playback::kernel::toS16(conformed_audio_->samples(audio_playback.conform_position),
+                                    reinterpret_cast<int16_t*>(frame.data[0]),
+                                    static_cast<size_t>(frame.nb_samples * frame.channels));
+  // timed as a decoded frame would be, for the offset into it the playhead starts at
+  const double secs = static_cast<double>(audio_playback.conform_position) / current_audio_freq();
+  frame.pts = seconds_to_timestamp(secs);
+  audio_playback.conform_position += frame.nb_samples;
+  return true;
+}
+
+
 long Clip::playhead_to_frame(const long playhead) const noexcept
 {
   return (qMax(0L, playhead - timelineInWithTransition()) + clipInWithTransition());
@@ -1649,6 +1612,14 @@ int64_t Clip::playhead_to_timestamp(const long playhead) const noexcept
   return seconds_to_timestamp(playhead_to_seconds(playhead));
 }
 
+
+int64_t Clip::frameTimestamp(const long playhead) const noexcept
+{
+  const int64_t ts = qMax(static_cast<int64_t>(0), playhead_to_timestamp(playhead));
+  // deinterlacing doubles the timebase of the frames
+  return deinterlacing_ ? (ts * 2) : ts;
+}
+
 bool Clip::retrieve_next_frame(AVFrame& frame)
 {
   int result = 0;
@@ -1667,7 +1638,7 @@ bool Clip::retrieve_next_frame(AVFrame& frame)
       if (read_ret >= 0) {
         pkt_written = true;
       }
-    } while (read_ret >= 0 && media_handling_.pkt_->stream_index != timeline_info.media_stream);
+    } while (read_ret >= 0 && media_handling_.pkt_->stream_index != media_handling_.stream_->index);
 
     if (read_ret >= 0) {
       int send_ret = avcodec_send_packet(media_handling_.codec_ctx_, media_handling_.pkt_);
@@ -1679,6 +1650,7 @@ bool Clip::retrieve_next_frame(AVFrame& frame)
     } else {
       if (read_ret == AVERROR_EOF) {
         int send_ret = avcodec_send_packet(media_handling_.codec_ctx_, nullptr);
+        media_handling_.decoder_->drained_ = true;
         if (send_ret < 0) {
           av_strerror(send_ret, err.data(), ERR_LEN);
           qCritical() << "Failed to send packet to decoder, msg =" << err.data();
@@ -1696,6 +1668,8 @@ bool Clip::retrieve_next_frame(AVFrame& frame)
       qCritical() << "Failed to receive packet from decoder." << receive_ret;
     }
     result = receive_ret;
+  } else {
+    media_handling_.decoder_->last_pts_ = frame.pts;
   }
 
   return result == 0;
@@ -1738,6 +1712,14 @@ void Clip::cache_audio_worker(const bool scrubbing, QVector<ClipPtr> &nests)
   long timeline_out = timelineOutWithTransition();
   long target_frame = audio_playback.target_frame;
 
+  if (mix_bus_ == nullptr) {
+    qWarning() << "Audio clip has no mix bus, track:" << timeline_info.track_.load();
+    return;
+  }
+  auto& mixer = chestnut::playback::AudioMixer::instance();
+  // byte offset in the sequence's audio of the sample next output
+  const auto mixer_offset = [&mixer] { return static_cast<int>(mixer.position() * static_cast<int64_t>(sizeof(int16_t))); };
+
   long frame_skip = 0;
   double last_fr = sequence->frameRate();
   if (!nests.isEmpty()) {
@@ -1780,7 +1762,7 @@ void Clip::cache_audio_worker(const bool scrubbing, QVector<ClipPtr> &nests)
         if (audio_playback.buffer_write == 0) {
           audio_playback.buffer_write = get_buffer_offset_from_frame(last_fr, qMax(timeline_in, target_frame));
         }
-        const int offset = audio_ibuffer_read - audio_playback.buffer_write;
+        const int offset = mixer_offset() - audio_playback.buffer_write;
         if (offset > 0) {
           audio_playback.buffer_write += offset;
           audio_playback.frame_sample_index += offset;
@@ -1799,7 +1781,7 @@ void Clip::cache_audio_worker(const bool scrubbing, QVector<ClipPtr> &nests)
           int loop = 0;
 
           if (timeline_info.reverse && !audio_playback.just_reset) {
-            avcodec_flush_buffers(media_handling_.codec_ctx_);
+            media_handling_.decoder_->flush();
             reached_end = false;
             int64_t backtrack_seek = qMax(audio_playback.reverse_target
                                           - static_cast<int64_t>(av_q2d(av_inv_q(media_handling_.stream_->time_base))), static_cast<int64_t>(0));
@@ -1809,6 +1791,11 @@ void Clip::cache_audio_worker(const bool scrubbing, QVector<ClipPtr> &nests)
           do {
             av_frame_unref(av_frame);
 
+            if (conformed_audio_ != nullptr) {
+              reached_end = !take_conformed_audio(*av_frame);
+              break;
+            }
+
             int ret;
 
             while ((ret = av_buffersink_get_frame(buffersink_ctx, av_frame)) == AVERROR(EAGAIN)) {
@@ -1946,7 +1933,7 @@ void Clip::cache_audio_worker(const bool scrubbing, QVector<ClipPtr> &nests)
           }
         }
 
-        const int offset = audio_ibuffer_read - audio_playback.buffer_write;
+        const int offset = mixer_offset() - audio_playback.buffer_write;
         if (offset > 0) {
           audio_playback.buffer_write += offset;
           audio_playback.frame_sample_index += offset;
@@ -1982,32 +1969,31 @@ void Clip::cache_audio_worker(const bool scrubbing, QVector<ClipPtr> &nests)
     }
 
     // mix audio into internal buffer
+    const long buffer_timeline_out = get_buffer_offset_from_frame(sequence->frameRate(), timeline_out);
     if (av_frame->nb_samples == 0) {
+      // nothing more will be staged, so don't hold back the other clips
+      mixer.finish(*mix_bus_, true);
+      mixer.mix(!audio_rendering);
       break;
     }
 
-    // have audio data so write to audio_data_buffer
-    long buffer_timeline_out = get_buffer_offset_from_frame(sequence->frameRate(), timeline_out);
-    audio_write_lock.lock();
-
-    while (audio_playback.frame_sample_index < nb_bytes
-           && audio_playback.buffer_write < audio_ibuffer_read+(AUDIO_IBUFFER_SIZE>>1)
-           && audio_playback.buffer_write < buffer_timeline_out) {
-      int upper_byte_index = (audio_playback.buffer_write + 1) % AUDIO_IBUFFER_SIZE;
-      int lower_byte_index = (audio_playback.buffer_write) % AUDIO_IBUFFER_SIZE;
-      const auto old_sample = static_cast<qint16>( ((audio_ibuffer[upper_byte_index] & 0xFF) << 8)
-                                                   | (audio_ibuffer[lower_byte_index] & 0xFF));
-      const auto new_sample = static_cast<qint16>(((av_frame->data[0][audio_playback.frame_sample_index + 1] & 0xFF) << 8)
-          | (av_frame->data[0][audio_playback.frame_sample_index] & 0xFF));
-      const qint16 mixed_sample = mix_audio_sample(old_sample, new_sample);
-
-      audio_ibuffer[upper_byte_index] = static_cast<quint8>((mixed_sample >> 8) & 0xFF);
-      audio_ibuffer[lower_byte_index] = static_cast<quint8>(mixed_sample & 0xFF);
-
-      audio_playback.buffer_write += 2;
-      audio_playback.frame_sample_index += 2;
-    }//while
-    audio_write_lock.unlock();
+    // have audio data so stage it for the mixer, as far ahead of the output as it mixes
+    const int64_t buffer_limit = qMin(static_cast<int64_t>(buffer_timeline_out),
+                                      static_cast<int64_t>(mixer_offset())
+                                      + static_cast<int64_t>(mixer.lookahead() * sizeof(int16_t)));
+    if ( (audio_playback.frame_sample_index < nb_bytes) && (audio_playback.buffer_write < buffer_limit) ) {
+      const auto len = static_cast<size_t>(qMin(static_cast<int64_t>(nb_bytes - audio_playback.frame_sample_index),
+                                                buffer_limit - audio_playback.buffer_write)) / sizeof(int16_t);
+      const size_t staged = mixer.stage(*mix_bus_,
+                                        audio_playback.buffer_write / static_cast<int>(sizeof(int16_t)),
+                                        reinterpret_cast<const int16_t*>(av_frame->data[0]
+                                                                         + audio_playback.frame_sample_index),
+                                        len);
+      audio_playback.buffer_write += static_cast<int>(staged * sizeof(int16_t));
+      audio_playback.frame_sample_index += static_cast<int>(staged * sizeof(int16_t));
+    }
+    mixer.finish(*mix_bus_, audio_playback.buffer_write >= buffer_timeline_out);
+    mixer.mix(!audio_rendering);
 
     if (scrubbing && (audio_thread != nullptr) ) {
       audio_thread->notifyReceiver();
@@ -2037,64 +2023,53 @@ void Clip::cache_video_worker(const long playhead)
 {
   int read_ret, send_ret, retr_ret;
 
-  const int64_t target_pts = seconds_to_timestamp(playhead_to_seconds(playhead));
-
-  const int limit = [this]{
-    int lim = max_queue_size;
-    if (ignore_reverse) {
-      // waiting for one frame
-      lim = queue.size() + 1;
-    } else if (timeline_info.reverse) {
-      lim *= 2;
-    }
-    return lim;
-  }();
-
-  if (queue.size() >= limit) {
+  auto& frame_cache = chestnut::playback::FrameCache::instance();
+  const int64_t target_pts = frameTimestamp(playhead);
+  if (reverse_decoder_ != nullptr) {
+    reverse_decoder_->decode(target_pts);
     return;
   }
-  const bool reverse = (timeline_info.reverse && !ignore_reverse);
+
+  const bool one_frame = ignore_reverse;
   ignore_reverse = false;
 
-  int64_t smallest_pts = INT64_MAX;
-  if (reverse && !queue.empty()) {
-    const int64_t quarter_sec = qRound64(av_q2d(av_inv_q(media_handling_.stream_->time_base))) >> 2;
-    for (const auto& q : queue) {
-      Q_ASSERT(q);
-      smallest_pts = qMin(smallest_pts, q->pts);
-    }
-    avcodec_flush_buffers(media_handling_.codec_ctx_);
-    reached_end = false;
-    const int64_t seek_ts = qMax(static_cast<int64_t>(0), smallest_pts - quarter_sec);
-    av_seek_frame(media_handling_.format_ctx_, media_handling_.stream_->index, seek_ts, AVSEEK_FLAG_BACKWARD);
-  } else {
-    smallest_pts = target_pts;
+  if (infinite_length_) {
+    if (frame_cache.first(cache_key_) != nullptr) {
+      return;
+    }
+  } else if (!one_frame) {
+    // frames decoded by this or any other clip of the footage needn't be decoded again
+    const auto cached = frame_cache.run(cache_key_, target_pts, upcoming_frames_);
+    if (cached.has_value() && (cached->after_ >= upcoming_frames_)) {
+      return;
+    }
   }
 
   if (multithreaded && cache_info.interrupt) { // ignore interrupts for now
     cache_info.interrupt = false;
   }
 
-  while (true) {
-    AVFrame* frame = av_frame_alloc();
-    Q_ASSERT(frame);
+  // filtered frames are only held until converted into a pooled frame for the cache
+  std::unique_ptr<AVFrame, decltype(&freeFrame)> filtered(av_frame_alloc(), freeFrame);
+  Q_ASSERT(filtered);
 
-    while ((retr_ret = av_buffersink_get_frame(buffersink_ctx, frame)) == AVERROR(EAGAIN)) {
-      if (multithreaded && cache_info.interrupt) return; // abort
+  int upcoming = 0;
+  while (true) {
+    while ((retr_ret = av_buffersink_get_frame(buffersink_ctx, filtered.get())) == AVERROR(EAGAIN)) {
+      if (multithreaded && cache_info.interrupt) {
+        return; // abort
+      }
 
       AVFrame* send_frame = media_handling_.frame_;
       Q_ASSERT(send_frame);
       read_ret = (use_existing_frame) ? 0 : retrieve_next_frame(*send_frame);
       use_existing_frame = false;
       if (read_ret >= 0) {
-        bool send_it = true;
-        if (send_it) {
-          if ((send_ret = av_buffersrc_add_frame_flags(buffersrc_ctx, send_frame, AV_BUFFERSRC_FLAG_KEEP_REF)) < 0) {
-            av_strerror(send_ret, err.data(), ERR_LEN);
-            qCritical() << "Failed to add frame to buffer source, msg =" << err.data();
-            av_frame_unref(media_handling_.frame_);
-            break;
-          }
+        if ((send_ret = av_buffersrc_add_frame_flags(buffersrc_ctx, send_frame, AV_BUFFERSRC_FLAG_KEEP_REF)) < 0) {
+          av_strerror(send_ret, err.data(), ERR_LEN);
+          qCritical() << "Failed to add frame to buffer source, msg =" << err.data();
+          av_frame_unref(media_handling_.frame_);
+          break;
         }
         av_frame_unref(media_handling_.frame_);
       } else {
@@ -2115,40 +2090,24 @@ void Clip::cache_video_worker(const long playhead)
         av_strerror(retr_ret, err.data(), ERR_LEN);
         qCritical() << "Failed to retrieve frame from buffersink, msg =" << err.data();
       }
-      av_frame_free(&frame);
       break;
     }
 
-    if (reverse && (( (smallest_pts == target_pts) && (frame->pts >= smallest_pts) )
-                    || ((smallest_pts != target_pts) && (frame->pts > smallest_pts)))) {
-      av_frame_free(&frame);
+    AVFrame* frame = converter_->convert(*filtered);
+    av_frame_unref(filtered.get());
+    if (frame == nullptr) {
+      qCritical() << "Failed to convert frame, name:" << name();
       break;
     }
+    const int64_t pts = frame->pts;
+    frame_cache.insert(cache_key_, frame, frame_duration_);
 
-    QMutexLocker locker(&queue_lock);
-    queue.append(frame);
-
-    const auto ftg = timeline_info.media->object<Footage>();
-    if (const auto ms = ftg->video_stream_from_file_index(timeline_info.media_stream);
-        (!ms->infinite_length && (!reverse && queue.size() == limit))) {
-      // see if we got the frame we needed (used for speed ups primarily)
-      bool found = false;
-      for (const auto& q : queue) {
-        Q_ASSERT(q);
-        if (q->pts >= target_pts) {
-          found = true;
-          break;
-        }
-      }
-      if (found) {
-        locker.unlock();
-        break;
-      }
-
-      // remove earliest frame and loop to store another
-      removeEarliestFromQueue();
+    if (infinite_length_) {
+      break;
+    }
+    if ((pts >= target_pts) && (one_frame || (++upcoming >= upcoming_frames_))) {
+      break;
     }
-    locker.unlock();
     if (multithreaded && cache_info.interrupt) { // abort
       return;
     }
@@ -2219,9 +2178,6 @@ void Clip::reset_cache(const long target_frame) {
       use_existing_frame = false;
     } else {
       if (media_handling_.stream_->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-        // clear current queue
-        clearQueue();
-
         // seeks to nearest keyframe (target_frame represents internal clip frame)
         const int64_t target_ts = seconds_to_timestamp(playhead_to_seconds(target_frame));
         int64_t seek_ts = target_ts;
@@ -2230,13 +2186,40 @@ void Clip::reset_cache(const long target_frame) {
           seek_ts -= timebase_half_second;
         }
 
+        // every frame of a proxy is a keyframe
+        const auto index = proxy_ ? nullptr : ms->keyframeIndex();
+        const auto keyframe = (index != nullptr) ? index->keyframeBefore(target_ts) : std::nullopt;
+
+        if (!timeline_info.reverse) {
+          // the (pooled) decoder is already within the target's GOP, or just short of the target.
+          // decoding on is cheaper than a seek
+          const int64_t window = keyframe.has_value() ? (target_ts - keyframe->pts_) : timebase_half_second;
+          if (media_handling_.decoder_->canContinueTo(target_ts, window)) {
+            reached_end = false;
+            use_existing_frame = false;
+            return;
+          }
+        }
+
+        if (keyframe.has_value()) {
+          // the index gives the exact keyframe, no need to guess and check
+          media_handling_.decoder_->flush();
+          reached_end = false;
+          av_frame_unref(media_handling_.frame_);
+          av_seek_frame(media_handling_.format_ctx_, media_handling_.stream_->index, keyframe->pts_, AVSEEK_FLAG_BACKWARD);
+          use_existing_frame = false;
+          qDebug() << "Seeked to indexed keyframe, frames to decode:"
+                   << project::KeyframeIndex::framesToDecode(keyframe.value(), target_ts, frame_duration_);
+          return;
+        }
+
         while (true) {
           // flush ffmpeg codecs
-          avcodec_flush_buffers(media_handling_.codec_ctx_);
+          media_handling_.decoder_->flush();
           reached_end = false;
 
           if (seek_ts > 0) {
-            av_seek_frame(media_handling_.format_ctx_, ms->file_index, seek_ts, AVSEEK_FLAG_BACKWARD);
+            av_seek_frame(media_handling_.format_ctx_, media_handling_.stream_->index, seek_ts, AVSEEK_FLAG_BACKWARD);
 
             av_frame_unref(media_handling_.frame_);
             Q_ASSERT(media_handling_.frame_);
@@ -2253,14 +2236,14 @@ void Clip::reset_cache(const long target_frame) {
             seek_ts -= timebase_half_second;
           } else {
             av_frame_unref(media_handling_.frame_);
-            av_seek_frame(media_handling_.format_ctx_, ms->file_index, 0, AVSEEK_FLAG_BACKWARD);
+            av_seek_frame(media_handling_.format_ctx_, media_handling_.stream_->index, 0, AVSEEK_FLAG_BACKWARD);
             use_existing_frame = false;
             break;
           }
         }
       } else if (media_handling_.stream_->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
         // flush ffmpeg codecs
-        avcodec_flush_buffers(media_handling_.codec_ctx_);
+        media_handling_.decoder_->flush();
         reached_end = false;
 
         // seek (target_frame represents timeline timecode in frames, not clip timecode)
@@ -2271,7 +2254,12 @@ void Clip::reset_cache(const long target_frame) {
           audio_playback.reverse_target = timestamp;
           timestamp -= av_q2d(av_inv_q(media_handling_.stream_->time_base));
         }
-        av_seek_frame(media_handling_.format_ctx_, ms->file_index, timestamp, AVSEEK_FLAG_BACKWARD);
+        if (conformed_audio_ != nullptr) {
+          audio_playback.conform_position = qMax(static_cast<int64_t>(0),
+                                                 qRound64(playhead_to_seconds(target_frame) * current_audio_freq()));
+        } else {
+          av_seek_frame(media_handling_.format_ctx_, media_handling_.stream_->index, timestamp, AVSEEK_FLAG_BACKWARD);
+        }
         audio_playback.target_frame = target_frame;
         audio_playback.frame_sample_index = -1;
         audio_playback.just_reset = true;
@@ -18,14 +18,12 @@
 #ifndef CLIP_H
 #define CLIP_H
 
-#include <QWaitCondition>
 #include <QMutex>
 #include <QVector>
 #include <QOpenGLFramebufferObject>
 #include <QOpenGLTexture>
 #include <memory>
 #include <QMetaType>
-#include <QThread>
 
 #include "project/effect.h"
 #include "project/sequence.h"
@@ -33,11 +31,24 @@
 #include "project/footage.h"
 #include "project/media.h"
 #include "project/timelineinfo.h"
+#include "playback/decoderpool.h"
+#include "playback/framecache.h"
+#include "playback/reversedecoder.h"
+#include "playback/decodescheduler.h"
+#include "playback/videofilter.h"
+#include "playback/textureuploader.h"
+#include "playback/planartexture.h"
+#include "playback/audiomixer.h"
 
 
 class Transition;
 class ComboAction;
 
+namespace chestnut::playback
+{
+  class ClipAudioSource;
+}
+
 struct AVFormatContext;
 struct AVStream;
 struct AVCodec;
@@ -48,7 +59,6 @@ struct SwsContext;
 struct SwrContext;
 struct AVFilterGraph;
 struct AVFilterContext;
-struct AVDictionary;
 
 
 using ClipPtr = std::shared_ptr<Clip>;
@@ -70,8 +80,7 @@ enum class ClipType {
 
 class Clip : public project::SequenceItem,
     public std::enable_shared_from_this<Clip>,
-    public project::IXMLStreamer,
-    protected QThread
+    public project::IXMLStreamer
 {
 public:
   explicit Clip(SequencePtr s);
@@ -93,6 +102,18 @@ public:
      * @return true==caching used
      */
   bool usesCacher() const;
+  /**
+   * @brief Identify if the frames cached are no longer in a format the clip can show, e.g. an effect
+   *        needing the RGB image was added to a clip kept in YUV
+   * @return true==clip is to be reopened
+   */
+  bool formatStale() const;
+  /**
+   * @brief Identify if the clip is reading from the original footage when it should be reading its proxy, or
+   *        vice-versa
+   * @return true==clip is to be reopened
+   */
+  bool sourceStale() const;
   /**
    * @brief open_worker
    * @return true==success
@@ -131,6 +152,12 @@ public:
    * @return  true==cached
    */
   bool cache(const long playhead, const bool do_reset, const bool scrubbing, QVector<ClipPtr>& nests);
+  /**
+   * @brief Decode the frames of an open clip the playhead is about to reach, without it being shown
+   * @param playhead  Frame of the sequence the playhead will enter the clip at
+   * @return true==decode requested
+   */
+  bool prefetch(const long playhead);
   /**
    * @brief Nudge the clip
    * @param pos The amount + direction to nudge the clip
@@ -202,7 +229,6 @@ public:
 
   // queue functions
   void clearQueue();
-  void removeEarliestFromQueue();
 
 
   [[deprecated("Use Clip::getTransition")]]
@@ -307,8 +333,10 @@ public:
     AVCodecContext* codec_ctx_ {nullptr};
     AVPacket* pkt_ {nullptr};
     AVFrame* frame_ {nullptr};
-    AVDictionary* opts_ {nullptr};
     long calculated_length_ {-1};
+    // leased from the DecoderPool. format_ctx_, stream_, codec_ and codec_ctx_ belong to this. Set and cleared
+    // atomically, as frame() pins it while the clip may be closed on another thread
+    chestnut::playback::DecoderContextPtr decoder_ {nullptr};
   } media_handling_; //FIXME: the use of this lot should really be its own library/class
 
   // temporary variables
@@ -322,10 +350,10 @@ public:
   // caching functions
   bool use_existing_frame;
   bool multithreaded{};
-  QWaitCondition can_cache;
-  int max_queue_size{};
+  // frames to have decoded ahead of the playhead. reversed clips buffer whole GOPs instead
+  int upcoming_frames_{};
+  // audio working frames. decoded video is kept in the FrameCache
   QVector<AVFrame*> queue;
-  QMutex queue_lock;
   QMutex lock;
   QMutex open_lock;
   int64_t last_invalid_ts{};
@@ -338,6 +366,8 @@ public:
   // video playback variables
   QOpenGLFramebufferObject** fbo;
   std::unique_ptr<QOpenGLTexture> texture = nullptr;
+  // used instead of texture for frames kept in YUV
+  std::unique_ptr<chestnut::playback::PlanarTexture> planar_texture = nullptr;
   long texture_frame{};
 
   struct AudioPlaybackInfo {
@@ -348,6 +378,8 @@ public:
     bool reset = false;
     bool just_reset = false;
     long target_frame = -1;
+    // sample of each channel next taken from the conformed audio
+    int64_t conform_position = 0;
   } audio_playback;
 
   struct {
@@ -357,11 +389,11 @@ public:
 
 
 protected:
-  virtual void run() override;
   static int32_t next_id;
 private:
   friend class ClipTest;
   friend class ObjectClip;
+  friend class chestnut::playback::ClipAudioSource;
   struct {
     bool caching = false;
     // must be set before caching
@@ -369,10 +401,32 @@ private:
     bool reset = false;
     bool scrubbing = false;
     bool interrupt = false;
+    // cache() has been called since the last caching
+    bool requested = false;
     QVector<ClipPtr> nests = QVector<ClipPtr>();
   } cache_info;
-
-
+  // a job of this clip is waiting in the DecodeScheduler
+  std::atomic_bool scheduled_{false};
+
+
+  chestnut::playback::FrameCacheKey cache_key_;
+  int64_t frame_duration_{1};
+  // converts filtered video frames for upload, into pooled buffers
+  std::unique_ptr<chestnut::playback::FrameConverter> converter_;
+  // uploads frames into texture, created and destroyed with it in the render thread
+  std::unique_ptr<chestnut::playback::TextureUploader> uploader_;
+  // decodes and buffers whole GOPs of a reversed video clip. Set and cleared atomically, as frame() pins it
+  std::shared_ptr<chestnut::playback::ReverseDecoder> reverse_decoder_;
+  bool infinite_length_{false};
+  bool deinterlacing_{false};
+  // video is being read from the footage's proxy
+  bool proxy_{false};
+  // playhead of the last prefetch() since opening
+  long prefetched_{-1};
+  // audio samples staged for the mixer, held while open
+  chestnut::playback::MixBusPtr mix_bus_;
+  // audio read in place of decoding, when the footage has been conformed to the sequence's rate
+  project::ConformedAudioPtr conformed_audio_;
   std::atomic_bool finished_opening{false};
   bool pkt_written{};
   int32_t id_{-1};
@@ -382,9 +436,21 @@ private:
   bool created_object_{false};
 
   void apply_audio_effects(const double timecode_start, AVFrame* frame, const int nb_bytes, QVector<ClipPtr>& nests);
+  /**
+   * @brief       Take the next samples from the conformed audio, in place of the filter graph
+   * @param frame Unreferenced, to be filled with 16-bit samples
+   * @return      false==no more samples
+   */
+  bool take_conformed_audio(AVFrame& frame);
 
   long playhead_to_frame(const long playhead) const noexcept;
   int64_t playhead_to_timestamp(const long playhead) const noexcept;
+  /**
+   * @brief           Obtain the timestamp of the decoded, and filtered, frame at a playhead position
+   * @param playhead
+   * @return          timestamp
+   */
+  int64_t frameTimestamp(const long playhead) const noexcept;
   bool retrieve_next_frame(AVFrame& frame);
   double playhead_to_seconds(const long playhead) const noexcept;
   int64_t seconds_to_timestamp(const double seconds) const noexcept;
@@ -406,6 +472,36 @@ private:
    * @param target_frame
    */
   void reset_cache(const long target_frame);
+  /**
+   * @brief           Queue a job on the DecodeScheduler to open, cache or close the clip, unless one is already queued
+   * @param priority
+   */
+  void schedule(const chestnut::playback::DecodePriority& priority);
+  /**
+   * @brief The job run by the DecodeScheduler. Opens, caches or closes the clip as last requested
+   */
+  void service();
+  /**
+   * @brief   Stop caching and free the resources of a clip opened multithreaded
+   */
+  void stopCaching();
+  /**
+   * @brief         How urgent a job of this clip is at the sequence's playhead
+   * @param visible The clip is in the sequence shown, not a nested one
+   * @return        priority
+   */
+  chestnut::playback::DecodePriority decodePriority(const bool visible) const;
+  /**
+   * @brief   Identify if any effect works on the RGB image of a frame
+   * @return  true==has such an effect
+   */
+  bool imageEffects() const;
+  /**
+   * @brief     Identify if the video of a footage stream is to be read from its proxy
+   * @param ms  Video stream of the clip's footage
+   * @return    true==read from proxy
+   */
+  static bool useProxy(const project::FootageStream& ms);
   bool loadInEffect(QXmlStreamReader& stream);
   TransitionPtr loadTransition(QXmlStreamReader& stream);
   void linkClips(const QVector<ClipPtr>& linked_clips) const;
@@ -0,0 +1,180 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "conformedaudio.h"
+
+#include <QDataStream>
+#include <algorithm>
+#include <vector>
+
+#include "io/audiodecoder.h"
+#include "debug.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+using project::ConformedAudio;
+using chestnut::io::AudioDecoder;
+
+namespace
+{
+  constexpr quint32 MAGIC = 0x43464155; // CFAU
+  constexpr quint32 VERSION = 1;
+  // magic, version, sample rate and channels precede the length
+  constexpr qint64 LENGTH_OFFSET = 16;
+  constexpr qint64 HEADER_BYTES = LENGTH_OFFSET + 8;
+  constexpr qint64 FRAME_BYTES = ConformedAudio::CHANNELS * static_cast<qint64>(sizeof(float));
+}
+
+
+bool ConformedAudio::build(const QString& location, const int stream_index, const int sample_rate,
+                           const QString& path, const std::atomic_bool& running)
+{
+  if (sample_rate <= 0) {
+    return false;
+  }
+  AudioDecoder decoder;
+  if (!decoder.open(location, stream_index, AV_CH_LAYOUT_STEREO, sample_rate)) {
+    qWarning() << "Could not conform audio, path:" << location << "index:" << stream_index;
+    return false;
+  }
+  const AVStream* stream = decoder.stream();
+
+  // written aside, so an abandoned or failed conform is never mistaken for a whole one
+  const QString partial_path = path + ".part";
+  QFile file(partial_path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << "Could not open conformed audio file for writing, path:" << partial_path;
+    return false;
+  }
+  QDataStream header(&file);
+  header << MAGIC << VERSION << static_cast<qint32>(sample_rate) << static_cast<qint32>(CHANNELS)
+         << static_cast<qint64>(0);
+
+  int64_t length = 0;
+  // samples to drop, or when negative silence to insert, so that the first sample is the start of the stream
+  int64_t skip = 0;
+  bool first = true;
+  const auto write = [&] (const float* samples, const int count, const int64_t pts) {
+    if (first) {
+      const auto start = std::max(static_cast<int64_t>(0), stream->start_time);
+      const double secs = (pts != AV_NOPTS_VALUE) ? (pts - start) * av_q2d(stream->time_base) : 0.0;
+      skip = -qRound64(secs * sample_rate);
+      first = false;
+    }
+    auto from = samples;
+    auto remaining = static_cast<int64_t>(count);
+    if (skip > 0) {
+      const auto skipped = std::min(skip, remaining);
+      from += skipped * CHANNELS;
+      remaining -= skipped;
+      skip -= skipped;
+    }
+    if (skip < 0) {
+      const std::vector<float> silence(static_cast<size_t>(-skip * CHANNELS), 0.0f);
+      file.write(reinterpret_cast<const char*>(silence.data()), -skip * FRAME_BYTES);
+      length -= skip;
+      skip = 0;
+    }
+    file.write(reinterpret_cast<const char*>(from), remaining * FRAME_BYTES);
+    length += remaining;
+  };
+
+  if (!decoder.decode(write, running) || !file.seek(LENGTH_OFFSET)) {
+    file.remove();
+    return false;
+  }
+  header << static_cast<qint64>(length);
+  if ( (header.status() != QDataStream::Ok) || (file.error() != QFileDevice::NoError) ) {
+    qWarning() << "Could not write conformed audio file, path:" << partial_path << "msg =" << file.errorString();
+    file.remove();
+    return false;
+  }
+  file.close();
+  QFile::remove(path);
+  if (!QFile::rename(partial_path, path)) {
+    qWarning() << "Could not move conformed audio file, path:" << path;
+    QFile::remove(partial_path);
+    return false;
+  }
+  qInfo() << "Conformed audio, path:" << location << "index:" << stream_index << "rate:" << sample_rate
+          << "samples:" << length;
+  return length > 0;
+}
+
+
+bool ConformedAudio::load(const QString& path)
+{
+  auto file = std::make_unique<QFile>(path);
+  if (!file->open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream stream(file.get());
+  quint32 magic = 0;
+  quint32 version = 0;
+  qint32 sample_rate = 0;
+  qint32 channels = 0;
+  qint64 length = 0;
+  stream >> magic >> version >> sample_rate >> channels >> length;
+  if ( (magic != MAGIC) || (version != VERSION) || (sample_rate <= 0) || (channels != CHANNELS) || (length <= 0) ) {
+    qWarning() << "Conformed audio file not recognised, path:" << path;
+    return false;
+  }
+  const qint64 total = length * FRAME_BYTES;
+  if ( (stream.status() != QDataStream::Ok) || (file->size() < (HEADER_BYTES + total)) ) {
+    qWarning() << "Conformed audio file truncated, path:" << path;
+    return false;
+  }
+  const uchar* mapped = file->map(HEADER_BYTES, total);
+  if (mapped == nullptr) {
+    qWarning() << "Could not map conformed audio file, path:" << path << "msg =" << file->errorString();
+    return false;
+  }
+
+  file_ = std::move(file);
+  samples_ = reinterpret_cast<const float*>(mapped);
+  length_ = length;
+  sample_rate_ = sample_rate;
+  return true;
+}
+
+
+const float* ConformedAudio::samples(const int64_t from) const
+{
+  Q_ASSERT(samples_ != nullptr);
+  Q_ASSERT( (from >= 0) && (from < length_) );
+  return samples_ + (from * CHANNELS);
+}
+
+
+int64_t ConformedAudio::length() const
+{
+  return length_;
+}
+
+
+int ConformedAudio::sampleRate() const
+{
+  return sample_rate_;
+}
+
+
+bool ConformedAudio::empty() const
+{
+  return samples_ == nullptr;
+}
@@ -0,0 +1,81 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CONFORMEDAUDIO_H
+#define CONFORMEDAUDIO_H
+
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <memory>
+
+namespace project
+{
+  /**
+   * @brief An audio stream decoded once to interleaved float stereo at a sample rate, in a file that is memory-mapped.
+   *        Clips playing the stream at that rate slice their samples from it rather than decoding and resampling
+   */
+  class ConformedAudio
+  {
+    public:
+      static constexpr int CHANNELS = 2;
+
+      ConformedAudio() = default;
+
+      ConformedAudio(const ConformedAudio&) = delete;
+      ConformedAudio& operator=(const ConformedAudio&) = delete;
+
+      /**
+       * @brief               Decode and resample a stream to file
+       * @param location      Path of the source file
+       * @param stream_index  File index of the stream
+       * @param sample_rate   Of the conformed samples
+       * @param path          Of the file written
+       * @param running       Checked during the decode, to abandon it
+       * @return              true==success
+       */
+      static bool build(const QString& location, const int stream_index, const int sample_rate, const QString& path,
+                        const std::atomic_bool& running);
+      /**
+       * @brief       Map a file previously built
+       * @param path
+       * @return      true==success
+       */
+      bool load(const QString& path);
+
+      /**
+       * @brief       The samples from a position on
+       * @param from  Sample of each channel, less than length()
+       * @return      Interleaved stereo, full scale being [-1.0, 1.0]
+       */
+      const float* samples(const int64_t from) const;
+      // number of samples of each channel
+      int64_t length() const;
+      int sampleRate() const;
+      bool empty() const;
+
+    private:
+      std::unique_ptr<QFile> file_;
+      const float* samples_ {nullptr};
+      int64_t length_ {0};
+      int sample_rate_ {0};
+  };
+
+  using ConformedAudioPtr = std::shared_ptr<const ConformedAudio>;
+}
+
+#endif // CONFORMEDAUDIO_H
@@ -18,6 +18,7 @@
 #include "effectfield.h"
 
 #include <QDateTime>
+#include <algorithm>
 
 #include "ui/colorbutton.h"
 #include "ui/texteditex.h"
@@ -39,6 +40,12 @@
 
 #include "debug.h"
 
+namespace
+{
+  // sample frames between evaluations of keyframed values across an audio block
+  constexpr size_t AUTOMATION_STEP = 64;
+}
+
 QString fieldTypeValueToString(const EffectFieldType type, const QVariant& value)
 {
   switch (type) {
@@ -532,6 +539,37 @@ double EffectField::get_double_value(double timecode, bool async)
   return dynamic_cast<LabelSlider*>(ui_element)->value();
 }
 
+void EffectField::get_double_values(const double timecode_start,
+                                    const double timecode_end,
+                                    std::vector<float>& values,
+                                    const std::function<double(double)>& map)
+{
+  if (values.empty()) {
+    return;
+  }
+  const auto evaluate = [&] (const double timecode) {
+    const double value = get_double_value(timecode, true);
+    return static_cast<float>(map ? map(value) : value);
+  };
+  if (!hasKeyframes()) {
+    std::fill(values.begin(), values.end(), evaluate(timecode_start));
+    return;
+  }
+
+  const size_t frames = values.size();
+  const double interval = (timecode_end - timecode_start) / frames;
+  float from = evaluate(timecode_start);
+  for (size_t start = 0; start < frames; start += AUTOMATION_STEP) {
+    const size_t end = qMin(start + AUTOMATION_STEP, frames);
+    const float to = evaluate(timecode_start + (interval * end));
+    const float step = (to - from) / (end - start);
+    for (size_t i = start; i < end; ++i) {
+      values[i] = from + (step * (i - start));
+    }
+    from = to;
+  }
+}
+
 void EffectField::set_double_value(double v) {
   dynamic_cast<LabelSlider*>(ui_element)->set_value(v, false);
 }
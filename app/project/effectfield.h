@@ -23,6 +23,8 @@
 #include <QVariant>
 #include <QVector>
 #include <memory>
+#include <vector>
+#include <functional>
 
 #include "ui/labelslider.h"
 #include "project/keyframe.h"
@@ -67,6 +69,18 @@ public:
   QVariant validate_keyframe_data(double timecode, bool async = false);
 
   double get_double_value(double timecode, bool async = false);
+  /**
+   * @brief                 Values across a block of audio, one per sample frame. Evaluated once every AUTOMATION_STEP
+   *                        frames and ramped linearly between, or only once without keyframes
+   * @param timecode_start  Of the first frame
+   * @param timecode_end    Of the frame after the last
+   * @param values          Filled, sized to the number of frames
+   * @param map             Applied to each evaluated value, before ramping
+   */
+  void get_double_values(const double timecode_start,
+                         const double timecode_end,
+                         std::vector<float>& values,
+                         const std::function<double(double)>& map = nullptr);
   void set_double_value(double v);
   void set_double_default_value(double v);
   void set_double_minimum_value(double v);
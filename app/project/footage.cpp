@@ -20,6 +20,7 @@
 
 #include <mediahandling/mediahandling.h>
 #include <regex>
+#include <future>
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -352,17 +353,49 @@ bool Footage::generatePreviews()
 {
   qInfo() << "Generating previews for all streams, path:" << url_;
   bool success = true;
-  for (const auto& trk : video_tracks + audio_tracks) {
+  // each audio stream is decoded in full for its waveform, so those are done alongside each other
+  std::vector<std::future<bool>> waveforms;
+  for (const auto& trk : audio_tracks) {
+    Q_ASSERT(trk);
+    qDebug() << "Stream index:" << trk->file_index;
+    waveforms.push_back(std::async(std::launch::async, [trk] { return trk->generatePreview(); }));
+  }
+  for (const auto& trk : video_tracks) {
     Q_ASSERT(trk);
     qDebug() << "Stream index:" << trk->file_index;
     success &= trk->generatePreview();
   }
+  for (auto& waveform : waveforms) {
+    success &= waveform.get();
+  }
 
   ready_ = success;
   has_preview_ = success;
   return success;
 }
 
+bool Footage::generateProxies(const int height, const std::atomic_bool& running)
+{
+  bool success = true;
+  for (const auto& trk : video_tracks) {
+    Q_ASSERT(trk);
+    if (trk->proxyable()) {
+      success &= trk->generateProxy(height, running);
+    }
+  }
+  return success;
+}
+
+bool Footage::conformAudio(const int sample_rate, const std::atomic_bool& running)
+{
+  bool success = true;
+  for (const auto& trk : audio_tracks) {
+    Q_ASSERT(trk);
+    success &= trk->conformAudio(sample_rate, running);
+  }
+  return success;
+}
+
 bool Footage::isMissing() const noexcept
 {
   return media_source_ == nullptr;
@@ -72,6 +72,20 @@ class Footage : public std::enable_shared_from_this<Footage>, public project::Pr
      * @return  true==all streams have previews, false==at least one stream has no preview
      */
     bool generatePreviews();
+    /**
+     * @brief         Generate a proxy for each of the Footage's video streams
+     * @param height  Of the proxy frames
+     * @param running Checked during generation, to abandon it
+     * @return        true==all video streams have proxies
+     */
+    bool generateProxies(const int height, const std::atomic_bool& running);
+    /**
+     * @brief             Conform the audio streams to a sample rate, for playback and export to read in place of decoding
+     * @param sample_rate
+     * @param running     Checked during the decode, to abandon it
+     * @return            true==all audio streams are conformed
+     */
+    bool conformAudio(const int sample_rate, const std::atomic_bool& running);
 
     /**
      * @brief Identify if the Footage is missing its source file
@@ -25,12 +25,11 @@
 #include <QDateTime>
 #include <mediahandling/imediastream.h>
 #include <mediahandling/gsl-lite.hpp>
-#include <fmt/core.h>
-#include <stdlib.h>
 
 #include "io/path.h"
 #include "debug.h"
 #include "footage.h"
+#include "project/proxytranscoder.h"
 
 
 using project::FootageStream;
@@ -45,15 +44,6 @@ constexpr auto PREVIEW_HEIGHT = 480;
 constexpr auto PREVIEW_DIR = "/previews";
 constexpr auto THUMB_PREVIEW_FORMAT = "jpg";
 constexpr auto THUMB_PREVIEW_QUALITY = 80;
-constexpr auto EXTENSION = "dat";
-constexpr auto PIXELS_PER_SECOND = 100;
-#ifdef __linux__
-constexpr auto CMD_FORMAT = "ffmpeg -i \"{0}\" -map 0:{1} -f wav - | audiowaveform --input-format wav --output-format {2} -b 8 "
-                            "--split-channels --pixels-per-second {3} -o \"{4}\" &>/dev/null";
-#elif _WIN64
-//TODO:
-constexpr auto CMD_FORMAT = "";
-#endif
 
 
 FootageStream::FootageStream(std::weak_ptr<Footage> parent)
@@ -89,6 +79,10 @@ bool FootageStream::generatePreview()
     success = generateVisualPreview();
     if (success) {
       makeSquareThumb();
+      if (type_ == StreamType::VIDEO) {
+        // seeking falls back to guessing without an index, so not a failure
+        generateKeyframeIndex();
+      }
     }
   }
   qDebug() << "success:" << success << ", index:" << file_index << ", path:" <<  par->location();
@@ -136,6 +130,21 @@ std::optional<media_handling::FieldOrder> FootageStream::fieldOrder() const
   return f_order;
 }
 
+project::KeyframeIndexPtr FootageStream::keyframeIndex() const
+{
+  return std::atomic_load(&keyframe_index_);
+}
+
+project::WaveformPyramidPtr FootageStream::waveform() const
+{
+  return std::atomic_load(&waveform_);
+}
+
+project::ConformedAudioPtr FootageStream::conformedAudio() const
+{
+  return std::atomic_load(&conformed_audio_);
+}
+
 bool FootageStream::load(QXmlStreamReader& stream)
 {
   auto name = stream.name().toString().toLower();
@@ -221,69 +230,6 @@ bool FootageStream::save(QXmlStreamWriter& stream) const
 }
 
 
-auto convert(char* data, int size)
-{
-  uint32_t val = 0;
-  for (auto i = 0; i < size; ++i){
-    val |= static_cast<uint8_t>(data[i]) << (i * 8);
-  }
-  return val;
-}
-
-
-bool FootageStream::loadWaveformFile(const QString& data_path)
-{
-  qInfo() << "Reading waveform data, path:" << data_path;
-  QFile file(data_path);
-  if (!file.open(QIODevice::ReadOnly)) {
-    qWarning() << "Failed to open wavform file, path:" << data_path;
-    return false;
-  }
-
-  constexpr auto buf_size = 4;
-  char data[buf_size];
-  auto readUint = [&]() -> uint32_t {
-    if (file.read(data, buf_size) != buf_size) {
-      throw std::runtime_error("Unable to read from file");
-    }
-    return convert(data, buf_size);
-};
-
-  waveform_info_.version_ = readUint();
-  if (waveform_info_.version_ > 2){
-    qCritical() << "audiowaveform version '" << waveform_info_.version_ << "' is not supported";
-    return false;
-  }
-
-  waveform_info_.flags_ = readUint();
-  waveform_info_.rate_ = readUint();
-  waveform_info_.samples_per_pixel_= readUint();
-  waveform_info_.length_ = readUint();
-  if (waveform_info_.version_ == 1) {
-    waveform_info_.channels_ = 1;
-  } else {
-    waveform_info_.channels_ = readUint();
-  }
-
-  // TODO: identify what to do about 16bit sampling
-  const size_t datasize = [&] {
-    size_t sz = waveform_info_.length_ * waveform_info_.channels_ * 2;
-    if ((waveform_info_.flags_ & 0x1) == 0) {
-      // 16bit values
-      sz *= 2;
-    }
-    return sz;
-  }();
-
-  audio_preview.clear();
-  QByteArray samples = file.read(datasize);
-  for (const auto& samp: samples) {
-    audio_preview.push_back(samp);
-  }
-  return true;
-}
-
-
 void FootageStream::initialise(const media_handling::IMediaStream& stream)
 {
   file_index = stream.sourceIndex();
@@ -402,24 +348,103 @@ bool FootageStream::generateAudioPreview()
 {
   const auto par = parent_.lock();
   Q_ASSERT(par);
-  bool success = false;
+  auto pyramid = std::make_shared<WaveformPyramid>();
   const auto preview_path = waveformPath();
-  QFileInfo file(preview_path);
-  if (file.exists() && file.size() > 0) {
-    success = loadWaveformFile(preview_path);
+  if (QFileInfo(preview_path).exists() && pyramid->load(preview_path)) {
     qDebug() << "Opened existing preview, index:" << file_index;
+  } else if (pyramid->build(par->location(), file_index)) {
+    // mapped from file rather than held in memory, as when opened again
+    if (!pyramid->save(preview_path) || !pyramid->load(preview_path)) {
+      qWarning() << "Waveform did not save, path:" << par->location();
+    }
   } else {
-    const auto cmd = fmt::format(CMD_FORMAT, par->location().toStdString(), file_index, EXTENSION, PIXELS_PER_SECOND,
-                                 preview_path.toStdString());
-    if (system(cmd.c_str()) == 0) {
-      success = loadWaveformFile(preview_path);
-    } else {
-      qWarning() << "Failed to generate waveform, index:" << file_index;
+    qWarning() << "Failed to generate waveform, index:" << file_index;
+    return false;
+  }
+  std::atomic_store(&waveform_, WaveformPyramidPtr(std::move(pyramid)));
+  return true;
+}
+
+bool FootageStream::generateKeyframeIndex()
+{
+  const auto par = parent_.lock();
+  Q_ASSERT(par);
+  auto index = std::make_shared<KeyframeIndex>();
+  const auto index_path = keyframeIndexPath();
+  if (QFileInfo(index_path).exists() && index->load(index_path)) {
+    qDebug() << "Opened existing keyframe index, index:" << file_index;
+  } else if (index->build(par->location(), file_index)) {
+    if (!index->save(index_path)) {
+      qWarning() << "Keyframe index did not save, path:" << par->location();
     }
+  } else {
+    qWarning() << "Failed to index keyframes, index:" << file_index << ", path:" << par->location();
+    return false;
+  }
+  std::atomic_store(&keyframe_index_, KeyframeIndexPtr(std::move(index)));
+  return true;
+}
+
+bool FootageStream::generateProxy(const int height, const std::atomic_bool& running)
+{
+  if (!proxyable()) {
+    return false;
+  }
+  const auto par = parent_.lock();
+  Q_ASSERT(par);
+  const auto proxy_path = proxyPath();
+  if (QFileInfo::exists(proxy_path)) {
+    qDebug() << "Using existing proxy, index:" << file_index << ", path:" << par->location();
+    proxy_status_ = ProxyStatus::READY;
+    return true;
   }
+  qInfo() << "Generating proxy, index:" << file_index << ", path:" << par->location();
+  proxy_status_ = ProxyStatus::GENERATING;
+  ProxyTranscoder transcoder(par->location(), file_index, proxy_path);
+  const bool success = transcoder.transcode(height, running);
+  proxy_status_ = success ? ProxyStatus::READY : ProxyStatus::FAILED;
   return success;
 }
 
+
+bool FootageStream::conformAudio(const int sample_rate, const std::atomic_bool& running)
+{
+  if (!audio_ || infinite_length) {
+    return false;
+  }
+  if (const auto current = conformedAudio(); (current != nullptr) && (current->sampleRate() == sample_rate)) {
+    return true;
+  }
+  const auto par = parent_.lock();
+  Q_ASSERT(par);
+  auto conformed = std::make_shared<ConformedAudio>();
+  const auto conformed_path = conformedAudioPath(sample_rate);
+  if (QFileInfo::exists(conformed_path) && conformed->load(conformed_path)) {
+    qDebug() << "Opened existing conformed audio, index:" << file_index;
+  } else {
+    qInfo() << "Conforming audio, index:" << file_index << ", rate:" << sample_rate << ", path:" << par->location();
+    if (!ConformedAudio::build(par->location(), file_index, sample_rate, conformed_path, running)
+        || !conformed->load(conformed_path)) {
+      return false;
+    }
+  }
+  std::atomic_store(&conformed_audio_, ConformedAudioPtr(std::move(conformed)));
+  return true;
+}
+
+
+bool FootageStream::proxyable() const
+{
+  return !audio_ && (type_ == StreamType::VIDEO) && !infinite_length;
+}
+
+
+QString FootageStream::proxyPath() const
+{
+  return QDir(data_path).filePath(previewHash() + "p" + QString::number(file_index) + ".mov");
+}
+
+
 QString FootageStream::previewHash() const
 {
   const auto par = parent_.lock();
@@ -442,3 +467,15 @@ QString FootageStream::waveformPath() const
 {
   return QDir(data_path).filePath(previewHash() + "w" + QString::number(file_index));
 }
+
+
+QString FootageStream::keyframeIndexPath() const
+{
+  return QDir(data_path).filePath(previewHash() + "k" + QString::number(file_index));
+}
+
+
+QString FootageStream::conformedAudioPath(const int sample_rate) const
+{
+  return QDir(data_path).filePath(previewHash() + "c" + QString::number(file_index) + "_" + QString::number(sample_rate));
+}
@@ -20,16 +20,28 @@
 #define FOOTAGESTREAM_H
 
 #include <memory>
+#include <atomic>
 #include <QImage>
 #include <QIcon>
 #include <mediahandling/imediastream.h>
 
 #include "project/ixmlstreamer.h"
+#include "project/keyframeindex.h"
+#include "project/waveformpyramid.h"
+#include "project/conformedaudio.h"
 
 class Footage;
 
 namespace project {
 
+  enum class ProxyStatus {
+    NONE = 0,
+    QUEUED,
+    GENERATING,
+    READY,
+    FAILED
+  };
+
   enum class ScanMethod {
     PROGRESSIVE = 0,
     TOP_FIRST = 1,
@@ -50,11 +62,11 @@ namespace project {
       int audio_frequency {-1};
       QImage video_preview;
       QIcon video_preview_square;
-      QVector<char> audio_preview;
       media_handling::StreamType type_ {media_handling::StreamType::UNKNOWN};
       bool enabled_ {true};
       bool infinite_length {false};
       bool preview_done_ {false};
+      std::atomic<ProxyStatus> proxy_status_ {ProxyStatus::NONE};
 
       FootageStream() = delete;
       explicit FootageStream(std::weak_ptr<Footage> parent);
@@ -73,6 +85,46 @@ namespace project {
 
       void setStreamInfo(media_handling::MediaStreamPtr stream_info);
       std::optional<media_handling::FieldOrder> fieldOrder() const;
+      /**
+       * @brief   Obtain the keyframe positions of a video stream
+       * @return  index or null if not (yet) available
+       */
+      KeyframeIndexPtr keyframeIndex() const;
+      /**
+       * @brief   Obtain the waveform peaks of an audio stream
+       * @return  pyramid or null if not (yet) available
+       */
+      WaveformPyramidPtr waveform() const;
+      /**
+       * @brief   Obtain the samples of an audio stream conformed to a sample rate
+       * @return  conformed audio or null if not (yet) available
+       */
+      ConformedAudioPtr conformedAudio() const;
+      /**
+       * @brief             Decode an audio stream to a sample rate once, for clips to read in place of decoding it,
+       *                    unless it has been already
+       * @param sample_rate
+       * @param running     Checked during the decode, to abandon it
+       * @return            true==conformed audio is available
+       */
+      bool conformAudio(const int sample_rate, const std::atomic_bool& running);
+      /**
+       * @brief         Transcode the stream into a proxy for playback, unless one exists already
+       * @param height  Of the proxy frames
+       * @param running Checked during the transcode, to abandon it
+       * @return        true==proxy is ready
+       */
+      bool generateProxy(const int height, const std::atomic_bool& running);
+      /**
+       * @brief   Identify if the stream is a video worth making a proxy of
+       * @return  true==can have a proxy
+       */
+      bool proxyable() const;
+      /**
+       * @brief   Path of the stream's proxy, which is a file holding it alone
+       * @return  path
+       */
+      QString proxyPath() const;
 
       /* IXMLStreamer overrides */
       virtual bool load(QXmlStreamReader& stream) override;
@@ -80,19 +132,13 @@ namespace project {
 
 
     private:
-      struct WaveformInfo
-      {
-          uint32_t version_ {};
-          uint32_t flags_ {};
-          uint32_t rate_ {};
-          uint32_t samples_per_pixel_ {};
-          uint32_t length_ {};
-          uint32_t channels_ {};
-      } waveform_info_;
       std::weak_ptr<Footage> parent_;
       media_handling::MediaStreamPtr stream_info_{nullptr};
       QString data_path;
       bool audio_ {false};
+      KeyframeIndexPtr keyframe_index_ {nullptr};
+      WaveformPyramidPtr waveform_ {nullptr};
+      ConformedAudioPtr conformed_audio_ {nullptr};
 
       void initialise(const media_handling::IMediaStream& stream);
       /**
@@ -107,6 +153,12 @@ namespace project {
        * @return  true==preview available
        */
       bool generateAudioPreview();
+      /**
+       * @brief   Index the keyframes of a video stream
+       * @note    Only scans the stream if an index doesn't already exist. Loads if it does exist
+       * @return  true==index available
+       */
+      bool generateKeyframeIndex();
       /**
        * @brief   The hash of the source file path
        * @return
@@ -123,11 +175,16 @@ namespace project {
        */
       QString waveformPath() const;
       /**
-       * @brief           Load a waveform file formatted using bbc/audiowaveform structure
-       * @param data_path Location of waveform file to load
-       * @return          true==success
+       * @brief  Filepath where the keyframe index of this stream should be located
+       * @return filepath
+       */
+      QString keyframeIndexPath() const;
+      /**
+       * @brief             Filepath where the samples of this stream conformed to a sample rate should be located
+       * @param sample_rate
+       * @return            filepath
        */
-      bool loadWaveformFile(const QString& data_path);
+      QString conformedAudioPath(const int sample_rate) const;
       /**
        * @brief Make an thumbnail (icon)
        * @note Thumbnail is used in tree-view
@@ -0,0 +1,190 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "keyframeindex.h"
+
+#include <QFile>
+#include <QDataStream>
+#include <algorithm>
+#include <array>
+
+#include "debug.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+using project::KeyframeIndex;
+
+namespace
+{
+  constexpr quint32 MAGIC = 0x4b464958; // KFIX
+  constexpr quint32 VERSION = 1;
+  constexpr auto ERR_LEN = 256;
+}
+
+
+KeyframeIndex::KeyframeIndex(QVector<Entry> entries) : entries_(std::move(entries))
+{
+  std::sort(entries_.begin(), entries_.end(), [] (const Entry& lhs, const Entry& rhs) { return lhs.pts_ < rhs.pts_; });
+}
+
+
+bool KeyframeIndex::build(const QString& location, const int stream_index)
+{
+  entries_.clear();
+  const auto filename = location.toUtf8();
+  std::array<char, ERR_LEN> err{};
+
+  AVFormatContext* fmt_ctx = nullptr;
+  int ret = avformat_open_input(&fmt_ctx, filename.data(), nullptr, nullptr);
+  if (ret != 0) {
+    av_strerror(ret, err.data(), ERR_LEN);
+    qWarning() << "Could not open file to index, path:" << location << "msg =" << err.data();
+    return false;
+  }
+  ret = avformat_find_stream_info(fmt_ctx, nullptr);
+  if ( (ret < 0) || (stream_index < 0) || (static_cast<unsigned int>(stream_index) >= fmt_ctx->nb_streams) ) {
+    qWarning() << "Could not find stream to index, path:" << location << "index:" << stream_index;
+    avformat_close_input(&fmt_ctx);
+    return false;
+  }
+
+  // only the packets of the one stream need to be read
+  for (unsigned int i = 0; i < fmt_ctx->nb_streams; ++i) {
+    if (static_cast<int>(i) != stream_index) {
+      fmt_ctx->streams[i]->discard = AVDISCARD_ALL;
+    }
+  }
+
+  AVPacket* pkt = av_packet_alloc();
+  while ((ret = av_read_frame(fmt_ctx, pkt)) >= 0) {
+    if (pkt->stream_index == stream_index) {
+      const int64_t pts = (pkt->pts != AV_NOPTS_VALUE) ? pkt->pts : pkt->dts;
+      if ( ((pkt->flags & AV_PKT_FLAG_KEY) != 0) && (pts != AV_NOPTS_VALUE) ) {
+        entries_.append({pts, pkt->pos, 0});
+      }
+      if (!entries_.empty()) {
+        entries_.last().frames_++;
+      }
+    }
+    av_packet_unref(pkt);
+  }
+  av_packet_free(&pkt);
+  avformat_close_input(&fmt_ctx);
+
+  if (ret != AVERROR_EOF) {
+    av_strerror(ret, err.data(), ERR_LEN);
+    qWarning() << "Keyframe index incomplete, path:" << location << "msg =" << err.data();
+    entries_.clear();
+    return false;
+  }
+
+  // keyframe packets are in decode order, which isn't always presentation order
+  std::sort(entries_.begin(), entries_.end(), [] (const Entry& lhs, const Entry& rhs) { return lhs.pts_ < rhs.pts_; });
+  qInfo() << "Indexed keyframes, path:" << location << "index:" << stream_index << "count:" << entries_.size();
+  return !entries_.empty();
+}
+
+
+bool KeyframeIndex::load(const QString& path)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream stream(&file);
+  quint32 magic = 0;
+  quint32 version = 0;
+  qint32 count = 0;
+  stream >> magic >> version >> count;
+  if ( (magic != MAGIC) || (version != VERSION) || (count < 0) ) {
+    qWarning() << "Keyframe index file not recognised, path:" << path;
+    return false;
+  }
+
+  QVector<Entry> entries;
+  entries.reserve(count);
+  for (qint32 i = 0; i < count; ++i) {
+    qint64 pts = 0;
+    qint64 pos = 0;
+    qint32 frames = 0;
+    stream >> pts >> pos >> frames;
+    entries.append({pts, pos, frames});
+  }
+  if (stream.status() != QDataStream::Ok) {
+    qWarning() << "Keyframe index file truncated, path:" << path;
+    return false;
+  }
+  entries_ = std::move(entries);
+  return true;
+}
+
+
+bool KeyframeIndex::save(const QString& path) const
+{
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << "Could not open keyframe index file for writing, path:" << path;
+    return false;
+  }
+  QDataStream stream(&file);
+  stream << MAGIC << VERSION << static_cast<qint32>(entries_.size());
+  for (const auto& entry : entries_) {
+    stream << static_cast<qint64>(entry.pts_) << static_cast<qint64>(entry.pos_) << static_cast<qint32>(entry.frames_);
+  }
+  return stream.status() == QDataStream::Ok;
+}
+
+
+std::optional<KeyframeIndex::Entry> KeyframeIndex::keyframeBefore(const int64_t pts) const
+{
+  const auto it = std::upper_bound(entries_.cbegin(), entries_.cend(), pts,
+                                   [] (const int64_t val, const Entry& entry) { return val < entry.pts_; });
+  if (it == entries_.cbegin()) {
+    return {};
+  }
+  return *std::prev(it);
+}
+
+
+int32_t KeyframeIndex::framesToDecode(const Entry& keyframe, const int64_t pts, const int64_t frame_length)
+{
+  if ( (pts < keyframe.pts_) || (frame_length <= 0) ) {
+    return 1;
+  }
+  const auto frames = static_cast<int32_t>((pts - keyframe.pts_) / frame_length) + 1;
+  return (keyframe.frames_ > 0) ? std::min(frames, keyframe.frames_) : frames;
+}
+
+
+bool KeyframeIndex::empty() const
+{
+  return entries_.empty();
+}
+
+
+int KeyframeIndex::size() const
+{
+  return entries_.size();
+}
+
+
+const QVector<KeyframeIndex::Entry>& KeyframeIndex::entries() const
+{
+  return entries_;
+}
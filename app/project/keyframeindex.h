@@ -0,0 +1,94 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef KEYFRAMEINDEX_H
+#define KEYFRAMEINDEX_H
+
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <optional>
+
+namespace project
+{
+  /**
+   * @brief The positions of the keyframes of a video stream, to seek straight to the frame needed
+   */
+  class KeyframeIndex
+  {
+    public:
+      struct Entry
+      {
+        // presentation timestamp of the keyframe, in stream timebase
+        int64_t pts_;
+        // byte offset of the keyframe's packet in the file
+        int64_t pos_;
+        // number of frames from this keyframe up to the next
+        int32_t frames_;
+      };
+
+      KeyframeIndex() = default;
+      explicit KeyframeIndex(QVector<Entry> entries);
+
+      /**
+       * @brief               Scan the packets of a stream for its keyframes
+       * @param location      Path of the source file
+       * @param stream_index  File index of the stream
+       * @return              true==success
+       */
+      bool build(const QString& location, const int stream_index);
+      /**
+       * @brief       Read an index previously saved
+       * @param path
+       * @return      true==success
+       */
+      bool load(const QString& path);
+      /**
+       * @brief       Write the index to file
+       * @param path
+       * @return      true==success
+       */
+      bool save(const QString& path) const;
+
+      /**
+       * @brief     Find the keyframe from which decoding reaches a timestamp
+       * @param pts Target, in stream timebase
+       * @return    The last keyframe at or before pts, or empty if there isn't one
+       */
+      std::optional<Entry> keyframeBefore(const int64_t pts) const;
+      /**
+       * @brief               Estimate the number of frames decoded from a keyframe up to and including a timestamp
+       * @param keyframe
+       * @param pts           Target, in stream timebase
+       * @param frame_length  Duration of a frame, in stream timebase
+       * @return              frame count
+       */
+      static int32_t framesToDecode(const Entry& keyframe, const int64_t pts, const int64_t frame_length);
+
+      bool empty() const;
+      int size() const;
+      const QVector<Entry>& entries() const;
+
+    private:
+      // ordered by pts
+      QVector<Entry> entries_;
+  };
+
+  using KeyframeIndexPtr = std::shared_ptr<const KeyframeIndex>;
+}
+
+#endif // KEYFRAMEINDEX_H
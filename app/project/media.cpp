@@ -42,11 +42,28 @@ int32_t Media::nextID = 0;
 
 namespace
 {
-  const auto COLUMN_COUNT = 3;
+  const auto COLUMN_COUNT = 4;
   const auto FOLDER_ICON = ":/icons/folder.png";
   const auto SEQUENCE_ICON = ":/icons/sequence.png";
   const auto FRAME_RATE_DECIMAL_POINTS = 2;
   const auto FRAME_RATE_ARG_FORMAT = 'f';
+
+  QString proxyStatusName(const project::ProxyStatus status)
+  {
+    switch (status) {
+      case project::ProxyStatus::NONE:
+        return QCoreApplication::translate("ProxyStatusName", "None");
+      case project::ProxyStatus::QUEUED:
+        return QCoreApplication::translate("ProxyStatusName", "Queued");
+      case project::ProxyStatus::GENERATING:
+        return QCoreApplication::translate("ProxyStatusName", "Generating");
+      case project::ProxyStatus::READY:
+        return QCoreApplication::translate("ProxyStatusName", "Ready");
+      case project::ProxyStatus::FAILED:
+        return QCoreApplication::translate("ProxyStatusName", "Failed");
+    }
+    return {};
+  }
 }
 
 QString get_interlacing_name(const media_handling::FieldOrder interlacing)
@@ -487,8 +504,23 @@ QVariant Media::data(const int32_t column, const int32_t role)
           }
         }
           break;
+        case 3:
+        {
+          if (root_) {
+            return QCoreApplication::translate("Media", "Proxy");
+          }
+          if (type() == MediaType::FOOTAGE) {
+            auto ftg = object<Footage>();
+            Q_ASSERT(ftg);
+            if (!ftg->videoTracks().empty() && ftg->videoTracks().front()
+                && ftg->videoTracks().front()->proxyable()) {
+              return proxyStatusName(ftg->videoTracks().front()->proxy_status_);
+            }
+          }
+        }
+          break;
         default:
-          // There's only 3 columns
+          // There's only 4 columns
           break;
       }//switch
       break;
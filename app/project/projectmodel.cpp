@@ -267,6 +267,14 @@ void ProjectModel::setIcon(FootagePtr ftg, QIcon icon)
   }
 }
 
+void ProjectModel::refresh(const FootagePtr& ftg)
+{
+  Q_ASSERT(ftg);
+  if (auto mda = ftg->parent().lock()) {
+    emit dataChanged(create_index(mda->row(), 0, mda), create_index(mda->row(), mda->columnCount() - 1, mda));
+  }
+}
+
 QModelIndex ProjectModel::add(const MediaPtr& mda)
 {
   insert(mda);
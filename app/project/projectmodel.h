@@ -57,6 +57,11 @@ public:
     int childCount(MediaPtr parent = nullptr);
     void set_icon(const MediaPtr& m, const QIcon &ico);
     void setIcon(FootagePtr ftg, QIcon icon);
+    /**
+     * @brief     Notify views that the data of a Footage's item, in any column, has changed
+     * @param ftg
+     */
+    void refresh(const FootagePtr& ftg);
     QModelIndex add(const MediaPtr& mda);
     MediaPtr get(const QModelIndex& idx);
     const MediaPtr get(const QModelIndex& idx) const;
@@ -0,0 +1,92 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "proxygeneratorthread.h"
+
+#include "io/config.h"
+#include "debug.h"
+
+using chestnut::project::ProxyGeneratorThread;
+using project::ProxyStatus;
+
+ProxyGeneratorThread::ProxyGeneratorThread(QObject* parent) : QObject(parent)
+{
+  thread_ = std::thread(&ProxyGeneratorThread::run, this);
+}
+
+ProxyGeneratorThread::~ProxyGeneratorThread()
+{
+  qInfo() << "Stopping Proxy generation thread";
+  QMutexLocker lock(&queue_mutex_);
+  running_ = false;
+  lock.unlock();
+  wait_cond_.wakeAll();
+  thread_.join();
+}
+
+void ProxyGeneratorThread::addToQueue(FootagePtr ftg)
+{
+  if (ftg == nullptr) {
+    return;
+  }
+  bool wanted = false;
+  for (const auto& trk : ftg->videoTracks()) {
+    Q_ASSERT(trk);
+    const auto status = trk->proxy_status_.load();
+    if (trk->proxyable() && ( (status == ProxyStatus::NONE) || (status == ProxyStatus::FAILED) )) {
+      trk->proxy_status_ = ProxyStatus::QUEUED;
+      wanted = true;
+    }
+  }
+  if (!wanted) {
+    return;
+  }
+  QMutexLocker lock(&queue_mutex_);
+  queue_.enqueue(ftg);
+  lock.unlock();
+  qDebug() << "Added footage to proxy generator queue, file_path:" << ftg->location();
+  wait_cond_.wakeAll();
+}
+
+
+void ProxyGeneratorThread::run()
+{
+  qDebug() << "Starting Proxy Generator thread";
+  QMutexLocker lock(&queue_mutex_);
+  while (running_) {
+    if (queue_.empty()) {
+      wait_cond_.wait(&queue_mutex_);
+      continue;
+    }
+    const auto item = queue_.dequeue();
+    lock.unlock();
+    if (auto ftg = item.lock()) {
+      emit proxyStarted(ftg);
+      if (ftg->generateProxies(global::config.proxy_height, running_)) {
+        emit proxyGenerated(ftg);
+        qInfo() << "Footage generated proxies, file_path:" << ftg->location();
+      } else if (running_) {
+        emit proxyFailed(ftg);
+        qWarning() << "Footage failed to generate proxies, file_path:" << ftg->location();
+      }
+    } else {
+      qDebug() << "Queued Footage has since been removed";
+    }
+    lock.relock();
+  }
+  qInfo() << "Exiting Proxy Generator thread";
+}
@@ -0,0 +1,82 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PROXYGENERATORTHREAD_H
+#define PROXYGENERATORTHREAD_H
+
+#include <thread>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+
+// for the FootageWPtr metatype
+#include "previewgeneratorthread.h"
+
+
+namespace chestnut::project
+{
+  /**
+   * @brief Transcodes the video of Footage, one at a time, into proxies that playback uses in place of the original
+   */
+  class ProxyGeneratorThread : public QObject
+  {
+      Q_OBJECT
+    public:
+      explicit ProxyGeneratorThread(QObject* parent=nullptr);
+      ~ProxyGeneratorThread() override;
+
+      /**
+       * @brief       Add to the queue a Footage for proxies of its video streams to be generated in turn
+       * @param ftg
+       * @see proxyGenerated
+       * @see proxyFailed
+       */
+      void addToQueue(FootagePtr ftg);
+    signals:
+      /**
+       * @brief       Signal to indicate that proxies of a Footage are being generated
+       * @param item
+       */
+      void proxyStarted(FootageWPtr item);
+      /**
+       * @brief       Signal to indicate that all video streams in a Footage have proxies
+       * @param item
+       */
+      void proxyGenerated(FootageWPtr item);
+      /**
+       * @brief       Signal to indicate that one or all video streams in a Footage are missing proxies
+       * @param item
+       */
+      void proxyFailed(FootageWPtr item);
+
+    private:
+      std::thread thread_;
+      QQueue<FootageWPtr> queue_;
+      QMutex queue_mutex_;
+      QWaitCondition wait_cond_;
+      std::atomic_bool running_ {true};
+
+      /**
+       * @brief The worker method for the thread
+       */
+      void run();
+
+  };
+}
+
+#endif // PROXYGENERATORTHREAD_H
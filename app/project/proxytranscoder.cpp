@@ -0,0 +1,306 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "proxytranscoder.h"
+
+#include <QFile>
+#include <QtGlobal>
+#include <array>
+
+#include "debug.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
+
+using project::ProxyTranscoder;
+
+namespace
+{
+  constexpr auto ERR_LEN = 256;
+  constexpr auto PART_SUFFIX = ".part";
+  constexpr auto CONTAINER = "mov";
+  // every frame a keyframe
+  constexpr auto PROXY_CODEC = AV_CODEC_ID_MJPEG;
+  constexpr auto PROXY_PIX_FMT = AV_PIX_FMT_YUVJ420P;
+  // quantiser of the proxy's frames, lower is better
+  constexpr int PROXY_QUALITY = 5;
+
+  struct Contexts
+  {
+    AVFormatContext* in_ {nullptr};
+    AVCodecContext* dec_ {nullptr};
+    AVFormatContext* out_ {nullptr};
+    AVCodecContext* enc_ {nullptr};
+    SwsContext* sws_ {nullptr};
+    AVPacket* pkt_ {nullptr};
+    AVPacket* out_pkt_ {nullptr};
+    AVFrame* decoded_ {nullptr};
+    AVFrame* scaled_ {nullptr};
+
+    ~Contexts()
+    {
+      av_frame_free(&scaled_);
+      av_frame_free(&decoded_);
+      av_packet_free(&out_pkt_);
+      av_packet_free(&pkt_);
+      sws_freeContext(sws_);
+      avcodec_free_context(&enc_);
+      avcodec_free_context(&dec_);
+      if (out_ != nullptr) {
+        if ((out_->oformat->flags & AVFMT_NOFILE) == 0) {
+          avio_closep(&out_->pb);
+        }
+        avformat_free_context(out_);
+      }
+      avformat_close_input(&in_);
+    }
+  };
+
+  bool failed(const int ret, const char* msg, const QString& path)
+  {
+    if (ret >= 0) {
+      return false;
+    }
+    std::array<char, ERR_LEN> err{};
+    av_strerror(ret, err.data(), ERR_LEN);
+    qWarning() << msg << "path:" << path << "msg =" << err.data();
+    return true;
+  }
+}
+
+
+ProxyTranscoder::ProxyTranscoder(QString source, const int stream_index, QString destination)
+  : source_(std::move(source)),
+    stream_index_(stream_index),
+    destination_(std::move(destination))
+{
+
+}
+
+
+bool ProxyTranscoder::transcode(const int height, const std::atomic_bool& running)
+{
+  // written aside so that an interrupted transcode is never mistaken for a proxy
+  const QString part(destination_ + PART_SUFFIX);
+  if (!encode(part, height, running)) {
+    QFile::remove(part);
+    return false;
+  }
+  QFile::remove(destination_);
+  if (!QFile::rename(part, destination_)) {
+    qWarning() << "Could not move proxy into place, path:" << destination_;
+    QFile::remove(part);
+    return false;
+  }
+  return true;
+}
+
+
+bool ProxyTranscoder::encode(const QString& path, const int height, const std::atomic_bool& running) const
+{
+  Contexts ctx;
+  const auto src = source_.toUtf8();
+  if (failed(avformat_open_input(&ctx.in_, src.data(), nullptr, nullptr), "Could not open footage for proxy,", source_)
+      || failed(avformat_find_stream_info(ctx.in_, nullptr), "Could not read footage for proxy,", source_)) {
+    return false;
+  }
+  if ( (stream_index_ < 0) || (static_cast<unsigned int>(stream_index_) >= ctx.in_->nb_streams) ) {
+    qWarning() << "Could not find stream for proxy, path:" << source_ << "index:" << stream_index_;
+    return false;
+  }
+  for (unsigned int i = 0; i < ctx.in_->nb_streams; ++i) {
+    if (static_cast<int>(i) != stream_index_) {
+      ctx.in_->streams[i]->discard = AVDISCARD_ALL;
+    }
+  }
+  AVStream* in_stream = ctx.in_->streams[stream_index_];
+
+  // decoder
+  const AVCodec* decoder = avcodec_find_decoder(in_stream->codecpar->codec_id);
+  ctx.dec_ = avcodec_alloc_context3(decoder);
+  if ( (decoder == nullptr) || (ctx.dec_ == nullptr) ) {
+    qWarning() << "No decoder for proxy, path:" << source_;
+    return false;
+  }
+  AVDictionary* opts = nullptr;
+  av_dict_set(&opts, "threads", "auto", 0);
+  const bool dec_failed = failed(avcodec_parameters_to_context(ctx.dec_, in_stream->codecpar),
+                                 "Could not set up decoder for proxy,", source_)
+                          || failed(avcodec_open2(ctx.dec_, decoder, &opts), "Could not open decoder for proxy,", source_);
+  av_dict_free(&opts);
+  if (dec_failed) {
+    return false;
+  }
+
+  // the proxy keeps the aspect of the source at the proxy height, with even dimensions for 4:2:0
+  const int src_width = ctx.dec_->width;
+  const int src_height = ctx.dec_->height;
+  const int dst_height = qMin(height, src_height) & ~1;
+  if ( (src_width <= 0) || (dst_height <= 0) ) {
+    qWarning() << "Invalid dimensions for proxy, path:" << source_ << "height:" << src_height;
+    return false;
+  }
+  const int dst_width = qMax(2, qRound(static_cast<double>(src_width) * dst_height / src_height) & ~1);
+
+  // encoder and muxer
+  const auto dst = path.toUtf8();
+  if (failed(avformat_alloc_output_context2(&ctx.out_, nullptr, CONTAINER, dst.data()),
+             "Could not create proxy,", path)) {
+    return false;
+  }
+  const AVCodec* encoder = avcodec_find_encoder(PROXY_CODEC);
+  ctx.enc_ = avcodec_alloc_context3(encoder);
+  if ( (encoder == nullptr) || (ctx.enc_ == nullptr) ) {
+    qWarning() << "No encoder for proxy, path:" << path;
+    return false;
+  }
+  ctx.enc_->width = dst_width;
+  ctx.enc_->height = dst_height;
+  ctx.enc_->pix_fmt = PROXY_PIX_FMT;
+  ctx.enc_->color_range = AVCOL_RANGE_JPEG;
+  ctx.enc_->colorspace = ctx.dec_->colorspace;
+  ctx.enc_->sample_aspect_ratio = in_stream->codecpar->sample_aspect_ratio;
+  // timestamps of the source are kept
+  ctx.enc_->time_base = in_stream->time_base;
+  ctx.enc_->framerate = av_guess_frame_rate(ctx.in_, in_stream, nullptr);
+  ctx.enc_->flags |= AV_CODEC_FLAG_QSCALE;
+  ctx.enc_->global_quality = FF_QP2LAMBDA * PROXY_QUALITY;
+  if ((ctx.out_->oformat->flags & AVFMT_GLOBALHEADER) != 0) {
+    ctx.enc_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+  }
+  if (failed(avcodec_open2(ctx.enc_, encoder, nullptr), "Could not open encoder for proxy,", path)) {
+    return false;
+  }
+  AVStream* out_stream = avformat_new_stream(ctx.out_, nullptr);
+  if (out_stream == nullptr) {
+    qWarning() << "Could not add stream to proxy, path:" << path;
+    return false;
+  }
+  out_stream->time_base = ctx.enc_->time_base;
+  out_stream->sample_aspect_ratio = ctx.enc_->sample_aspect_ratio;
+  if (failed(avcodec_parameters_from_context(out_stream->codecpar, ctx.enc_), "Could not set up proxy stream,", path)
+      || failed(avio_open(&ctx.out_->pb, dst.data(), AVIO_FLAG_WRITE), "Could not open proxy for writing,", path)
+      || failed(avformat_write_header(ctx.out_, nullptr), "Could not write proxy header,", path)) {
+    return false;
+  }
+
+  ctx.pkt_ = av_packet_alloc();
+  ctx.out_pkt_ = av_packet_alloc();
+  ctx.decoded_ = av_frame_alloc();
+  ctx.scaled_ = av_frame_alloc();
+  if ( (ctx.pkt_ == nullptr) || (ctx.out_pkt_ == nullptr) || (ctx.decoded_ == nullptr) || (ctx.scaled_ == nullptr) ) {
+    qCritical() << "Could not allocate for proxy, path:" << path;
+    return false;
+  }
+  ctx.scaled_->width = dst_width;
+  ctx.scaled_->height = dst_height;
+  ctx.scaled_->format = PROXY_PIX_FMT;
+  if (failed(av_frame_get_buffer(ctx.scaled_, 0), "Could not allocate proxy frame,", path)) {
+    return false;
+  }
+
+  // write all the packets the encoder has ready. frame==null flushes it
+  const auto encode_frame = [&ctx, out_stream, &path] (AVFrame* frame) {
+    int ret = avcodec_send_frame(ctx.enc_, frame);
+    if ( (ret < 0) && (ret != AVERROR_EOF) ) {
+      return !failed(ret, "Could not encode proxy frame,", path);
+    }
+    while ((ret = avcodec_receive_packet(ctx.enc_, ctx.out_pkt_)) >= 0) {
+      av_packet_rescale_ts(ctx.out_pkt_, ctx.enc_->time_base, out_stream->time_base);
+      ctx.out_pkt_->stream_index = out_stream->index;
+      ret = av_interleaved_write_frame(ctx.out_, ctx.out_pkt_);
+      if (failed(ret, "Could not write proxy frame,", path)) {
+        return false;
+      }
+    }
+    return (ret == AVERROR(EAGAIN)) || (ret == AVERROR_EOF);
+  };
+
+  // scale and encode all the frames the decoder has ready
+  const auto drain_decoder = [&ctx, &encode_frame, &path] {
+    int ret;
+    while ((ret = avcodec_receive_frame(ctx.dec_, ctx.decoded_)) >= 0) {
+      ctx.sws_ = sws_getCachedContext(ctx.sws_,
+                                      ctx.decoded_->width,
+                                      ctx.decoded_->height,
+                                      static_cast<AVPixelFormat>(ctx.decoded_->format),
+                                      ctx.scaled_->width,
+                                      ctx.scaled_->height,
+                                      PROXY_PIX_FMT,
+                                      SWS_BILINEAR,
+                                      nullptr,
+                                      nullptr,
+                                      nullptr);
+      if ( (ctx.sws_ == nullptr) || failed(av_frame_make_writable(ctx.scaled_), "Could not reuse proxy frame,", path)) {
+        av_frame_unref(ctx.decoded_);
+        return false;
+      }
+      const int* coefficients = sws_getCoefficients((ctx.decoded_->colorspace == AVCOL_SPC_UNSPECIFIED)
+                                                    ? SWS_CS_DEFAULT : ctx.decoded_->colorspace);
+      sws_setColorspaceDetails(ctx.sws_,
+                               coefficients,
+                               (ctx.decoded_->color_range == AVCOL_RANGE_JPEG) ? 1 : 0,
+                               coefficients,
+                               1,
+                               0,
+                               1 << 16,
+                               1 << 16);
+      sws_scale(ctx.sws_,
+                ctx.decoded_->data,
+                ctx.decoded_->linesize,
+                0,
+                ctx.decoded_->height,
+                ctx.scaled_->data,
+                ctx.scaled_->linesize);
+      ctx.scaled_->pts = (ctx.decoded_->best_effort_timestamp != AV_NOPTS_VALUE) ? ctx.decoded_->best_effort_timestamp
+                                                                                 : ctx.decoded_->pts;
+      av_frame_unref(ctx.decoded_);
+      if (!encode_frame(ctx.scaled_)) {
+        return false;
+      }
+    }
+    return (ret == AVERROR(EAGAIN)) || (ret == AVERROR_EOF);
+  };
+
+  bool ok = true;
+  int ret = 0;
+  while (ok && running && ((ret = av_read_frame(ctx.in_, ctx.pkt_)) >= 0)) {
+    if (ctx.pkt_->stream_index == stream_index_) {
+      ret = avcodec_send_packet(ctx.dec_, ctx.pkt_);
+      // a corrupt packet isn't worth losing the whole proxy over
+      ok = ( (ret >= 0) || (ret == AVERROR_INVALIDDATA) ) && drain_decoder();
+    }
+    av_packet_unref(ctx.pkt_);
+  }
+  if (!running) {
+    qInfo() << "Proxy transcode abandoned, path:" << source_;
+    return false;
+  }
+  if (!ok || ( (ret < 0) && (ret != AVERROR_EOF) && failed(ret, "Could not read footage for proxy,", source_))) {
+    return false;
+  }
+
+  avcodec_send_packet(ctx.dec_, nullptr);
+  if (!drain_decoder() || !encode_frame(nullptr)) {
+    return false;
+  }
+  return !failed(av_write_trailer(ctx.out_), "Could not finish proxy,", path);
+}
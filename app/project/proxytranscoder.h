@@ -0,0 +1,61 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PROXYTRANSCODER_H
+#define PROXYTRANSCODER_H
+
+#include <QString>
+#include <atomic>
+
+namespace project
+{
+  /**
+   * @brief Transcodes a video stream into a low-resolution, intra-frame only file that decodes quickly at any
+   *        position. Timestamps and timebase of the source are kept so frames can be found as in the original
+   */
+  class ProxyTranscoder
+  {
+    public:
+      /**
+       * @param source        Path of the footage
+       * @param stream_index  File index of the video stream
+       * @param destination   Path of the proxy file to create
+       */
+      ProxyTranscoder(QString source, const int stream_index, QString destination);
+
+      ProxyTranscoder() = delete;
+      ProxyTranscoder(const ProxyTranscoder&) = delete;
+      ProxyTranscoder& operator=(const ProxyTranscoder&) = delete;
+
+      /**
+       * @brief         Create the proxy. Nothing is left at the destination unless successful
+       * @param height  Of the proxy frames. Smaller sources aren't scaled up
+       * @param running Checked between frames, to abandon the transcode
+       * @return        true==success
+       */
+      bool transcode(const int height, const std::atomic_bool& running);
+
+    private:
+      const QString source_;
+      const int stream_index_;
+      const QString destination_;
+
+      bool encode(const QString& path, const int height, const std::atomic_bool& running) const;
+  };
+}
+
+#endif // PROXYTRANSCODER_H
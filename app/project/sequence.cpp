@@ -286,6 +286,15 @@ void Sequence::setAudioLayout(const int32_t layout) noexcept
 }
 
 
+int32_t Sequence::audioChannels() const noexcept
+{
+  if (audio_layout_ <= 0) {
+    return av_get_channel_layout_nb_channels(DEFAULT_LAYOUT);
+  }
+  return av_get_channel_layout_nb_channels(static_cast<uint64_t>(audio_layout_));
+}
+
+
 int Sequence::trackCount(const bool video) const
 {
   QSet<int> tracks;
@@ -100,6 +100,11 @@ public:
      * @param layout AV_CH_LAYOUT_* value from libavutil/channel_layout.h
      */
     void setAudioLayout(const int32_t layout) noexcept;
+    /**
+     * @brief audioChannels of the sequence's layout
+     * @return count, stereo's if the layout is unset
+     */
+    int32_t audioChannels() const noexcept;
 
     /**
      * @brief         Obtain the track count in the sequence. This includes empty tracks e.g. between populated tracks
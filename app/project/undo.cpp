@@ -26,6 +26,9 @@
 #include "project/sequence.h"
 #include "panels/panelmanager.h"
 #include "playback/playback.h"
+#include "playback/audioscrubber.h"
+#include "playback/decoderpool.h"
+#include "playback/framecache.h"
 #include "ui/sourcetable.h"
 #include "project/effect.h"
 #include "project/transition.h"
@@ -38,10 +41,56 @@
 #include "project/media.h"
 #include "debug.h"
 
-QUndoStack e_undo_stack;
+UndoStack e_undo_stack;
 
 using panels::PanelManager;
 
+namespace
+{
+  /**
+   * @brief Drop the decoders and frames held of a footage for reuse, once its clips are closed, so nothing of the
+   *        file it was is read again
+   */
+  void purgeFootage(Media& mda)
+  {
+    if (mda.type() != MediaType::FOOTAGE) {
+      return;
+    }
+    const auto ftg = mda.object<Footage>();
+    if (ftg == nullptr) {
+      return;
+    }
+    QStringList locations {ftg->location()};
+    for (const auto& ms : ftg->videoTracks()) {
+      if (ms != nullptr) {
+        locations.append(ms->proxyPath());
+      }
+    }
+    for (const auto& location : locations) {
+      chestnut::playback::DecoderPool::instance().purge(location);
+      chestnut::playback::FrameCache::instance().purge(location);
+    }
+  }
+}
+
+void UndoStack::push(QUndoCommand* cmd)
+{
+  chestnut::playback::AudioScrubber::instance().stop();
+  QUndoStack::push(cmd);
+}
+
+void UndoStack::undo()
+{
+  chestnut::playback::AudioScrubber::instance().stop();
+  QUndoStack::undo();
+}
+
+void UndoStack::redo()
+{
+  chestnut::playback::AudioScrubber::instance().stop();
+  QUndoStack::redo();
+}
+
 //FIXME: far too much logic held in these actions
 
 ComboAction::~ComboAction()
@@ -485,6 +534,7 @@ void DeleteMediaCommand::undo()
 void DeleteMediaCommand::redo()
 {
   Project::model().removeChild(parent, item);
+  purgeFootage(*item);
 
   MainWindow::instance().setWindowModified(true);
   done = true;
@@ -589,6 +639,8 @@ void ReplaceMediaCommand::replace(QString& filename)
     }
   }
 
+  purgeFootage(*item);
+
   // replace media
   QStringList files;
   files.append(filename);
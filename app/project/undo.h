@@ -45,7 +45,18 @@ class Footage;
 class EffectMeta;
 
 
-extern QUndoStack e_undo_stack;
+/**
+ * @brief The project's undo stack. A command changes the project as it's pushed, undone or redone, so the audio
+ *        scrubber's render of a sequence is stopped first
+ */
+class UndoStack : public QUndoStack {
+public:
+  void push(QUndoCommand* cmd);
+  void undo();
+  void redo();
+};
+
+extern UndoStack e_undo_stack;
 
 class ComboAction : public QUndoCommand {
 public:
@@ -0,0 +1,333 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "waveformpyramid.h"
+
+#include <QDataStream>
+#include <algorithm>
+#include <cmath>
+
+#include "io/audiodecoder.h"
+#include "debug.h"
+
+using project::WaveformPyramid;
+using chestnut::io::AudioDecoder;
+
+namespace
+{
+  constexpr quint32 MAGIC = 0x57465059; // WFPY
+  constexpr quint32 VERSION = 1;
+  // about 2.7ms of 48kHz audio
+  constexpr int32_t FINEST_SAMPLES_PER_PEAK = 128;
+  constexpr int MAX_LEVELS = 16;
+
+  int8_t quantise(const float sample)
+  {
+    return static_cast<int8_t>(std::clamp(std::lround(sample * 128.0f), -128L, 127L));
+  }
+
+  /**
+   * @brief Summarises interleaved samples as they are decoded into the peaks of the finest level
+   */
+  class PeakAccumulator
+  {
+    public:
+      explicit PeakAccumulator(const int channels)
+        : min_(static_cast<size_t>(channels)),
+          max_(static_cast<size_t>(channels))
+      {
+        reset();
+      }
+
+      void add(const float* samples, const int64_t frames)
+      {
+        const size_t channels = min_.size();
+        for (int64_t f = 0; f < frames; ++f) {
+          for (size_t c = 0; c < channels; ++c) {
+            const float sample = samples[(static_cast<size_t>(f) * channels) + c];
+            min_[c] = std::min(min_[c], sample);
+            max_[c] = std::max(max_[c], sample);
+          }
+          if (++count_ == FINEST_SAMPLES_PER_PEAK) {
+            flush();
+          }
+        }
+        length_ += frames;
+      }
+
+      std::vector<int8_t> finish()
+      {
+        if (count_ > 0) {
+          flush();
+        }
+        return std::move(peaks_);
+      }
+
+      int64_t length() const
+      {
+        return length_;
+      }
+
+    private:
+      std::vector<float> min_;
+      std::vector<float> max_;
+      int32_t count_ {0};
+      int64_t length_ {0};
+      std::vector<int8_t> peaks_;
+
+      void flush()
+      {
+        for (size_t c = 0; c < min_.size(); ++c) {
+          peaks_.push_back(quantise(min_[c]));
+          peaks_.push_back(quantise(max_[c]));
+        }
+        reset();
+      }
+
+      void reset()
+      {
+        std::fill(min_.begin(), min_.end(), 0.0f);
+        std::fill(max_.begin(), max_.end(), 0.0f);
+        count_ = 0;
+      }
+  };
+
+  int64_t levelBytes(const WaveformPyramid::Level& level, const int channels)
+  {
+    return level.length_ * channels * 2;
+  }
+}
+
+
+WaveformPyramid::WaveformPyramid(const int channels, const QVector<float>& samples)
+{
+  if (channels <= 0) {
+    return;
+  }
+  PeakAccumulator peaks(channels);
+  peaks.add(samples.constData(), samples.size() / channels);
+  assemble(channels, peaks.length(), peaks.finish());
+}
+
+
+bool WaveformPyramid::build(const QString& location, const int stream_index)
+{
+  // only the sample format changes, so samples come out as they go in
+  AudioDecoder decoder;
+  if (!decoder.open(location, stream_index)) {
+    qWarning() << "Could not generate waveform, path:" << location << "index:" << stream_index;
+    return false;
+  }
+  const int channels = decoder.channels();
+  PeakAccumulator peaks(channels);
+  const auto add = [&peaks] (const float* samples, const int count, const int64_t /*pts*/) {
+    peaks.add(samples, count);
+  };
+  if (!decoder.decode(add)) {
+    return false;
+  }
+
+  assemble(channels, peaks.length(), peaks.finish());
+  qInfo() << "Generated waveform, path:" << location << "index:" << stream_index << "levels:" << levels_.size();
+  return !empty();
+}
+
+
+bool WaveformPyramid::load(const QString& path)
+{
+  auto file = std::make_unique<QFile>(path);
+  if (!file->open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream stream(file.get());
+  quint32 magic = 0;
+  quint32 version = 0;
+  qint32 channels = 0;
+  qint64 length = 0;
+  qint32 count = 0;
+  stream >> magic >> version >> channels >> length >> count;
+  if ( (magic != MAGIC) || (version != VERSION) || (channels <= 0) || (count <= 0) || (count > MAX_LEVELS) ) {
+    qWarning() << "Waveform file not recognised, path:" << path;
+    return false;
+  }
+
+  QVector<Level> levels;
+  int64_t total = 0;
+  for (qint32 i = 0; i < count; ++i) {
+    Level level;
+    qint32 samples_per_peak = 0;
+    qint64 peaks = 0;
+    stream >> samples_per_peak >> peaks;
+    level.samples_per_peak_ = samples_per_peak;
+    level.length_ = peaks;
+    total += levelBytes(level, channels);
+    levels.append(level);
+  }
+  const qint64 offset = file->pos();
+  if ( (stream.status() != QDataStream::Ok) || (file->size() < (offset + total)) ) {
+    qWarning() << "Waveform file truncated, path:" << path;
+    return false;
+  }
+  const uchar* mapped = file->map(offset, total);
+  if (mapped == nullptr) {
+    qWarning() << "Could not map waveform file, path:" << path << "msg =" << file->errorString();
+    return false;
+  }
+
+  data_.clear();
+  file_ = std::move(file);
+  channels_ = channels;
+  length_ = length;
+  levels_ = std::move(levels);
+  locate(reinterpret_cast<const int8_t*>(mapped));
+  return true;
+}
+
+
+bool WaveformPyramid::save(const QString& path) const
+{
+  if (empty()) {
+    return false;
+  }
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << "Could not open waveform file for writing, path:" << path;
+    return false;
+  }
+  QDataStream stream(&file);
+  stream << MAGIC << VERSION << static_cast<qint32>(channels_) << static_cast<qint64>(length_)
+         << static_cast<qint32>(levels_.size());
+  int64_t total = 0;
+  for (const auto& level : levels_) {
+    stream << static_cast<qint32>(level.samples_per_peak_) << static_cast<qint64>(level.length_);
+    total += levelBytes(level, channels_);
+  }
+  // the levels are contiguous
+  stream.writeRawData(reinterpret_cast<const char*>(levels_.front().peaks_), static_cast<int>(total));
+  return stream.status() == QDataStream::Ok;
+}
+
+
+const WaveformPyramid::Level* WaveformPyramid::level(const double samples_per_pixel) const
+{
+  if (levels_.empty()) {
+    return nullptr;
+  }
+  const Level* best = &levels_.front();
+  for (const auto& lvl : levels_) {
+    if (lvl.samples_per_peak_ > samples_per_pixel) {
+      break;
+    }
+    best = &lvl;
+  }
+  return best;
+}
+
+
+std::pair<int8_t, int8_t> WaveformPyramid::peak(const Level& level, int64_t from, int64_t to, const int channel) const
+{
+  from = std::max(from, static_cast<int64_t>(0));
+  to = std::min(to, level.length_);
+  if ( (from >= to) || (channel < 0) || (channel >= channels_) ) {
+    return {0, 0};
+  }
+  int8_t min = INT8_MAX;
+  int8_t max = INT8_MIN;
+  for (int64_t i = from; i < to; ++i) {
+    const int8_t* pk = level.peaks_ + (((i * channels_) + channel) * 2);
+    min = std::min(min, pk[0]);
+    max = std::max(max, pk[1]);
+  }
+  return {min, max};
+}
+
+
+bool WaveformPyramid::empty() const
+{
+  return levels_.empty();
+}
+
+
+int WaveformPyramid::channels() const
+{
+  return channels_;
+}
+
+
+int64_t WaveformPyramid::length() const
+{
+  return length_;
+}
+
+
+const QVector<WaveformPyramid::Level>& WaveformPyramid::levels() const
+{
+  return levels_;
+}
+
+
+void WaveformPyramid::assemble(const int channels, const int64_t length, const std::vector<int8_t>& finest)
+{
+  file_.reset();
+  levels_.clear();
+  channels_ = channels;
+  length_ = length;
+  if (finest.empty()) {
+    return;
+  }
+
+  data_ = QByteArray(reinterpret_cast<const char*>(finest.data()), static_cast<int>(finest.size()));
+  Level level;
+  level.samples_per_peak_ = FINEST_SAMPLES_PER_PEAK;
+  level.length_ = static_cast<int64_t>(finest.size()) / (channels * 2);
+  levels_.append(level);
+
+  // each level pairs up the peaks of the one before
+  int64_t prev_offset = 0;
+  while ( (levels_.size() < MAX_LEVELS) && (levels_.last().length_ > 1) ) {
+    const Level prev = levels_.last();
+    Level next;
+    next.samples_per_peak_ = prev.samples_per_peak_ * 2;
+    next.length_ = (prev.length_ + 1) / 2;
+    const int64_t next_offset = data_.size();
+    data_.resize(static_cast<int>(next_offset + levelBytes(next, channels)));
+    const auto src = reinterpret_cast<const int8_t*>(data_.constData()) + prev_offset;
+    auto dst = reinterpret_cast<int8_t*>(data_.data()) + next_offset;
+    for (int64_t i = 0; i < next.length_; ++i) {
+      const int64_t first = i * 2;
+      const int64_t second = std::min(first + 1, prev.length_ - 1);
+      for (int c = 0; c < channels; ++c) {
+        const int8_t* a = src + (((first * channels) + c) * 2);
+        const int8_t* b = src + (((second * channels) + c) * 2);
+        dst[((i * channels) + c) * 2] = std::min(a[0], b[0]);
+        dst[(((i * channels) + c) * 2) + 1] = std::max(a[1], b[1]);
+      }
+    }
+    prev_offset = next_offset;
+    levels_.append(next);
+  }
+  locate(reinterpret_cast<const int8_t*>(data_.constData()));
+}
+
+
+void WaveformPyramid::locate(const int8_t* peaks)
+{
+  for (auto& level : levels_) {
+    level.peaks_ = peaks;
+    peaks += levelBytes(level, channels_);
+  }
+}
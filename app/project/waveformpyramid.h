@@ -0,0 +1,127 @@
+/*
+ * Chestnut. Chestnut is a free non-linear video editor for Linux.
+ * Copyright (C) 2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef WAVEFORMPYRAMID_H
+#define WAVEFORMPYRAMID_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief The min/max peaks of an audio stream at several resolutions, each level summarising twice the samples per
+   *        peak of the one before. Drawing picks the level nearest to the zoom, so costs only the width drawn.
+   *        A loaded pyramid is memory-mapped
+   */
+  class WaveformPyramid
+  {
+    public:
+      struct Level
+      {
+        // samples of each channel summarised by a peak
+        int32_t samples_per_peak_ {0};
+        // peaks of each channel
+        int64_t length_ {0};
+        // min then max of each channel, for each peak in turn. Full scale is [-128, 127]
+        const int8_t* peaks_ {nullptr};
+      };
+
+      WaveformPyramid() = default;
+      /**
+       * @param channels  Number of channels
+       * @param samples   Interleaved, full scale being [-1.0, 1.0]
+       */
+      WaveformPyramid(const int channels, const QVector<float>& samples);
+
+      WaveformPyramid(const WaveformPyramid&) = delete;
+      WaveformPyramid& operator=(const WaveformPyramid&) = delete;
+
+      /**
+       * @brief               Decode a stream for its peaks
+       * @param location      Path of the source file
+       * @param stream_index  File index of the stream
+       * @return              true==success
+       */
+      bool build(const QString& location, const int stream_index);
+      /**
+       * @brief       Map a pyramid previously saved
+       * @param path
+       * @return      true==success
+       */
+      bool load(const QString& path);
+      /**
+       * @brief       Write the pyramid to file
+       * @param path
+       * @return      true==success
+       */
+      bool save(const QString& path) const;
+
+      /**
+       * @brief                   Find the level to draw at a zoom
+       * @param samples_per_pixel Samples of each channel drawn across a pixel
+       * @return                  The coarsest level with at least a peak per pixel, or the finest. Null if empty
+       */
+      const Level* level(const double samples_per_pixel) const;
+      /**
+       * @brief         The extent of the peaks of a channel across a range of a level
+       * @param level
+       * @param from    First peak
+       * @param to      Peak after the last, at least one after from
+       * @param channel
+       * @return        min and max, both 0 if the range is beyond the level
+       */
+      std::pair<int8_t, int8_t> peak(const Level& level, int64_t from, int64_t to, const int channel) const;
+
+      bool empty() const;
+      int channels() const;
+      // number of samples of each channel
+      int64_t length() const;
+      const QVector<Level>& levels() const;
+
+    private:
+      int channels_ {0};
+      int64_t length_ {0};
+      QVector<Level> levels_;
+      // the peaks of all levels, finest first, when built
+      QByteArray data_;
+      // the peaks of all levels when loaded
+      std::unique_ptr<QFile> file_;
+
+      /**
+       * @brief           Derive the coarser levels from the finest and hold them all
+       * @param channels
+       * @param length    Number of samples of each channel
+       * @param finest    Peaks of the finest level
+       */
+      void assemble(const int channels, const int64_t length, const std::vector<int8_t>& finest);
+      /**
+       * @brief       Point the levels into the peaks
+       * @param peaks Of all levels, finest first
+       */
+      void locate(const int8_t* peaks);
+  };
+
+  using WaveformPyramidPtr = std::shared_ptr<const WaveformPyramid>;
+}
+
+#endif // WAVEFORMPYRAMID_H
@@ -20,20 +20,29 @@
 #include <QPainter>
 #include <QLinearGradient>
 #include <QtMath>
-#include <limits>
+#include <cmath>
 
 #include "project/sequence.h"
-#include "playback/audio.h"
-#include "panels/panelmanager.h"
+#include "playback/audiometer.h"
 
-extern "C" {
-#include "libavformat/avformat.h"
-}
+using chestnut::playback::AudioMeter;
+using chestnut::playback::LoudnessMeter;
 
 constexpr int AUDIO_MONITOR_GAP = 3;
 constexpr auto PEAK_COLOUR = Qt::lightGray;
 constexpr auto PEAK_MAXED_COLOUR = Qt::red;
+constexpr auto RMS_COLOUR = Qt::white;
 constexpr auto PEAK_WIDTH = 2;
+// bottom of the meter, dBFS
+constexpr double METER_FLOOR = -60.0;
+
+namespace
+{
+  QString loudnessText(const QString& label, const double lufs)
+  {
+    return std::isfinite(lufs) ? label + QString::number(lufs, 'f', 1) : label + "-inf";
+  }
+}
 
 AudioMonitor::AudioMonitor(QWidget *parent) : QWidget(parent)
 {
@@ -42,15 +51,16 @@ AudioMonitor::AudioMonitor(QWidget *parent) : QWidget(parent)
 
 void AudioMonitor::reset()
 {
-  sample_cache_offset = -1;
-  sample_cache.clear();
+  active_ = false;
   update();
 }
 
 
 void AudioMonitor::resetPeaks()
 {
-  peaks_.clear();
+  AudioMeter::instance().reset();
+  active_ = true;
+  update();
 }
 
 void AudioMonitor::resizeEvent(QResizeEvent* event)
@@ -71,70 +81,58 @@ void AudioMonitor::paintEvent(QPaintEvent* event)
   }
 
   QPainter p(this);
-  const int channel_count = av_get_channel_layout_nb_channels(static_cast<uint64_t>(global::sequence->audioLayout()));
+  const auto levels = AudioMeter::instance().levels();
+
+  // momentary and integrated loudness beneath the bars, where there's room
+  const QStringList lines {loudnessText(tr("M "), levels.momentary_), loudnessText(tr("I "), levels.integrated_)};
+  const QFontMetrics metrics(font());
+  int bottom = height();
+  if (height() > metrics.height() * lines.size() * 4) {
+    bottom -= metrics.height() * lines.size();
+    int y = bottom;
+    for (const auto& line : lines) {
+      p.setPen(palette().text().color());
+      p.drawText(QRect(0, y, width(), metrics.height()), Qt::AlignCenter, line);
+      y += metrics.height();
+    }
+  }
 
+  const int channel_count = LoudnessMeter::CHANNELS;
   const int channel_width = (width() / channel_count) - AUDIO_MONITOR_GAP;
-  int32_t playhead_offset = -1;
   int channel_x = AUDIO_MONITOR_GAP;
 
-  for (auto channel = 0; channel < channel_count; ++channel) {
-    QRect r(channel_x, AUDIO_MONITOR_GAP, channel_width, height());
+  for (size_t channel = 0; channel < static_cast<size_t>(channel_count); ++channel) {
+    QRect r(channel_x, AUDIO_MONITOR_GAP, channel_width, bottom - AUDIO_MONITOR_GAP);
     p.fillRect(r, gradient);
 
-    qint16 peak = -1;
-    if ( (sample_cache_offset != -1) && !sample_cache.empty()) {
-      playhead_offset = static_cast<int32_t>((global::sequence->playhead_ - sample_cache_offset) * channel_count);
-      if ( (playhead_offset >= 0) && (playhead_offset < sample_cache.size()) ) {
-        const qint16 val = sample_cache.at(playhead_offset + channel);
-        const double multiplier = 1 - qAbs(static_cast<double>(val) / std::numeric_limits<int16_t>::max());
-        const auto height = static_cast<qint16>(qRound(r.height() * multiplier));
-        r.setHeight(height);
-        peak = updatePeak(channel, height);
-      } else {
-        reset();
-      }
-    } else if (peaks_.count(channel) == 1) {
-      // happens on a reset
-      peak = peaks_.at(channel);
+    if (active_) {
+      r.setBottom(levelY(levels.peak_.at(channel), r.top(), r.bottom()));
     }
     p.fillRect(r, QColor(0, 0, 0, 160));
 
-    if (peak >= 0) {
+    if (active_ && (levels.rms_.at(channel) > 0)) {
+      const int rms = levelY(levels.rms_.at(channel), AUDIO_MONITOR_GAP, bottom);
+      p.fillRect(QRect(channel_x, rms, channel_width, 1), RMS_COLOUR);
+    }
+    if (levels.max_peak_.at(channel) > 0) {
+      // inter-sample overs count as clipping
+      const int peak = levelY(levels.max_peak_.at(channel), AUDIO_MONITOR_GAP, bottom);
       const QRect peak_rect(channel_x, peak, channel_width, PEAK_WIDTH);
-      const QColor clr(peak > 0 ? PEAK_COLOUR : PEAK_MAXED_COLOUR);
+      const QColor clr(levels.true_peak_.at(channel) < 1.0f ? PEAK_COLOUR : PEAK_MAXED_COLOUR);
       p.fillRect(peak_rect, clr);
     }
 
     channel_x += channel_width + AUDIO_MONITOR_GAP;
   }
-
-  if (playhead_offset > -1) {
-    // clean up used samples
-    bool error = false;
-    while ( (sample_cache_offset < global::sequence->playhead_) && !error) {
-      sample_cache_offset++;
-      for (auto i = 0; i < channel_count; i++) {
-        if (sample_cache.isEmpty()) {
-          reset();
-          error = true;
-          break;
-        } else {
-          sample_cache.removeFirst();
-        }
-      }//for
-    }//while
-  }
 }
 
 
-qint16 AudioMonitor::updatePeak(const int channel, const qint16 value)
+int AudioMonitor::levelY(const float level, const int top, const int bottom)
 {
-  if (peaks_.count(channel) == 1) {
-    if (peaks_[channel] > value) {
-      peaks_[channel] = value;
-    }
-  } else {
-    peaks_[channel] = value;
+  if (level <= 0) {
+    return bottom;
   }
-  return peaks_[channel];
+  const double db = 20.0 * std::log10(static_cast<double>(level));
+  const double fraction = qBound(0.0, 1.0 - (db / METER_FLOOR), 1.0);
+  return bottom - qRound((bottom - top) * fraction);
 }
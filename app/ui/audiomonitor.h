@@ -19,19 +19,18 @@
 #define AUDIOMONITOR_H
 
 #include <QWidget>
-#include <map>
 
 class AudioMonitor : public QWidget
 {
     Q_OBJECT
 public:
-    QVector<qint16> sample_cache;
-    long sample_cache_offset;
-
     explicit AudioMonitor(QWidget *parent = nullptr);
+    /**
+     * @brief Stop showing levels, leaving the peaks and loudness measured
+     */
     void reset();
     /**
-     * @brief Reset all the channel peak values
+     * @brief Reset all the channel peak values, starting a new measurement
      */
     void resetPeaks();
 
@@ -44,15 +43,17 @@ public slots:
 
 private:
     QLinearGradient gradient;
-    std::map<int, qint16> peaks_;
+    // levels are being measured
+    bool active_ {false};
 
     /**
-     * @brief         Update the peak value of a channel
-     * @param channel Channel to update
-     * @param value   Value to update the channel peak
-     * @return        The peak value of the channel updated
+     * @brief         Position of a level on the meter
+     * @param level   Linear
+     * @param top     Of the meter
+     * @param bottom  Of the meter
+     * @return        y
      */
-    qint16 updatePeak(const int channel, const qint16 value);
+    static int levelY(const float level, const int top, const int bottom);
 };
 
 #endif // AUDIOMONITOR_H
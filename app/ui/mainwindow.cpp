@@ -32,6 +32,7 @@
 #include <QApplication>
 #include <QPushButton>
 #include <QStandardPaths>
+#include <QProgressDialog>
 
 #include "io/config.h"
 #include "io/path.h"
@@ -60,6 +61,8 @@
 
 #include "playback/audio.h"
 #include "playback/playback.h"
+#include "playback/offlineaudiorender.h"
+#include "playback/audioscrubber.h"
 
 #include "debug.h"
 
@@ -312,6 +315,10 @@ void MainWindow::initialise()
   QObject::connect(&PanelManager::timeLine(), &Timeline::newSequenceLoaded, this, &MainWindow::sequenceLoaded);
   QObject::connect(&PanelManager::footageViewer(), &Viewer::mediaSet, this, &MainWindow::footageViewerSet);
   QObject::connect(&PanelManager::footageViewer(), &Viewer::mediaCleared, this, &MainWindow::footageViewerCleared);
+  // otherwise scrubbing plays the audio of the sequence as it was before an edit
+  QObject::connect(&e_undo_stack, &QUndoStack::indexChanged, [] {
+    chestnut::playback::AudioScrubber::instance().invalidate();
+  });
 }
 
 MainWindow& MainWindow::instance(QWidget* parent, const QString& an)
@@ -544,6 +551,66 @@ void MainWindow::export_dialog()
   }
 }
 
+void MainWindow::bounce_audio()
+{
+  if (global::sequence == nullptr) {
+    QMessageBox::information(this,
+                             tr("No active sequence"),
+                             tr("Please open the sequence you wish to bounce."),
+                             QMessageBox::Ok);
+    return;
+  }
+  if (!chestnut::playback::OfflineAudioRender::supports(*global::sequence)) {
+    QMessageBox::information(this,
+                             tr("Bounce Audio"),
+                             tr("Sequences with nested sequences or reversed audio clips can only be exported."),
+                             QMessageBox::Ok);
+    return;
+  }
+  const QString path = QFileDialog::getSaveFileName(this, tr("Bounce Audio..."), "", tr("WAV (*.wav)"));
+  if (path.isEmpty()) {
+    return;
+  }
+
+  // the work area when set, otherwise the whole sequence
+  const auto& seq = global::sequence;
+  long start_frame = 0;
+  long end_frame = seq->endFrame();
+  if (seq->workarea_.using_) {
+    start_frame = seq->workarea_.in_;
+    end_frame = seq->workarea_.out_;
+  }
+
+  // the clips' effects are run by the bounce alone, as they are by an export
+  PanelManager::sequenceViewer().pause();
+  PanelManager::footageViewer().pause();
+  chestnut::playback::AudioScrubber::instance().stop();
+  seq->closeActiveClips();
+  set_rendering_state(true);
+  e_rendering = true;
+
+  QProgressDialog progress(tr("Bouncing audio..."), tr("Cancel"), 0, 100, this);
+  progress.setWindowModality(Qt::WindowModal);
+  std::atomic_bool running {true};
+  chestnut::playback::OfflineAudioRender render(seq, start_frame, end_frame);
+  const bool bounced = render.bounce(path, running, [&] (const int percent) {
+    progress.setValue(percent);
+    running = !progress.wasCanceled();
+  });
+  progress.reset();
+
+  e_rendering = false;
+  set_rendering_state(false);
+  PanelManager::refreshPanels(false);
+
+  if (!bounced && running) {
+    QMessageBox::critical(this,
+                          tr("Bounce Audio"),
+                          tr("Failed to bounce audio to %1").arg(path),
+                          QMessageBox::Ok);
+  }
+}
+
 void MainWindow::ripple_delete()
 {
   if (global::sequence != nullptr) {
@@ -776,6 +843,7 @@ void MainWindow::setup_menus() {
   file_menu->addSeparator();
 
   file_menu->addAction(tr("&Export..."), this, SLOT(export_dialog()), QKeySequence("Ctrl+M"))->setProperty("id", "export");
+  file_menu->addAction(tr("&Bounce Audio..."), this, SLOT(bounce_audio()))->setProperty("id", "bounceaudio");
 
   file_menu->addSeparator();
 
@@ -81,6 +81,7 @@ class MainWindow : public QMainWindow {
     void zoom_in();
     void zoom_out();
     void export_dialog();
+    void bounce_audio();
     void ripple_delete();
 
     void open_project();
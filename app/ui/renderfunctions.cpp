@@ -4,6 +4,7 @@
 #include <QApplication>
 #include <QDesktopWidget>
 #include <QDebug>
+#include <QDateTime>
 
 #include "project/clip.h"
 #include "project/sequence.h"
@@ -182,6 +183,22 @@ void renderClip(ClipPtr& clp, const int64_t playhead, const GLint current_fbo, V
             qCritical() << "Media stream is null";
             break;
           }
+          if (is_gl_yuv_format(clp->pix_fmt)) {
+            if ( (clp->planar_texture == nullptr) && chestnut::playback::PlanarTexture::supported()) {
+              clp->planar_texture = std::make_unique<chestnut::playback::PlanarTexture>(
+                                      clp->media_handling_.stream_->codecpar->width,
+                                      clp->media_handling_.stream_->codecpar->height,
+                                      clp->pix_fmt);
+            }
+            if ( (clp->planar_texture == nullptr) || !clp->planar_texture->isValid()) {
+              // reopened in RGB on the next pass, see Clip::formatStale()
+              texture_failed = true;
+              break;
+            }
+            clp->frame(playhead, texture_failed);
+            textureID = clp->planar_texture->textureId();
+            break;
+          }
           if (clp->texture == nullptr) {
             clp->texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
             clp->texture->setSize(clp->media_handling_.stream_->codecpar->width,
@@ -236,7 +253,14 @@ void renderClip(ClipPtr& clp, const int64_t playhead, const GLint current_fbo, V
           fbo_switcher = true;
         }
 
-        composite_texture = draw_clip(*ctx, clp->fbo[fbo_switcher], textureID, true);
+        if (clp->planar_texture != nullptr) {
+          // converted to RGB as it is drawn into the clip's framebuffer
+          clp->planar_texture->bind(*ctx);
+          composite_texture = draw_clip(*ctx, clp->fbo[fbo_switcher], textureID, true);
+          clp->planar_texture->release(*ctx);
+        } else {
+          composite_texture = draw_clip(*ctx, clp->fbo[fbo_switcher], textureID, true);
+        }
       }
 
       fbo_switcher = !fbo_switcher;
@@ -444,6 +468,17 @@ GLuint compose_sequence(Viewer* viewer,
 
   auto audio_track_count = 0;
 
+  // in playback, video clips are opened and decoded ahead of the playhead in the direction and at the speed it is
+  // moving. export and audio (mixed ahead of the playhead anyway) keep to the clips about to start
+  const bool prefetching = video && !rendering && (viewer != nullptr);
+  chestnut::playback::PrefetchWindow window;
+  if (prefetching) {
+    if (nests.isEmpty()) {
+      viewer->prefetcher().update(playhead, lcl_seq->frameRate(), QDateTime::currentMSecsSinceEpoch());
+    }
+    window = viewer->prefetcher().window(playhead, lcl_seq->frameRate(), global::config.prefetch_length);
+  }
+
   QVector<ClipPtr> current_clips;
 
   for (auto clp : lcl_seq->clips()) {
@@ -471,14 +506,26 @@ GLuint compose_sequence(Viewer* viewer,
       if (!( (clp->timeline_info.track_ >= 0) && !is_audio_device_set())) {
         if (ftg->ready_) {
           const auto found = ftg->has_stream_from_file_index(clp->timeline_info.media_stream);
-
-          if (found && clp->isActive(playhead)) {
+          const auto in = clp->timelineInWithTransition();
+          const auto out = clp->timelineOutWithTransition();
+          const bool active = clp->isActive(playhead) && (!prefetching || (playhead >= in));
+          const bool upcoming = !active && prefetching && clp->timeline_info.enabled && window.overlaps(in, out);
+
+          if (found && (active || upcoming)) {
+            if (clp->is_open && (clp->formatStale() || clp->sourceStale())) {
+              clp->close(rendering);
+            }
             // if thread is already working, we don't want to touch this,
             // but we also don't want to hang the UI thread
             clp->open(!rendering);
-            clip_is_active = true;
-            if (clp->timeline_info.track_ >= 0) {
-              audio_track_count++;
+            if (upcoming) {
+              // the frame the playhead will enter at, from whichever side
+              clp->prefetch((playhead < in) ? in : (out - 1));
+            } else {
+              clip_is_active = true;
+              if (clp->timeline_info.track_ >= 0) {
+                audio_track_count++;
+              }
             }
           } else if (clp->is_open) {
             clp->close(false);
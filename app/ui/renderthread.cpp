@@ -3,13 +3,24 @@
 #include <QApplication>
 #include <QImage>
 #include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QMutexLocker>
+#include <cstring>
 
 #include "ui/renderfunctions.h"
 #include "playback/playback.h"
 #include "project/sequence.h"
 #include "panels/panelmanager.h"
 
+namespace
+{
+  // between looking for frames read back, while there are any and nothing to draw
+  constexpr unsigned long READBACK_POLL_MILLIS = 2;
+  // for a readback to finish before mapping it regardless, in nanoseconds
+  constexpr GLuint64 READBACK_TIMEOUT = 1000000000;
+  constexpr int BYTES_PER_PIXEL = 4;
+}
+
 RenderThread::RenderThread()
 {
   surface.create();
@@ -25,11 +36,27 @@ void RenderThread::run()
   QMutexLocker locker(&mutex);
   while (running) {
     if (!queued) {
-      waitCond.wait(&mutex);
+      if (readbacks_pending_ > 0) {
+        waitCond.wait(&mutex, READBACK_POLL_MILLIS);
+      } else {
+        waitCond.wait(&mutex);
+      }
     }
     if (!running) {
       break;
     }
+    if (converter_pending_) {
+      makeConverter();
+      continue;
+    }
+    if (!queued) {
+      // nothing to draw, only frames read back to copy out
+      if (ctx != nullptr) {
+        ctx->makeCurrent(&surface);
+        while (retireReadback(false)) {}
+      }
+      continue;
+    }
     queued = false;
 
     if (share_ctx == nullptr) {
@@ -78,8 +105,20 @@ void RenderThread::run()
         // draw
         paint();
 
-        // flush changes
-        glFinish();
+        if (async_readback_) {
+          // whatever draws the frame waits on this for it, rather than this thread on the GPU
+          auto funcs = ctx->extraFunctions();
+          if (frame_fence_ != nullptr) {
+            funcs->glDeleteSync(frame_fence_);
+          }
+          frame_fence_ = funcs->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+          glFlush();
+          // earlier frames that have been read back meanwhile
+          while (retireReadback(false)) {}
+        } else {
+          // flush changes
+          glFinish();
+        }
 
         // release
         ctx->functions()->glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -92,6 +131,9 @@ void RenderThread::run()
       qCritical() << "Context instance is NULL";
     }
   }
+  // a caller of setReadbackFormat isn't left waiting
+  converter_pending_ = false;
+  converterCond_.wakeAll();
 
   delete_ctx();
 }
@@ -123,18 +165,14 @@ void RenderThread::paint()
         queued = true;
       } else {
         // used when saving a frame as a picture
-        QImage img(tex_width, tex_height, QImage::Format_RGBA8888);
-        ctx->functions()->glBindFramebuffer(GL_READ_FRAMEBUFFER, frameBuffer);
-        glReadPixels(0, 0, tex_width, tex_height, GL_RGBA, GL_UNSIGNED_BYTE, img.bits());
-        ctx->functions()->glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-        emit frameGrabbed(img);
+        readBack(nullptr, true);
         frame_grabbing_ = false;
       }
     } else if (pix_buf_ != nullptr) {
-      // used on exporting sequence
-      ctx->functions()->glBindFramebuffer(GL_READ_FRAMEBUFFER, frameBuffer);
-      glReadPixels(0, 0, tex_width, tex_height, GL_RGBA, GL_UNSIGNED_BYTE, pix_buf_);
-      ctx->functions()->glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+      // used on exporting sequence. A failed frame is drawn again into the same buffer
+      if (!texture_failed) {
+        readBack(pix_buf_, false);
+      }
       pix_buf_ = nullptr;
     }
 
@@ -157,6 +195,17 @@ void RenderThread::start_render(QOpenGLContext *share, SequenceWPtr s, const boo
   // stall any dependent actions
   texture_failed = true;
 
+  setShareContext(share);
+
+  frame_grabbing_ = grab;
+  pix_buf_ = pixel_buffer;
+
+  queued = true;
+  waitCond.wakeAll();
+}
+
+void RenderThread::setShareContext(QOpenGLContext* share)
+{
   if ( (share != nullptr) && ( (ctx == nullptr) || (ctx->shareContext() != share_ctx) )) {
     share_ctx = share;
     delete_ctx();
@@ -165,13 +214,8 @@ void RenderThread::start_render(QOpenGLContext *share, SequenceWPtr s, const boo
     ctx->setShareContext(share_ctx);
     ctx->create();
     ctx->moveToThread(this);
+    async_readback_ = ctx->format().version() >= qMakePair(3, 2);
   }
-
-  frame_grabbing_ = grab;
-  pix_buf_ = pixel_buffer;
-
-  queued = true;
-  waitCond.wakeAll();
 }
 
 bool RenderThread::did_texture_fail()
@@ -186,6 +230,223 @@ void RenderThread::cancel()
   wait();
 }
 
+void RenderThread::waitForFrame()
+{
+  auto current = QOpenGLContext::currentContext();
+  if ( (frame_fence_ != nullptr) && (current != nullptr) ) {
+    // waits on the GPU, not in this thread
+    current->extraFunctions()->glWaitSync(frame_fence_, 0, GL_TIMEOUT_IGNORED);
+  }
+}
+
+uint64_t RenderThread::readbacks() const
+{
+  return readbacks_;
+}
+
+bool RenderThread::readbackFailed() const
+{
+  return readback_failed_;
+}
+
+void RenderThread::dropReadbacks()
+{
+  QMutexLocker locker(&mutex);
+  for (auto& slot : readback_ring_) {
+    slot.destination_ = nullptr;
+  }
+}
+
+bool RenderThread::setReadbackFormat(const int format, const int colorspace, const int color_range, const int width,
+                                     const int height)
+{
+  QMutexLocker locker(&mutex);
+  readback_failed_ = false;
+  readback_format_.format_ = -1;
+  readback_format_.colorspace_ = colorspace;
+  readback_format_.color_range_ = color_range;
+  if (format < 0) {
+    return true;
+  }
+  if ( !chestnut::playback::PlanarConverter::handles(format) || (ctx == nullptr)
+       || !chestnut::playback::PlanarConverter::supported(*ctx) || !isRunning() ) {
+    return false;
+  }
+  // made now rather than at the first readback, so a shader or framebuffer that fails leaves the frames as RGBA
+  readback_format_.format_ = format;
+  converter_width_ = (width > 0) ? width : tex_width;
+  converter_height_ = (height > 0) ? height : tex_height;
+  converter_pending_ = true;
+  waitCond.wakeAll();
+  while (converter_pending_ && running) {
+    converterCond_.wait(&mutex);
+  }
+  if ( (converter_ == nullptr) || !converter_->isValid() ) {
+    qWarning() << "Could not convert frames as drawn, format =" << format;
+    converter_.reset();
+    readback_format_.format_ = -1;
+    return false;
+  }
+  return true;
+}
+
+void RenderThread::makeConverter()
+{
+  converter_.reset();
+  if ( (ctx != nullptr) && ctx->makeCurrent(&surface) && (converter_width_ > 0) && (converter_height_ > 0) ) {
+    converter_ = std::make_unique<chestnut::playback::PlanarConverter>(converter_width_, converter_height_,
+                                                                       readback_format_.format_,
+                                                                       readback_format_.colorspace_,
+                                                                       readback_format_.color_range_);
+  }
+  converter_pending_ = false;
+  converterCond_.wakeAll();
+}
+
+void RenderThread::readBack(GLvoid* destination, const bool grab)
+{
+  chestnut::playback::PlanarConverter* converter = nullptr;
+  if (!grab && (readback_format_.format_ >= 0)) {
+    if ( (converter_ == nullptr) || !converter_->matches(tex_width, tex_height, readback_format_.format_,
+                                                         readback_format_.colorspace_, readback_format_.color_range_) ) {
+      converter_ = std::make_unique<chestnut::playback::PlanarConverter>(tex_width, tex_height,
+                                                                         readback_format_.format_,
+                                                                         readback_format_.colorspace_,
+                                                                         readback_format_.color_range_);
+    }
+    if (!converter_->isValid()) {
+      // left unfilled, rather than overrun with RGBA. Not counted, so neither it nor those after are taken as filled
+      qCritical() << "Failed to convert frame to read back";
+      readback_failed_ = true;
+      return;
+    }
+    // drawn into the planes, which are read back in place of the frame
+    converter_->draw(*ctx, texColorBuffer);
+    converter = converter_.get();
+  }
+
+  auto funcs = ctx->extraFunctions();
+  funcs->glBindFramebuffer(GL_READ_FRAMEBUFFER, frameBuffer);
+  if (!async_readback_) {
+    // waits for the frame to be drawn and copied
+    if (grab) {
+      QImage img(tex_width, tex_height, QImage::Format_RGBA8888);
+      glReadPixels(0, 0, tex_width, tex_height, GL_RGBA, GL_UNSIGNED_BYTE, img.bits());
+      emit frameGrabbed(img);
+    } else {
+      if (converter != nullptr) {
+        converter->readPixels(*ctx, destination);
+      } else {
+        glReadPixels(0, 0, tex_width, tex_height, GL_RGBA, GL_UNSIGNED_BYTE, destination);
+      }
+      ++readbacks_;
+    }
+    funcs->glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    return;
+  }
+
+  if (readbacks_pending_ == readback_ring_.size()) {
+    retireReadback(true);
+  }
+  auto& slot = readback_ring_.at(readback_next_);
+  const auto size = (converter != nullptr) ? static_cast<GLsizeiptr>(converter->size())
+                                           : static_cast<GLsizeiptr>(tex_width) * tex_height * BYTES_PER_PIXEL;
+  if (slot.buffer_ == 0) {
+    funcs->glGenBuffers(1, &slot.buffer_);
+  }
+  funcs->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_);
+  if (slot.size_ != size) {
+    funcs->glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    slot.size_ = size;
+  }
+  // into the buffer, returning once the copy is queued rather than done
+  if (converter != nullptr) {
+    converter->readPixels(*ctx, nullptr);
+  } else {
+    glReadPixels(0, 0, tex_width, tex_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  }
+  funcs->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  funcs->glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+  slot.fence_ = funcs->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.destination_ = destination;
+  slot.grab_ = grab;
+  slot.width_ = tex_width;
+  slot.height_ = tex_height;
+  readback_next_ = (readback_next_ + 1) % readback_ring_.size();
+  ++readbacks_pending_;
+}
+
+bool RenderThread::retireReadback(const bool wait)
+{
+  if (readbacks_pending_ == 0) {
+    return false;
+  }
+  const auto oldest = (readback_next_ + readback_ring_.size() - readbacks_pending_) % readback_ring_.size();
+  auto& slot = readback_ring_.at(oldest);
+  auto funcs = ctx->extraFunctions();
+  // flushed, so the fence is bound to be signalled
+  const auto status = funcs->glClientWaitSync(slot.fence_, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? READBACK_TIMEOUT : 0);
+  if ( (status == GL_TIMEOUT_EXPIRED) && !wait ) {
+    return false;
+  }
+  if (status == GL_WAIT_FAILED) {
+    qWarning() << "Failed to wait for frame to be read back";
+  }
+  funcs->glDeleteSync(slot.fence_);
+  slot.fence_ = nullptr;
+
+  if ( (slot.destination_ != nullptr) || slot.grab_ ) {
+    funcs->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_);
+    // waits for the copy itself, should the wait above have timed out
+    const auto pixels = funcs->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size_, GL_MAP_READ_BIT);
+    if (pixels == nullptr) {
+      qCritical() << "Failed to map frame read back";
+      if (slot.destination_ != nullptr) {
+        readback_failed_ = true;
+      }
+    } else if (slot.grab_) {
+      QImage img(slot.width_, slot.height_, QImage::Format_RGBA8888);
+      memcpy(img.bits(), pixels, static_cast<size_t>(slot.size_));
+      emit frameGrabbed(img);
+    } else {
+      memcpy(slot.destination_, pixels, static_cast<size_t>(slot.size_));
+    }
+    if (pixels != nullptr) {
+      funcs->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    funcs->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+  if (!slot.grab_) {
+    // counted whether filled or dropped, to stay in step with the buffers given
+    ++readbacks_;
+  }
+  slot.destination_ = nullptr;
+  slot.grab_ = false;
+  --readbacks_pending_;
+  return true;
+}
+
+void RenderThread::delete_readbacks()
+{
+  auto funcs = ctx->extraFunctions();
+  for (auto& slot : readback_ring_) {
+    if (slot.fence_ != nullptr) {
+      funcs->glDeleteSync(slot.fence_);
+    }
+    if (slot.buffer_ > 0) {
+      funcs->glDeleteBuffers(1, &slot.buffer_);
+    }
+    slot = Readback();
+  }
+  if (frame_fence_ != nullptr) {
+    funcs->glDeleteSync(frame_fence_);
+    frame_fence_ = nullptr;
+  }
+  readback_next_ = 0;
+  readbacks_pending_ = 0;
+}
+
 void RenderThread::delete_texture()
 {
   if (texColorBuffer > 0) {
@@ -206,6 +467,10 @@ void RenderThread::delete_fbo()
 void RenderThread::delete_ctx()
 {
   if (ctx != nullptr) {
+    if (async_readback_) {
+      delete_readbacks();
+    }
+    converter_.reset();
     delete_texture();
     delete_fbo();
     ctx->doneCurrent();
@@ -7,9 +7,13 @@
 #include <QOffscreenSurface>
 #include <QOpenGLContext>
 #include <QOpenGLFramebufferObject>
+#include <array>
+#include <atomic>
+#include <memory>
 
 #include "project/sequence.h"
 #include "project/effect.h"
+#include "playback/planarconverter.h"
 
 class RenderThread : public QThread {
     Q_OBJECT
@@ -29,8 +33,45 @@ class RenderThread : public QThread {
     void paint();
     void setAsExporting(const bool value);
     void start_render(QOpenGLContext* share, SequenceWPtr s, const bool grab=false, GLvoid *pixel_buffer=nullptr);
+    /**
+     * @brief       Create the context rendered in, sharing another's resources, unless it already does. start_render()
+     *              does so too, but the context is needed before then to know what it supports
+     * @param share
+     */
+    void setShareContext(QOpenGLContext* share);
     bool did_texture_fail();
     void cancel();
+    /**
+     * @brief Hold the current context's commands until the last frame is drawn, to draw it in turn. The caller holds
+     *        mutex
+     */
+    void waitForFrame();
+    /**
+     * @return Pixel buffers given to start_render that have been filled since the thread started. They are read back
+     *         while the frames after are drawn, so each is filled some time after ready() for it, in the order given
+     */
+    uint64_t readbacks() const;
+    /**
+     * @return  A pixel buffer given could not be filled, so the frames from it on are missing
+     */
+    bool readbackFailed() const;
+    /**
+     * @brief Forget the pixel buffers given that are yet to be filled, so they can be freed
+     */
+    void dropReadbacks();
+    /**
+     * @brief             Have the pixel buffers given to start_render filled with the planes of a YUV format, converted
+     *                    by a shader before being read back, rather than with RGBA
+     * @param format      AVPixelFormat, or AV_PIX_FMT_NONE for RGBA
+     * @param colorspace  AVColorSpace to convert with
+     * @param color_range AVColorRange to convert to
+     * @param width       Of the frames to be drawn
+     * @param height      Of the frames to be drawn
+     * @return            true==the buffers are filled in the format, laid out with an alignment of 1. Otherwise
+     *                    they are filled with RGBA
+     */
+    bool setReadbackFormat(const int format, const int colorspace, const int color_range, const int width = 0,
+                           const int height = 0);
   protected:
     void run() override;
   public slots:
@@ -44,6 +85,33 @@ class RenderThread : public QThread {
     // cleanup functions
     void delete_texture();
     void delete_fbo();
+    void delete_readbacks();
+
+    // a frame read back into a pixel-pack buffer, copied out once the GPU has signalled the copy is done
+    struct Readback
+    {
+      GLuint buffer_ {0};
+      GLsizeiptr size_ {0};
+      GLsync fence_ {nullptr};
+      // of the caller, or null for a frame grab
+      GLvoid* destination_ {nullptr};
+      bool grab_ {false};
+      int width_ {0};
+      int height_ {0};
+    };
+
+    /**
+     * @brief             Start reading the frame drawn back from the GPU
+     * @param destination Filled with it, if not a frame grab
+     * @param grab        Emit frameGrabbed with it
+     */
+    void readBack(GLvoid* destination, const bool grab);
+    /**
+     * @brief       Copy out the oldest frame being read back
+     * @param wait  For the GPU to have read it back, otherwise only if it has
+     * @return      true==copied
+     */
+    bool retireReadback(const bool wait);
 
     GLuint frameBuffer {0};
     QWaitCondition waitCond;
@@ -61,6 +129,31 @@ class RenderThread : public QThread {
     std::atomic_bool draw_clipped_{false};
     GLvoid* pix_buf_{nullptr};
     std::atomic_bool exporting_ {false};
+    // with sync objects the frames are read back while those after are drawn, otherwise each is waited for
+    bool async_readback_ {false};
+    std::array<Readback, 3> readback_ring_;
+    size_t readback_next_ {0};
+    size_t readbacks_pending_ {0};
+    std::atomic<uint64_t> readbacks_ {0};
+    std::atomic_bool readback_failed_ {false};
+    GLsync frame_fence_ {nullptr};
+    // of the pixel buffers given, when not RGBA
+    struct {
+      int format_ {-1};
+      int colorspace_ {-1};
+      int color_range_ {-1};
+    } readback_format_;
+    std::unique_ptr<chestnut::playback::PlanarConverter> converter_;
+    // the converter is to be made for setReadbackFormat, which only this thread can do with its context current
+    bool converter_pending_ {false};
+    int converter_width_ {0};
+    int converter_height_ {0};
+    QWaitCondition converterCond_;
+
+    /**
+     * @brief Make the converter of the readback format, with the context current
+     */
+    void makeConverter();
 };
 
 #endif // RENDERTHREAD_H
@@ -2712,32 +2712,38 @@ void TimelineWidget::leaveEvent(QEvent*) {
 void draw_waveform(ClipPtr& clip, const FootageStreamPtr& ms, const long media_length, QPainter &p, const QRect& clip_rect,
                    const int waveform_start, const int waveform_limit, const double zoom)
 {
-  //FIXME: magic numbers in function
-  const auto divider = ms->audio_channels * 2;
-  const auto channel_height = clip_rect.height() / ms->audio_channels;
+  const auto waveform = ms->waveform();
+  if ( (waveform == nullptr) || waveform->empty() || (media_length <= 0) ) {
+    return;
+  }
+  const auto channels = waveform->channels();
+  const auto channel_height = clip_rect.height() / channels;
+  // the level with about a peak per pixel at this zoom
+  const double samples_per_pixel = static_cast<double>(waveform->length()) / (media_length * zoom);
+  const auto level = waveform->level(samples_per_pixel);
+  Q_ASSERT(level);
+  const double peaks_per_frame = static_cast<double>(level->length_) / media_length;
 
   for (auto i = waveform_start; i < waveform_limit; ++i) {
-    auto waveform_index = qFloor( ( ( (clip->timeline_info.clip_in + (static_cast<double>(i)/zoom)) / media_length)
-                                   * ms->audio_preview.size() ) / divider) * divider;
-
+    const auto frame = clip->timeline_info.clip_in + (static_cast<double>(i) / zoom);
+    auto from = static_cast<int64_t>(qFloor(frame * peaks_per_frame));
+    auto to = qMax(from + 1, static_cast<int64_t>(qFloor((frame + (1.0 / zoom)) * peaks_per_frame)));
     if (clip->timeline_info.reverse) {
-      waveform_index = ms->audio_preview.size() - waveform_index - (ms->audio_channels * 2);
+      const auto reversed = level->length_ - to;
+      to = level->length_ - from;
+      from = reversed;
     }
 
-    for (auto j=0; j < ms->audio_channels; ++j) {
+    for (auto j=0; j < channels; ++j) {
       auto mid = (global::config.rectified_waveforms) ? clip_rect.top()+channel_height*(j+1) : clip_rect.top()+channel_height*j+(channel_height/2);
-      auto offset = waveform_index+(j*2);
-      Q_ASSERT(offset >= 0);
-
-      if ((offset + 1) < ms->audio_preview.size()) {
-        const auto min = static_cast<double>(ms->audio_preview.at(offset)) / 128.0 * (channel_height/2);
-        const auto max = static_cast<double>(ms->audio_preview.at(offset+1)) / 128.0 * (channel_height/2);
+      const auto peak = waveform->peak(*level, from, to, j);
+      const auto min = static_cast<double>(peak.first) / 128.0 * (channel_height/2);
+      const auto max = static_cast<double>(peak.second) / 128.0 * (channel_height/2);
 
-        if (global::config.rectified_waveforms)  {
-          p.drawLine(clip_rect.left() + i, mid, clip_rect.left() + i, mid - (max - min));
-        } else {
-          p.drawLine(clip_rect.left() + i, mid + min, clip_rect.left() + i, mid + max);
-        }
+      if (global::config.rectified_waveforms)  {
+        p.drawLine(clip_rect.left() + i, mid, clip_rect.left() + i, mid - (max - min));
+      } else {
+        p.drawLine(clip_rect.left() + i, mid + min, clip_rect.left() + i, mid + max);
       }
     }//for
   }
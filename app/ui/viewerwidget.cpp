@@ -661,6 +661,7 @@ void ViewerWidget::paintGL()
     renderer->mutex.lock();
 
     makeCurrent();
+    renderer->waitForFrame();
 
     // clear to solid black
 
@@ -711,7 +712,7 @@ void ViewerWidget::paintGL()
     if (window != nullptr && window->isVisible()) {
       window->setTexture(renderer->texColorBuffer,
                           static_cast<double>(viewer->getSequence()->width()) / viewer->getSequence()->height(),
-                          &renderer->mutex);
+                          renderer);
     }
 
     renderer->mutex.unlock();
@@ -3,6 +3,8 @@
 #include <QMutex>
 #include <QMutexLocker>
 
+#include "ui/renderthread.h"
+
 ViewerWindow::ViewerWindow(QOpenGLContext *share) :
   QOpenGLWindow(share)
 {
@@ -11,14 +13,14 @@ ViewerWindow::ViewerWindow(QOpenGLContext *share) :
 
 ViewerWindow::~ViewerWindow()
 {
-  mutex = nullptr;
+  renderer_ = nullptr;
 }
 
-void ViewerWindow::setTexture(const GLuint t, const double iar, QMutex* imutex)
+void ViewerWindow::setTexture(const GLuint t, const double iar, RenderThread* renderer)
 {
   texture = t;
   ar = iar;
-  mutex = imutex;
+  renderer_ = renderer;
   update();
 }
 
@@ -28,7 +30,8 @@ void ViewerWindow::paintGL()
     return;
   }
 
-  QMutexLocker locker(mutex);
+  QMutexLocker locker(&renderer_->mutex);
+  renderer_->waitForFrame();
 
   glClearColor(0.0, 0.0, 0.0, 1.0);
   glClear(GL_COLOR_BUFFER_BIT);
@@ -3,7 +3,7 @@
 
 #include <QOpenGLWindow>
 
-class QMutex;
+class RenderThread;
 
 class ViewerWindow : public QOpenGLWindow {
     Q_OBJECT
@@ -16,12 +16,17 @@ class ViewerWindow : public QOpenGLWindow {
     ViewerWindow(const ViewerWindow&& ) = delete;
     ViewerWindow& operator=(const ViewerWindow&&) = delete;
 
-    void setTexture(const GLuint t, const double iar, QMutex *imutex);
+    /**
+     * @param t         Texture to draw
+     * @param iar       Its aspect ratio
+     * @param renderer  That draws the texture, locked while it is drawn here
+     */
+    void setTexture(const GLuint t, const double iar, RenderThread* renderer);
   private:
     void paintGL() override;
     GLuint texture {0};
     double ar {0.0};
-    QMutex* mutex {nullptr};
+    RenderThread* renderer_ {nullptr};
 };
 
 #endif // VIEWERWINDOW_H
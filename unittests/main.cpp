@@ -35,6 +35,21 @@
 #include "panels/unittest/viewertest.h"
 #include "panels/unittest/timelinetest.h"
 #include "unittest/databasetest.h"
+#include "playback/UnitTest/framecachetest.h"
+#include "project/UnitTest/keyframeindextest.h"
+#include "project/UnitTest/waveformpyramidtest.h"
+#include "project/UnitTest/conformedaudiotest.h"
+#include "playback/UnitTest/decodeschedulertest.h"
+#include "playback/UnitTest/framepooltest.h"
+#include "io/UnitTest/avtogltest.h"
+#include "playback/UnitTest/prefetchertest.h"
+#include "playback/UnitTest/audiomixertest.h"
+#include "playback/UnitTest/offlineaudiorendertest.h"
+#include "playback/UnitTest/loudnessmetertest.h"
+#include "playback/UnitTest/audioscrubbertest.h"
+#include "playback/UnitTest/recordingwritertest.h"
+#include "io/UnitTest/exportpipelinetest.h"
+#include "io/UnitTest/exportpresetstest.h"
 
 namespace
 {
@@ -72,5 +87,20 @@ int main(int argc, char** argv)
   status |= runTest<ViewerTest>();
   status |= runTest<TimelineTest>();
   status |= runTest<DatabaseTest>();
+  status |= runTest<FrameCacheTest>();
+  status |= runTest<KeyframeIndexTest>();
+  status |= runTest<WaveformPyramidTest>();
+  status |= runTest<ConformedAudioTest>();
+  status |= runTest<DecodeSchedulerTest>();
+  status |= runTest<FramePoolTest>();
+  status |= runTest<AvToGlTest>();
+  status |= runTest<PrefetcherTest>();
+  status |= runTest<AudioMixerTest>();
+  status |= runTest<OfflineAudioRenderTest>();
+  status |= runTest<LoudnessMeterTest>();
+  status |= runTest<AudioScrubberTest>();
+  status |= runTest<RecordingWriterTest>();
+  status |= runTest<ExportPipelineTest>();
+  status |= runTest<ExportPresetsTest>();
   return status;
 }
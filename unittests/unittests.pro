@@ -41,7 +41,22 @@ SOURCES += \
     ../app/project/UnitTest/mediahandlertest.cpp \
     ../app/project/UnitTest/effecttest.cpp \
     ../app/panels/unittest/histogramviewertest.cpp \
-    ../app/project/UnitTest/effectkeyframetest.cpp
+    ../app/project/UnitTest/effectkeyframetest.cpp \
+    ../app/playback/UnitTest/framecachetest.cpp \
+    ../app/project/UnitTest/keyframeindextest.cpp \
+    ../app/project/UnitTest/waveformpyramidtest.cpp \
+    ../app/project/UnitTest/conformedaudiotest.cpp \
+    ../app/playback/UnitTest/decodeschedulertest.cpp \
+    ../app/playback/UnitTest/framepooltest.cpp \
+    ../app/io/UnitTest/avtogltest.cpp \
+    ../app/playback/UnitTest/prefetchertest.cpp \
+    ../app/playback/UnitTest/audiomixertest.cpp \
+    ../app/playback/UnitTest/offlineaudiorendertest.cpp \
+    ../app/playback/UnitTest/loudnessmetertest.cpp \
+    ../app/playback/UnitTest/audioscrubbertest.cpp \
+    ../app/playback/UnitTest/recordingwritertest.cpp \
+    ../app/io/UnitTest/exportpipelinetest.cpp \
+    ../app/io/UnitTest/exportpresetstest.cpp
 
 
 DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -63,7 +78,22 @@ HEADERS += \
     ../app/project/UnitTest/effecttest.h \
     ../app/panels/unittest/histogramviewertest.h \
     ../app/project/UnitTest/effectkeyframetest.h \
-    ../app/unittest/databasetest.h
+    ../app/unittest/databasetest.h \
+    ../app/playback/UnitTest/framecachetest.h \
+    ../app/project/UnitTest/keyframeindextest.h \
+    ../app/project/UnitTest/waveformpyramidtest.h \
+    ../app/project/UnitTest/conformedaudiotest.h \
+    ../app/playback/UnitTest/decodeschedulertest.h \
+    ../app/playback/UnitTest/framepooltest.h \
+    ../app/io/UnitTest/avtogltest.h \
+    ../app/playback/UnitTest/prefetchertest.h \
+    ../app/playback/UnitTest/audiomixertest.h \
+    ../app/playback/UnitTest/offlineaudiorendertest.h \
+    ../app/playback/UnitTest/loudnessmetertest.h \
+    ../app/playback/UnitTest/audioscrubbertest.h \
+    ../app/playback/UnitTest/recordingwritertest.h \
+    ../app/io/UnitTest/exportpipelinetest.h \
+    ../app/io/UnitTest/exportpresetstest.h
 
 INCLUDEPATH += ../app/
 